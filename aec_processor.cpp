@@ -0,0 +1,351 @@
+#include "aec_processor.h"
+#include "speaker_manager.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+AecProcessor::AecProcessor(QObject *parent)
+    : QObject(parent)
+    , enabled(true)
+    , initialized(false)
+    , sampleRate(16000)
+    , tapCount(0)
+    , maxDelay(0)
+    , delay(0)
+    , candidateDelay(-1)
+    , envelopeBin(16)
+    , samplesSinceDelayUpdate(0)
+    , referenceCursor(0.0)
+    , cursorValid(false)
+    , referenceRate(0)
+    , doubleTalkHold(0)
+    , erle(0.0)
+{
+}
+
+AecProcessor::~AecProcessor()
+{
+}
+
+bool AecProcessor::initialize(int newSampleRate, int tailMs)
+{
+    if (newSampleRate <= 0 || tailMs <= 0) {
+        qDebug() << "AEC参数不合法:" << newSampleRate << tailMs;
+        return false;
+    }
+
+    sampleRate = newSampleRate;
+    tapCount = sampleRate * tailMs / 1000;
+    maxDelay = sampleRate * MAX_DELAY_MS / 1000;
+    envelopeBin = qMax(1, sampleRate / 1000);
+
+    weights.assign(tapCount, 0.0f);
+    initialized = true;
+    reset();
+
+    qDebug() << "AEC初始化成功:"
+             << "\n  采样率:" << sampleRate
+             << "\n  滤波器阶数:" << tapCount
+             << "\n  最大延迟:" << MAX_DELAY_MS << "ms";
+    return true;
+}
+
+void AecProcessor::setReferenceSource(SpeakerManager* newSpeaker)
+{
+    speaker = newSpeaker;
+    cursorValid = false;
+}
+
+void AecProcessor::reset()
+{
+    std::fill(weights.begin(), weights.end(), 0.0f);
+    farHistory.assign(maxDelay + tapCount, 0.0f);
+    nearEnvelope.assign(DELAY_WINDOW_MS, 0.0f);
+    farEnvelope.assign(DELAY_WINDOW_MS + MAX_DELAY_MS, 0.0f);
+    samplesSinceDelayUpdate = 0;
+    delay = 0;
+    candidateDelay = -1;
+    cursorValid = false;
+    doubleTalkHold = 0;
+    erle = 0.0;
+}
+
+int AecProcessor::estimatedDelayMs() const
+{
+    return sampleRate > 0 ? delay * 1000 / sampleRate : 0;
+}
+
+QByteArray AecProcessor::process(const QByteArray& nearEnd)
+{
+    if (!enabled || !initialized || speaker.isNull() || nearEnd.isEmpty()) {
+        return nearEnd;
+    }
+
+    const int samples = nearEnd.size() / sizeof(qint16);
+    const int rate = speaker->getSampleRate();
+    if (rate != referenceRate) {
+        referenceRate = rate;
+        cursorValid = false;
+    }
+
+    // 参考游标按麦克风时钟推进，只有偏差过大时才重新对齐到实际播放位置，
+    // 避免回调抖动破坏滤波器的对齐
+    referenceCursor += samples * static_cast<double>(rate) / sampleRate;
+    if (speaker->isPlaying()) {
+        const double measured = static_cast<double>(speaker->playbackPosition());
+        const double threshold = RESYNC_THRESHOLD_MS * rate / 1000.0;
+        if (!cursorValid || std::abs(measured - referenceCursor) > threshold) {
+            referenceCursor = measured;
+            cursorValid = true;
+        }
+    }
+
+    farScratch.resize(samples);
+    speaker->copyPlaybackReference(static_cast<qint64>(referenceCursor),
+                                   farScratch.data(), samples, sampleRate);
+
+    return processFrame(nearEnd, samples);
+}
+
+QByteArray AecProcessor::process(const QByteArray& nearEnd, const QByteArray& farEnd)
+{
+    if (!enabled || !initialized || nearEnd.isEmpty()) {
+        return nearEnd;
+    }
+
+    const int samples = nearEnd.size() / sizeof(qint16);
+    const int farSamples = farEnd.size() / sizeof(qint16);
+    const qint16* far = reinterpret_cast<const qint16*>(farEnd.constData());
+
+    farScratch.resize(samples);
+    for (int i = 0; i < samples; ++i) {
+        farScratch[i] = i < farSamples ? far[i] : 0.0f;
+    }
+
+    return processFrame(nearEnd, samples);
+}
+
+QByteArray AecProcessor::processFrame(const QByteArray& nearEnd, int samples)
+{
+    const qint16* near = reinterpret_cast<const qint16*>(nearEnd.constData());
+    nearScratch.resize(samples);
+    for (int i = 0; i < samples; ++i) {
+        nearScratch[i] = near[i];
+    }
+
+    outScratch.resize(samples);
+    pushHistory(nearScratch.data(), farScratch.data(), samples);
+    cancelEcho(nearScratch.data(), outScratch.data(), samples);
+
+    QByteArray result(samples * sizeof(qint16), Qt::Uninitialized);
+    qint16* out = reinterpret_cast<qint16*>(result.data());
+    for (int i = 0; i < samples; ++i) {
+        out[i] = static_cast<qint16>(std::clamp(std::lround(outScratch[i]), -32768L, 32767L));
+    }
+    return result;
+}
+
+void AecProcessor::pushHistory(const float* near, const float* far, int samples)
+{
+    // 远端历史需要容纳本帧 + 最大延迟 + 滤波器长度
+    const size_t needed = static_cast<size_t>(samples + maxDelay + tapCount);
+    if (farHistory.size() < needed) {
+        farHistory.insert(farHistory.begin(), needed - farHistory.size(), 0.0f);
+    }
+    std::move(farHistory.begin() + samples, farHistory.end(), farHistory.begin());
+    std::copy(far, far + samples, farHistory.end() - samples);
+
+    // 计算 1ms 包络，整帧统一平移
+    const int bins = samples / envelopeBin;
+    if (bins > 0) {
+        std::move(nearEnvelope.begin() + bins, nearEnvelope.end(), nearEnvelope.begin());
+        std::move(farEnvelope.begin() + bins, farEnvelope.end(), farEnvelope.begin());
+        float* nearTail = nearEnvelope.data() + nearEnvelope.size() - bins;
+        float* farTail = farEnvelope.data() + farEnvelope.size() - bins;
+        for (int b = 0; b < bins; ++b) {
+            float nearSum = 0.0f;
+            float farSum = 0.0f;
+            for (int i = 0; i < envelopeBin; ++i) {
+                nearSum += std::fabs(near[b * envelopeBin + i]);
+                farSum += std::fabs(far[b * envelopeBin + i]);
+            }
+            nearTail[b] = nearSum / envelopeBin;
+            farTail[b] = farSum / envelopeBin;
+        }
+    }
+
+    samplesSinceDelayUpdate += samples;
+    if (samplesSinceDelayUpdate >= sampleRate * DELAY_UPDATE_MS / 1000) {
+        samplesSinceDelayUpdate = 0;
+        updateDelayEstimate();
+    }
+}
+
+void AecProcessor::updateDelayEstimate()
+{
+    const int window = static_cast<int>(nearEnvelope.size());
+    const int lags = MAX_DELAY_MS;
+
+    // 远端没有播放时无法估计
+    const float farPeak = *std::max_element(farEnvelope.begin(), farEnvelope.end());
+    if (farPeak < FAR_ACTIVE_LEVEL) {
+        return;
+    }
+
+    double nearMean = 0.0;
+    for (float v : nearEnvelope) {
+        nearMean += v;
+    }
+    nearMean /= window;
+    double farMean = 0.0;
+    for (float v : farEnvelope) {
+        farMean += v;
+    }
+    farMean /= farEnvelope.size();
+
+    double nearVar = 0.0;
+    for (float v : nearEnvelope) {
+        nearVar += (v - nearMean) * (v - nearMean);
+    }
+    if (nearVar <= 1e-6) {
+        return;
+    }
+
+    double bestScore = 0.0;
+    int bestLag = -1;
+    for (int lag = 0; lag <= lags; ++lag) {
+        const float* farSeg = farEnvelope.data() + lags - lag;
+        double corr = 0.0;
+        double farVar = 0.0;
+        for (int i = 0; i < window; ++i) {
+            const double f = farSeg[i] - farMean;
+            corr += (nearEnvelope[i] - nearMean) * f;
+            farVar += f * f;
+        }
+        const double score = corr / std::sqrt(nearVar * farVar + 1e-9);
+        if (score > bestScore) {
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+
+    if (bestLag < 0 || bestScore < 0.5) {
+        return;
+    }
+
+    // 预留 2ms 余量给非因果的回声扩散
+    const int candidate = qMax(0, (bestLag - 2) * envelopeBin);
+    const bool confirmed = candidateDelay >= 0 &&
+                           std::abs(candidate - candidateDelay) <= 2 * envelopeBin;
+    candidateDelay = candidate;
+
+    if (confirmed && std::abs(candidate - delay) > 2 * envelopeBin) {
+        qDebug() << "AEC回声延迟更新:" << delay * 1000 / sampleRate << "->"
+                 << candidate * 1000 / sampleRate << "ms, 相关系数:" << bestScore;
+        applyDelayChange(candidate);
+    }
+}
+
+void AecProcessor::applyDelayChange(int newDelay)
+{
+    // weights[tapCount-1-k] 对应延迟 delay+k，平移系数以保留已收敛的回声路径
+    const int shift = newDelay - delay;
+    std::vector<float> shifted(tapCount, 0.0f);
+    for (int i = 0; i < tapCount; ++i) {
+        const int src = i - shift;
+        if (src >= 0 && src < tapCount) {
+            shifted[i] = weights[src];
+        }
+    }
+    weights.swap(shifted);
+    delay = newDelay;
+}
+
+void AecProcessor::cancelEcho(const float* near, float* out, int samples)
+{
+    const int history = static_cast<int>(farHistory.size());
+    const int block = qMax(1, sampleRate / 100);
+    const int holdSamples = sampleRate * DOUBLE_TALK_HOLD_MS / 1000;
+    const float eps = tapCount * 100.0f;
+    float* w = weights.data();
+
+    double nearEnergy = 0.0;
+    double outEnergy = 0.0;
+    bool farActive = false;
+
+    for (int start = 0; start < samples; start += block) {
+        const int end = qMin(samples, start + block);
+        // 本块第一个采样对应的参考窗口起点（窗口按时间正序，长度 tapCount）
+        const int base = history - samples - delay - (tapCount - 1);
+
+        float farMax = 0.0f;
+        for (int i = base + start; i < base + end + tapCount - 1; ++i) {
+            farMax = qMax(farMax, std::fabs(farHistory[i]));
+        }
+        float nearMax = 0.0f;
+        for (int n = start; n < end; ++n) {
+            nearMax = qMax(nearMax, std::fabs(near[n]));
+        }
+
+        // Geigel 双讲检测：近端明显强于远端时冻结自适应
+        const bool blockFarActive = farMax > FAR_ACTIVE_LEVEL;
+        if (blockFarActive && nearMax > GEIGEL_THRESHOLD * farMax) {
+            doubleTalkHold = holdSamples;
+        }
+        const bool adapt = blockFarActive && doubleTalkHold <= 0;
+        farActive = farActive || blockFarActive;
+
+        const float* x = farHistory.data() + base + start;
+        double power = 0.0;
+        for (int j = 0; j < tapCount; ++j) {
+            power += x[j] * x[j];
+        }
+
+        double blockNear = 0.0;
+        double blockOut = 0.0;
+        for (int n = start; n < end; ++n) {
+            x = farHistory.data() + base + n;
+
+            float y = 0.0f;
+            for (int j = 0; j < tapCount; ++j) {
+                y += w[j] * x[j];
+            }
+            const float e = near[n] - y;
+            out[n] = e;
+            blockNear += near[n] * near[n];
+            blockOut += e * e;
+
+            if (adapt) {
+                const float g = STEP_SIZE * e / static_cast<float>(power + eps);
+                for (int j = 0; j < tapCount; ++j) {
+                    w[j] += g * x[j];
+                }
+            }
+
+            // 滑动更新参考能量
+            if (n + 1 < end) {
+                power += x[tapCount] * x[tapCount] - x[0] * x[0];
+                if (power < 0.0) {
+                    power = 0.0;
+                }
+            }
+        }
+
+        // 发散保护：输出能量远大于输入时重置滤波器
+        if (blockOut > 4.0 * blockNear + 1e3) {
+            qDebug() << "AEC滤波器发散，重置";
+            std::fill(weights.begin(), weights.end(), 0.0f);
+            std::copy(near + start, near + end, out + start);
+            blockOut = blockNear;
+        }
+
+        doubleTalkHold = qMax(0, doubleTalkHold - (end - start));
+        nearEnergy += blockNear;
+        outEnergy += blockOut;
+    }
+
+    if (farActive && doubleTalkHold <= 0 && nearEnergy > 0.0) {
+        const double instant = 10.0 * std::log10((nearEnergy + 1.0) / (outEnergy + 1.0));
+        erle = 0.9 * erle + 0.1 * instant;
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef AEC_PROCESSOR_H
+#define AEC_PROCESSOR_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QPointer>
+#include <vector>
+
+class SpeakerManager;
+
+// 回声消除：以扬声器播放环形缓冲区为远端参考，
+// 先用包络互相关估计回声延迟，再用 NLMS 自适应滤波消除线性回声
+class AecProcessor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AecProcessor(QObject *parent = nullptr);
+    ~AecProcessor();
+
+    // 初始化，tailMs 为延迟补偿之后的回声尾长
+    bool initialize(int sampleRate, int tailMs = 64);
+
+    // 设置远端参考信号来源
+    void setReferenceSource(SpeakerManager* speaker);
+
+    // 在线处理：参考信号从 SpeakerManager 的播放环形缓冲区读取
+    QByteArray process(const QByteArray& nearEnd);
+
+    // 离线处理：近端与远端参考逐帧对齐给出（同采样率、同长度）
+    QByteArray process(const QByteArray& nearEnd, const QByteArray& farEnd);
+
+    // 清空滤波器和延迟估计状态
+    void reset();
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+
+    // 当前估计的回声延迟（毫秒）
+    int estimatedDelayMs() const;
+
+    // 远端有声时的回声损耗增强（ERLE，dB）
+    double erleDb() const { return erle; }
+
+private:
+    QByteArray processFrame(const QByteArray& nearEnd, int samples);
+    void pushHistory(const float* near, const float* far, int samples);
+    void updateDelayEstimate();
+    void applyDelayChange(int newDelay);
+    void cancelEcho(const float* near, float* out, int samples);
+
+private:
+    QPointer<SpeakerManager> speaker;
+    bool enabled;
+    bool initialized;
+
+    int sampleRate;
+    int tapCount;       // 自适应滤波器阶数
+    int maxDelay;       // 最大可估计延迟（采样点）
+    int delay;          // 当前回声延迟（采样点）
+    int candidateDelay; // 待确认的延迟候选
+
+    // 远端参考历史，末尾为最新采样（延迟为 0）
+    std::vector<float> farHistory;
+    std::vector<float> weights;     // 按时间正序存放，weights[tapCount-1] 对应延迟 delay
+    std::vector<float> nearScratch;
+    std::vector<float> farScratch;
+    std::vector<float> outScratch;
+
+    // 延迟估计用的 1ms 包络
+    int envelopeBin;               // 每个包络点的采样数
+    std::vector<float> nearEnvelope;
+    std::vector<float> farEnvelope;
+    int samplesSinceDelayUpdate;
+
+    // 播放位置跟踪（扬声器采样点）
+    double referenceCursor;
+    bool cursorValid;
+    int referenceRate;
+
+    int doubleTalkHold;  // 双讲保持剩余采样数
+    double erle;
+
+    static constexpr int MAX_DELAY_MS = 320;
+    static constexpr int DELAY_WINDOW_MS = 1000;
+    static constexpr int DELAY_UPDATE_MS = 500;
+    static constexpr int RESYNC_THRESHOLD_MS = 40;
+    static constexpr int DOUBLE_TALK_HOLD_MS = 30;
+    static constexpr float STEP_SIZE = 0.5f;
+    static constexpr float GEIGEL_THRESHOLD = 1.0f;   // 假设回声路径增益不超过 0dB
+    static constexpr float FAR_ACTIVE_LEVEL = 64.0f;  // 远端有声的幅度门限
+};
+
+#endif // AEC_PROCESSOR_H
@@ -0,0 +1,47 @@
+#include "aes_ctr.h"
+#include <openssl/evp.h>
+#include <QDebug>
+
+AesCtr::AesCtr()
+    : ctx(EVP_CIPHER_CTX_new())
+    , keyed(false)
+{
+}
+
+AesCtr::~AesCtr()
+{
+    EVP_CIPHER_CTX_free(ctx);
+}
+
+bool AesCtr::setKey(const QByteArray& key)
+{
+    keyed = false;
+    if (!ctx || key.size() != KEY_SIZE) {
+        qDebug() << "AES 密钥长度错误:" << key.size();
+        return false;
+    }
+    if (EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), nullptr,
+                           reinterpret_cast<const uchar*>(key.constData()), nullptr) != 1) {
+        qDebug() << "AES 初始化失败";
+        return false;
+    }
+    keyed = true;
+    return true;
+}
+
+bool AesCtr::apply(const uchar* iv, const char* in, int size, char* out)
+{
+    if (!keyed) {
+        return false;
+    }
+    // 只替换计数器块，保留已展开的密钥
+    if (EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv) != 1) {
+        return false;
+    }
+    int written = 0;
+    if (EVP_EncryptUpdate(ctx, reinterpret_cast<uchar*>(out), &written,
+                          reinterpret_cast<const uchar*>(in), size) != 1) {
+        return false;
+    }
+    return written == size;
+}
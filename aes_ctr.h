@@ -0,0 +1,36 @@
+#ifndef AES_CTR_H
+#define AES_CTR_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+struct evp_cipher_ctx_st;
+
+// AES-128-CTR（OpenSSL EVP）。加密和解密是同一个操作。
+// 密钥只设置一次，每个包只重新设置 16 字节的初始计数器块（即包头 nonce），
+// 复用同一个上下文，不在每包分配内存
+class AesCtr
+{
+public:
+    AesCtr();
+    ~AesCtr();
+
+    AesCtr(const AesCtr&) = delete;
+    AesCtr& operator=(const AesCtr&) = delete;
+
+    // key 必须为 16 字节
+    bool setKey(const QByteArray& key);
+    bool isValid() const { return keyed; }
+
+    // 用 iv（16 字节）作为初始计数器处理 size 字节，out 至少 size 字节，可以与 in 相同
+    bool apply(const uchar* iv, const char* in, int size, char* out);
+
+    static constexpr int KEY_SIZE = 16;
+    static constexpr int IV_SIZE = 16;
+
+private:
+    evp_cipher_ctx_st* ctx;
+    bool keyed;
+};
+
+#endif // AES_CTR_H
@@ -0,0 +1,27 @@
+#include "audio_backlog.h"
+
+AudioBacklog::AudioBacklog(int maxLagMs)
+    : maxLag(maxLagMs)
+{
+}
+
+int AudioBacklog::push(const QByteArray& data, Clock::time_point now)
+{
+    chunks.enqueue({data, now, false});
+    return shed(now);
+}
+
+int AudioBacklog::shed(Clock::time_point now)
+{
+    if (maxLag <= 0 || chunks.size() < 2
+        || now - chunks.head().enqueued <= std::chrono::milliseconds(maxLag)) {
+        return 0;
+    }
+
+    const int dropped = chunks.size() - 1;
+    Chunk newest = chunks.takeLast();
+    chunks.clear();
+    newest.discontinuity = true;
+    chunks.enqueue(newest);
+    return dropped;
+}
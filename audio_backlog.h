@@ -0,0 +1,46 @@
+#ifndef AUDIO_BACKLOG_H
+#define AUDIO_BACKLOG_H
+
+#include <QByteArray>
+#include <QQueue>
+#include <chrono>
+
+// 唤醒词检测的音频积压。每块音频记下入队时间，最早一块等待超过 maxLagMs 时
+// 只保留最新的一块：识别跟不上实时的时候，迟到几秒的唤醒不如跳过一段音频。
+// 保留的那一块标记为不连续，识别器处理它之前需要重置。
+// 本身不加锁，由调用方保护；时间由调用方传入
+class AudioBacklog
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Chunk {
+        QByteArray data;
+        Clock::time_point enqueued;
+        bool discontinuity = false;   // 前面的音频被丢弃过
+    };
+
+    // maxLagMs <= 0 时不限制
+    explicit AudioBacklog(int maxLagMs);
+
+    void setMaxLagMs(int ms) { maxLag = ms; }
+    int maxLagMs() const { return maxLag; }
+
+    // 入队，返回因积压丢弃的块数
+    int push(const QByteArray& data, Clock::time_point now);
+
+    // 最早一块等待超过上限时丢弃除最新一块以外的全部，返回丢弃的块数
+    int shed(Clock::time_point now);
+
+    // 取出最早的一块，队列不能为空
+    Chunk takeFirst() { return chunks.dequeue(); }
+
+    bool isEmpty() const { return chunks.isEmpty(); }
+    int size() const { return chunks.size(); }
+
+private:
+    QQueue<Chunk> chunks;
+    int maxLag;
+};
+
+#endif // AUDIO_BACKLOG_H
@@ -0,0 +1,552 @@
+#include "audio_engine.h"
+#include "microphone_manager.h"
+#include "speaker_manager.h"
+#include "opus_encoder.h"
+#include "opus_decoder.h"
+#include "aec_processor.h"
+#include "wake_word_detector.h"
+#include "vad_processor.h"
+#include "local_asr.h"
+#include <QDebug>
+#include <QMetaObject>
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+AudioEngine::Options AudioEngine::Options::fromEnvironment()
+{
+    Options options;
+    bool ok = false;
+
+    options.realtimePriority = qEnvironmentVariableIntValue("XIAOZHI_AUDIO_RT") != 0;
+    int niceValue = qEnvironmentVariableIntValue("XIAOZHI_AUDIO_NICE", &ok);
+    if (ok) {
+        options.niceValue = niceValue;
+    }
+    int cpuCore = qEnvironmentVariableIntValue("XIAOZHI_AUDIO_CPU", &ok);
+    if (ok) {
+        options.cpuCore = cpuCore;
+    }
+    return options;
+}
+
+AudioEngine::AudioEngine(QObject *parent)
+    : QObject(nullptr)  // 需要移动到音频线程，不能有父对象
+    , running(false)
+    , micManager(nullptr)
+    , speakerManager(nullptr)
+    , opusEncoder(nullptr)
+    , opusDecoder(nullptr)
+    , aecProcessor(nullptr)
+    , wakeWordDetector(nullptr)
+    , vadProcessor(nullptr)
+    , localAsr(nullptr)
+    , uploading(false)
+    , fullDuplex(false)
+    , bargeInNs(0)
+    , awaitingSilence(false)
+    , awaitingUpload(false)
+    , downlinkFrameMs(60)
+    , downlinkTimed(false)
+    , expectedDownlinkTs(0)
+    , downlinkPool(4096, BufferPool::MAX_BUFFERS)
+    , inboxPending(false)
+    , downlinkPending(false)
+    , uplinkPending(false)
+    , eventPending(false)
+    , captureRequested(false)
+    , dropped(0)
+    , concealed(0)
+    , late(0)
+{
+    Q_UNUSED(parent);
+    clock.start();
+    thread.setObjectName("xiaozhi-audio");
+    moveToThread(&thread);
+}
+
+AudioEngine::~AudioEngine()
+{
+    stop();
+}
+
+bool AudioEngine::start(const Options& options, int sampleRate, int channels, int frameDuration)
+{
+    if (running) {
+        return true;
+    }
+
+    thread.start();
+    running = true;
+
+    // 设备对象必须在音频线程中创建，这样它们的信号槽都在音频线程执行
+    QMetaObject::invokeMethod(this, [=]() {
+        setupInThread(options, sampleRate, channels, frameDuration);
+    }, Qt::BlockingQueuedConnection);
+
+    return micManager && speakerManager;
+}
+
+void AudioEngine::stop()
+{
+    if (!running) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(this, [this]() {
+        teardownInThread();
+    }, Qt::BlockingQueuedConnection);
+
+    thread.quit();
+    thread.wait();
+    running = false;
+}
+
+void AudioEngine::setupInThread(const Options& options, int sampleRate, int channels, int frameDuration)
+{
+    applyThreadOptions(options);
+
+    micManager = new MicrophoneManager(nullptr);
+    speakerManager = new SpeakerManager(nullptr);
+    opusEncoder = new OpusEncoder(nullptr);
+    opusDecoder = new OpusDecoder(nullptr);
+
+    micManager->configureAudioParams(sampleRate, channels);
+    speakerManager->configureAudioParams(sampleRate, channels);
+    opusEncoder->initialize(sampleRate, channels, frameDuration);
+    opusDecoder->initialize(sampleRate, channels, frameDuration);
+    downlinkFrameMs = frameDuration > 0 ? frameDuration : 60;
+
+    // 初始化回声消除，远端参考取自扬声器播放环形缓冲区
+    aecProcessor = new AecProcessor(nullptr);
+    aecProcessor->initialize(sampleRate);
+    aecProcessor->setReferenceSource(speakerManager);
+
+    // 同一线程内直接连接，采集到的数据不经过事件队列
+    connect(micManager, &MicrophoneManager::pcmDataReady,
+            this, &AudioEngine::onPcmCaptured, Qt::DirectConnection);
+    connect(speakerManager, &SpeakerManager::playbackIdle,
+            this, &AudioEngine::onPlaybackIdle, Qt::DirectConnection);
+
+    // 音频设备热插拔
+    connect(micManager, &MicrophoneManager::deviceSwitched,
+            this, [this](const QString& name, qint64 latencyMs) {
+        pushEvent(EventType::MicrophoneSwitched, latencyMs, name);
+    });
+    connect(micManager, &MicrophoneManager::captureFailed,
+            this, [this](const QString& reason) {
+        // 录音中设备失效且无法迁移，与启动失败一样由 GUI 线程结束本轮
+        captureRequested.store(false, std::memory_order_relaxed);
+        pushEvent(EventType::CaptureFailed, 0, reason);
+    });
+    connect(speakerManager, &SpeakerManager::deviceSwitched,
+            this, [this](const QString& name, qint64 latencyMs) {
+        // 回声路径变了，重新收敛
+        aecProcessor->reset();
+        pushEvent(EventType::SpeakerSwitched, latencyMs, name);
+    });
+
+    qDebug() << "音频线程初始化完成";
+}
+
+void AudioEngine::teardownInThread()
+{
+    if (micManager) {
+        micManager->stopRecording();
+    }
+
+    delete micManager;
+    delete speakerManager;
+    delete opusEncoder;
+    delete opusDecoder;
+    delete aecProcessor;
+    micManager = nullptr;
+    speakerManager = nullptr;
+    opusEncoder = nullptr;
+    opusDecoder = nullptr;
+    aecProcessor = nullptr;
+
+    speechPreRoll.clear();
+    qDebug() << "音频线程已释放设备";
+}
+
+void AudioEngine::applyThreadOptions(const Options& options)
+{
+#ifdef Q_OS_LINUX
+    if (options.realtimePriority) {
+        sched_param param{};
+        param.sched_priority = options.fifoPriority;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (rc == 0) {
+            qDebug() << "音频线程使用 SCHED_FIFO，优先级:" << options.fifoPriority;
+        } else {
+            // 没有 CAP_SYS_NICE 或 rtprio 限制时回退到 nice
+            qDebug() << "设置 SCHED_FIFO 失败:" << strerror(rc) << "，改用 nice:" << options.niceValue;
+            pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+            if (setpriority(PRIO_PROCESS, tid, options.niceValue) != 0) {
+                qDebug() << "设置 nice 失败:" << strerror(errno);
+            }
+        }
+    }
+
+    if (options.cpuCore >= 0) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(options.cpuCore, &cpuSet);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        if (rc == 0) {
+            qDebug() << "音频线程绑定到 CPU" << options.cpuCore;
+        } else {
+            qDebug() << "绑定 CPU 失败:" << strerror(rc);
+        }
+    }
+#else
+    if (options.realtimePriority) {
+        QThread::currentThread()->setPriority(QThread::TimeCriticalPriority);
+    }
+    if (options.cpuCore >= 0) {
+        qDebug() << "当前平台不支持绑定 CPU，忽略";
+    }
+#endif
+}
+
+bool AudioEngine::postControl(Control control)
+{
+    control.issuedNs = clock.nsecsElapsed();
+    if (!inbox.push(std::move(control))) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        qDebug() << "音频线程命令队列已满，丢弃";
+        return false;
+    }
+
+    // 音频线程取空队列之前只投递一次
+    if (!inboxPending.exchange(true)) {
+        QMetaObject::invokeMethod(this, &AudioEngine::drainInbox, Qt::QueuedConnection);
+    }
+    return true;
+}
+
+void AudioEngine::startCapture()
+{
+    captureRequested.store(true, std::memory_order_relaxed);
+    Control control;
+    control.type = ControlType::StartCapture;
+    postControl(std::move(control));
+}
+
+void AudioEngine::stopCapture()
+{
+    captureRequested.store(false, std::memory_order_relaxed);
+    Control control;
+    control.type = ControlType::StopCapture;
+    postControl(std::move(control));
+}
+
+void AudioEngine::setUploading(bool enabled)
+{
+    Control control;
+    control.type = ControlType::SetUploading;
+    control.enabled = enabled;
+    postControl(std::move(control));
+}
+
+void AudioEngine::setFullDuplex(bool enabled)
+{
+    Control control;
+    control.type = ControlType::SetFullDuplex;
+    control.enabled = enabled;
+    postControl(std::move(control));
+}
+
+void AudioEngine::configurePlayback(int sampleRate, int channels, int frameDuration)
+{
+    Control control;
+    control.type = ControlType::ConfigurePlayback;
+    control.sampleRate = sampleRate;
+    control.channels = channels;
+    control.frameDuration = frameDuration;
+    postControl(std::move(control));
+}
+
+void AudioEngine::stopPlayback()
+{
+    Control control;
+    control.type = ControlType::StopPlayback;
+    postControl(std::move(control));
+}
+
+void AudioEngine::bargeIn(int fadeMs)
+{
+    Control control;
+    control.type = ControlType::BargeIn;
+    control.fadeMs = fadeMs;
+    postControl(std::move(control));
+}
+
+bool AudioEngine::pushDownlink(const QByteArray& opusData, qint64 timestamp)
+{
+    DownlinkPacket packet;
+    packet.timestamp = timestamp;
+    // opusData 可能直接指向网络帧，复制到缓冲池中复用的内存
+    packet.payload = downlinkPool.acquire(opusData.size());
+    memcpy(packet.payload.data(), opusData.constData(), opusData.size());
+    if (!downlink.push(std::move(packet))) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (!downlinkPending.exchange(true)) {
+        QMetaObject::invokeMethod(this, &AudioEngine::drainDownlink, Qt::QueuedConnection);
+    }
+    return true;
+}
+
+int AudioEngine::drainUplink(const std::function<void(const QByteArray&)>& handler)
+{
+    // 先清除标志再取数据，取数据期间新到的数据会重新发出信号
+    uplinkPending.store(false);
+    int count = 0;
+    QByteArray packet;
+    while (uplink.pop(packet)) {
+        handler(packet);
+        ++count;
+    }
+    return count;
+}
+
+int AudioEngine::drainEvents(const std::function<void(const Event&)>& handler)
+{
+    eventPending.store(false);
+    int count = 0;
+    Event event;
+    while (events.pop(event)) {
+        handler(event);
+        ++count;
+    }
+    return count;
+}
+
+int AudioEngine::underrunCount() const
+{
+    return speakerManager ? speakerManager->underrunCount() : 0;
+}
+
+void AudioEngine::drainInbox()
+{
+    inboxPending.store(false);
+    Control control;
+    while (inbox.pop(control)) {
+        handleControl(control);
+    }
+}
+
+void AudioEngine::drainDownlink()
+{
+    downlinkPending.store(false);
+    DownlinkPacket packet;
+    while (downlink.pop(packet)) {
+        if (!speakerManager) {
+            downlinkPool.release(std::move(packet.payload));
+            continue;
+        }
+        playDownlink(packet);
+    }
+}
+
+void AudioEngine::discardDownlink()
+{
+    // 停止播放前已经排队的下行包属于被打断的 TTS，不再播放
+    DownlinkPacket packet;
+    while (downlink.pop(packet)) {
+        downlinkPool.release(std::move(packet.payload));
+    }
+}
+
+void AudioEngine::handleControl(const Control& control)
+{
+    if (!micManager || !speakerManager) {
+        return;
+    }
+
+    switch (control.type) {
+        case ControlType::StartCapture:
+            if (!micManager->startRecording()) {
+                captureRequested.store(false, std::memory_order_relaxed);
+                pushEvent(EventType::CaptureFailed);
+            }
+            break;
+        case ControlType::StopCapture:
+            micManager->stopRecording();
+            speechPreRoll.clear();
+            break;
+        case ControlType::SetUploading:
+            uploading = control.enabled;
+            if (!uploading) {
+                speechPreRoll.clear();
+            }
+            break;
+        case ControlType::SetFullDuplex:
+            fullDuplex = control.enabled;
+            speechPreRoll.clear();
+            break;
+        case ControlType::ConfigurePlayback:
+            // 只更新解码器和扬声器的参数，保持麦克风配置不变
+            speakerManager->configureAudioParams(control.sampleRate, control.channels);
+            opusDecoder->initialize(control.sampleRate, control.channels, control.frameDuration);
+            downlinkFrameMs = control.frameDuration > 0 ? control.frameDuration : 60;
+            resetDownlinkTiming();
+            break;
+        case ControlType::StopPlayback:
+            speakerManager->stopPlaying();
+            discardDownlink();
+            resetDownlinkTiming();
+            break;
+        case ControlType::BargeIn:
+            // 计时从 GUI 线程发出命令时算起
+            bargeInNs = control.issuedNs;
+            awaitingSilence = true;
+            awaitingUpload = true;
+            speakerManager->stopWithFade(control.fadeMs);
+            discardDownlink();
+            resetDownlinkTiming();
+
+            // 立即开始上传，并补发打断前缓存的语音
+            uploading = true;
+            while (!speechPreRoll.isEmpty()) {
+                encodeAndPush(speechPreRoll.dequeue());
+            }
+            break;
+    }
+}
+
+void AudioEngine::resetDownlinkTiming()
+{
+    downlinkTimed = false;
+    expectedDownlinkTs = 0;
+}
+
+void AudioEngine::playDownlink(DownlinkPacket& packet)
+{
+    if (packet.timestamp >= 0) {
+        if (downlinkTimed) {
+            const qint64 gap = packet.timestamp - expectedDownlinkTs;
+            if (gap < 0 && gap > -LATE_WINDOW_MS) {
+                // 比已播放位置更早的包，播放它只会让声音倒退
+                late.fetch_add(1, std::memory_order_relaxed);
+                downlinkPool.release(std::move(packet.payload));
+                return;
+            }
+            // 少量缺帧用解码器的丢包补偿填充，间隔过大视为新的一句
+            const qint64 missing = gap / downlinkFrameMs;
+            if (missing > 0 && missing <= MAX_CONCEALED_FRAMES) {
+                for (qint64 i = 0; i < missing; ++i) {
+                    QByteArray filler = opusDecoder->decodeLost();
+                    if (!filler.isEmpty()) {
+                        speakerManager->playPCM(filler);
+                    }
+                }
+                concealed.fetch_add(static_cast<int>(missing), std::memory_order_relaxed);
+            }
+        }
+        downlinkTimed = true;
+        expectedDownlinkTs = packet.timestamp + downlinkFrameMs;
+    }
+
+    QByteArray pcmData = opusDecoder->decode(packet.payload);
+    downlinkPool.release(std::move(packet.payload));
+    if (!pcmData.isEmpty()) {
+        speakerManager->playPCM(pcmData);
+    }
+}
+
+void AudioEngine::onPcmCaptured(const QByteArray& rawPcmData)
+{
+    // 回声消除放在编码器/VAD/唤醒词之前
+    const QByteArray pcmData = aecProcessor ? aecProcessor->process(rawPcmData) : rawPcmData;
+
+    // 发送数据到唤醒词检测器
+    if (wakeWordDetector) {
+        wakeWordDetector->processAudioData(pcmData);
+    }
+
+    // 全双工下 VAD 持续运行，TTS 播放期间用于检测打断；
+    // 半双工下只在监听（上传）期间运行，用于本地断句
+    if (!fullDuplex && !uploading) {
+        return;
+    }
+
+    if (vadProcessor) {
+        vadProcessor->processAudioData(pcmData);
+    }
+
+    if (!uploading) {
+        // 未上传时保留最近几帧，打断时补发，避免丢掉句首
+        speechPreRoll.enqueue(pcmData);
+        while (speechPreRoll.size() > PRE_ROLL_FRAMES) {
+            speechPreRoll.dequeue();
+        }
+        return;
+    }
+
+    // 监听期间的音频同时送本地识别
+    if (localAsr) {
+        localAsr->processAudioData(pcmData);
+    }
+
+    encodeAndPush(pcmData);
+}
+
+void AudioEngine::encodeAndPush(const QByteArray& pcmData)
+{
+    QByteArray opusData = opusEncoder->encode(pcmData);
+    if (opusData.isEmpty()) {
+        qDebug() << "Opus编码失败";
+        return;
+    }
+
+    if (!uplink.push(std::move(opusData))) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (awaitingUpload) {
+        awaitingUpload = false;
+        pushEvent(EventType::BargeInUpload, (clock.nsecsElapsed() - bargeInNs) / 1000000);
+    }
+
+    if (!uplinkPending.exchange(true)) {
+        emit uplinkReady();
+    }
+}
+
+void AudioEngine::pushEvent(EventType type, qint64 value, const QString& text)
+{
+    Event event;
+    event.type = type;
+    event.value = value;
+    event.text = text;
+    if (!events.push(std::move(event))) {
+        qDebug() << "音频线程事件队列已满，丢弃事件";
+        return;
+    }
+
+    if (!eventPending.exchange(true)) {
+        emit eventReady();
+    }
+}
+
+void AudioEngine::onPlaybackIdle()
+{
+    if (awaitingSilence) {
+        awaitingSilence = false;
+        pushEvent(EventType::BargeInSilence, (clock.nsecsElapsed() - bargeInNs) / 1000000);
+    }
+}
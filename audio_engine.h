@@ -0,0 +1,189 @@
+#ifndef AUDIO_ENGINE_H
+#define AUDIO_ENGINE_H
+
+#include <QObject>
+#include <QThread>
+#include <QByteArray>
+#include <QQueue>
+#include <QElapsedTimer>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include "spsc_queue.h"
+#include "buffer_pool.h"
+
+class MicrophoneManager;
+class SpeakerManager;
+class OpusEncoder;
+class OpusDecoder;
+class AecProcessor;
+class WakeWordDetector;
+class VadProcessor;
+class LocalAsr;
+
+// 音频线程：采集、播放、回声消除和编解码都在这个线程中完成，不经过 GUI 线程。
+// GUI 线程只通过无锁队列发送控制命令/下行音频，并从无锁队列取出上行音频和事件。
+class AudioEngine : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options {
+        bool realtimePriority = false;  // 尝试使用 SCHED_FIFO
+        int fifoPriority = 10;          // SCHED_FIFO 优先级
+        int niceValue = -10;            // SCHED_FIFO 不可用时回退到 nice
+        int cpuCore = -1;               // 绑定的 CPU 核，-1 表示不绑定
+
+        // 从环境变量读取：XIAOZHI_AUDIO_RT、XIAOZHI_AUDIO_NICE、XIAOZHI_AUDIO_CPU
+        static Options fromEnvironment();
+    };
+
+    enum class EventType {
+        CaptureFailed,        // text: 原因，启动录音失败时为空
+        BargeInSilence,       // value: 打断到播放静音的延迟（毫秒）
+        BargeInUpload,        // value: 打断到首帧上行的延迟（毫秒）
+        MicrophoneSwitched,   // text: 设备名，value: 切换耗时（毫秒）
+        SpeakerSwitched
+    };
+
+    struct Event {
+        EventType type = EventType::CaptureFailed;
+        qint64 value = 0;
+        QString text;
+    };
+
+    explicit AudioEngine(QObject *parent = nullptr);
+    ~AudioEngine();
+
+    // 以下几个需要在 start() 之前设置，对象本身是线程安全的
+    void setWakeWordDetector(WakeWordDetector* detector) { wakeWordDetector = detector; }
+    void setVadProcessor(VadProcessor* processor) { vadProcessor = processor; }
+    void setLocalAsr(LocalAsr* asr) { localAsr = asr; }
+
+    // 启动音频线程并在线程内创建设备和编解码器，返回时已初始化完成
+    bool start(const Options& options, int sampleRate, int channels, int frameDuration);
+    void stop();
+
+    // 控制命令（GUI 线程调用，异步执行）
+    void startCapture();
+    void stopCapture();
+    void setUploading(bool enabled);
+    void setFullDuplex(bool enabled);
+    void configurePlayback(int sampleRate, int channels, int frameDuration);
+    void stopPlayback();
+    void bargeIn(int fadeMs = 30);
+
+    // 下行 Opus 数据，队列满时返回 false。opusData 会被复制到缓冲池，
+    // 调用返回后即可释放；timestamp 为包时间戳（毫秒），没有时传 -1。
+    // 下行数据单独排队，可以直接在网络线程中调用，但始终只能由同一个线程调用
+    bool pushDownlink(const QByteArray& opusData, qint64 timestamp = -1);
+
+    // 取出所有上行 Opus 数据 / 事件（GUI 线程在收到对应信号后调用）
+    int drainUplink(const std::function<void(const QByteArray&)>& handler);
+    int drainEvents(const std::function<void(const Event&)>& handler);
+
+    // 已请求开始采集（命令可能尚未执行）
+    bool isCapturing() const { return captureRequested.load(std::memory_order_relaxed); }
+
+    // 统计：播放缓冲区播空次数、因队列满而丢弃的包数
+    int underrunCount() const;
+    int droppedPackets() const { return dropped.load(std::memory_order_relaxed); }
+    // 统计：按时间戳补偿（PLC）的帧数、迟到丢弃的包数
+    int concealedFrames() const { return concealed.load(std::memory_order_relaxed); }
+    int lateFrames() const { return late.load(std::memory_order_relaxed); }
+
+signals:
+    // 有新的上行数据/事件，每次取空之前只发出一次
+    void uplinkReady();
+    void eventReady();
+
+private:
+    enum class ControlType {
+        StartCapture,
+        StopCapture,
+        SetUploading,
+        SetFullDuplex,
+        ConfigurePlayback,
+        StopPlayback,
+        BargeIn
+    };
+
+    struct Control {
+        ControlType type = ControlType::StopPlayback;
+        int sampleRate = 0;
+        int channels = 0;
+        int frameDuration = 0;
+        int fadeMs = 0;
+        bool enabled = false;
+        qint64 issuedNs = 0;   // 命令发出时刻，用于跨线程延迟统计
+    };
+
+    struct DownlinkPacket {
+        QByteArray payload;
+        qint64 timestamp = -1; // 包时间戳（毫秒）
+    };
+
+    // GUI 线程
+    bool postControl(Control control);
+
+    // 音频线程
+    void setupInThread(const Options& options, int sampleRate, int channels, int frameDuration);
+    void teardownInThread();
+    void applyThreadOptions(const Options& options);
+    void drainInbox();
+    void handleControl(const Control& control);
+    void drainDownlink();
+    void discardDownlink();
+    void playDownlink(DownlinkPacket& packet);
+    void resetDownlinkTiming();
+    void onPcmCaptured(const QByteArray& rawPcmData);
+    void encodeAndPush(const QByteArray& pcmData);
+    void pushEvent(EventType type, qint64 value = 0, const QString& text = QString());
+    void onPlaybackIdle();
+
+    QThread thread;
+    bool running;
+    QElapsedTimer clock;   // 两个线程共用的单调时钟
+
+    // 以下对象只在音频线程中创建和使用
+    MicrophoneManager* micManager;
+    SpeakerManager* speakerManager;
+    OpusEncoder* opusEncoder;
+    OpusDecoder* opusDecoder;
+    AecProcessor* aecProcessor;
+    WakeWordDetector* wakeWordDetector;
+    VadProcessor* vadProcessor;
+    LocalAsr* localAsr;
+
+    bool uploading;
+    bool fullDuplex;
+    QQueue<QByteArray> speechPreRoll;  // 未上传时保留的最近几帧，打断后补发
+    static constexpr int PRE_ROLL_FRAMES = 4;
+    qint64 bargeInNs;
+    bool awaitingSilence;              // 等待打断后的播放静音
+    bool awaitingUpload;               // 等待打断后的首帧上传
+
+    // 下行时间戳跟踪：缺帧时用解码器补偿，迟到的包丢弃
+    int downlinkFrameMs;
+    bool downlinkTimed;
+    qint64 expectedDownlinkTs;
+    static constexpr int MAX_CONCEALED_FRAMES = 3;
+    static constexpr qint64 LATE_WINDOW_MS = 1000;
+    BufferPool downlinkPool;   // pushDownlink 的线程取用，音频线程归还（无锁）
+
+    // 跨线程队列：inbox 由 GUI 线程写入，downlink 由下行数据的生产者（通常是网络线程）写入，
+    // uplink/events 由音频线程写入
+    SpscQueue<Control, 512> inbox;
+    SpscQueue<DownlinkPacket, 256> downlink;
+    SpscQueue<QByteArray, 256> uplink;
+    SpscQueue<Event, 64> events;
+    std::atomic<bool> inboxPending;
+    std::atomic<bool> downlinkPending;
+    std::atomic<bool> uplinkPending;
+    std::atomic<bool> eventPending;
+    std::atomic<bool> captureRequested;
+    std::atomic<int> dropped;
+    std::atomic<int> concealed;
+    std::atomic<int> late;
+};
+
+#endif // AUDIO_ENGINE_H
@@ -0,0 +1,147 @@
+#include "audio_file.h"
+#include <QFile>
+#include <QFileInfo>
+#include <ogg/ogg.h>
+#include <opus/opus.h>
+#include <cstring>
+#include <vector>
+
+namespace {
+constexpr int OPUS_RATE = 48000;                 // OpusHead 的 pre-skip 和 granulepos 以 48kHz 计
+constexpr int MAX_FRAME_SAMPLES = 16000 * 120 / 1000;  // 一个包最长 120ms
+
+int readLe16(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8);
+}
+}
+
+namespace AudioFile {
+
+bool isSupported(const QString& path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "pcm" || suffix == "raw" || suffix == "ogg" || suffix == "opus";
+}
+
+bool read(const QString& path, QByteArray* pcm, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = "无法打开文件";
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "pcm" || suffix == "raw") {
+        *pcm = data;
+        pcm->truncate(pcm->size() / 2 * 2);
+        return true;
+    }
+    if (suffix == "ogg" || suffix == "opus") {
+        return decodeOggOpus(data, pcm, error);
+    }
+    *error = "不支持的文件类型";
+    return false;
+}
+
+bool decodeOggOpus(const QByteArray& data, QByteArray* pcm, QString* error)
+{
+    ogg_sync_state sync;
+    ogg_stream_state stream;
+    ogg_sync_init(&sync);
+    bool streamStarted = false;
+    ::OpusDecoder* decoder = nullptr;
+    auto cleanup = [&]() {
+        if (decoder) {
+            opus_decoder_destroy(decoder);
+        }
+        if (streamStarted) {
+            ogg_stream_clear(&stream);
+        }
+        ogg_sync_clear(&sync);
+    };
+
+    char* buffer = ogg_sync_buffer(&sync, data.size());
+    memcpy(buffer, data.constData(), data.size());
+    ogg_sync_wrote(&sync, data.size());
+
+    pcm->clear();
+    std::vector<opus_int16> frame(MAX_FRAME_SAMPLES);
+    int packets = 0;
+    int preSkip = 0;
+    ogg_int64_t lastGranule = -1;
+    ogg_page page;
+    while (ogg_sync_pageout(&sync, &page) == 1) {
+        // 只解码第一个逻辑流
+        if (!streamStarted) {
+            ogg_stream_init(&stream, ogg_page_serialno(&page));
+            streamStarted = true;
+        } else if (ogg_page_serialno(&page) != stream.serialno) {
+            continue;
+        }
+        ogg_stream_pagein(&stream, &page);
+
+        ogg_packet packet;
+        while (ogg_stream_packetout(&stream, &packet) == 1) {
+            const int index = packets++;
+            if (index == 0) {
+                // OpusHead：魔数、版本、声道数、pre-skip、原始采样率、增益、映射方式
+                if (packet.bytes < 19 || memcmp(packet.packet, "OpusHead", 8) != 0) {
+                    *error = "不是 Ogg Opus 文件";
+                    cleanup();
+                    return false;
+                }
+                if (packet.packet[18] > 1) {
+                    *error = "不支持多流 Opus";
+                    cleanup();
+                    return false;
+                }
+                preSkip = readLe16(packet.packet + 10);
+                // 立体声由解码器直接混成单声道，并重采样到 16kHz
+                int result = OPUS_OK;
+                decoder = opus_decoder_create(SAMPLE_RATE, 1, &result);
+                if (result != OPUS_OK) {
+                    *error = QString("创建 Opus 解码器失败: %1").arg(result);
+                    cleanup();
+                    return false;
+                }
+                continue;
+            }
+            if (index == 1) {
+                continue;  // OpusTags
+            }
+            const int samples = opus_decode(decoder, packet.packet, static_cast<opus_int32>(packet.bytes),
+                                            frame.data(), MAX_FRAME_SAMPLES, 0);
+            if (samples < 0) {
+                *error = QString("Opus 解码失败: %1").arg(samples);
+                cleanup();
+                return false;
+            }
+            pcm->append(reinterpret_cast<const char*>(frame.data()), samples * 2);
+            if (packet.granulepos >= 0) {
+                lastGranule = packet.granulepos;
+            }
+        }
+    }
+    cleanup();
+
+    if (packets < 2) {
+        *error = "Ogg Opus 文件不完整";
+        return false;
+    }
+
+    // 去掉编码器开头的填充；最后一页的 granulepos 给出实际长度，去掉结尾的填充
+    const int scale = OPUS_RATE / SAMPLE_RATE;
+    const int skipBytes = qMin(pcm->size(), preSkip / scale * 2);
+    pcm->remove(0, skipBytes);
+    if (lastGranule > preSkip) {
+        const qint64 totalBytes = (lastGranule - preSkip) / scale * 2;
+        if (totalBytes < pcm->size()) {
+            pcm->truncate(static_cast<int>(totalBytes));
+        }
+    }
+    return true;
+}
+
+}
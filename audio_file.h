@@ -0,0 +1,24 @@
+#ifndef AUDIO_FILE_H
+#define AUDIO_FILE_H
+
+#include <QByteArray>
+#include <QString>
+
+// 离线工具读取录音：统一转换为 16kHz 单声道 s16le，与采集和 Vosk 的输入一致。
+// 支持 .pcm/.raw（已是 16kHz 单声道 s16le，例如 send.pcm）和 .ogg/.opus（Ogg Opus）
+namespace AudioFile {
+
+constexpr int SAMPLE_RATE = 16000;
+
+// 按扩展名判断是否支持
+bool isSupported(const QString& path);
+
+// 读取并解码整个文件，失败时返回 false 并给出原因
+bool read(const QString& path, QByteArray* pcm, QString* error);
+
+// Ogg Opus 数据解码为 16kHz 单声道 s16le（按 OpusHead 的 pre-skip 去掉开头的填充）
+bool decodeOggOpus(const QByteArray& data, QByteArray* pcm, QString* error);
+
+}
+
+#endif // AUDIO_FILE_H
@@ -0,0 +1,87 @@
+#include "binary_protocol.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace BinaryProtocol {
+
+int headerSize(int version)
+{
+    switch (version) {
+        case 2:
+            return HEADER_SIZE_V2;
+        case 3:
+            return HEADER_SIZE_V3;
+        default:
+            return 0;
+    }
+}
+
+bool parse(int version, const QByteArray& frame, PacketView& view)
+{
+    const uchar* data = reinterpret_cast<const uchar*>(frame.constData());
+    const int size = frame.size();
+
+    if (version == 2) {
+        if (size < HEADER_SIZE_V2 || qFromBigEndian<quint16>(data) != 2) {
+            return false;
+        }
+        const quint32 payloadSize = qFromBigEndian<quint32>(data + 12);
+        if (payloadSize > static_cast<quint32>(size - HEADER_SIZE_V2)) {
+            return false;
+        }
+        view.type = qFromBigEndian<quint16>(data + 2);
+        view.hasTimestamp = true;
+        view.timestamp = qFromBigEndian<quint32>(data + 8);
+        view.payload = frame.constData() + HEADER_SIZE_V2;
+        view.payloadSize = static_cast<int>(payloadSize);
+        return true;
+    }
+
+    if (version == 3) {
+        if (size < HEADER_SIZE_V3) {
+            return false;
+        }
+        const quint16 payloadSize = qFromBigEndian<quint16>(data + 2);
+        if (payloadSize > size - HEADER_SIZE_V3) {
+            return false;
+        }
+        view.type = data[0];
+        view.hasTimestamp = false;
+        view.timestamp = 0;
+        view.payload = frame.constData() + HEADER_SIZE_V3;
+        view.payloadSize = payloadSize;
+        return true;
+    }
+
+    // 版本 1：整帧都是音频
+    view.type = Audio;
+    view.hasTimestamp = false;
+    view.timestamp = 0;
+    view.payload = frame.constData();
+    view.payloadSize = size;
+    return true;
+}
+
+void build(int version, quint16 type, quint32 timestamp,
+           const char* payload, int payloadSize, QByteArray& out)
+{
+    const int header = headerSize(version);
+    out.resize(header + payloadSize);
+    uchar* data = reinterpret_cast<uchar*>(out.data());
+
+    if (version == 2) {
+        qToBigEndian<quint16>(2, data);
+        qToBigEndian<quint16>(type, data + 2);
+        qToBigEndian<quint32>(0, data + 4);
+        qToBigEndian<quint32>(timestamp, data + 8);
+        qToBigEndian<quint32>(static_cast<quint32>(payloadSize), data + 12);
+    } else if (version == 3) {
+        data[0] = static_cast<uchar>(type);
+        data[1] = 0;
+        qToBigEndian<quint16>(static_cast<quint16>(payloadSize), data + 2);
+    }
+
+    memcpy(data + header, payload, payloadSize);
+}
+
+} // namespace BinaryProtocol
@@ -0,0 +1,43 @@
+#ifndef BINARY_PROTOCOL_H
+#define BINARY_PROTOCOL_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+// 二进制帧格式（与新版 xiaozhi 固件一致，多字节字段均为网络字节序）：
+//   版本 1：无帧头，整帧就是 Opus 数据
+//   版本 2：u16 version, u16 type, u32 reserved, u32 timestamp, u32 payload_size, payload
+//   版本 3：u8 type, u8 reserved, u16 payload_size, payload
+// 版本在 hello 中协商，服务器不支持时回退到版本 1
+namespace BinaryProtocol {
+
+enum PacketType : quint16 {
+    Audio = 0,
+    Json = 1,
+    DeflateJson = 2   // 压缩后的 JSON（见 message_deflate.h），只在 hello 协商后使用；音频从不压缩
+};
+
+constexpr int HEADER_SIZE_V2 = 16;
+constexpr int HEADER_SIZE_V3 = 4;
+
+int headerSize(int version);
+
+// 解析结果直接指向收到的帧，不拷贝负载；只在帧数据有效期间使用
+struct PacketView {
+    quint16 type = Audio;
+    bool hasTimestamp = false;
+    quint32 timestamp = 0;     // 毫秒，仅版本 2
+    const char* payload = nullptr;
+    int payloadSize = 0;
+};
+
+// 帧头不完整或长度不符时返回 false
+bool parse(int version, const QByteArray& frame, PacketView& view);
+
+// 把帧头和负载写入 out（复用 out 已有的容量，不额外分配）
+void build(int version, quint16 type, quint32 timestamp,
+           const char* payload, int payloadSize, QByteArray& out);
+
+} // namespace BinaryProtocol
+
+#endif // BINARY_PROTOCOL_H
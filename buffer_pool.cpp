@@ -0,0 +1,36 @@
+#include "buffer_pool.h"
+
+BufferPool::BufferPool(int bufferCapacity, int maxBuffers)
+    : bufferCapacity(bufferCapacity)
+    , maxBuffers(qMin(maxBuffers, MAX_BUFFERS))
+    , allocations(0)
+{
+}
+
+QByteArray BufferPool::acquire(int size)
+{
+    QByteArray buffer;
+    freeQueue.pop(buffer);
+
+    if (buffer.capacity() < size) {
+        buffer.reserve(qMax(size, bufferCapacity));
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+void BufferPool::release(QByteArray&& buffer)
+{
+    // 还有其他引用时归还会导致下次写入时分离，不如直接释放
+    if (!buffer.isDetached() || buffer.capacity() > bufferCapacity * 4) {
+        return;
+    }
+
+    // size() 是近似值，只会因取用方同时取出而偏大，池满的判断偏保守
+    if (static_cast<int>(freeQueue.size()) >= maxBuffers) {
+        return;
+    }
+    buffer.resize(0);
+    freeQueue.push(std::move(buffer));
+}
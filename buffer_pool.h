@@ -0,0 +1,37 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <QByteArray>
+#include <atomic>
+#include "spsc_queue.h"
+
+// 固定容量缓冲区池：音频包在线程间传递时复用已分配的内存，
+// 稳态下不再触发堆分配。池本身是一个无锁的 SPSC 空闲队列，与传递音频包的
+// SPSC 队列方向相反：acquire 只在取用方（包队列的生产者）线程调用，
+// release 只在归还方（包队列的消费者，可能是实时优先级的音频线程）线程调用，
+// 两端都不加锁，不会因为另一端被抢占而阻塞
+class BufferPool
+{
+public:
+    static constexpr int MAX_BUFFERS = 256;
+
+    // maxBuffers 不超过 MAX_BUFFERS
+    explicit BufferPool(int bufferCapacity = 4096, int maxBuffers = 64);
+
+    // 取出一个大小为 size 的缓冲区（内容未初始化），只在取用方线程调用
+    QByteArray acquire(int size);
+
+    // 归还缓冲区，只在归还方线程调用；仍被其他地方共享或池已满时直接释放
+    void release(QByteArray&& buffer);
+
+    // 累计新分配的缓冲区数量，稳态下应保持不变
+    int allocationCount() const { return allocations.load(std::memory_order_relaxed); }
+
+private:
+    SpscQueue<QByteArray, MAX_BUFFERS> freeQueue;   // 归还方 -> 取用方
+    int bufferCapacity;
+    int maxBuffers;
+    std::atomic<int> allocations;
+};
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,130 @@
+#include "capture_converter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+CaptureConverter::CaptureConverter()
+    : targetRate(16000)
+    , targetChannels(1)
+    , passthrough(true)
+    , position(0.0)
+    , previous(0.0f)
+{
+}
+
+int CaptureConverter::bytesPerSample(SampleFormat format)
+{
+    switch (format) {
+        case SampleFormat::UInt8:
+            return 1;
+        case SampleFormat::Int16:
+            return 2;
+        case SampleFormat::Int32:
+        case SampleFormat::Float:
+            return 4;
+        case SampleFormat::Unknown:
+            break;
+    }
+    return 0;
+}
+
+bool CaptureConverter::configure(const Format& deviceFormat, int rate, int channels)
+{
+    if (bytesPerSample(deviceFormat.sampleFormat) == 0 || deviceFormat.sampleRate <= 0
+        || deviceFormat.channels <= 0 || rate <= 0 || channels <= 0) {
+        return false;
+    }
+    device = deviceFormat;
+    targetRate = rate;
+    targetChannels = channels;
+    passthrough = device.sampleFormat == SampleFormat::Int16 && device.sampleRate == targetRate
+                  && device.channels == targetChannels;
+    reset();
+    return true;
+}
+
+void CaptureConverter::reset()
+{
+    remainder.clear();
+    position = 0.0;
+    previous = 0.0f;
+}
+
+float CaptureConverter::sampleAt(const char* frame, int channel) const
+{
+    const char* p = frame + channel * bytesPerSample(device.sampleFormat);
+    switch (device.sampleFormat) {
+        case SampleFormat::UInt8:
+            return (static_cast<uint8_t>(*p) - 128) / 128.0f;
+        case SampleFormat::Int16: {
+            int16_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value / 32768.0f;
+        }
+        case SampleFormat::Int32: {
+            int32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return static_cast<float>(value / 2147483648.0);
+        }
+        case SampleFormat::Float: {
+            float value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+        case SampleFormat::Unknown:
+            break;
+    }
+    return 0.0f;
+}
+
+QByteArray CaptureConverter::convert(const QByteArray& data)
+{
+    if (passthrough) {
+        return data;
+    }
+
+    // 拼上上一块的尾部，只处理完整的采样点
+    QByteArray input = remainder;
+    input.append(data);
+    const int frameBytes = bytesPerSample(device.sampleFormat) * device.channels;
+    const int frames = input.size() / frameBytes;
+    remainder = input.mid(frames * frameBytes);
+    if (frames == 0) {
+        return QByteArray();
+    }
+
+    // 下混为单声道
+    std::vector<float> mono(frames);
+    for (int i = 0; i < frames; ++i) {
+        const char* frame = input.constData() + i * frameBytes;
+        float sum = 0.0f;
+        for (int c = 0; c < device.channels; ++c) {
+            sum += sampleAt(frame, c);
+        }
+        mono[i] = sum / device.channels;
+    }
+
+    // 线性插值，输出样点落在上一块最后一个样点和本块之间时用 previous
+    const double step = static_cast<double>(device.sampleRate) / targetRate;
+    std::vector<int16_t> output;
+    output.reserve(static_cast<size_t>(frames / step + 2) * targetChannels);
+    while (position <= frames - 1) {
+        const int index = static_cast<int>(std::floor(position));
+        const double fraction = position - index;
+        const float s0 = index < 0 ? previous : mono[index];
+        const float s1 = fraction > 0.0 ? mono[index + 1] : s0;
+        const float value = static_cast<float>(s0 + (s1 - s0) * fraction);
+        const int16_t sample = static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+        for (int c = 0; c < targetChannels; ++c) {
+            output.push_back(sample);
+        }
+        position += step;
+    }
+    position -= frames;
+    previous = mono[frames - 1];
+
+    return QByteArray(reinterpret_cast<const char*>(output.data()),
+                      static_cast<int>(output.size() * sizeof(int16_t)));
+}
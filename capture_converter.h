@@ -0,0 +1,55 @@
+#ifndef CAPTURE_CONVERTER_H
+#define CAPTURE_CONVERTER_H
+
+#include <QByteArray>
+
+// 采集格式转换。回声消除、Opus 编码、VAD 和 Vosk 都按固定的流水线格式
+// （默认 16kHz 单声道 s16）处理；热插拔后的新设备（蓝牙耳机、USB 声卡等）不支持
+// 这个格式时，以设备格式打开，在这里下混、重采样并转换成 s16。
+// 声道取平均下混，采样率用线性插值转换，跨块保留插值状态和不足一个采样点的尾部
+class CaptureConverter
+{
+public:
+    enum class SampleFormat {
+        Unknown,
+        UInt8,
+        Int16,
+        Int32,
+        Float
+    };
+
+    struct Format {
+        int sampleRate = 16000;
+        int channels = 1;
+        SampleFormat sampleFormat = SampleFormat::Int16;
+    };
+
+    CaptureConverter();
+
+    // 设置设备格式和流水线格式（总是 s16），清空状态。不支持的设备格式返回 false
+    bool configure(const Format& device, int targetRate, int targetChannels);
+
+    // 设备格式与流水线格式相同，convert() 原样返回
+    bool isPassthrough() const { return passthrough; }
+
+    // 转换一块设备数据，返回流水线格式的数据
+    QByteArray convert(const QByteArray& data);
+
+    // 丢弃插值状态和尾部（设备切换或重新开始录音时）
+    void reset();
+
+    static int bytesPerSample(SampleFormat format);
+
+private:
+    float sampleAt(const char* frame, int channel) const;
+
+    Format device;
+    int targetRate;
+    int targetChannels;
+    bool passthrough;
+    QByteArray remainder;   // 不足一个采样点（所有声道）的尾部
+    double position;        // 下一个输出样点在本块输入中的位置，-1 对应上一块最后一个样点
+    float previous;         // 上一块最后一个（下混后的）样点
+};
+
+#endif // CAPTURE_CONVERTER_H
@@ -0,0 +1,186 @@
+#include "connection_manager.h"
+#include "transport.h"
+#include <QHostInfo>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <algorithm>
+
+ConnectionManager::ConnectionManager(Transport* client, QObject *parent)
+    : QObject(parent)
+    , client(client)
+    , state(State::Idle)
+    , wantConnected(false)
+    , attempt(0)
+    , outage(false)
+{
+    retryTimer.setSingleShot(true);
+    connect(&retryTimer, &QTimer::timeout, this, &ConnectionManager::connectNow);
+
+    attemptTimer.setSingleShot(true);
+    connect(&attemptTimer, &QTimer::timeout, this, [this]() {
+        qDebug() << "连接尝试超时";
+        this->client->closeConnection();
+        handleConnectionLost("timeout");
+    });
+
+    client->setOnConnectedCallback([this]() {
+        handleConnected();
+    });
+    client->setOnDisconnectedCallback([this]() {
+        handleConnectionLost("disconnected");
+    });
+    client->setOnErrorCallback([this](const QString& error) {
+        handleConnectionLost(error);
+    });
+}
+
+void ConnectionManager::start(const QString& newUrl)
+{
+    url = QUrl(newUrl);
+    wantConnected = true;
+
+    if (state == State::Connected || state == State::Connecting) {
+        return;
+    }
+
+    // 用户手动点击连接时跳过剩余的退避时间
+    retryTimer.stop();
+    prefetchHost();
+    connectNow();
+}
+
+void ConnectionManager::stop()
+{
+    wantConnected = false;
+    retryTimer.stop();
+    attemptTimer.stop();
+    outage = false;
+    attempt = 0;
+    client->closeConnection();
+    if (state != State::Connected) {
+        state = State::Idle;
+    }
+}
+
+void ConnectionManager::connectNow()
+{
+    if (!wantConnected) {
+        return;
+    }
+
+    state = State::Connecting;
+    client->setSslSessionTicket(sessionTicket);
+    client->connectToServer(url.toString());
+    attemptTimer.start(ATTEMPT_TIMEOUT_MS);
+}
+
+void ConnectionManager::handleConnected()
+{
+    attemptTimer.stop();
+    retryTimer.stop();
+    state = State::Connected;
+    attempt = 0;
+
+    // 记住本次会话票据，下次握手时恢复会话
+    QByteArray ticket = client->sslSessionTicket();
+    if (!ticket.isEmpty()) {
+        sessionTicket = ticket;
+    }
+
+    if (outage) {
+        outage = false;
+        qint64 elapsed = outageTimer.elapsed();
+        reconnectTimes.append(elapsed);
+        if (reconnectTimes.size() > MAX_SAMPLES) {
+            reconnectTimes.removeFirst();
+        }
+        qDebug() << "重连成功，耗时:" << elapsed << "ms";
+        emit connected();
+        emit reconnected(elapsed);
+        return;
+    }
+    emit connected();
+}
+
+void ConnectionManager::handleConnectionLost(const QString& reason)
+{
+    // 断开和错误可能先后到达，同一次断线只处理一次
+    if (state == State::Backoff || state == State::Idle) {
+        return;
+    }
+
+    const bool wasConnected = state == State::Connected;
+    attemptTimer.stop();
+    state = wantConnected ? State::Backoff : State::Idle;
+
+    if (wasConnected) {
+        qDebug() << "连接断开:" << reason;
+        if (wantConnected) {
+            outage = true;
+            outageTimer.start();
+        }
+        emit disconnected();
+    } else {
+        qDebug() << "连接失败:" << reason;
+        if (attempt == 0 && !outage) {
+            // 首次连接就失败，同样通知界面恢复按钮状态
+            emit disconnected();
+        }
+    }
+
+    if (wantConnected) {
+        scheduleRetry();
+    }
+}
+
+void ConnectionManager::scheduleRetry()
+{
+    const int delay = nextDelayMs();
+    ++attempt;
+    qDebug() << "将在" << delay << "ms 后第" << attempt << "次重连";
+    emit reconnecting(attempt, delay);
+
+    // 等待期间预先解析域名
+    prefetchHost();
+    retryTimer.start(delay);
+}
+
+int ConnectionManager::nextDelayMs()
+{
+    // 指数退避加抖动：在 [上限/2, 上限] 之间随机，避免大量客户端同时重连
+    const qint64 ceiling = std::min<qint64>(MAX_DELAY_MS, static_cast<qint64>(BASE_DELAY_MS) << std::min(attempt, 16));
+    const int half = static_cast<int>(ceiling / 2);
+    return half + QRandomGenerator::global()->bounded(half + 1);
+}
+
+void ConnectionManager::prefetchHost()
+{
+    const QString host = url.host();
+    if (host.isEmpty()) {
+        return;
+    }
+
+    // 结果进入 Qt 的主机名缓存，随后建立连接时直接命中
+    QElapsedTimer timer;
+    timer.start();
+    QHostInfo::lookupHost(host, this, [host, timer](const QHostInfo& info) {
+        if (info.error() != QHostInfo::NoError) {
+            qDebug() << "DNS 预解析失败:" << host << info.errorString();
+            return;
+        }
+        qDebug() << "DNS 预解析完成:" << host << "耗时:" << timer.elapsed() << "ms";
+    });
+}
+
+qint64 ConnectionManager::reconnectPercentile(double percentile) const
+{
+    if (reconnectTimes.isEmpty()) {
+        return -1;
+    }
+
+    QVector<qint64> sorted = reconnectTimes;
+    std::sort(sorted.begin(), sorted.end());
+    int index = static_cast<int>(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+    index = std::clamp(index, 0, static_cast<int>(sorted.size()) - 1);
+    return sorted[index];
+}
@@ -0,0 +1,79 @@
+#ifndef CONNECTION_MANAGER_H
+#define CONNECTION_MANAGER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QUrl>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QByteArray>
+
+class Transport;
+
+// 连接管理：断线后按带抖动的指数退避自动重连。
+// 退避期间预先解析域名（预热 Qt 的 DNS 缓存），并复用上一次的 TLS 会话票据，
+// 缩短重连握手时间。
+class ConnectionManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ConnectionManager(Transport* client, QObject *parent = nullptr);
+
+    // 开始连接，断线后自动重连；已在退避中时立即重试
+    void start(const QString& url);
+
+    // 用户主动断开，不再重连
+    void stop();
+
+    bool isReconnecting() const { return state == State::Backoff || (state == State::Connecting && attempt > 0); }
+
+    // 重连耗时（从断线到收到服务器 hello）的分位数，单位毫秒；没有样本时返回 -1
+    qint64 reconnectPercentile(double percentile) const;
+    int reconnectCount() const { return reconnectTimes.size(); }
+
+signals:
+    // 收到服务器 hello，连接可用
+    void connected();
+    // 连接断开（包括连接失败）
+    void disconnected();
+    // 将在 delayMs 后进行第 attempt 次重连
+    void reconnecting(int attempt, int delayMs);
+    // 重连成功，elapsedMs 为断线到重新可用的耗时
+    void reconnected(qint64 elapsedMs);
+
+private:
+    enum class State {
+        Idle,
+        Connecting,
+        Connected,
+        Backoff
+    };
+
+    void connectNow();
+    void handleConnected();
+    void handleConnectionLost(const QString& reason);
+    void scheduleRetry();
+    void prefetchHost();
+    int nextDelayMs();
+
+    Transport* client;
+    QUrl url;
+    State state;
+    bool wantConnected;
+    int attempt;
+
+    QTimer retryTimer;
+    QTimer attemptTimer;       // 单次连接尝试的超时
+    QElapsedTimer outageTimer; // 从断线开始计时
+    bool outage;
+
+    QByteArray sessionTicket;  // 上一次 TLS 会话票据
+    QVector<qint64> reconnectTimes;
+
+    static constexpr int BASE_DELAY_MS = 500;
+    static constexpr int MAX_DELAY_MS = 30000;
+    static constexpr int ATTEMPT_TIMEOUT_MS = 12000;
+    static constexpr int MAX_SAMPLES = 1000;
+};
+
+#endif // CONNECTION_MANAGER_H
@@ -0,0 +1,213 @@
+#include "device_identity.h"
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QRegularExpression>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkInterface>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <climits>
+
+namespace {
+const char* DEFAULT_MAC = "60:a4:4c:59:44:60";
+constexpr uint RTF_UP = 0x0001;
+
+QString normalizedMac(const QString& address)
+{
+    const QString mac = address.trimmed().toLower();
+    if (mac.isEmpty() || mac == "00:00:00:00:00:00") {
+        return QString();
+    }
+    return mac;
+}
+}
+
+const DeviceIdentity& DeviceIdentity::current()
+{
+    // 局部静态变量的初始化是线程安全的
+    static const DeviceIdentity identity = load(defaultCachePath());
+    return identity;
+}
+
+DeviceIdentity DeviceIdentity::load(const QString& cachePath, const QString& procRoot, const QString& sysRoot)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(cachePath);
+    if (file.open(QIODevice::ReadOnly)) {
+        const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+        DeviceIdentity cached;
+        cached.deviceId = normalizedMac(root.value("device_id").toString());
+        cached.clientId = root.value("client_id").toString();
+        cached.interfaceName = root.value("interface").toString();
+        cached.source = "cache";
+        if (cached.isValid()) {
+            qDebug() << "设备标识（缓存）:" << cached.deviceId << cached.clientId
+                     << "耗时" << timer.nsecsElapsed() / 1000 << "us";
+            return cached;
+        }
+        qDebug() << "设备标识缓存无效，重新解析:" << cachePath;
+    }
+
+    DeviceIdentity identity = resolve(procRoot, sysRoot);
+    // 兜底的默认地址不写缓存，下次启动还有机会拿到真实地址
+    if (identity.source != "default" && !identity.save(cachePath)) {
+        qDebug() << "设备标识缓存写入失败:" << cachePath;
+    }
+    qDebug() << "设备标识（" << identity.source << "）:" << identity.interfaceName << identity.deviceId
+             << identity.clientId << "耗时" << timer.nsecsElapsed() / 1000 << "us";
+    return identity;
+}
+
+DeviceIdentity DeviceIdentity::resolve(const QString& procRoot, const QString& sysRoot)
+{
+    DeviceIdentity identity;
+
+    // 1. 路由表中默认路由的网卡
+    const QString name = defaultRouteInterface(procRoot);
+    if (!name.isEmpty()) {
+        identity.deviceId = interfaceAddress(name, sysRoot);
+        if (!identity.deviceId.isEmpty()) {
+            identity.interfaceName = name;
+            identity.source = "route";
+        }
+    }
+
+    // 2. 没有路由表（非 Linux）或离线：取第一个已启用的非回环网卡
+    if (identity.deviceId.isEmpty()) {
+        const QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
+        for (const QNetworkInterface& interface : interfaces) {
+            if (interface.flags().testFlag(QNetworkInterface::IsLoopBack) ||
+                !interface.flags().testFlag(QNetworkInterface::IsUp) ||
+                !interface.flags().testFlag(QNetworkInterface::IsRunning)) {
+                continue;
+            }
+            const QString mac = normalizedMac(interface.hardwareAddress());
+            if (!mac.isEmpty()) {
+                identity.deviceId = mac;
+                identity.interfaceName = interface.name();
+                identity.source = "interfaces";
+                break;
+            }
+        }
+    }
+
+    // 3. 使用默认值
+    if (identity.deviceId.isEmpty()) {
+        identity.deviceId = DEFAULT_MAC;
+        identity.source = "default";
+        qDebug() << "未找到出口网卡的MAC地址，使用默认地址:" << identity.deviceId;
+    }
+
+    identity.clientId = clientIdFor(identity.deviceId);
+    return identity;
+}
+
+QString DeviceIdentity::defaultRouteInterface(const QString& procRoot)
+{
+    QString best;
+    uint bestMetric = UINT_MAX;
+
+    // IPv4：Iface Destination Gateway Flags RefCnt Use Metric Mask ...，地址为十六进制
+    QFile route(procRoot + "/net/route");
+    if (route.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream stream(&route);
+        stream.readLine();  // 表头
+        while (!stream.atEnd()) {
+            const QStringList fields = stream.readLine().split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+            if (fields.size() < 8) {
+                continue;
+            }
+            bool ok = false;
+            const uint flags = fields[3].toUInt(&ok, 16);
+            const uint metric = fields[6].toUInt();
+            if (ok && fields[1] == "00000000" && fields[7] == "00000000" && (flags & RTF_UP) && metric < bestMetric) {
+                best = fields[0];
+                bestMetric = metric;
+            }
+        }
+    }
+    if (!best.isEmpty()) {
+        return best;
+    }
+
+    // 只有 IPv6 默认路由：目的地址 32 个 0、前缀长度 00，最后一列为网卡
+    QFile route6(procRoot + "/net/ipv6_route");
+    if (route6.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream stream(&route6);
+        while (!stream.atEnd()) {
+            const QStringList fields = stream.readLine().split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+            if (fields.size() < 10 || fields[0] != QString(32, '0') || fields[1] != "00") {
+                continue;
+            }
+            bool ok = false;
+            const uint metric = fields[5].toUInt(&ok, 16);
+            const uint flags = fields[8].toUInt(nullptr, 16);
+            if (ok && (flags & RTF_UP) && fields[9] != "lo" && metric < bestMetric) {
+                best = fields[9];
+                bestMetric = metric;
+            }
+        }
+    }
+    return best;
+}
+
+QString DeviceIdentity::interfaceAddress(const QString& name, const QString& sysRoot)
+{
+    // 网卡名来自路由表，不允许借此读取其他路径
+    if (name.isEmpty() || name.contains('/') || name.startsWith('.')) {
+        return QString();
+    }
+    QFile file(sysRoot + "/class/net/" + name + "/address");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QString();
+    }
+    return normalizedMac(QString::fromLatin1(file.readAll()));
+}
+
+QString DeviceIdentity::clientIdFor(const QString& macAddress)
+{
+    // 使用MAC地址作为种子生成UUID
+    QByteArray hash = QCryptographicHash::hash(macAddress.toUtf8(), QCryptographicHash::Md5);
+
+    // 构造UUID格式 (8-4-4-4-12)
+    QString uuid = hash.toHex();
+    uuid.insert(8, '-');
+    uuid.insert(13, '-');
+    uuid.insert(18, '-');
+    uuid.insert(23, '-');
+    return uuid.left(36);
+}
+
+QString DeviceIdentity::defaultCachePath()
+{
+    const QString path = qEnvironmentVariable("XIAOZHI_IDENTITY_FILE");
+    if (!path.isEmpty()) {
+        return path;
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation) + "/device_identity.json";
+}
+
+bool DeviceIdentity::save(const QString& path) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QJsonObject root;
+    root["device_id"] = deviceId;
+    root["client_id"] = clientId;
+    root["interface"] = interfaceName;
+
+    // 先写临时文件再替换，中途退出不会留下半个缓存
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
@@ -0,0 +1,43 @@
+#ifndef DEVICE_IDENTITY_H
+#define DEVICE_IDENTITY_H
+
+#include <QString>
+
+// 设备标识（Device-Id 为出口网卡的 MAC 地址，Client-Id 由 MAC 派生）。
+// 不建立任何 socket：从路由表（/proc/net/route、/proc/net/ipv6_route）找到默认路由的网卡，
+// 再读 /sys/class/net/<网卡>/address；结果缓存到磁盘，之后启动直接读缓存。
+// 离线或受限网络下也不会阻塞界面
+struct DeviceIdentity {
+    QString deviceId;        // MAC 地址，小写、冒号分隔
+    QString clientId;        // UUID 格式
+    QString interfaceName;   // 出口网卡
+    QString source;          // 来源："cache"、"route"、"interfaces" 或 "default"
+
+    bool isValid() const { return !deviceId.isEmpty() && !clientId.isEmpty(); }
+
+    // 进程内只解析一次，可在任意线程调用
+    static const DeviceIdentity& current();
+
+    // 缓存优先；缓存不存在或无效时解析并写入缓存
+    static DeviceIdentity load(const QString& cachePath, const QString& procRoot = "/proc",
+                               const QString& sysRoot = "/sys");
+
+    // 不读缓存，直接解析
+    static DeviceIdentity resolve(const QString& procRoot = "/proc", const QString& sysRoot = "/sys");
+
+    // 默认路由所在的网卡（跃点数最小），找不到时返回空
+    static QString defaultRouteInterface(const QString& procRoot = "/proc");
+
+    // 网卡的 MAC 地址，不存在或全零时返回空
+    static QString interfaceAddress(const QString& name, const QString& sysRoot = "/sys");
+
+    // 与之前的 WebSocketClient 相同：MAC 的 MD5 排成 8-4-4-4-12
+    static QString clientIdFor(const QString& macAddress);
+
+    // 缓存文件：XIAOZHI_IDENTITY_FILE，默认在应用配置目录下
+    static QString defaultCachePath();
+
+    bool save(const QString& path) const;
+};
+
+#endif // DEVICE_IDENTITY_H
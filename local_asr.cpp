@@ -0,0 +1,314 @@
+#include "local_asr.h"
+#include <vosk_api.h>
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaObject>
+#include <QTextStream>
+#include <chrono>
+
+namespace {
+// Vosk 的 JSON 结果取出文本；中文模型按词加空格，去掉后作为一句话
+QString resultText(const char* json, const char* key)
+{
+    if (!json) {
+        return QString();
+    }
+    QString text = QJsonDocument::fromJson(json).object()[key].toString();
+    text.remove(' ');
+    return text;
+}
+}
+
+LocalAsr::DecodeOptions LocalAsr::DecodeOptions::fromModelConf(const QString& modelPath)
+{
+    DecodeOptions result;
+    QFile file(modelPath + "/conf/model.conf");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return result;
+    }
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        // 每行形如 --max-active=5000
+        const QString line = in.readLine().trimmed();
+        const int eq = line.indexOf('=');
+        if (!line.startsWith("--") || eq < 0) {
+            continue;
+        }
+        const QString key = line.mid(2, eq - 2);
+        const QString value = line.mid(eq + 1);
+        if (key == "max-active") {
+            result.maxActive = value.toInt();
+        } else if (key == "min-active") {
+            result.minActive = value.toInt();
+        } else if (key == "beam") {
+            result.beam = value.toDouble();
+        } else if (key == "lattice-beam") {
+            result.latticeBeam = value.toDouble();
+        }
+    }
+    return result;
+}
+
+QString LocalAsr::DecodeOptions::summary() const
+{
+    return QString("max-active=%1 min-active=%2 beam=%3 lattice-beam=%4")
+        .arg(maxActive).arg(minActive).arg(beam).arg(latticeBeam);
+}
+
+LocalAsr::LocalAsr(QObject *parent)
+    : QObject(parent)
+    , recognizer(nullptr, [](VoskRecognizer* r) { if(r) vosk_recognizer_free(r); })
+    , initialized(false)
+    , isRunning(false)
+    , active(false)
+    , workerThread(nullptr)
+    , maxLag(qEnvironmentVariableIsSet("XIAOZHI_ASR_MAX_LAG_MS")
+             ? qEnvironmentVariableIntValue("XIAOZHI_ASR_MAX_LAG_MS") : DEFAULT_MAX_LAG_MS)
+    , lag(0)
+    , dropped(0)
+    , utteranceBytes(0)
+    , decodeNs(0)
+{
+}
+
+LocalAsr::~LocalAsr()
+{
+    stop();
+}
+
+bool LocalAsr::initialize(VoskModel* model, const QString& modelPath)
+{
+    if (initialized) {
+        return true;
+    }
+    if (!model) {
+        qDebug() << "本地识别: 模型为空";
+        return false;
+    }
+
+    VoskRecognizer* rawRecognizer = vosk_recognizer_new(model, 16000.0);
+    if (!rawRecognizer) {
+        qDebug() << "本地识别: 无法创建Vosk识别器";
+        return false;
+    }
+    recognizer.reset(rawRecognizer);
+
+    // 解码参数在模型加载时已从 model.conf 读入，这里只读出来报告和检查
+    options = DecodeOptions::fromModelConf(modelPath);
+    qDebug() << "本地识别解码参数:" << options.summary();
+    if (options.maxActive <= 0 || options.maxActive > MAX_ACTIVE_WARNING) {
+        qDebug() << "本地识别: model.conf 未限制 --max-active 或取值过大，"
+                    "弱 CPU 上可能跟不上实时，可在" << modelPath + "/conf/model.conf" << "中调小";
+    }
+
+    initialized = true;
+    return true;
+}
+
+void LocalAsr::start()
+{
+    if (!initialized || isRunning) {
+        return;
+    }
+    isRunning = true;
+    workerThread = std::make_unique<std::thread>(&LocalAsr::processingLoop, this);
+}
+
+void LocalAsr::stop()
+{
+    if (!isRunning) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&mutex);
+        isRunning = false;
+        condition.wakeAll();
+    }
+
+    if (workerThread && workerThread->joinable()) {
+        workerThread->join();
+    }
+    workerThread.reset();
+}
+
+void LocalAsr::beginUtterance()
+{
+    if (!initialized) {
+        return;
+    }
+    // 先入队再置位，音频线程随后送入的数据一定排在 Begin 之后
+    enqueue(Command::Begin);
+    active = true;
+}
+
+void LocalAsr::endUtterance()
+{
+    if (!initialized || !active.exchange(false)) {
+        return;
+    }
+    enqueue(Command::End);
+}
+
+void LocalAsr::processAudioData(const QByteArray& pcmData)
+{
+    if (!active) {
+        return;
+    }
+    enqueue(Command::Audio, pcmData);
+}
+
+void LocalAsr::setMaxLagMs(int ms)
+{
+    QMutexLocker locker(&mutex);
+    maxLag = ms;
+}
+
+int LocalAsr::maxLagMs() const
+{
+    QMutexLocker locker(&mutex);
+    return maxLag;
+}
+
+void LocalAsr::enqueue(Command::Type type, const QByteArray& data)
+{
+    const AudioBacklog::Clock::time_point now = AudioBacklog::Clock::now();
+    int shedChunks = 0;
+    {
+        QMutexLocker locker(&mutex);
+        commandQueue.enqueue({type, data, now});
+        if (type == Command::Audio) {
+            shedChunks = shed(now);
+        }
+        condition.wakeOne();
+    }
+    if (shedChunks > 0) {
+        reportDropped(shedChunks);
+    }
+}
+
+int LocalAsr::shed(AudioBacklog::Clock::time_point now)
+{
+    if (maxLag <= 0) {
+        return 0;
+    }
+    int audioChunks = 0;
+    bool late = false;
+    for (const Command& command : commandQueue) {
+        if (command.type == Command::Audio) {
+            if (audioChunks == 0) {
+                late = now - command.enqueued > std::chrono::milliseconds(maxLag);
+            }
+            ++audioChunks;
+        }
+    }
+    if (!late || audioChunks < 2) {
+        return 0;
+    }
+
+    // 只保留最新的一块音频，Begin/End 按原顺序保留，每句仍然成对
+    QQueue<Command> kept;
+    int seen = 0;
+    for (Command& command : commandQueue) {
+        if (command.type != Command::Audio) {
+            kept.enqueue(std::move(command));
+        } else if (++seen == audioChunks) {
+            command.discontinuity = true;
+            kept.enqueue(std::move(command));
+        }
+    }
+    commandQueue.swap(kept);
+    return audioChunks - 1;
+}
+
+void LocalAsr::reportDropped(int chunks)
+{
+    const int total = dropped.fetch_add(chunks, std::memory_order_relaxed) + chunks;
+    qDebug() << "本地识别跟不上实时，丢弃积压音频" << chunks << "块，累计" << total << "块";
+    QMetaObject::invokeMethod(this, [this, chunks]() {
+        emit backlogDropped(chunks);
+    }, Qt::QueuedConnection);
+}
+
+void LocalAsr::processingLoop()
+{
+    using Clock = std::chrono::steady_clock;
+    QString committed;  // 一句中 Vosk 自身端点之前已经确定的部分
+
+    while (isRunning) {
+        Command command;
+        int shedChunks = 0;
+        {
+            QMutexLocker locker(&mutex);
+            while (commandQueue.isEmpty() && isRunning) {
+                condition.wait(&mutex);
+            }
+            if (!isRunning) {
+                break;
+            }
+            // 音频停止入队后不再有新的检查，取出前也检查一次积压
+            shedChunks = shed(Clock::now());
+            command = commandQueue.dequeue();
+        }
+        if (shedChunks > 0) {
+            reportDropped(shedChunks);
+        }
+
+        const Clock::time_point begin = Clock::now();
+        switch (command.type) {
+        case Command::Begin:
+            vosk_recognizer_reset(recognizer.get());
+            committed.clear();
+            lastPartial.clear();
+            utteranceBytes = 0;
+            decodeNs = 0;
+            break;
+
+        case Command::Audio: {
+            // 前面的音频被丢弃：已解码的部分作为确定的文本，识别器从这块重新开始
+            if (command.discontinuity) {
+                committed += resultText(vosk_recognizer_final_result(recognizer.get()), "text");
+                vosk_recognizer_reset(recognizer.get());
+            }
+            utteranceBytes += command.data.size();
+            const int result = vosk_recognizer_accept_waveform(recognizer.get(), command.data.constData(),
+                                                               command.data.size());
+            // 这块音频在入队时已采集完，解码完成时落后墙上时钟的时间
+            lag.store(static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                Clock::now() - command.enqueued).count()), std::memory_order_relaxed);
+            if (result < 0) {
+                qDebug() << "本地识别: 音频数据处理失败";
+                break;
+            }
+            // 长句中 Vosk 可能自行断开，已确定的部分接在前面
+            if (result == 1) {
+                committed += resultText(vosk_recognizer_result(recognizer.get()), "text");
+            }
+            const QString partial = committed
+                + resultText(vosk_recognizer_partial_result(recognizer.get()), "partial");
+            if (partial != lastPartial) {
+                lastPartial = partial;
+                QMetaObject::invokeMethod(this, [this, partial]() {
+                    emit partialResult(partial);
+                }, Qt::QueuedConnection);
+            }
+            break;
+        }
+
+        case Command::End: {
+            const QString text = committed + resultText(vosk_recognizer_final_result(recognizer.get()), "text");
+            decodeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+            const qint64 audioMs = utteranceBytes / 32;  // 16kHz * 2 字节
+            const double rtf = audioMs > 0 ? decodeNs / 1e6 / audioMs : 0.0;
+            QMetaObject::invokeMethod(this, [this, text, audioMs, rtf]() {
+                emit finalResult(text, audioMs, rtf);
+            }, Qt::QueuedConnection);
+            vosk_recognizer_reset(recognizer.get());
+            continue;
+        }
+        }
+        decodeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+    }
+}
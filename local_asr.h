@@ -0,0 +1,118 @@
+#ifndef LOCAL_ASR_H
+#define LOCAL_ASR_H
+
+#include <QObject>
+#include <QString>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include "audio_backlog.h"
+
+struct VoskRecognizer;
+struct VoskModel;
+
+// 本地流式识别：与唤醒词检测器共用同一个 Vosk 模型，另开一个识别器，
+// 只解码监听期间的这一句。部分结果实时发给界面预览，一句结束后给出最终结果，
+// 服务器不可用或识别结果迟迟不到时可作为文本请求发送。
+// 解码开销由模型 conf/model.conf 中的 --max-active/--beam 限定（模型加载时读取，
+// 两个识别器共用），每句结束时报告实时率（解码耗时 / 音频时长）。
+// 解码跟不上实时时，排队最久的音频等待超过 maxLagMs 就丢弃积压、只保留最新的一块
+// （与唤醒词检测的 AudioBacklog 相同），已解码的部分保留在这一句的结果中
+class LocalAsr : public QObject
+{
+    Q_OBJECT
+
+public:
+    // model.conf 中与解码开销有关的参数，缺省为 0
+    struct DecodeOptions {
+        int maxActive = 0;
+        int minActive = 0;
+        double beam = 0.0;
+        double latticeBeam = 0.0;
+
+        static DecodeOptions fromModelConf(const QString& modelPath);
+        QString summary() const;
+    };
+
+    explicit LocalAsr(QObject *parent = nullptr);
+    ~LocalAsr();
+
+    // model 由唤醒词检测器创建，识别器持有模型的引用，释放顺序不限
+    bool initialize(VoskModel* model, const QString& modelPath);
+    bool isInitialized() const { return initialized; }
+    const DecodeOptions& decodeOptions() const { return options; }
+
+    void start();
+    void stop();
+
+    // 开始/结束一句（GUI 线程调用），与音频数据按调用顺序排队处理
+    void beginUtterance();
+    void endUtterance();
+
+    // 送入 16kHz 单声道 s16le（音频线程调用），不在一句之内的数据丢弃
+    void processAudioData(const QByteArray& pcmData);
+
+    // 积压上限，默认取 XIAOZHI_ASR_MAX_LAG_MS（未设置时 DEFAULT_MAX_LAG_MS），0 不限制
+    void setMaxLagMs(int ms);
+    int maxLagMs() const;
+
+    // 统计：解码延迟（刚解码完的一块音频落后墙上时钟的时间）、因积压丢弃的音频块数
+    int lagMs() const { return lag.load(std::memory_order_relaxed); }
+    int droppedChunks() const { return dropped.load(std::memory_order_relaxed); }
+
+signals:
+    // 部分结果有变化时发出
+    void partialResult(const QString& text);
+
+    // 一句结束：最终识别结果、音频时长和实时率
+    void finalResult(const QString& text, qint64 audioMs, double realTimeFactor);
+
+    // 解码跟不上实时，丢弃了 chunks 块积压音频
+    void backlogDropped(int chunks);
+
+private:
+    struct Command {
+        enum Type { Begin, Audio, End };
+        Type type;
+        QByteArray data;
+        AudioBacklog::Clock::time_point enqueued;
+        bool discontinuity = false;   // 前面的音频被丢弃过
+    };
+
+    void enqueue(Command::Type type, const QByteArray& data = QByteArray());
+    // 最早的音频等待超过上限时丢弃除最新一块以外的音频（Begin/End 保留），返回丢弃的块数。
+    // 调用方持有 mutex
+    int shed(AudioBacklog::Clock::time_point now);
+    void reportDropped(int chunks);  // 累计丢弃数并通知界面线程（任意线程）
+    void processingLoop();
+
+    std::unique_ptr<VoskRecognizer, void(*)(VoskRecognizer*)> recognizer;
+    DecodeOptions options;
+    std::atomic<bool> initialized;
+    std::atomic<bool> isRunning;
+    std::atomic<bool> active;          // 一句进行中，音频线程据此决定是否入队
+
+    std::unique_ptr<std::thread> workerThread;
+    QQueue<Command> commandQueue;     // 以下两项由 mutex 保护
+    int maxLag;
+    mutable QMutex mutex;
+    QWaitCondition condition;
+    std::atomic<int> lag;
+    std::atomic<int> dropped;
+
+    // 以下只在工作线程中使用
+    QString lastPartial;
+    qint64 utteranceBytes;
+    qint64 decodeNs;                   // 本句 accept_waveform 和取结果的累计耗时
+
+    // max-active 超过此值时提示解码开销可能跟不上实时
+    static constexpr int MAX_ACTIVE_WARNING = 7000;
+
+    // 本地识别的结果一句结束才用，比唤醒词检测多容忍一些延迟
+    static constexpr int DEFAULT_MAX_LAG_MS = 2000;
+};
+
+#endif // LOCAL_ASR_H
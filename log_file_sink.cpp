@@ -0,0 +1,109 @@
+#include "log_file_sink.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QMutexLocker>
+
+LogFileSink::LogFileSink(const QString& path, qint64 maxBytes, int maxFiles)
+    : path(path)
+    , maxBytes(maxBytes)
+    , maxFiles(qMax(1, maxFiles))
+    , file(path)
+    , currentSize(0)
+    , opened(false)
+    , stopping(false)
+    , dropped(0)
+{
+    opened = file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+    if (!opened) {
+        qDebug() << "无法打开日志文件:" << path << file.errorString();
+        return;
+    }
+    currentSize = file.size();
+
+    worker = std::make_unique<std::thread>(&LogFileSink::writerLoop, this);
+}
+
+LogFileSink::~LogFileSink()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        condition.wakeOne();
+    }
+    if (worker && worker->joinable()) {
+        worker->join();
+    }
+    file.close();
+}
+
+void LogFileSink::write(const LogEntry& entry)
+{
+    if (!opened) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    if (queue.size() >= MAX_QUEUE) {
+        queue.removeFirst();
+        ++dropped;
+    }
+    queue.append(entry);
+    condition.wakeOne();
+}
+
+void LogFileSink::writerLoop()
+{
+    static const char levelNames[] = {'D', 'I', 'W', 'E'};
+
+    while (true) {
+        QList<LogEntry> batch;
+        {
+            QMutexLocker locker(&mutex);
+            while (queue.isEmpty() && !stopping) {
+                condition.wait(&mutex);
+            }
+            if (queue.isEmpty() && stopping) {
+                break;
+            }
+            batch.swap(queue);
+        }
+
+        // 格式化和写文件都在写线程中完成
+        for (const LogEntry& entry : batch) {
+            QByteArray line = QDateTime::fromMSecsSinceEpoch(entry.timestampMs)
+                                  .toString("yyyy-MM-dd hh:mm:ss.zzz").toUtf8();
+            line += " [";
+            line += levelNames[static_cast<int>(entry.level)];
+            line += "] ";
+            line += entry.text.toUtf8();
+            line += '\n';
+            currentSize += file.write(line);
+
+            if (currentSize >= maxBytes) {
+                rotate();
+            }
+        }
+        file.flush();
+    }
+}
+
+void LogFileSink::rotate()
+{
+    file.close();
+
+    // path.(n-1) 被删除，其余依次后移
+    QFile::remove(QString("%1.%2").arg(path).arg(maxFiles - 1));
+    for (int i = maxFiles - 2; i >= 1; --i) {
+        QFile::rename(QString("%1.%2").arg(path).arg(i), QString("%1.%2").arg(path).arg(i + 1));
+    }
+    if (maxFiles > 1) {
+        QFile::rename(path, path + ".1");
+    } else {
+        QFile::remove(path);
+    }
+
+    currentSize = 0;
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qDebug() << "日志文件滚动后无法重新打开:" << path;
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef LOG_FILE_SINK_H
+#define LOG_FILE_SINK_H
+
+#include <QString>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <memory>
+#include <thread>
+#include "log_model.h"
+
+// 异步日志文件：调用方只入队，由写线程格式化并写入，超过大小后滚动为
+// path.1、path.2 ...，最多保留 maxFiles 个文件
+class LogFileSink
+{
+public:
+    explicit LogFileSink(const QString& path, qint64 maxBytes = 4 * 1024 * 1024, int maxFiles = 5);
+    ~LogFileSink();
+
+    bool isOpen() const { return opened; }
+
+    // 线程安全，写线程来不及时丢弃最旧的条目
+    void write(const LogEntry& entry);
+
+    // 累计丢弃的条目数
+    qint64 droppedCount() const { return dropped; }
+
+private:
+    void writerLoop();
+    void rotate();
+
+    QString path;
+    qint64 maxBytes;
+    int maxFiles;
+    QFile file;
+    qint64 currentSize;
+    bool opened;
+
+    std::unique_ptr<std::thread> worker;
+    QMutex mutex;
+    QWaitCondition condition;
+    QList<LogEntry> queue;
+    bool stopping;
+    qint64 dropped;
+
+    static constexpr int MAX_QUEUE = 10000;
+};
+
+#endif // LOG_FILE_SINK_H
@@ -0,0 +1,125 @@
+#include "log_model.h"
+#include "log_file_sink.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QBrush>
+#include <QColor>
+
+LogModel::LogModel(int capacity, QObject *parent)
+    : QAbstractListModel(parent)
+    , head(0)
+    , count(0)
+    , evicted(0)
+    , fileSink(nullptr)
+{
+    ring.resize(qMax(1, capacity));
+
+    connect(&flushTimer, &QTimer::timeout, this, &LogModel::flushPending);
+    flushTimer.start(FLUSH_INTERVAL_MS);
+}
+
+LogModel::~LogModel()
+{
+    delete fileSink;
+}
+
+void LogModel::setFileSink(LogFileSink* sink)
+{
+    QMutexLocker locker(&pendingMutex);
+    delete fileSink;
+    fileSink = sink;
+}
+
+void LogModel::append(const QString& text, LogLevel level)
+{
+    LogEntry entry;
+    entry.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    entry.level = level;
+    entry.text = text;
+
+    QMutexLocker locker(&pendingMutex);
+
+    // 文件输出不受界面容量限制，直接交给写线程
+    if (fileSink) {
+        fileSink->write(entry);
+    }
+
+    // 界面来不及刷新时只保留最近 capacity 条
+    if (pending.size() >= ring.size()) {
+        pending.removeFirst();
+        evicted.fetch_add(1, std::memory_order_relaxed);
+    }
+    pending.append(std::move(entry));
+}
+
+void LogModel::flushPending()
+{
+    QList<LogEntry> batch;
+    {
+        QMutexLocker locker(&pendingMutex);
+        batch.swap(pending);
+    }
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    const int capacity = ring.size();
+    const int incoming = batch.size();
+
+    // 先移除最旧的条目腾出空间
+    const int overflow = qMin(count, count + incoming - capacity);
+    if (overflow > 0) {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        head = (head + overflow) % capacity;
+        count -= overflow;
+        evicted.fetch_add(overflow, std::memory_order_relaxed);
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), count, count + incoming - 1);
+    for (LogEntry& entry : batch) {
+        ring[(head + count) % capacity] = std::move(entry);
+        ++count;
+    }
+    endInsertRows();
+
+    emit entriesAppended();
+}
+
+int LogModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : count;
+}
+
+QVariant LogModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= count) {
+        return QVariant();
+    }
+
+    const LogEntry& entry = entryAt(index.row());
+    switch (role) {
+        case Qt::DisplayRole: {
+            // 行高固定，多行消息在列表中压成一行，完整内容见提示
+            QString timestamp = QDateTime::fromMSecsSinceEpoch(entry.timestampMs).toString("hh:mm:ss");
+            QString text = entry.text;
+            text.replace('\n', QLatin1String("  "));
+            return QString("[%1] %2").arg(timestamp, text);
+        }
+        case Qt::ToolTipRole:
+            return entry.text;
+        case Qt::ForegroundRole:
+            if (entry.level == LogLevel::Error) {
+                return QBrush(QColor(200, 0, 0));
+            }
+            if (entry.level == LogLevel::Warning) {
+                return QBrush(QColor(180, 110, 0));
+            }
+            if (entry.level == LogLevel::Debug) {
+                return QBrush(Qt::gray);
+            }
+            return QVariant();
+        default:
+            return QVariant();
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef LOG_MODEL_H
+#define LOG_MODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QList>
+#include <QMutex>
+#include <QTimer>
+#include <atomic>
+
+enum class LogLevel {
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+struct LogEntry {
+    qint64 timestampMs = 0;   // 毫秒级时间戳（自 1970 年起）
+    LogLevel level = LogLevel::Info;
+    QString text;
+};
+
+class LogFileSink;
+
+// 界面日志：固定容量的环形缓冲区 + 列表模型。
+// append 可在任意线程调用，新条目先进入待显示队列，由定时器按固定频率批量插入，
+// 配合 QListView 只绘制可见行，界面开销与运行时长无关。
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit LogModel(int capacity = 2000, QObject *parent = nullptr);
+    ~LogModel();
+
+    // 线程安全
+    void append(const QString& text, LogLevel level = LogLevel::Info);
+
+    // 设置文件输出（可选），LogModel 接管所有权
+    void setFileSink(LogFileSink* sink);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    int capacity() const { return ring.size(); }
+
+    // 因超出容量被移出界面的条目数（文件中仍然保留），线程安全
+    qint64 evictedCount() const { return evicted.load(std::memory_order_relaxed); }
+
+signals:
+    // 一批新条目已插入模型
+    void entriesAppended();
+
+private slots:
+    void flushPending();
+
+private:
+    const LogEntry& entryAt(int row) const { return ring[(head + row) % ring.size()]; }
+
+    QVector<LogEntry> ring;
+    int head;    // 最旧条目在 ring 中的位置
+    int count;   // 当前条目数
+    std::atomic<qint64> evicted;   // append（任意线程）和 flushPending（界面线程）都会累加
+
+    QMutex pendingMutex;
+    QList<LogEntry> pending;   // 等待插入模型的条目，最多 capacity 条
+    QTimer flushTimer;
+    LogFileSink* fileSink;
+
+    static constexpr int FLUSH_INTERVAL_MS = 100;
+};
+
+#endif // LOG_MODEL_H
@@ -19,41 +19,74 @@
 #include <QHBoxLayout>
 #include <QComboBox>
 #include <QLabel>
-#include <QUdpSocket>
-#include <QNetworkInterface>
-#include <QNetworkAddressEntry>
 #include "webrtcvad.h"
 #include <QMutex>
 #include <QMutexLocker>
 #include <QMetaObject>
 #include "vad_processor.h"
 #include "wake_word_detector.h"
+#include "log_file_sink.h"
+#include "device_identity.h"
+#include <QElapsedTimer>
+#include <QScrollBar>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , wsClient(nullptr)
+    , transport(nullptr)
+    , useMqtt(false)
+    , protocolVersionFromEnv(false)
+    , connectWhenConfigured(false)
+    , otaClient(nullptr)
+    , serverUrl("wss://api.tenclass.net/xiaozhi/v1/")  // 替换为实际的服务器地址
+    , connectionManager(nullptr)
+    , resumeListening(false)
     , networkManager(new QNetworkAccessManager(this))
-    , micManager(nullptr)
-    , speakerManager(nullptr)
-    , opusEncoder(nullptr)
-    , opusDecoder(nullptr)
+    , audioEngine(nullptr)
     , wakeWordDetector(nullptr)
+    , localAsr(nullptr)
     , isListening(false)
     , isRecording(false)
     , sessionId("")
     , deviceMacAddress("")
+    , logView(nullptr)
+    , logModel(nullptr)
+    , logFollowTail(true)
+    , fullDuplexCheckBox(nullptr)
+    , endpointCheckBox(nullptr)
+    , fullDuplexMode(false)
+    , ttsPlaying(false)
+    , dropTtsAudio(false)
+    , clientEndpointing(qEnvironmentVariable("XIAOZHI_LISTEN_MODE") != "manual")
+    , turnUtterance(-1)
+    , turnVadUtterance(0)
+    , turnSpeechSeen(false)
+    , turnUplinkBytes(0)
+    , turnSpeechEndMs(-1)
+    , localFallbackMs(qEnvironmentVariableIsSet("XIAOZHI_LOCAL_ASR_TIMEOUT_MS")
+                          ? qEnvironmentVariableIntValue("XIAOZHI_LOCAL_ASR_TIMEOUT_MS") : 3000)
     , SILENCE_THRESHOLD(500)
     , SILENCE_DURATION_MS(300)
     , lastActiveTime(0)
-    , VAD_SILENCE_FRAMES(100)
     , vadProcessor(nullptr)
 {
+    // 启动耗时按阶段记录到日志
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+    qint64 stageStart = 0;
+    auto traceStage = [&startupTimer, &stageStart](const char* stage) {
+        const qint64 now = startupTimer.elapsed();
+        qDebug().noquote() << QString("启动阶段 %1: %2 ms").arg(stage).arg(now - stageStart);
+        stageStart = now;
+    };
+    
     // 首先设置UI
     ui->setupUi(this);
+    traceStage("界面");
     
-    // 设置WebSocket
-    setupWebSocket();
+    // 设置传输层
+    setupTransport();
+    traceStage("传输层");
     
     // 将窗口移动到屏幕中央
     QRect screenGeometry = QApplication::primaryScreen()->geometry();
@@ -61,15 +94,19 @@ MainWindow::MainWindow(QWidget *parent)
     int y = (screenGeometry.height() - height()) / 2;
     move(x, y);
     
-    // 初始化设备MAC地址
-    deviceMacAddress = getMacAddress();
-    qDebug() << "设备MAC地址:" << deviceMacAddress;
+    // 初始化设备MAC地址：读缓存或路由表，不建立网络连接
+    const DeviceIdentity& identity = DeviceIdentity::current();
+    deviceMacAddress = identity.deviceId;
+    qDebug() << "设备MAC地址:" << deviceMacAddress << "来源:" << identity.source;
+    traceStage("设备标识");
     
-    // 检查固件版本
+    // 检查固件版本：先应用缓存的配置，再在后台刷新
     checkFirmwareVersion();
+    traceStage("OTA 配置");
     
     // 设置音频模块
     setupAudioModules();
+    traceStage("音频模块");
     
     // 连接录音按钮信号
     connect(ui->recordButton, &QPushButton::clicked, this, [this]() {
@@ -82,6 +119,8 @@ MainWindow::MainWindow(QWidget *parent)
     
     // 确保窗口可见
     show();
+    traceStage("显示窗口");
+    qDebug() << "启动总耗时:" << startupTimer.elapsed() << "ms";
     
     // 自动连接服务器
     QTimer::singleShot(500, this, [this]() {
@@ -91,13 +130,13 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // 先停网络线程，它直接向音频引擎送下行音频
+    delete transport;
+    // 再停音频线程，它还在向唤醒词检测器和 VAD 送数据
+    delete audioEngine;
     delete ui;
-    delete wsClient;
     delete networkManager;
-    delete micManager;
-    delete speakerManager;
-    delete opusEncoder;
-    delete opusDecoder;
+    delete localAsr;
     delete wakeWordDetector;
     delete vadProcessor;
 }
@@ -106,11 +145,8 @@ void MainWindow::setupAudioModules()
 {
     qDebug() << "开始初始化音频模块...";
     
-    // 创建音频模块实例
-    micManager = new MicrophoneManager(this);
-    speakerManager = new SpeakerManager(this);
-    opusEncoder = new OpusEncoder(this);
-    opusDecoder = new OpusDecoder(this);
+    // 音频设备和编解码器由音频线程创建
+    audioEngine = new AudioEngine();
     
     qDebug() << "开始初始化唤醒词检测器...";
     // 初始化唤醒词检测器
@@ -142,11 +178,38 @@ void MainWindow::setupAudioModules()
             wakeWordDetector = nullptr;
         } else {
             qDebug() << "唤醒词检测器初始化成功，准备启动...";
-            appendLog("唤醒词检测器初始化成功");
+            appendLog(QString("唤醒词检测器初始化成功，积压上限 %1ms").arg(wakeWordDetector->maxLagMs()));
             connect(wakeWordDetector, &WakeWordDetector::wakeWordDetected,
                     this, &MainWindow::onWakeWordDetected);
+            connect(wakeWordDetector, &WakeWordDetector::endpointDetected,
+                    this, &MainWindow::onEndpointDetected);
+            connect(wakeWordDetector, &WakeWordDetector::backlogDropped, this, [this](int chunks) {
+                appendLog(QString("唤醒词检测跟不上实时，跳过 %1 块积压音频（累计 %2 块）")
+                          .arg(chunks).arg(wakeWordDetector->droppedChunks()));
+            });
             wakeWordDetector->start();
             qDebug() << "唤醒词检测器启动完成";
+            
+            // 本地识别另开一个识别器，模型只加载一次
+            localAsr = new LocalAsr(this);
+            if (localAsr->initialize(wakeWordDetector->voskModel(), modelPath)) {
+                connect(localAsr, &LocalAsr::partialResult,
+                        this, &MainWindow::onLocalPartialResult);
+                connect(localAsr, &LocalAsr::finalResult,
+                        this, &MainWindow::onLocalFinalResult);
+                connect(localAsr, &LocalAsr::backlogDropped, this, [this](int chunks) {
+                    appendLog(QString("本地识别跟不上实时，跳过 %1 块积压音频（累计 %2 块）")
+                              .arg(chunks).arg(localAsr->droppedChunks()));
+                });
+                localAsr->start();
+                appendLog(QString("本地识别已启用，解码参数: %1，积压上限 %2ms")
+                          .arg(localAsr->decodeOptions().summary()).arg(localAsr->maxLagMs()));
+                updateConnectionStatus(transport->isConnected());
+            } else {
+                appendLog("本地识别初始化失败");
+                delete localAsr;
+                localAsr = nullptr;
+            }
         }
     }
     
@@ -156,121 +219,188 @@ void MainWindow::setupAudioModules()
     int channels = 1;
     int frameDuration = 60;
     
-    micManager->configureAudioParams(sampleRate, channels);
-    speakerManager->configureAudioParams(sampleRate, channels);
-    opusEncoder->initialize(sampleRate, channels, frameDuration);
-    opusDecoder->initialize(sampleRate, channels, frameDuration);
-    
-    // 连接麦克风PCM数据信号
-    connect(micManager, &MicrophoneManager::pcmDataReady,
-            this, &MainWindow::onPCMDataReady);
-    
     qDebug() << "初始化 VAD 处理器...";
     // 初始化 VAD 处理器
     vadProcessor = new VadProcessor(nullptr);
-    vadProcessor->setVadFrames(VAD_SILENCE_FRAMES);
+    // 起止阈值和拖尾时长可通过 XIAOZHI_VAD_* 环境变量调整
+    vadProcessor->setConfig(VadEngine::Config::fromEnvironment());
     
     // 连接信号
     connect(vadProcessor, &VadProcessor::silenceDetected,
             this, &MainWindow::handleSilenceDetected,
             Qt::QueuedConnection);
-    
+    connect(vadProcessor, &VadProcessor::speechStarted,
+            this, &MainWindow::onSpeechStarted,
+            Qt::QueuedConnection);
     vadProcessor->start();
+    
+    // 上行音频和事件由音频线程通过无锁队列送回
+    connect(audioEngine, &AudioEngine::uplinkReady,
+            this, &MainWindow::onUplinkReady, Qt::QueuedConnection);
+    connect(audioEngine, &AudioEngine::eventReady,
+            this, &MainWindow::onAudioEvent, Qt::QueuedConnection);
+    
+    // 启动音频线程（可通过环境变量开启实时优先级和 CPU 绑定）
+    audioEngine->setWakeWordDetector(wakeWordDetector);
+    audioEngine->setVadProcessor(vadProcessor);
+    audioEngine->setLocalAsr(localAsr);
+    if (!audioEngine->start(AudioEngine::Options::fromEnvironment(), sampleRate, channels, frameDuration)) {
+        appendLog("音频设备初始化失败");
+    }
     qDebug() << "音频模块初始化完成";
 }
 
-void MainWindow::handleSilenceDetected()
+void MainWindow::handleSilenceDetected(qint64 endSample, qint64 delayMs, int utterance)
 {
-    qDebug() << "检测到持续静音，准备停止录音";
-    
-    // 设置标志，防止新的音频数据进入
-    isRecording = false;
-    isListening = false;
-    
-    // 停止录音
-    if (micManager) {
-        micManager->stopRecording();
-    }
-    
-    // 发送停止监听状态
-    if (wsClient && wsClient->isConnected()) {
-        sendListenState("stop", "manual");
+    Q_UNUSED(endSample);
+    // 与 Vosk 端点相同：重置前排队的音频产生的语音结束属于上一轮，忽略
+    if (utterance != turnVadUtterance) {
+        return;
     }
-    
-    // 更新UI状态
-    updateConnectionStatus(wsClient && wsClient->isConnected());
-    appendLog("检测到持续静音，停止录音");
+    finishUtterance("VAD", delayMs);
 }
 
-void MainWindow::onPCMDataReady(const QByteArray& pcmData)
+void MainWindow::onEndpointDetected(const QString& text, int utterance)
 {
-    if (!isRecording) {
-        qDebug() << "当前未在录音状态，忽略PCM数据";
+    // 只接受本轮开始之后的端点，之前排队的旧端点忽略
+    if (utterance != turnUtterance) {
         return;
     }
-    
-    // 发送数据到唤醒词检测器
-    if (wakeWordDetector)
-        wakeWordDetector->processAudioData(pcmData);
-
-        return;
-    
-    
-    // 发送数据到 VAD 处理器进行处理
-    // vadProcessor->processAudioData(pcmData);
-    
-    // 再次检查录音状态，避免在停止过程中继续处理数据
-    if (!isRecording) {
-        qDebug() << "录音已停止，不再处理音频数据";
+    if (!turnSpeechSeen && text.isEmpty()) {
+        finishUtterance("开头静音超时", 0);
         return;
     }
+    // Vosk 在识别出内容后静音 ENDPOINT_END_S 判定一句结束，通常与 VAD 拖尾相当，
+    // 两者谁先到用谁；VAD 漏掉的轻声也能由识别结果兜底
+    finishUtterance("Vosk 端点", 500);
+}
+
+void MainWindow::onLocalPartialResult(const QString& text)
+{
+    transcriptLabel->setText(text);
+}
 
-    if (!wsClient || !wsClient->isConnected()) {
-        qDebug() << "WebSocket未连接，无法发送音频数据";
+void MainWindow::onLocalFinalResult(const QString& text, qint64 audioMs, double realTimeFactor)
+{
+    transcriptLabel->setText(text);
+    appendLog(QString("本地识别: %1（音频 %2 秒，实时率 %3，解码延迟 %4ms）")
+                  .arg(text.isEmpty() ? "无内容" : text)
+                  .arg(audioMs / 1000.0, 0, 'f', 1)
+                  .arg(realTimeFactor, 0, 'f', 3)
+                  .arg(localAsr->lagMs()));
+    if (text.isEmpty()) {
         return;
     }
     
-    if (!opusEncoder) {
-        qDebug() << "Opus编码器未初始化";
+    // 服务器不可用：保留结果，重新连接后作为文本请求发送
+    if (!transport || !transport->isConnected()) {
+        pendingLocalQuery = text;
+        pendingLocalQueryAge.start();
+        appendLog("服务器未连接，连接后发送本地识别结果");
         return;
     }
- 
-    QByteArray opusData = opusEncoder->encode(pcmData);
-    if (opusData.isEmpty()) {
-        qDebug() << "Opus编码失败";
+    
+    // 服务器识别结果已到（onSttMessage 清除了说话结束时刻），或未开启兜底
+    if (turnSpeechEndMs < 0 || localFallbackMs <= 0) {
         return;
     }
-    
-    if (wsClient && wsClient->isConnected()) {
-        std::vector<uint8_t> data(opusData.begin(), opusData.end());
-        wsClient->sendAudio(data);
+    localTranscript = text;
+    const qint64 waited = turnClock.elapsed() - turnSpeechEndMs;
+    QTimer::singleShot(qMax<qint64>(0, localFallbackMs - waited), this, [this, text]() {
+        // 期间收到了服务器结果，或已经开始新的一轮
+        if (turnSpeechEndMs < 0 || localTranscript != text) {
+            return;
+        }
+        appendLog(QString("说话结束 %1 ms 后仍无服务器识别结果，改发本地识别结果")
+                      .arg(turnClock.elapsed() - turnSpeechEndMs));
+        turnSpeechEndMs = -1;
+        sendTextQuery(text);
+    });
+}
+
+QString MainWindow::listenMode() const
+{
+    if (fullDuplexMode) {
+        return "realtime";
+    }
+    return clientEndpointing ? "auto" : "manual";
+}
+
+void MainWindow::finishUtterance(const QString& reason, qint64 delayMs)
+{
+    // 全双工由服务器断句，手动模式由用户停止
+    if (!isListening || fullDuplexMode || !clientEndpointing) {
+        return;
     }
+    
+    qDebug() << "本地断句:" << reason << "判决延迟:" << delayMs << "ms";
+    turnSpeechEndMs = turnClock.elapsed() - delayMs;
+    
+    // 立即停止上传和编码，再通知服务器
+    isRecording = false;
+    setListening(false);
+    audioEngine->stopCapture();
+    sendListenState("stop", listenMode());
+    
+    updateConnectionStatus(transport && transport->isConnected());
+    appendLog(QString("本地断句（%1），停止录音，本轮上行 %2 字节（%3 秒）")
+                  .arg(reason)
+                  .arg(turnUplinkBytes)
+                  .arg(turnClock.elapsed() / 1000.0, 0, 'f', 1));
 }
 
-void MainWindow::onAudioReceived(const std::vector<uint8_t>& data)
+void MainWindow::onUplinkReady()
 {
-    QByteArray opusData(reinterpret_cast<const char*>(data.data()), data.size());
+    audioEngine->drainUplink([this](const QByteArray& opusData) {
+        if (!transport || !transport->isConnected()) {
+            return;
+        }
+        transport->sendAudio(opusData);
+        turnUplinkBytes += opusData.size();
+    });
+}
 
-    // qDebug() << "收到音频数据，大小:" << data.size() << "字节";
-    // qDebug() << "转换后的Opus数据大小:" << opusData.size() << "字节";
+void MainWindow::onAudioEvent()
+{
+    audioEngine->drainEvents([this](const AudioEngine::Event& event) {
+        switch (event.type) {
+            case AudioEngine::EventType::CaptureFailed:
+                appendLog(event.text.isEmpty() ? QString("启动录音失败") : "录音失败: " + event.text);
+                isRecording = false;
+                if (isListening) {
+                    setListening(false);
+                    sendListenState("stop", "manual");  // 通知服务器停止监听
+                }
+                break;
+            case AudioEngine::EventType::BargeInSilence:
+                qDebug() << "打断: abort到播放静音延迟:" << event.value << "ms";
+                appendLog(QString("打断: abort到静音延迟 %1 ms").arg(event.value));
+                break;
+            case AudioEngine::EventType::BargeInUpload:
+                qDebug() << "打断: 检测到语音到首帧上传延迟:" << event.value << "ms";
+                appendLog(QString("打断: 语音到上传延迟 %1 ms").arg(event.value));
+                break;
+            case AudioEngine::EventType::MicrophoneSwitched:
+                appendLog(QString("麦克风已切换到: %1，耗时 %2 ms").arg(event.text).arg(event.value));
+                break;
+            case AudioEngine::EventType::SpeakerSwitched:
+                appendLog(QString("扬声器已切换到: %1，耗时 %2 ms").arg(event.text).arg(event.value));
+                break;
+        }
+    });
+}
 
-    // 保存opus数据到文件，包含帧长度信息
-    // QFile file("recv.opus");
-    // if (file.open(QIODevice::Append)) {
-    //     QDataStream stream(&file);
-    //     stream.setByteOrder(QDataStream::LittleEndian);
-    //     // 写入帧长度（2字节）和数据
-    //     stream << (quint16)opusData.size();
-    //     stream.writeRawData(opusData.constData(), opusData.size());
-    //     file.close();
-    // }
+void MainWindow::onAudioReceived(const QByteArray& opusData, qint64 timestamp)
+{
+    if (dropTtsAudio) {
+        return;
+    }
     
-    QByteArray pcmData = opusDecoder->decode(opusData);
-    if (!pcmData.isEmpty()) {
-        speakerManager->playPCM(pcmData);
+    // 在网络线程中调用，不经过 GUI 线程。解码和播放在音频线程中完成，
+    // opusData 只在回调期间有效，由 pushDownlink 复制
+    if (!audioEngine->pushDownlink(opusData, timestamp)) {
+        qDebug() << "下行音频队列已满，丢弃" << opusData.size() << "字节";
     }
-    // appendLog(QString("解码后的PCM数据帧长度: %1 字节").arg(pcmData.size()));
-    // appendLog(QString("收到音频数据: %1 字节").arg(data.size()));
 }
 
 void MainWindow::startRecording()
@@ -279,15 +409,12 @@ void MainWindow::startRecording()
         return;
     }
     
-    // 开始录音
-    if (micManager->startRecording()) {
-        isRecording = true;
-        if (this->isVisible() && ui && ui->recordButton) {
-            ui->recordButton->setText("停止录音");
-            appendLog("开始录音");
-        }
-    } else {
-        appendLog("启动录音失败");
+    // 开始录音，失败时音频线程会发回 CaptureFailed 事件
+    audioEngine->startCapture();
+    isRecording = true;
+    if (this->isVisible() && ui && ui->recordButton) {
+        ui->recordButton->setText("停止录音");
+        appendLog("开始录音");
     }
 }
 
@@ -308,7 +435,7 @@ void MainWindow::stopRecording()
     isRecording = false;  // 先设置标志，防止新的音频数据进入
     
     // 停止录音
-    micManager->stopRecording();
+    audioEngine->stopCapture();
     
     // 更新UI（如果UI组件还存在且窗口可见）
     if (this->isVisible()) {
@@ -321,31 +448,95 @@ void MainWindow::stopRecording()
     }
 }
 
-void MainWindow::setupWebSocket()
+void MainWindow::setupTransport()
 {
-    wsClient = new WebSocketClient(this);
+    bool ok = false;
+    // 二进制协议版本默认为 1（与只实现版本 1 的服务器兼容），指定后请求 2/3；
+    // 未指定时也可由 OTA 配置的 websocket.version 给出
+    int protocolVersion = qEnvironmentVariableIntValue("XIAOZHI_PROTOCOL_VERSION", &ok);
+    protocolVersionFromEnv = ok;
+    const int preferredVersion = ok ? protocolVersion : 1;
+    // 不小于该长度的 JSON 控制消息压缩发送（服务器同意时），0 表示不压缩
+    int deflateThreshold = qEnvironmentVariableIntValue("XIAOZHI_DEFLATE_THRESHOLD", &ok);
+    const int compressionThreshold = ok ? deflateThreshold : 256;
+    useMqtt = qEnvironmentVariable("XIAOZHI_TRANSPORT") == "mqtt";
+    const bool mqtt = useMqtt;
+    
+    // 传输层在独立的网络线程中运行，界面卡顿不影响收发
+    transport = new ThreadedTransport([mqtt, preferredVersion, compressionThreshold]() -> Transport* {
+        if (mqtt) {
+            // MQTT 控制 + UDP 音频，连接参数来自 OTA 响应
+            return new MqttUdpTransport();
+        }
+        WebSocketClient* wsClient = new WebSocketClient();
+        wsClient->setPreferredProtocolVersion(preferredVersion);
+        wsClient->setCompressionThreshold(compressionThreshold);
+        return wsClient;
+    }, this);
+    // 下行音频在网络线程中直接交给音频引擎，见 onAudioReceived
+    transport->setAudioCallbackOnNetworkThread(true);
+    // 新一轮 TTS 的音频可能先于 GUI 线程处理 tts start 到达，
+    // 所以丢弃标志在网络线程中按消息到达顺序清除
+    transport->setNetworkMessageObserver([this](const Protocol::Message& message) {
+        const Protocol::TtsMessage* tts = std::get_if<Protocol::TtsMessage>(&message);
+        if (tts && tts->state == Protocol::TtsState::Start) {
+            dropTtsAudio = false;
+        }
+    });
     
-    // 设置WebSocket回调
-    wsClient->setOnConnectedCallback([this]() {
-        onWebSocketConnected();
+    // 设置传输层回调
+    // 保活间隔和允许丢失的响应数可通过环境变量调整
+    int keepAliveMs = qEnvironmentVariableIntValue("XIAOZHI_KEEPALIVE_MS", &ok);
+    int maxMissed = qEnvironmentVariableIntValue("XIAOZHI_KEEPALIVE_MISSED");
+    transport->setKeepAlive(ok ? keepAliveMs : 5000, maxMissed > 0 ? maxMissed : 3);
+    transport->setOnRttCallback([this](qint64 sampleMs, double srttMs) {
+        Q_UNUSED(sampleMs);
+        statusLabel->setText(QString("已连接（RTT %1 ms）").arg(qRound(srttMs)));
     });
     
-    wsClient->setOnDisconnectedCallback([this]() {
-        onWebSocketDisconnected();
+    // 连接状态由 ConnectionManager 管理，断线后自动重连
+    connectionManager = new ConnectionManager(transport, this);
+    connect(connectionManager, &ConnectionManager::connected,
+            this, &MainWindow::onWebSocketConnected);
+    connect(connectionManager, &ConnectionManager::disconnected,
+            this, &MainWindow::onWebSocketDisconnected);
+    connect(connectionManager, &ConnectionManager::reconnecting,
+            this, [this](int attempt, int delayMs) {
+        appendLog(QString("%1 ms 后进行第 %2 次重连").arg(delayMs).arg(attempt));
+    });
+    connect(connectionManager, &ConnectionManager::reconnected,
+            this, [this](qint64 elapsedMs) {
+        appendLog(QString("重连成功，耗时 %1 ms（共 %2 次，p50 %3 ms / p90 %4 ms / p99 %5 ms）")
+                  .arg(elapsedMs)
+                  .arg(connectionManager->reconnectCount())
+                  .arg(connectionManager->reconnectPercentile(50))
+                  .arg(connectionManager->reconnectPercentile(90))
+                  .arg(connectionManager->reconnectPercentile(99)));
     });
     
-    wsClient->setOnJsonCallback([this](const QString& json) {
+    transport->setOnJsonCallback([this](const QString& json) {
         onJsonReceived(json);
     });
     
-    wsClient->setOnAudioCallback([this](const std::vector<uint8_t>& data) {
-        onAudioReceived(data);
+    transport->setOnAudioPacketCallback([this](const QByteArray& opusData, qint64 timestamp) {
+        onAudioReceived(opusData, timestamp);
     });
     
-    wsClient->setOnAudioParamsCallback([this](const AudioParams& params) {
+    // 按消息类型注册处理函数，每条消息只解析一次
+    Protocol::MessageDispatcher& dispatcher = transport->dispatcher();
+    dispatcher.on<Protocol::HelloMessage>([this](const Protocol::HelloMessage& hello) {
+        onHelloMessage(hello);
+    });
+    dispatcher.on<Protocol::SttMessage>([this](const Protocol::SttMessage& stt) {
+        onSttMessage(stt);
+    });
+    dispatcher.on<Protocol::TtsMessage>([this](const Protocol::TtsMessage& tts) {
+        onTtsMessage(tts);
+    });
+    
+    transport->setOnAudioParamsCallback([this](const AudioParams& params) {
         // 只更新解码器和扬声器的参数，保持麦克风配置不变
-        speakerManager->configureAudioParams(params.sampleRate, params.channels);
-        opusDecoder->initialize(params.sampleRate, params.channels, params.frameDuration);
+        audioEngine->configurePlayback(params.sampleRate, params.channels, params.frameDuration);
         
         qDebug() << "音频解码和播放参数已更新:"
                  << "\n  采样率:" << params.sampleRate
@@ -371,6 +562,11 @@ void MainWindow::setupWebSocket()
     statusLabel = new QLabel("未连接", this);
     mainLayout->addWidget(statusLabel);
     
+    // 本地识别预览
+    transcriptLabel = new QLabel(this);
+    transcriptLabel->setWordWrap(true);
+    mainLayout->addWidget(transcriptLabel);
+    
     // 录音控制
     startListenButton = new QPushButton("开始录音", this);
     stopListenButton = new QPushButton("停止录音", this);
@@ -379,10 +575,49 @@ void MainWindow::setupWebSocket()
     mainLayout->addWidget(startListenButton);
     mainLayout->addWidget(stopListenButton);
     
-    // 日志显示
-    logTextEdit = new QTextEdit(this);
-    logTextEdit->setReadOnly(true);
-    mainLayout->addWidget(logTextEdit);
+    // 全双工模式开关
+    fullDuplexCheckBox = new QCheckBox("全双工（播放时可打断）", this);
+    fullDuplexCheckBox->setChecked(fullDuplexMode);
+    connect(fullDuplexCheckBox, &QCheckBox::toggled, this, [this](bool checked) {
+        fullDuplexMode = checked;
+        audioEngine->setFullDuplex(checked);
+        appendLog(checked ? "已开启全双工模式" : "已关闭全双工模式");
+        if (checked && transport->isConnected() && !audioEngine->isCapturing()) {
+            audioEngine->startCapture();
+            isRecording = true;
+        }
+    });
+    mainLayout->addWidget(fullDuplexCheckBox);
+    
+    // 半双工下的断句方式：本地 VAD/Vosk 端点自动停止，或手动点击停止
+    endpointCheckBox = new QCheckBox("本地断句（说完自动停止录音）", this);
+    endpointCheckBox->setChecked(clientEndpointing);
+    connect(endpointCheckBox, &QCheckBox::toggled, this, [this](bool checked) {
+        clientEndpointing = checked;
+        appendLog(checked ? "已开启本地断句" : "已关闭本地断句，需手动停止录音");
+    });
+    mainLayout->addWidget(endpointCheckBox);
+    
+    // 日志显示：固定容量的模型，列表只绘制可见行
+    logModel = new LogModel(LOG_CAPACITY, this);
+    const QString logFile = qEnvironmentVariable("XIAOZHI_LOG_FILE");
+    if (!logFile.isEmpty()) {
+        logModel->setFileSink(new LogFileSink(logFile));
+    }
+    logView = new QListView(this);
+    logView->setModel(logModel);
+    logView->setUniformItemSizes(true);
+    logView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    logView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    connect(logView->verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+        logFollowTail = value == logView->verticalScrollBar()->maximum();
+    });
+    connect(logModel, &LogModel::entriesAppended, this, [this]() {
+        if (logFollowTail) {
+            logView->scrollToBottom();
+        }
+    });
+    mainLayout->addWidget(logView);
     
     // 初始状态
     updateConnectionStatus(false);
@@ -390,148 +625,262 @@ void MainWindow::setupWebSocket()
 
 void MainWindow::onConnectClicked()
 {
-    if (!wsClient->isConnected()) {
-        QString url = "wss://api.tenclass.net/xiaozhi/v1/";  // 替换为实际的服务器地址
-        wsClient->connectToServer(url);
+    if (!transport->isConnected()) {
+        QString url = serverUrl;
+        if (useMqtt) {
+            if (!mqttConfig.isValid()) {
+                appendLog("等待 OTA 下发 MQTT 配置后连接");
+                connectWhenConfigured = true;
+                return;
+            }
+            url = mqttConfig.url();
+        }
+        connectionManager->start(url);
         connectButton->setEnabled(false);
     } else {
-        wsClient->closeConnection();
+        connectionManager->stop();
     }
 }
 
 void MainWindow::onStartListenClicked()
 {
-    if (!wsClient->isConnected()) {
+    // 服务器未连接时只做本地识别
+    const bool connected = transport->isConnected();
+    if (!connected && !localAsr) {
         appendLog("WebSocket未连接");
         return;
     }
     
     qDebug() << "开始监听流程:";
-    qDebug() << "  - WebSocket状态:" << (wsClient->isConnected() ? "已连接" : "未连接");
+    qDebug() << "  - WebSocket状态:" << (transport->isConnected() ? "已连接" : "未连接");
     qDebug() << "  - 当前监听状态:" << (isListening ? "正在监听" : "未监听");
     qDebug() << "  - 当前录音状态:" << (isRecording ? "正在录音" : "未录音");
     
-    isListening = true;
-    isRecording = true;  // 设置录音状态
-    updateConnectionStatus(true);
-    
-    // 发送开始监听状态
-    sendListenState("start", "manual");
+    beginTurn(listenMode());
+    if (connected) {
+        updateConnectionStatus(true);
+    } else {
+        appendLog("服务器未连接，仅本地识别");
+    }
     appendLog("开始监听");
     
-    // 开始录音
-    if (micManager->startRecording()) {
-        appendLog("开始录音");
-    } else {
-        appendLog("启动录音失败");
-        isRecording = false;  // 如果启动失败，重置状态
-        sendListenState("stop", "manual"); // 通知服务器停止监听
+    // 全双工模式下麦克风可能已经常开
+    if (audioEngine->isCapturing()) {
+        return;
+    }
+    
+    // 开始录音，失败时音频线程发回 CaptureFailed 事件，再通知服务器停止监听
+    audioEngine->startCapture();
+    appendLog("开始录音");
+}
+
+void MainWindow::beginTurn(const QString& mode)
+{
+    // 新的一轮：清空本轮统计和 VAD 状态，Vosk 端点从现在开始计时
+    turnSpeechSeen = false;
+    turnUplinkBytes = 0;
+    turnSpeechEndMs = -1;
+    turnClock.start();
+    localTranscript.clear();
+    transcriptLabel->clear();
+    
+    setListening(true);
+    isRecording = true;  // 设置录音状态
+    if (vadProcessor) {
+        turnVadUtterance = vadProcessor->reset();
     }
+    if (wakeWordDetector) {
+        turnUtterance = wakeWordDetector->resetUtterance();
+    }
+    
+    // 发送开始监听状态
+    sendListenState("start", mode);
 }
 
 void MainWindow::onStopListenClicked()
 {
     if (isListening) {
         // 发送停止监听状态
-        sendListenState("stop", "manual");
+        sendListenState("stop", listenMode());
+        turnSpeechEndMs = turnClock.elapsed();
+        appendLog(QString("本轮上行 %1 字节").arg(turnUplinkBytes));
     }
     
-    isListening = false;
-    isRecording = false;  // 重置录音状态
-    updateConnectionStatus(true);
+    setListening(false);
+    updateConnectionStatus(transport->isConnected());
     appendLog("停止监听");
     
-    micManager->stopRecording();
+    // 全双工模式下保持麦克风常开
+    if (fullDuplexMode) {
+        return;
+    }
+    
+    isRecording = false;  // 重置录音状态
+    audioEngine->stopCapture();
 }
 
 void MainWindow::onWebSocketConnected()
 {
     updateConnectionStatus(true);
-    appendLog("已连接到服务器");
+    appendLog(QString("已连接到服务器，二进制协议版本 %1").arg(transport->protocolVersion()));
+    
+    // hello 握手已由传输层完成（WebSocket 的 hello 带压缩提议），这里不再发送：
+    // 第二个 hello 不带压缩提议，MQTT 下还会让服务器重新分配 UDP 会话
     
-    // 连接成功后发送 hello 消息
-    sendHelloMessage();
+    // 全双工模式下整个会话期间麦克风常开
+    if (fullDuplexMode && !audioEngine->isCapturing()) {
+        audioEngine->startCapture();
+        isRecording = true;
+    }
 }
 
 void MainWindow::onWebSocketDisconnected()
 {
+    // 自动重连时记住监听状态，收到新会话的 hello 后恢复
+    const bool reconnecting = connectionManager->isReconnecting();
+    resumeListening = reconnecting && isListening;
+    
+    // 旧会话已失效，新的 hello 需要重新获取 session_id
+    sessionId.clear();
+    
     updateConnectionStatus(false);
-    appendLog("已断开连接");
+    appendLog(reconnecting ? "连接断开，正在自动重连" : "已断开连接");
     
     // 确保停止录音
     if (isListening) {
-        micManager->stopRecording();
-        isListening = false;
+        audioEngine->stopCapture();
+        setListening(false);
+    }
+    
+    // 全双工会话结束，关闭常开的麦克风
+    if (fullDuplexMode && audioEngine->isCapturing()) {
+        audioEngine->stopCapture();
+        isRecording = false;
     }
+    ttsPlaying = false;
+    audioEngine->stopPlayback();
 }
 
 void MainWindow::onJsonReceived(const QString& json)
 {
+    // 消息已由 WebSocketClient 解析并分发到 on*Message，这里只记录原文
     appendLog("收到消息: " + json);
+}
+
+void MainWindow::onHelloMessage(const Protocol::HelloMessage& hello)
+{
+    // 只在首次收到hello消息时处理
+    if (!sessionId.isEmpty()) {
+        return;
+    }
+    
+    sessionId = hello.sessionId;
+    appendLog("获取到session_id: " + sessionId);
+    
+    // 断线期间本地识别的一句话，不太旧的补发给服务器
+    if (!pendingLocalQuery.isEmpty()) {
+        if (pendingLocalQueryAge.elapsed() <= LOCAL_QUERY_MAX_AGE_MS) {
+            sendTextQuery(pendingLocalQuery);
+        }
+        pendingLocalQuery.clear();
+    }
     
-    QJsonDocument doc = QJsonDocument::fromJson(json.toUtf8());
-    if (!doc.isNull()) {
-        QJsonObject root = doc.object();
-        QString type = root["type"].toString();
+    // 检查并更新音频参数
+    if (hello.hasAudioParams) {
+        const AudioParams& params = hello.audioParams;
         
-        if (type == "hello") {
-            // 只在首次收到hello消息时处理
-            if (sessionId.isEmpty()) {
-                sessionId = root["session_id"].toString();
-                appendLog("获取到session_id: " + sessionId);
-                
-                // 检查并更新音频参数
-                if (root.contains("audio_params")) {
-                    QJsonObject params = root["audio_params"].toObject();
-                    int sampleRate = params["sample_rate"].toInt();
-                    int channels = params["channels"].toInt();
-                    int frameDuration = params["frame_duration"].toInt();
-                    
-                    // 更新音频参数
-                    speakerManager->configureAudioParams(sampleRate, channels);
-                    opusDecoder->initialize(sampleRate, channels, frameDuration);
-                    
-                    appendLog(QString("更新音频参数: 采样率=%1, 通道数=%2, 帧长=%3ms")
-                            .arg(sampleRate)
-                            .arg(channels)
-                            .arg(frameDuration));
-                }
-                
-                // 在成功连接并收到hello消息后检查固件版本
-                // checkFirmwareVersion();
+        // 更新音频参数
+        audioEngine->configurePlayback(params.sampleRate, params.channels, params.frameDuration);
+        
+        appendLog(QString("更新音频参数: 采样率=%1, 通道数=%2, 帧长=%3ms")
+                .arg(params.sampleRate)
+                .arg(params.channels)
+                .arg(params.frameDuration));
+    }
+    
+    // 在成功连接并收到hello消息后检查固件版本
+    // checkFirmwareVersion();
+    
+    // 重连前正在监听，使用新的 session_id 恢复
+    if (resumeListening) {
+        resumeListening = false;
+        appendLog("恢复断线前的监听状态");
+        onStartListenClicked();
+    }
+}
+
+void MainWindow::onSttMessage(const Protocol::SttMessage& stt)
+{
+    appendLog("语音识别结果: " + stt.text);
+    
+    // 本轮说话结束（本地断句或手动停止）到收到识别结果的时间
+    if (turnSpeechEndMs >= 0) {
+        appendLog(QString("说话结束到识别结果: %1 ms").arg(turnClock.elapsed() - turnSpeechEndMs));
+        turnSpeechEndMs = -1;
+    }
+    
+    // 检查是否是唤醒词：与本地检测使用同一份唤醒词配置和模糊匹配。
+    // 没有唤醒词模型时只读一次配置文件
+    bool wake = false;
+    if (wakeWordDetector) {
+        wake = wakeWordDetector->matchesWakeWord(stt.text);
+    } else {
+        static const WakeWordMatcher fallback([]() {
+            WakeWordMatcher::Config config;
+            QString error;
+            if (!WakeWordMatcher::Config::loadIfExists(WakeWordMatcher::Config::defaultPath(), &config, &error)) {
+                qDebug() << "唤醒词配置无效，使用默认唤醒词:" << error;
+                config = WakeWordMatcher::Config();
             }
-        }
-        else if (type == "stt") {
-            QString text = root["text"].toString();
-            appendLog("语音识别结果: " + text);
-            
-            // 检查是否是唤醒词
-            if (text.startsWith("你好小智") || text.startsWith("小智小智")) {
-                sendWakeWordDetected(text);
+            return config;
+        }());
+        wake = fallback.matches(stt.text.toLower());
+    }
+    if (wake) {
+        sendWakeWordDetected(stt.text);
+    }
+}
+
+void MainWindow::onTtsMessage(const Protocol::TtsMessage& tts)
+{
+    if (tts.state == Protocol::TtsState::Start) {
+        appendLog("开始播放TTS");
+        ttsPlaying = true;
+        
+        if (fullDuplexMode) {
+            // 麦克风保持常开，只停止上传；VAD 和唤醒词继续运行用于打断
+            setListening(false);
+            if (vadProcessor) {
+                turnVadUtterance = vadProcessor->reset();
             }
         }
-        else if (type == "tts") {
-            QString state = root["state"].toString();
-            if (state == "start") {
-                appendLog("开始播放TTS");
-                // 如果正在录音，先停止录音并发送中断消息
-                if (isListening) {
-                    sendAbortMessage("tts_playback");
-                    micManager->stopRecording();
-                    isListening = false;
-                    isRecording = false;
-                    updateConnectionStatus(true);
-                }
-            }
-            else if (state == "stop") {
-                appendLog("TTS播放结束");
-                speakerManager->stopPlaying();
-                
-                // TTS播放结束后，可以根据需要自动恢复录音
-                if (!isListening) {
-                    onStartListenClicked();
-                }
-            }
+        // 如果正在录音，先停止录音并发送中断消息
+        else if (isListening) {
+            sendAbortMessage("tts_playback");
+            audioEngine->stopCapture();
+            setListening(false);
+            isRecording = false;
+            updateConnectionStatus(true);
+        }
+    }
+    else if (tts.state == Protocol::TtsState::Stop) {
+        appendLog("TTS播放结束");
+        if (transport->downlinkStatistics().packets() > 0) {
+            appendLog(QString("下行音频: %1，补偿 %2 帧，迟到丢弃 %3 帧")
+                      .arg(transport->downlinkStatistics().summary())
+                      .arg(audioEngine->concealedFrames())
+                      .arg(audioEngine->lateFrames()));
+        }
+        // 一轮对话以 TTS 结束为界，统计本轮线上字节数
+        const WireStats wire = transport->wireStatistics();
+        appendLog("本轮流量: " + (wire - turnWireStats).summary());
+        turnWireStats = wire;
+        ttsPlaying = false;
+        // 播放缓冲区中剩余的音频在音频线程中自然播完，不再截断
+        
+        // TTS播放结束后，可以根据需要自动恢复录音
+        if (!isListening) {
+            onStartListenClicked();
         }
     }
 }
@@ -539,25 +888,26 @@ void MainWindow::onJsonReceived(const QString& json)
 void MainWindow::updateConnectionStatus(bool connected)
 {
     connectButton->setEnabled(!connected);
-    startListenButton->setEnabled(connected);
-    stopListenButton->setEnabled(connected);
+    // 有本地识别时断线也能录音
+    startListenButton->setEnabled(connected || localAsr);
+    stopListenButton->setEnabled(connected || localAsr);
     
     statusLabel->setText(connected ? "已连接" : "未连接");
     if (!connected) {
-        isListening = false;
+        setListening(false);
     }
 }
 
 void MainWindow::appendLog(const QString& text)
 {
-    QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss");
-    logTextEdit->append(QString("[%1] %2").arg(timestamp).arg(text));
+    // 只入队，由日志模型按固定频率批量刷新到界面
+    logModel->append(text);
 }
 
 void MainWindow::keyPressEvent(QKeyEvent* event)
 {
     if (event->key() == Qt::Key_F2 && !event->isAutoRepeat()) {
-        if (wsClient->isConnected() && !isListening) {
+        if (transport->isConnected() && !isListening) {
             onStartListenClicked();
         }
     }
@@ -567,7 +917,7 @@ void MainWindow::keyPressEvent(QKeyEvent* event)
 void MainWindow::keyReleaseEvent(QKeyEvent* event)
 {
     if (event->key() == Qt::Key_F2 && !event->isAutoRepeat()) {
-        if (wsClient->isConnected() && isListening) {
+        if (transport->isConnected() && isListening) {
             onStopListenClicked();
         }
     }
@@ -576,11 +926,10 @@ void MainWindow::keyReleaseEvent(QKeyEvent* event)
 
 void MainWindow::checkFirmwareVersion()
 {
-    QString url = "https://api.tenclass.net/xiaozhi/ota/";
-    
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("Device-Id", deviceMacAddress.toUtf8());
+    QString url = qEnvironmentVariable("XIAOZHI_OTA_URL");
+    if (url.isEmpty()) {
+        url = "https://api.tenclass.net/xiaozhi/ota/";
+    }
     
     // 构建请求数据
     QJsonObject payload;
@@ -614,83 +963,98 @@ void MainWindow::checkFirmwareVersion()
     payload["board"] = board;
     
     QJsonDocument doc(payload);
-    QByteArray data = doc.toJson();
-    
-    // 发送POST请求
-    QNetworkReply* reply = networkManager->post(request, data);
+    QByteArray data = doc.toJson(QJsonDocument::Compact);
     
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-        if (reply->error() == QNetworkReply::NoError) {
-            QByteArray response = reply->readAll();
-            QJsonDocument doc = QJsonDocument::fromJson(response);
-            QJsonObject root = doc.object();
-            
-            // 显示详细的配置信息
-            QString logMsg = "收到固件版本检查响应：";
-            if (root.contains("mqtt")) {
-                QJsonObject mqtt = root["mqtt"].toObject();
-                logMsg += "\nMQTT配置:";
-                if (mqtt.contains("endpoint")) {
-                    logMsg += "\n- 服务器: " + mqtt["endpoint"].toString();
-                }
-                if (mqtt.contains("client_id")) {
-                    logMsg += "\n- 客户端ID: " + mqtt["client_id"].toString();
-                }
-                if (mqtt.contains("publish_topic")) {
-                    logMsg += "\n- 发布主题: " + mqtt["publish_topic"].toString();
-                }
-                if (mqtt.contains("subscribe_topic")) {
-                    logMsg += "\n- 订阅主题: " + mqtt["subscribe_topic"].toString();
-                }
-            }
-            if (root.contains("firmware")) {
-                QJsonObject firmware = root["firmware"].toObject();
-                if (firmware.contains("version")) {
-                    logMsg += "\n固件版本: " + firmware["version"].toString();
-                }
-            }
-            if (root.contains("activation")) {
-                QJsonObject activation = root["activation"].toObject();
-                if (activation.contains("code")) {
-                    logMsg += "\n激活码: " + activation["code"].toString();
-                }
-            }
-            appendLog(logMsg);
+    otaClient = new OtaClient(networkManager, url, OtaClient::defaultCachePath(), this);
+    otaClient->setDevice(deviceMacAddress, DeviceIdentity::current().clientId, data);
+    connect(otaClient, &OtaClient::configUpdated, this, [this](const OtaConfig& config, bool connectionChanged) {
+        if (connectionChanged) {
+            applyOtaConfig(config, false);
         } else {
-            appendLog("固件版本检查失败: " + reply->errorString());
+            appendLog("OTA 配置已刷新，连接参数无变化");
         }
-        
-        reply->deleteLater();
     });
+    connect(otaClient, &OtaClient::refreshFailed, this, [this](const QString& error, int retryMs) {
+        appendLog(QString("固件版本检查失败: %1，%2 秒后重试").arg(error).arg(retryMs / 1000));
+    });
+    
+    // 上一次的响应立即可用，连接不必等待 OTA 请求
+    if (otaClient->loadCache()) {
+        applyOtaConfig(otaClient->config(), true);
+    }
+    otaClient->refresh();
 }
 
-void MainWindow::sendHelloMessage()
+void MainWindow::applyOtaConfig(const OtaConfig& config, bool fromCache)
 {
-    if (!wsClient || !wsClient->isConnected()) {
-        return;
+    // 显示详细的配置信息
+    QString logMsg = fromCache
+        ? QString("使用缓存的 OTA 配置（%1）：").arg(config.fetchedAt.toLocalTime().toString("yyyy-MM-dd HH:mm:ss"))
+        : QString("收到固件版本检查响应：");
+    if (!config.websocketUrl.isEmpty()) {
+        logMsg += "\nWebSocket: " + config.websocketUrl;
+        serverUrl = config.websocketUrl;
+        if (!useMqtt && !config.websocketToken.isEmpty()) {
+            const QString token = config.websocketToken;
+            transport->runInNetworkThread([token](Transport* inner) {
+                static_cast<WebSocketClient*>(inner)->setAccessToken(token);
+            });
+        }
+        // 环境变量优先；新的版本在下次连接时生效
+        if (!useMqtt && config.websocketVersion > 0 && !protocolVersionFromEnv) {
+            const int version = config.websocketVersion;
+            logMsg += QString("\n二进制协议版本: %1").arg(version);
+            transport->runInNetworkThread([version](Transport* inner) {
+                static_cast<WebSocketClient*>(inner)->setPreferredProtocolVersion(version);
+            });
+        }
     }
+    if (config.hasMqtt()) {
+        const QJsonObject& mqtt = config.mqtt;
+        logMsg += "\nMQTT配置:";
+        if (mqtt.contains("endpoint")) {
+            logMsg += "\n- 服务器: " + mqtt["endpoint"].toString();
+        }
+        if (mqtt.contains("client_id")) {
+            logMsg += "\n- 客户端ID: " + mqtt["client_id"].toString();
+        }
+        if (mqtt.contains("publish_topic")) {
+            logMsg += "\n- 发布主题: " + mqtt["publish_topic"].toString();
+        }
+        if (mqtt.contains("subscribe_topic")) {
+            logMsg += "\n- 订阅主题: " + mqtt["subscribe_topic"].toString();
+        }
+        if (useMqtt) {
+            mqttConfig = MqttConfig::fromJson(mqtt);
+            const MqttConfig mqttSettings = mqttConfig;
+            transport->runInNetworkThread([mqttSettings](Transport* inner) {
+                static_cast<MqttUdpTransport*>(inner)->setConfig(mqttSettings);
+            });
+        }
+    }
+    if (!config.firmwareVersion.isEmpty()) {
+        logMsg += "\n固件版本: " + config.firmwareVersion;
+    }
+    if (config.needsActivation()) {
+        logMsg += "\n激活码: " + config.activationCode;
+        if (!config.activationMessage.isEmpty()) {
+            logMsg += "\n" + config.activationMessage;
+        }
+    }
+    if (!fromCache && transport->isConnected()) {
+        logMsg += "\n新的连接参数在下次连接时生效";
+    }
+    appendLog(logMsg);
     
-    QJsonObject hello;
-    hello["type"] = "hello";
-    hello["version"] = 1;
-    hello["transport"] = "websocket";
-    
-    QJsonObject audioParams;
-    audioParams["format"] = "opus";
-    audioParams["sample_rate"] = 16000;
-    audioParams["channels"] = 1;
-    audioParams["frame_duration"] = 60;
-    
-    hello["audio_params"] = audioParams;
-    
-    QJsonDocument doc(hello);
-    wsClient->sendText(doc.toJson());
-    appendLog("发送Hello消息");
+    if (connectWhenConfigured && useMqtt && mqttConfig.isValid()) {
+        connectWhenConfigured = false;
+        onConnectClicked();
+    }
 }
 
 void MainWindow::sendListenState(const QString& state, const QString& mode)
 {
-    if (!wsClient || !wsClient->isConnected()) {
+    if (!transport || !transport->isConnected()) {
         return;
     }
     
@@ -701,13 +1065,13 @@ void MainWindow::sendListenState(const QString& state, const QString& mode)
     listen["mode"] = mode;
     
     QJsonDocument doc(listen);
-    wsClient->sendText(doc.toJson());
+    transport->sendText(doc.toJson(QJsonDocument::Compact));
     appendLog(QString("发送Listen状态: %1, 模式: %2").arg(state).arg(mode));
 }
 
 void MainWindow::sendAbortMessage(const QString& reason)
 {
-    if (!wsClient || !wsClient->isConnected()) {
+    if (!transport || !transport->isConnected()) {
         return;
     }
     
@@ -717,13 +1081,13 @@ void MainWindow::sendAbortMessage(const QString& reason)
     abort["reason"] = reason;
     
     QJsonDocument doc(abort);
-    wsClient->sendText(doc.toJson());
+    transport->sendText(doc.toJson(QJsonDocument::Compact));
     appendLog(QString("发送Abort消息，原因: %1").arg(reason));
 }
 
 void MainWindow::sendWakeWordDetected(const QString& text)
 {
-    if (!wsClient || !wsClient->isConnected()) {
+    if (!transport || !transport->isConnected()) {
         return;
     }
     
@@ -734,13 +1098,31 @@ void MainWindow::sendWakeWordDetected(const QString& text)
     detect["text"] = text;
     
     QJsonDocument doc(detect);
-    wsClient->sendText(doc.toJson());
+    transport->sendText(doc.toJson(QJsonDocument::Compact));
     appendLog(QString("发送唤醒词检测消息: %1").arg(text));
 }
 
+void MainWindow::sendTextQuery(const QString& text)
+{
+    if (!transport || !transport->isConnected()) {
+        return;
+    }
+    
+    // 服务器把 detect 消息中不是唤醒词的文本当作用户输入，直接进入对话
+    QJsonObject query;
+    query["type"] = "listen";
+    query["session_id"] = sessionId;
+    query["state"] = "detect";
+    query["text"] = text;
+    
+    QJsonDocument doc(query);
+    transport->sendText(doc.toJson(QJsonDocument::Compact));
+    appendLog(QString("发送本地识别文本: %1").arg(text));
+}
+
 void MainWindow::sendIoTState(const QJsonObject& states)
 {
-    if (!wsClient || !wsClient->isConnected()) {
+    if (!transport || !transport->isConnected()) {
         return;
     }
     
@@ -750,13 +1132,13 @@ void MainWindow::sendIoTState(const QJsonObject& states)
     iot["states"] = states;
     
     QJsonDocument doc(iot);
-    wsClient->sendText(doc.toJson());
+    transport->sendText(doc.toJson(QJsonDocument::Compact));
     appendLog("发送IoT状态更新");
 }
 
 void MainWindow::sendIoTDescriptors(const QJsonObject& descriptors)
 {
-    if (!wsClient || !wsClient->isConnected()) {
+    if (!transport || !transport->isConnected()) {
         return;
     }
     
@@ -766,68 +1148,76 @@ void MainWindow::sendIoTDescriptors(const QJsonObject& descriptors)
     iot["descriptors"] = descriptors;
     
     QJsonDocument doc(iot);
-    wsClient->sendText(doc.toJson());
+    transport->sendText(doc.toJson(QJsonDocument::Compact));
     appendLog("发送IoT设备描述");
 }
 
 void MainWindow::onWakeWordDetected(const QString& text)
 {
-    appendLog("检测到唤醒词: " + text);
+    appendLog(QString("检测到唤醒词: %1（检测延迟 %2ms）").arg(text).arg(wakeWordDetector->lagMs()));
     
-    // 如果当前未在录音状态，则开始录音
-    if (!isRecording) {
+    // 全双工模式下播放期间说出唤醒词直接打断
+    if (fullDuplexMode && ttsPlaying) {
+        bargeIn("wake_word_detected");
+    }
+    
+    // 如果当前未在录音状态，则开始录音（全双工模式下麦克风常开，只需进入监听）
+    if (!isRecording || (fullDuplexMode && !isListening)) {
         onStartListenClicked();
     }
     
     // 发送唤醒词检测消息到服务器
-    if (wsClient && wsClient->isConnected()) {
+    if (transport && transport->isConnected()) {
         sendWakeWordDetected(text);
     }
 }
 
-QString MainWindow::getMacAddress() {
-    QString macAddress;
+void MainWindow::onSpeechStarted(qint64 startSample, int utterance)
+{
+    Q_UNUSED(startSample);
+    // 重置前的语音开始不算本轮说话，也不用于打断本次播放
+    if (utterance != turnVadUtterance) {
+        return;
+    }
+    if (isListening) {
+        turnSpeechSeen = true;
+    }
+    if (fullDuplexMode && ttsPlaying) {
+        appendLog("播放期间检测到用户说话");
+        bargeIn("user_interruption");
+    }
+}
+
+void MainWindow::bargeIn(const QString& reason)
+{
+    if (!ttsPlaying) {
+        return;
+    }
     
-    // 创建UDP socket
-    QUdpSocket socket;
-    // 尝试连接阿里DNS服务器（不会真正发送数据）
-    socket.connectToHost("223.6.6.6", 53);
-    if (socket.waitForConnected(1000)) {  // 等待最多1秒
-        // 获取本地地址
-        QHostAddress localAddress = socket.localAddress();
-        socket.disconnectFromHost();
-        
-        // 获取所有网络接口
-        QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
-        
-        // 查找匹配的网络接口
-        for (const QNetworkInterface &interface : interfaces) {
-            // 跳过回环接口和非活动接口
-            if (interface.flags().testFlag(QNetworkInterface::IsLoopBack) ||
-                !interface.flags().testFlag(QNetworkInterface::IsUp) ||
-                !interface.flags().testFlag(QNetworkInterface::IsRunning)) {
-                continue;
-            }
-            
-            // 检查接口的地址列表
-            QList<QNetworkAddressEntry> entries = interface.addressEntries();
-            for (const QNetworkAddressEntry &entry : entries) {
-                if (entry.ip() == localAddress) {
-                    macAddress = interface.hardwareAddress();
-                    qDebug() << "找到出口网卡:" << interface.name() 
-                            << "IP:" << localAddress.toString()
-                            << "MAC:" << macAddress;
-                    return macAddress;
-                }
+    ttsPlaying = false;
+    dropTtsAudio = true;
+    
+    // 先通知服务器停止下发，再由音频线程淡出本地播放并补发缓存的语音
+    sendAbortMessage(reason);
+    // 打断命令先于开始上传到达音频线程，缓存的语音按顺序补发
+    audioEngine->bargeIn(30);
+    beginTurn("realtime");
+    updateConnectionStatus(true);
+}
+
+void MainWindow::setListening(bool listening)
+{
+    // 音频线程只在监听期间上传
+    if (isListening != listening) {
+        isListening = listening;
+        audioEngine->setUploading(listening);
+        // 本地识别以一次监听为一句
+        if (localAsr) {
+            if (listening) {
+                localAsr->beginUtterance();
+            } else {
+                localAsr->endUtterance();
             }
         }
     }
-    
-    // 如果没有找到出口网卡，使用默认值
-    if (macAddress.isEmpty()) {
-        macAddress = "60:A4:4C:59:44:60";  // 使用默认的MAC地址
-        qDebug() << "未找到出口网卡的MAC地址，使用默认地址:" << macAddress;
-    }
-    
-    return macAddress;
-} 
\ No newline at end of file
+}
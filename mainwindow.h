@@ -3,25 +3,32 @@
 #include <QMainWindow>
 #include <QLabel>
 #include <QPushButton>
-#include <QTextEdit>
+#include <QListView>
 #include <QLineEdit>
 #include <QVBoxLayout>
 #include "websocket_client.h"
-#include "microphone_manager.h"
-#include "speaker_manager.h"
-#include "opus_encoder.h"
-#include "opus_decoder.h"
+#include "mqtt_udp_transport.h"
+#include "threaded_transport.h"
 #include "wake_word_detector.h"
+#include "local_asr.h"
+#include "audio_engine.h"
+#include "log_model.h"
+#include "connection_manager.h"
+#include "ota_client.h"
 #include <QNetworkAccessManager>
 #include <QDir>
 #include <QFile>
 #include <QWebSocket>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QQueue>
+#include <QCheckBox>
+#include <atomic>
 #include "ui_mainwindow.h"
 
 // 前向声明
 class VadProcessor;
-class WebSocketClient;
+class Transport;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -47,58 +54,112 @@ private slots:
     void onWebSocketConnected();
     void onWebSocketDisconnected();
     void onJsonReceived(const QString& json);
-    void onAudioReceived(const std::vector<uint8_t>& data);
+    void onAudioReceived(const QByteArray& opusData, qint64 timestamp);
     
-    void onPCMDataReady(const QByteArray& pcmData);
+    void onUplinkReady();
+    void onAudioEvent();
     void startRecording();
     void stopRecording();
-    void handleSilenceDetected();
+    void handleSilenceDetected(qint64 endSample, qint64 delayMs, int utterance);
     void onWakeWordDetected(const QString& text);
+    void onSpeechStarted(qint64 startSample, int utterance);
+    void onEndpointDetected(const QString& text, int utterance);
+    void onLocalPartialResult(const QString& text);
+    void onLocalFinalResult(const QString& text, qint64 audioMs, double realTimeFactor);
 
 private:
     void setupAudioModules();
-    void setupWebSocket();
+    void setupTransport();
     void updateConnectionStatus(bool connected);
     void appendLog(const QString& text);
     void checkFirmwareVersion();
+    void applyOtaConfig(const OtaConfig& config, bool fromCache);
+
+    // 服务器消息处理（由 WebSocketClient 解析后分发）
+    void onHelloMessage(const Protocol::HelloMessage& hello);
+    void onSttMessage(const Protocol::SttMessage& stt);
+    void onTtsMessage(const Protocol::TtsMessage& tts);
+
+    // 全双工模式：麦克风常开，TTS 期间检测到用户说话即打断
+    void bargeIn(const QString& reason);
+    void setListening(bool listening);
+    // 开始新的一轮监听（手动、唤醒或打断）：重置本轮统计、VAD 和唤醒词编号，发送 listen start
+    void beginTurn(const QString& mode);
+
+    // 本地断句（listen 模式 auto）：说完后由客户端发送 listen stop 并停止上传
+    QString listenMode() const;
+    void finishUtterance(const QString& reason, qint64 delayMs);
 
     // 新增的WebSocket消息处理方法
-    void sendHelloMessage();
     void sendListenState(const QString& state, const QString& mode = "manual");
     void sendAbortMessage(const QString& reason);
     void sendWakeWordDetected(const QString& text);
+    void sendTextQuery(const QString& text);
     void sendIoTState(const QJsonObject& states);
     void sendIoTDescriptors(const QJsonObject& descriptors);
 
 private:
     Ui::MainWindow *ui;
-    WebSocketClient *wsClient;
+    ThreadedTransport *transport;      // 网络线程中的 WebSocket 或 MQTT+UDP，由 XIAOZHI_TRANSPORT 选择
+    bool useMqtt;                      // 使用 MQTT+UDP 传输
+    bool protocolVersionFromEnv;       // XIAOZHI_PROTOCOL_VERSION 已指定，忽略 OTA 配置的版本
+    MqttConfig mqttConfig;             // OTA 下发的 MQTT 配置，GUI 线程中的副本
+    WireStats turnWireStats;           // 上一轮对话结束时的累计线上字节数
+    bool connectWhenConfigured;        // MQTT 配置尚未从 OTA 获取时，获取后再连接
+    OtaClient *otaClient;              // OTA 配置，启动时先用缓存
+    QString serverUrl;                 // WebSocket 地址，OTA 下发时替换默认值
+    ConnectionManager *connectionManager;
+    bool resumeListening;   // 自动重连成功后恢复监听
     QNetworkAccessManager *networkManager;
     
-    MicrophoneManager *micManager;
-    SpeakerManager *speakerManager;
-    OpusEncoder *opusEncoder;
-    OpusDecoder *opusDecoder;
+    // 采集、播放、回声消除和编解码都在音频线程中
+    AudioEngine *audioEngine;
     WakeWordDetector *wakeWordDetector;
+    LocalAsr *localAsr;                // 与唤醒词检测共用模型的本地识别
     
     bool isListening;
     bool isRecording;
     QString sessionId;
     QString deviceMacAddress;
-    QString getMacAddress();
 
     // UI组件
     QVBoxLayout *mainLayout;
     QPushButton *connectButton;
     QLabel *statusLabel;
+    QLabel *transcriptLabel;           // 本地识别的部分/最终结果
     QPushButton *startListenButton;
     QPushButton *stopListenButton;
-    QTextEdit *logTextEdit;
+    QListView *logView;
+    LogModel *logModel;
+    bool logFollowTail;   // 滚动条在底部时新日志自动滚动到底部
+    static constexpr int LOG_CAPACITY = 2000;
+    QCheckBox *fullDuplexCheckBox;
+    QCheckBox *endpointCheckBox;
+
+    // 全双工/打断相关
+    bool fullDuplexMode;
+    bool ttsPlaying;
+    std::atomic<bool> dropTtsAudio;    // 打断后丢弃服务器仍在下发的 TTS 音频（网络线程读取）
+
+    // 本地断句与每轮统计
+    bool clientEndpointing;            // 半双工下由客户端断句（auto），否则手动停止（manual）
+    int turnUtterance;                 // 本轮 WakeWordDetector::resetUtterance() 的编号
+    int turnVadUtterance;              // 最近一次 VadProcessor::reset() 的编号
+    bool turnSpeechSeen;               // 本轮 VAD 已检测到语音
+    qint64 turnUplinkBytes;            // 本轮上传的 Opus 字节数
+    QElapsedTimer turnClock;           // 从开始监听计时
+    qint64 turnSpeechEndMs;            // 说话结束时刻（turnClock），-1 表示尚未结束
+
+    // 本地识别兜底
+    QString localTranscript;           // 本轮本地识别的最终结果
+    const int localFallbackMs;         // 说话结束后服务器识别结果超过这么久未到，改发本地结果
+    QString pendingLocalQuery;         // 断线期间的本地识别结果，重新连接后发送
+    QElapsedTimer pendingLocalQueryAge;
+    static constexpr int LOCAL_QUERY_MAX_AGE_MS = 30000;
 
     // VAD相关变量
     const int SILENCE_THRESHOLD;
     const int SILENCE_DURATION_MS;
     qint64 lastActiveTime;
     VadProcessor* vadProcessor;
-    int VAD_SILENCE_FRAMES;
 }; 
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "message_deflate.h"
+#include <zlib.h>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+// 与 permessage-deflate 默认参数一致：32KB 窗口，原始 deflate（无 zlib 头）
+constexpr int WINDOW_BITS = 15;
+const uchar SYNC_TAIL[4] = {0x00, 0x00, 0xff, 0xff};
+}
+
+MessageDeflate::MessageDeflate()
+    : deflater(new z_stream())
+    , inflater(new z_stream())
+    , ready(false)
+{
+    ready = deflateInit2(deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    if (inflateInit2(inflater, -WINDOW_BITS) != Z_OK) {
+        if (ready) {
+            deflateEnd(deflater);
+        }
+        ready = false;
+    }
+    if (!ready) {
+        qDebug() << "zlib 初始化失败";
+    }
+}
+
+MessageDeflate::~MessageDeflate()
+{
+    if (ready) {
+        deflateEnd(deflater);
+        inflateEnd(inflater);
+    }
+    delete deflater;
+    delete inflater;
+}
+
+void MessageDeflate::reset()
+{
+    if (ready) {
+        deflateReset(deflater);
+        inflateReset(inflater);
+    }
+}
+
+bool MessageDeflate::compress(const char* data, int size, QByteArray& out)
+{
+    if (!ready) {
+        return false;
+    }
+
+    // sync flush 保证消息结束时输出全部字节，且不结束 deflate 流
+    int capacity = static_cast<int>(deflateBound(deflater, size)) + 16;
+    out.resize(capacity);
+    deflater->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    deflater->avail_in = static_cast<uInt>(size);
+    int written = 0;
+    for (;;) {
+        deflater->next_out = reinterpret_cast<Bytef*>(out.data() + written);
+        deflater->avail_out = static_cast<uInt>(capacity - written);
+        const int result = deflate(deflater, Z_SYNC_FLUSH);
+        if (result != Z_OK && result != Z_BUF_ERROR) {
+            qDebug() << "deflate 失败:" << result;
+            return false;
+        }
+        written = capacity - static_cast<int>(deflater->avail_out);
+        if (deflater->avail_out > 0) {
+            break;
+        }
+        capacity *= 2;
+        out.resize(capacity);
+    }
+
+    // 去掉 sync flush 产生的空存储块尾部，接收方解压前补回
+    if (written >= 4 && memcmp(out.constData() + written - 4, SYNC_TAIL, 4) == 0) {
+        written -= 4;
+    }
+    out.resize(written);
+    return true;
+}
+
+bool MessageDeflate::decompress(const char* data, int size, QByteArray& out, int maxSize)
+{
+    if (!ready) {
+        return false;
+    }
+
+    out.resize(qMin(maxSize, qMax(256, size * 4)));
+    int written = 0;
+    // 先解压消息本身，再解压补回的 00 00 ff ff
+    const Bytef* inputs[2] = {reinterpret_cast<const Bytef*>(data), SYNC_TAIL};
+    const uInt sizes[2] = {static_cast<uInt>(size), 4};
+    for (int part = 0; part < 2; ++part) {
+        inflater->next_in = const_cast<Bytef*>(inputs[part]);
+        inflater->avail_in = sizes[part];
+        while (inflater->avail_in > 0) {
+            if (written == out.size()) {
+                if (out.size() >= maxSize) {
+                    qDebug() << "解压后的消息超过上限:" << maxSize;
+                    return false;
+                }
+                out.resize(qMin(maxSize, out.size() * 2));
+            }
+            inflater->next_out = reinterpret_cast<Bytef*>(out.data() + written);
+            inflater->avail_out = static_cast<uInt>(out.size() - written);
+            const int result = inflate(inflater, Z_SYNC_FLUSH);
+            written = out.size() - static_cast<int>(inflater->avail_out);
+            if (result == Z_STREAM_END) {
+                // 对端结束了 deflate 流，之后的消息从新的流开始
+                inflateReset(inflater);
+                break;
+            }
+            if (result != Z_OK && result != Z_BUF_ERROR) {
+                qDebug() << "inflate 失败:" << result;
+                return false;
+            }
+            if (result == Z_BUF_ERROR && inflater->avail_out > 0) {
+                break;
+            }
+        }
+    }
+    out.resize(written);
+    return true;
+}
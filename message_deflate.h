@@ -0,0 +1,37 @@
+#ifndef MESSAGE_DEFLATE_H
+#define MESSAGE_DEFLATE_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+struct z_stream_s;
+
+// JSON 控制消息的逐条压缩（zlib），格式与 WebSocket permessage-deflate（RFC 7692）相同：
+// 原始 deflate 流，每条消息以 sync flush 结束并去掉末尾的 00 00 ff ff。
+// 两个方向各自保留滑动窗口（context takeover），后面的消息可以引用前面消息中的字段名，
+// 短小而重复的 JSON 也能压缩。消息必须按发送顺序解压，新连接前调用 reset()
+class MessageDeflate
+{
+public:
+    MessageDeflate();
+    ~MessageDeflate();
+
+    MessageDeflate(const MessageDeflate&) = delete;
+    MessageDeflate& operator=(const MessageDeflate&) = delete;
+
+    // 清空两个方向的滑动窗口
+    void reset();
+
+    // 压缩一条消息，结果写入 out（复用 out 已有的容量）
+    bool compress(const char* data, int size, QByteArray& out);
+
+    // 解压一条消息，解压后超过 maxSize 字节视为错误
+    bool decompress(const char* data, int size, QByteArray& out, int maxSize = 1 << 20);
+
+private:
+    z_stream_s* deflater;
+    z_stream_s* inflater;
+    bool ready;
+};
+
+#endif // MESSAGE_DEFLATE_H
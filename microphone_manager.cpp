@@ -10,29 +10,67 @@ MicrophoneManager::MicrophoneManager(QObject *parent)
     : QObject(parent)
     , audioSource(nullptr)
     , audioDevice(nullptr)
+    , mediaDevices(new QMediaDevices(this))
     , sampleRate(16000)
     , channels(1)
-    , frameSize(320*3)  // 20ms @ 16kHz
+    , frameSize(16000 * FRAME_DURATION_MS / 1000)  // 60ms @ 16kHz
     , recording(false)
+    , firstFramePending(false)
+    , startLatencyMs(-1)
+    , lastSwitchMs(-1)
+    , maxSwitchMs(0)
+    , switchCount(0)
 {
     // 配置默认音频格式
     format.setSampleRate(sampleRate);
     format.setChannelCount(channels);
     format.setSampleFormat(QAudioFormat::Int16);
-    
+
     initializeAudioDevice();
+    
+    // 监听设备热插拔
+    connect(mediaDevices, &QMediaDevices::audioInputsChanged,
+            this, &MicrophoneManager::handleAudioInputsChanged);
 }
 
 MicrophoneManager::~MicrophoneManager()
 {
     stopRecording();
-    delete audioSource;
+    releaseAudioDevice();
 }
 
 bool MicrophoneManager::initializeAudioDevice()
 {
-    // 检查默认音频输入设备
-    QAudioDevice inputDevice = QMediaDevices::defaultAudioInput();
+    return openDevice(QMediaDevices::defaultAudioInput());
+}
+
+CaptureConverter::SampleFormat MicrophoneManager::converterFormat(QAudioFormat::SampleFormat format)
+{
+    switch (format) {
+        case QAudioFormat::UInt8:
+            return CaptureConverter::SampleFormat::UInt8;
+        case QAudioFormat::Int16:
+            return CaptureConverter::SampleFormat::Int16;
+        case QAudioFormat::Int32:
+            return CaptureConverter::SampleFormat::Int32;
+        case QAudioFormat::Float:
+            return CaptureConverter::SampleFormat::Float;
+        default:
+            return CaptureConverter::SampleFormat::Unknown;
+    }
+}
+
+bool MicrophoneManager::openDevice(const QAudioDevice& inputDevice)
+{
+    // 先释放旧的音频源，打开失败时不保留已失效的设备
+    releaseAudioDevice();
+    currentDevice = inputDevice;
+
+    if (inputDevice.isNull()) {
+        qDebug() << "找不到默认音频输入设备";
+        return false;
+    }
+
     qDebug() << "默认音频输入设备信息:"
              << "\n  设备名称:" << inputDevice.description()
              << "\n  最小采样率:" << inputDevice.minimumSampleRate()
@@ -40,33 +78,70 @@ bool MicrophoneManager::initializeAudioDevice()
              << "\n  最小通道数:" << inputDevice.minimumChannelCount()
              << "\n  最大通道数:" << inputDevice.maximumChannelCount()
              << "\n  支持的采样格式:" << inputDevice.supportedSampleFormats();
-    
+
+    // 回声消除、编码、VAD 和唤醒词都按流水线格式处理，这里不改变它：
+    // 设备不支持时以设备推荐的格式打开，读出的数据转换后再送出
+    deviceFormat = format;
     if (!inputDevice.isFormatSupported(format)) {
         qDebug() << "默认音频输入设备不支持当前格式:"
                  << "\n  采样率:" << format.sampleRate()
                  << "\n  通道数:" << format.channelCount()
                  << "\n  采样格式:" << format.sampleFormat();
-                 
-        // 尝试调整格式
-        QAudioFormat newFormat = inputDevice.preferredFormat();
-        qDebug() << "设备推荐的音频格式:"
-                 << "\n  采样率:" << newFormat.sampleRate()
-                 << "\n  通道数:" << newFormat.channelCount()
-                 << "\n  采样格式:" << newFormat.sampleFormat();
-                 
-        format = newFormat;
-        sampleRate = format.sampleRate();
-        channels = format.channelCount();
-        frameSize = (sampleRate * 60) / 1000;  // 60ms帧
+
+        deviceFormat = inputDevice.preferredFormat();
+        qDebug() << "改用设备推荐的音频格式并转换:"
+                 << "\n  采样率:" << deviceFormat.sampleRate()
+                 << "\n  通道数:" << deviceFormat.channelCount()
+                 << "\n  采样格式:" << deviceFormat.sampleFormat();
     }
-    
-    // 创建音频输入源
+    const CaptureConverter::Format converted{deviceFormat.sampleRate(), deviceFormat.channelCount(),
+                                             converterFormat(deviceFormat.sampleFormat())};
+    if (!converter.configure(converted, format.sampleRate(), format.channelCount())) {
+        qDebug() << "无法转换设备的音频格式，放弃该设备";
+        return false;
+    }
+
+    // 创建音频输入源，缓冲区按帧长设置，避免固定 4096 字节带来的额外延迟或溢出
+    audioSource = new QAudioSource(inputDevice, deviceFormat, this);
+    const int deviceFrameSize = deviceFormat.sampleRate() * FRAME_DURATION_MS / 1000;
+    audioSource->setBufferSize(deviceFrameSize * deviceFormat.bytesPerFrame() * BUFFER_FRAMES);
+    connect(audioSource, &QAudioSource::stateChanged,
+            this, &MicrophoneManager::handleStateChanged);
+
+    // 只在这里打开一次设备，之后保持打开，未录音时挂起
+    audioDevice = audioSource->start();
+    if (!audioDevice) {
+        qDebug() << "打开音频设备失败";
+        releaseAudioDevice();
+        return false;
+    }
+    connect(audioDevice, &QIODevice::readyRead, this, &MicrophoneManager::handleReadyRead);
+
+    if (!recording) {
+        audioSource->suspend();
+    }
+
+    qDebug() << "音频输入设备已打开:"
+             << "\n  缓冲区大小:" << audioSource->bufferSize() << "字节"
+             << "\n  帧长:" << FRAME_DURATION_MS << "ms";
+    return true;
+}
+
+void MicrophoneManager::releaseAudioDevice()
+{
+    if (audioDevice) {
+        disconnect(audioDevice, &QIODevice::readyRead,
+                   this, &MicrophoneManager::handleReadyRead);
+        audioDevice = nullptr;
+    }
+
     if (audioSource) {
+        disconnect(audioSource, &QAudioSource::stateChanged,
+                   this, &MicrophoneManager::handleStateChanged);
+        audioSource->stop();
         delete audioSource;
+        audioSource = nullptr;
     }
-    audioSource = new QAudioSource(inputDevice, format, this);
-    
-    return true;
 }
 
 void MicrophoneManager::configureAudioParams(int newSampleRate, int newChannels)
@@ -74,63 +149,58 @@ void MicrophoneManager::configureAudioParams(int newSampleRate, int newChannels)
     if (sampleRate == newSampleRate && channels == newChannels) {
         return;
     }
-    
+
     sampleRate = newSampleRate;
     channels = newChannels;
-    frameSize = (sampleRate * 60) / 1000;  // 60ms帧
-    
+    frameSize = (sampleRate * FRAME_DURATION_MS) / 1000;
+
     // 更新音频格式
     format.setSampleRate(sampleRate);
     format.setChannelCount(channels);
-    
-    // 重新初始化设备
+
+    // 格式变化时才需要重新打开设备
+    bool wasRecording = recording;
     if (recording) {
         stopRecording();
     }
     initializeAudioDevice();
+    if (wasRecording) {
+        startRecording();
+    }
 }
 
 bool MicrophoneManager::startRecording()
 {
-    QAudioFormat format;
-    format.setSampleRate(16000);
-    format.setChannelCount(1);
-    format.setSampleFormat(QAudioFormat::Int16);
+    QMutexLocker locker(&audioMutex);
 
-    // 检查格式是否支持
-    QAudioDevice inputDevice = QMediaDevices::defaultAudioInput();
-    if (!inputDevice.isFormatSupported(format)) {
-        qDebug() << "默认音频输入设备不支持请求的格式";
-        return false;
+    if (recording) {
+        return true;
     }
 
-    // 检查设备是否可用
-    if (!inputDevice.isNull()) {
-        audioSource = new QAudioSource(format, this);
-        if (audioSource) {
-            // 设置缓冲区大小（可选）
-            audioSource->setBufferSize(4096);
-
-            // 打开设备进行录音
-            audioDevice = audioSource->start();
-            if (audioDevice) {
-                connect(audioDevice, &QIODevice::readyRead, this, &MicrophoneManager::handleReadyRead);
-                recording = true;
-                qDebug() << "录音开始成功";
-                return true;
-            } else {
-                qDebug() << "打开音频设备失败";
-                delete audioSource;
-                audioSource = nullptr;
-            }
-        } else {
-            qDebug() << "创建音频源失败";
+    // 设备丢失（例如初始化时没有输入设备）时才重新打开
+    if (!audioSource || !audioDevice) {
+        locker.unlock();
+        if (!initializeAudioDevice()) {
+            return false;
         }
-    } else {
-        qDebug() << "找不到默认音频输入设备";
+        locker.relock();
+    }
+
+    // 丢弃挂起前残留的旧数据
+    audioDevice->readAll();
+    pendingData.clear();
+    converter.reset();
+
+    startTimer.start();
+    firstFramePending = true;
+    recording = true;
+
+    if (audioSource->state() == QAudio::SuspendedState) {
+        audioSource->resume();
     }
 
-    return false;
+    qDebug() << "录音开始成功";
+    return true;
 }
 
 void MicrophoneManager::stopRecording()
@@ -138,50 +208,23 @@ void MicrophoneManager::stopRecording()
     if (!recording) {
         return;
     }
-    
+
     // 防止重入
     QMutexLocker locker(&audioMutex);
-    
+
     if (!recording) {  // 双重检查
         return;
     }
-    
+
     recording = false;  // 先设置标志，防止新的音频数据进入
-    
-    // 保存需要清理的指针
-    QPointer<QAudioSource> sourceToStop = audioSource;
-    QPointer<QIODevice> ioToClose = audioDevice;
-    
-    // 清空类成员指针
-    audioSource = nullptr;
-    audioDevice = nullptr;
-    
-    // 使用 QPointer 安全地访问对象
-    if (!sourceToStop.isNull()) {
-        // 先断开状态变化信号，避免触发 handleStateChanged
-        disconnect(sourceToStop, &QAudioSource::stateChanged,
-                  this, &MicrophoneManager::handleStateChanged);
-        
-        // 停止音频源并阻止其他信号
-        sourceToStop->blockSignals(true);
-        sourceToStop->stop();
-        
-        // 延迟删除音频源
-        sourceToStop->deleteLater();
-    }
-    
-    if (!ioToClose.isNull()) {
-        // 断开信号并关闭设备
-        disconnect(ioToClose, &QIODevice::readyRead,
-                  this, &MicrophoneManager::handleReadyRead);
-        
-        ioToClose->blockSignals(true);
-        if (ioToClose->isOpen()) {
-            ioToClose->close();
-        }
+    pendingData.clear();
+
+    // 只挂起，不关闭设备，下次开始录音无需重新打开
+    if (audioSource && audioSource->state() == QAudio::ActiveState) {
+        audioSource->suspend();
     }
-    
-    qDebug() << "录音已停止，资源已清理";
+
+    qDebug() << "录音已停止，设备已挂起";
 }
 
 void MicrophoneManager::handleStateChanged(QAudio::State state)
@@ -191,13 +234,20 @@ void MicrophoneManager::handleStateChanged(QAudio::State state)
     if (source.isNull()) {
         return;
     }
-    
+
     qDebug() << "音频设备状态变化:" << state;
-    
+
     if (state == QAudio::StoppedState) {
         if (source->error() != QAudio::NoError) {
             qDebug() << "音频设备错误:" << source->error();
-            QMetaObject::invokeMethod(this, "stopRecording", Qt::QueuedConnection);
+            // 设备失效（如被拔出），迁移到当前默认设备。同一次拔出通常还会
+            // 收到 audioInputsChanged，音频源已被替换或释放时说明已经迁移过
+            QMetaObject::invokeMethod(this, [this, source]() {
+                if (source.isNull() || source.data() != audioSource) {
+                    return;
+                }
+                migrateToDevice(QMediaDevices::defaultAudioInput());
+            }, Qt::QueuedConnection);
         }
     } else if (state == QAudio::ActiveState) {
         qDebug() << "音频设备已进入活动状态";
@@ -207,60 +257,133 @@ void MicrophoneManager::handleStateChanged(QAudio::State state)
 void MicrophoneManager::handleReadyRead()
 {
     QMutexLocker locker(&audioMutex);
-    
-    // 先检查录音状态
-    if (!recording) {
-        return;
-    }
-    
+
     // 再检查设备状态
     if (!audioDevice || !audioDevice->isOpen() || !audioDevice->isReadable()) {
         return;
     }
-    
-    // 计算当前可用的数据大小
-    qint64 bytesAvailable = audioDevice->bytesAvailable();
-    int frameBytes = frameSize * format.bytesPerFrame();
-    
-    // 如果数据不足一帧，等待下次读取
-    if (bytesAvailable < frameBytes) {
+
+    // 未录音时直接丢弃，保持设备缓冲区不积压
+    if (!recording) {
+        audioDevice->readAll();
         return;
     }
-    
-    // 读取一帧数据
-    QByteArray frameData;
-    try {
-        frameData = audioDevice->read(frameBytes);
-    } catch (...) {
-        qDebug() << "警告：读取音频数据时发生异常";
+
+    // 设备格式与流水线格式不同时在这里转换，之后按流水线格式拼帧
+    pendingData.append(converter.convert(audioDevice->readAll()));
+
+    // 一次回调可能积累多帧，全部送出，避免延迟逐渐增大
+    const int frameBytes = frameSize * format.bytesPerFrame();
+    QList<QByteArray> frames;
+    while (pendingData.size() >= frameBytes) {
+        frames.append(pendingData.left(frameBytes));
+        pendingData.remove(0, frameBytes);
+    }
+
+    if (frames.isEmpty()) {
         return;
     }
-    
-    if (!frameData.isEmpty()) {
-        // 将PCM数据保存到文件用于调试
-        static QFile debugFile("send.pcm");
-        static bool fileOpened = false;
-        
-        if (!fileOpened) {
-            if (debugFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
-                fileOpened = true;
-                qDebug() << "调试文件已打开";
-            } else {
-                qDebug() << "无法打开调试文件";
-            }
+
+    if (firstFramePending) {
+        firstFramePending = false;
+        startLatencyMs = startTimer.elapsed();
+        qDebug() << "录音启动到第一帧延迟:" << startLatencyMs << "ms";
+    }
+
+    // 将PCM数据保存到文件用于调试
+    static QFile debugFile("send.pcm");
+    static bool fileOpened = false;
+
+    if (!fileOpened) {
+        if (debugFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            fileOpened = true;
+            qDebug() << "调试文件已打开";
+        } else {
+            qDebug() << "无法打开调试文件";
         }
-        
+    }
+
+    // 在互斥锁保护之外发送信号
+    locker.unlock();
+    for (const QByteArray& frameData : frames) {
         if (fileOpened) {
             debugFile.write(frameData);
         }
-        
-        // 在互斥锁保护之外发送信号
-        locker.unlock();
         // qDebug() << "MicrophoneManager: 准备发送PCM数据，大小:" << frameData.size() << "字节";
         emit pcmDataReady(frameData);
     }
 }
 
+void MicrophoneManager::handleAudioInputsChanged()
+{
+    QAudioDevice defaultDevice = QMediaDevices::defaultAudioInput();
+    bool currentPresent = false;
+    for (const QAudioDevice& device : QMediaDevices::audioInputs()) {
+        if (device.id() == currentDevice.id()) {
+            currentPresent = true;
+            break;
+        }
+    }
+
+    // 没有可用设备，之前也没有打开的设备：等下一次设备变化
+    if (defaultDevice.isNull() && !audioSource) {
+        return;
+    }
+
+    // 当前设备被拔出、默认设备发生变化，或之前打开失败时迁移
+    if (!currentPresent || defaultDevice.id() != currentDevice.id() || !audioSource) {
+        qDebug() << "音频输入设备变化:" << currentDevice.description()
+                 << "->" << defaultDevice.description();
+        migrateToDevice(defaultDevice);
+    }
+}
+
+void MicrophoneManager::migrateToDevice(const QAudioDevice& inputDevice)
+{
+    QElapsedTimer switchTimer;
+    switchTimer.start();
+
+    QMutexLocker locker(&audioMutex);
+
+    // 把旧设备中还能读出的数据按旧设备的格式转换后并入待送出缓冲区，
+    // 切换后新设备的数据也转换成同一格式，继续拼帧
+    if (recording && audioDevice && audioDevice->isOpen()) {
+        pendingData.append(converter.convert(audioDevice->readAll()));
+    }
+    QByteArray carried = pendingData;
+
+    locker.unlock();
+    bool opened = openDevice(inputDevice);
+    locker.relock();
+
+    // 打开失败时旧的音频源已经释放，停止录音并通知上层
+    const bool failedWhileRecording = !opened && recording;
+    if (opened) {
+        pendingData = carried;
+        if (recording && audioSource->state() == QAudio::SuspendedState) {
+            audioSource->resume();
+        }
+    } else {
+        pendingData.clear();
+        recording = false;
+    }
+    locker.unlock();
+
+    lastSwitchMs = switchTimer.elapsed();
+    maxSwitchMs = qMax(maxSwitchMs, lastSwitchMs);
+    ++switchCount;
+
+    qDebug() << "音频输入设备切换" << (opened ? "完成" : "失败") << ":" << inputDevice.description()
+             << "耗时:" << lastSwitchMs << "ms"
+             << "携带数据:" << carried.size() << "字节";
+    if (opened) {
+        emit deviceSwitched(inputDevice.description(), lastSwitchMs);
+    } else if (failedWhileRecording) {
+        emit captureFailed(inputDevice.isNull() ? QString("没有可用的音频输入设备")
+                                                : QString("无法打开音频输入设备 %1").arg(inputDevice.description()));
+    }
+}
+
 bool MicrophoneManager::checkDeviceHealth()
 {
     QAudioDevice inputDevice = QMediaDevices::defaultAudioInput();
@@ -269,4 +392,4 @@ bool MicrophoneManager::checkDeviceHealth()
         return false;
     }
     return true;
-} 
\ No newline at end of file
+}
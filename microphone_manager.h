@@ -6,6 +6,8 @@
 #include <QMediaDevices>
 #include <QAudioFormat>
 #include <QMutex>
+#include <QElapsedTimer>
+#include "capture_converter.h"
 
 class MicrophoneManager : public QObject {
     Q_OBJECT
@@ -24,31 +26,73 @@ public:
     
     // 配置音频参数
     void configureAudioParams(int sampleRate, int channels);
+    
+    // 最近一次 startRecording 到第一帧数据送出的耗时（毫秒），-1 表示尚未测得
+    qint64 lastStartLatencyMs() const { return startLatencyMs; }
+    
+    // 设备切换指标：最近一次切换耗时（毫秒）、最大耗时和切换次数
+    qint64 lastDeviceSwitchMs() const { return lastSwitchMs; }
+    qint64 maxDeviceSwitchMs() const { return maxSwitchMs; }
+    int deviceSwitchCount() const { return switchCount; }
 
 signals:
     // 当有新的PCM音频数据时发出信号
     void pcmDataReady(const QByteArray& pcmData);
+    
+    // 输入设备热插拔后已迁移到新的默认设备
+    void deviceSwitched(const QString& deviceName, qint64 latencyMs);
+    
+    // 录音中设备失效且无法迁移（没有输入设备或格式无法转换），录音已停止。
+    // 之后的设备变化仍会尝试打开新的默认设备
+    void captureFailed(const QString& reason);
 
 private slots:
     void handleStateChanged(QAudio::State state);
     void handleReadyRead();
+    void handleAudioInputsChanged();
 
 private:
-    // 初始化音频设备
+    // 初始化音频设备：只打开一次并保持挂起，录音开关通过 suspend/resume 控制
     bool initializeAudioDevice();
+    // 打开设备，失败时释放旧的音频源。流水线格式（format）不变，
+    // 设备不支持时以设备格式打开并由 converter 转换
+    bool openDevice(const QAudioDevice& inputDevice);
+    static CaptureConverter::SampleFormat converterFormat(QAudioFormat::SampleFormat format);
+    
+    // 把音频流迁移到新设备，已缓冲但未送出的数据保留
+    void migrateToDevice(const QAudioDevice& inputDevice);
+    
+    // 关闭并释放音频设备
+    void releaseAudioDevice();
     
     // 检查设备状态
     bool checkDeviceHealth();
 
     QAudioSource* audioSource;
     QIODevice* audioDevice;
-    QAudioFormat format;
+    QMediaDevices* mediaDevices;
+    QAudioDevice currentDevice;
+    QAudioFormat format;          // 流水线格式（s16），送出的数据总是这个格式
+    QAudioFormat deviceFormat;    // 设备实际打开的格式
+    CaptureConverter converter;   // deviceFormat -> format
     
     int sampleRate;
     int channels;
     int frameSize;  // 每帧采样数
     bool recording;
     QMutex audioMutex;  // 添加互斥锁
+    
+    QByteArray pendingData;       // 不足一帧的剩余数据（流水线格式）
+    QElapsedTimer startTimer;     // 测量启动到第一帧的延迟
+    bool firstFramePending;
+    qint64 startLatencyMs;
+    
+    qint64 lastSwitchMs;
+    qint64 maxSwitchMs;
+    int switchCount;
+    
+    static constexpr int FRAME_DURATION_MS = 60;
+    static constexpr int BUFFER_FRAMES = 2;  // 设备缓冲区为两帧
 };
 
 #endif // MICROPHONE_MANAGER_H 
\ No newline at end of file
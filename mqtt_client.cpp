@@ -0,0 +1,281 @@
+#include "mqtt_client.h"
+#include <QTcpSocket>
+#include <QtEndian>
+#include <QDebug>
+#ifndef QT_NO_SSL
+#include <QSslSocket>
+#endif
+
+MqttClient::MqttClient(QObject *parent)
+    : QObject(parent)
+    , socket(nullptr)
+    , sessionUp(false)
+    , nextPacketId(1)
+{
+}
+
+MqttClient::~MqttClient()
+{
+    abort();
+}
+
+void MqttClient::connectToHost(const Options& newOptions)
+{
+    abort();
+    options = newOptions;
+    rxBuffer.clear();
+
+#ifndef QT_NO_SSL
+    QSslSocket* sslSocket = new QSslSocket(this);
+    socket = sslSocket;
+#else
+    socket = new QTcpSocket(this);
+#endif
+    // 控制消息很小，关闭 Nagle 避免额外延迟
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(socket, &QTcpSocket::readyRead, this, &MqttClient::onReadyRead);
+    connect(socket, &QTcpSocket::disconnected, this, &MqttClient::onSocketDisconnected);
+    connect(socket, &QTcpSocket::errorOccurred, this, [this](QAbstractSocket::SocketError) {
+        qDebug() << "MQTT 连接错误:" << socket->errorString();
+        emit errorOccurred(socket->errorString());
+    });
+
+    qDebug() << "连接 MQTT 服务器:" << options.host << options.port << (options.useTls ? "TLS" : "");
+#ifndef QT_NO_SSL
+    if (options.useTls) {
+        connect(sslSocket, &QSslSocket::encrypted, this, &MqttClient::onSocketConnected);
+        sslSocket->connectToHostEncrypted(options.host, options.port);
+        return;
+    }
+#else
+    if (options.useTls) {
+        qDebug() << "Qt 未启用 SSL，使用明文连接";
+    }
+#endif
+    connect(socket, &QTcpSocket::connected, this, &MqttClient::onSocketConnected);
+    socket->connectToHost(options.host, options.port);
+}
+
+void MqttClient::disconnectFromHost()
+{
+    if (!socket) {
+        return;
+    }
+    if (sessionUp) {
+        sendPacket(DISCONNECT, QByteArray());
+        socket->flush();
+    }
+    socket->disconnectFromHost();
+}
+
+void MqttClient::abort()
+{
+    if (!socket) {
+        return;
+    }
+    QTcpSocket* old = socket;
+    socket = nullptr;
+    const bool wasUp = sessionUp;
+    sessionUp = false;
+    old->disconnect(this);
+    old->abort();
+    old->deleteLater();
+    if (wasUp) {
+        emit disconnected();
+    }
+}
+
+void MqttClient::subscribe(const QString& topic)
+{
+    QByteArray body;
+    const quint16 packetId = nextPacketId++;
+    if (nextPacketId == 0) {
+        nextPacketId = 1;
+    }
+    body.append(static_cast<char>(packetId >> 8));
+    body.append(static_cast<char>(packetId & 0xFF));
+    appendString(body, topic.toUtf8());
+    body.append('\0');  // QoS 0
+    sendPacket(SUBSCRIBE, body);
+}
+
+void MqttClient::publish(const QString& topic, const QByteArray& payload)
+{
+    QByteArray body;
+    const QByteArray topicBytes = topic.toUtf8();
+    body.reserve(2 + topicBytes.size() + payload.size());
+    appendString(body, topicBytes);
+    body.append(payload);
+    sendPacket(PUBLISH, body);
+}
+
+void MqttClient::ping()
+{
+    sendPacket(PINGREQ, QByteArray());
+}
+
+void MqttClient::onSocketConnected()
+{
+    QByteArray body;
+    appendString(body, "MQTT");
+    body.append(static_cast<char>(4));  // 协议级别 3.1.1
+
+    quint8 flags = 0x02;  // clean session
+    if (!options.username.isEmpty()) {
+        flags |= 0x80;
+    }
+    if (!options.password.isEmpty()) {
+        flags |= 0x40;
+    }
+    body.append(static_cast<char>(flags));
+    body.append(static_cast<char>((options.keepAliveSec >> 8) & 0xFF));
+    body.append(static_cast<char>(options.keepAliveSec & 0xFF));
+
+    appendString(body, options.clientId.toUtf8());
+    if (!options.username.isEmpty()) {
+        appendString(body, options.username.toUtf8());
+    }
+    if (!options.password.isEmpty()) {
+        appendString(body, options.password.toUtf8());
+    }
+    sendPacket(CONNECT, body);
+}
+
+void MqttClient::onReadyRead()
+{
+    if (!socket) {
+        return;
+    }
+    rxBuffer.append(socket->readAll());
+
+    // 固定报头：1 字节类型 + 1~4 字节剩余长度（变长编码）
+    while (rxBuffer.size() >= 2) {
+        int remaining = 0;
+        int multiplier = 1;
+        int pos = 1;
+        bool complete = false;
+        while (pos < rxBuffer.size() && pos <= 4) {
+            const quint8 byte = static_cast<quint8>(rxBuffer[pos++]);
+            remaining += (byte & 0x7F) * multiplier;
+            multiplier *= 128;
+            if ((byte & 0x80) == 0) {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete) {
+            if (pos > 4) {
+                qDebug() << "MQTT 剩余长度格式错误";
+                abort();
+            }
+            return;
+        }
+        if (rxBuffer.size() < pos + remaining) {
+            return;
+        }
+
+        const quint8 header = static_cast<quint8>(rxBuffer[0]);
+        const QByteArray body = rxBuffer.mid(pos, remaining);
+        rxBuffer.remove(0, pos + remaining);
+        processPacket(header, body);
+        if (!socket) {
+            return;
+        }
+    }
+}
+
+void MqttClient::processPacket(quint8 header, const QByteArray& body)
+{
+    switch (header & 0xF0) {
+        case CONNACK: {
+            const int code = body.size() >= 2 ? static_cast<quint8>(body[1]) : -1;
+            if (code != 0) {
+                qDebug() << "MQTT 服务器拒绝连接，返回码:" << code;
+                emit errorOccurred(QString("MQTT CONNACK %1").arg(code));
+                abort();
+                return;
+            }
+            sessionUp = true;
+            emit connected();
+            break;
+        }
+        case PUBLISH: {
+            if (body.size() < 2) {
+                return;
+            }
+            const int qos = (header >> 1) & 0x03;
+            const int topicLength = qFromBigEndian<quint16>(body.constData());
+            int offset = 2 + topicLength;
+            if (body.size() < offset) {
+                return;
+            }
+            const QString topic = QString::fromUtf8(body.constData() + 2, topicLength);
+            if (qos > 0) {
+                if (body.size() < offset + 2) {
+                    return;
+                }
+                // QoS 1 需要确认，服务器不应发送 QoS 2
+                sendPacket(PUBACK, body.mid(offset, 2));
+                offset += 2;
+            }
+            emit messageReceived(topic, body.mid(offset));
+            break;
+        }
+        case SUBACK:
+            if (body.size() >= 3 && static_cast<quint8>(body[2]) == 0x80) {
+                qDebug() << "MQTT 订阅失败";
+                emit errorOccurred("MQTT subscribe failed");
+            }
+            break;
+        case PINGRESP:
+            emit pingResponse();
+            break;
+        default:
+            break;
+    }
+}
+
+void MqttClient::onSocketDisconnected()
+{
+    qDebug() << "MQTT 连接断开";
+    const bool wasUp = sessionUp;
+    sessionUp = false;
+    if (socket) {
+        socket->deleteLater();
+        socket = nullptr;
+    }
+    if (wasUp) {
+        emit disconnected();
+    } else {
+        emit errorOccurred("MQTT connection closed");
+    }
+}
+
+void MqttClient::sendPacket(quint8 header, const QByteArray& body)
+{
+    if (!socket) {
+        return;
+    }
+
+    QByteArray packet;
+    packet.reserve(body.size() + 5);
+    packet.append(static_cast<char>(header));
+    int remaining = body.size();
+    do {
+        quint8 byte = remaining % 128;
+        remaining /= 128;
+        if (remaining > 0) {
+            byte |= 0x80;
+        }
+        packet.append(static_cast<char>(byte));
+    } while (remaining > 0);
+    packet.append(body);
+    socket->write(packet);
+}
+
+void MqttClient::appendString(QByteArray& out, const QByteArray& value)
+{
+    out.append(static_cast<char>((value.size() >> 8) & 0xFF));
+    out.append(static_cast<char>(value.size() & 0xFF));
+    out.append(value);
+}
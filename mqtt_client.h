@@ -0,0 +1,77 @@
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+
+class QTcpSocket;
+
+// 最小的 MQTT 3.1.1 客户端：只支持 QoS 0 发布、QoS 0 订阅和 PINGREQ，
+// 满足小智服务器控制通道的需要。端口为 TLS 时使用 QSslSocket。
+class MqttClient : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MqttClient(QObject *parent = nullptr);
+    ~MqttClient();
+
+    struct Options {
+        QString host;
+        quint16 port = 8883;
+        bool useTls = true;
+        QString clientId;
+        QString username;
+        QString password;
+        int keepAliveSec = 90;
+    };
+
+    void connectToHost(const Options& options);
+    // 发送 DISCONNECT 后关闭连接
+    void disconnectFromHost();
+    // 直接关闭连接（保活超时等）
+    void abort();
+
+    // 已收到 CONNACK 且服务器接受连接
+    bool isConnected() const { return sessionUp; }
+
+    void subscribe(const QString& topic);
+    void publish(const QString& topic, const QByteArray& payload);
+    void ping();
+
+signals:
+    void connected();
+    void disconnected();
+    void errorOccurred(const QString& message);
+    void messageReceived(const QString& topic, const QByteArray& payload);
+    void pingResponse();
+
+private slots:
+    void onSocketConnected();
+    void onReadyRead();
+    void onSocketDisconnected();
+
+private:
+    void sendPacket(quint8 header, const QByteArray& body);
+    void processPacket(quint8 header, const QByteArray& body);
+    static void appendString(QByteArray& out, const QByteArray& value);
+
+    QTcpSocket* socket;
+    Options options;
+    QByteArray rxBuffer;
+    bool sessionUp;
+    quint16 nextPacketId;
+
+    // 固定报头类型
+    static constexpr quint8 CONNECT = 0x10;
+    static constexpr quint8 CONNACK = 0x20;
+    static constexpr quint8 PUBLISH = 0x30;
+    static constexpr quint8 PUBACK = 0x40;
+    static constexpr quint8 SUBSCRIBE = 0x82;
+    static constexpr quint8 SUBACK = 0x90;
+    static constexpr quint8 PINGREQ = 0xC0;
+    static constexpr quint8 PINGRESP = 0xD0;
+    static constexpr quint8 DISCONNECT = 0xE0;
+};
+
+#endif // MQTT_CLIENT_H
@@ -0,0 +1,389 @@
+#include "mqtt_udp_transport.h"
+#include <QJsonDocument>
+#include <QUrl>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+
+// QoS 0 PUBLISH 报文长度：固定头 + 剩余长度 + 主题 + 负载
+static int publishSize(const QString& topic, int payloadSize)
+{
+    const int remaining = 2 + topic.toUtf8().size() + payloadSize;
+    int lengthBytes = 1;
+    for (int value = remaining; value > 127; value /= 128) {
+        ++lengthBytes;
+    }
+    return 1 + lengthBytes + remaining;
+}
+
+MqttConfig MqttConfig::fromJson(const QJsonObject& mqtt)
+{
+    MqttConfig config;
+    config.endpoint = mqtt.value("endpoint").toString();
+    config.clientId = mqtt.value("client_id").toString();
+    config.username = mqtt.value("username").toString();
+    config.password = mqtt.value("password").toString();
+    config.publishTopic = mqtt.value("publish_topic").toString();
+    config.subscribeTopic = mqtt.value("subscribe_topic").toString();
+    config.keepAliveSec = mqtt.value("keepalive").toInt(90);
+    return config;
+}
+
+QString MqttConfig::url() const
+{
+    QString host = endpoint;
+    int port = 8883;
+    const int colon = endpoint.lastIndexOf(':');
+    if (colon > 0) {
+        host = endpoint.left(colon);
+        port = endpoint.mid(colon + 1).toInt();
+    }
+    return QString("%1://%2:%3").arg(port == 8883 ? "mqtts" : "mqtt", host).arg(port);
+}
+
+MqttUdpTransport::MqttUdpTransport(QObject *parent)
+    : Transport(parent)
+    , serverHelloReceived(false)
+    , audioChannelOpen(false)
+    , localSequence(0)
+    , remoteSequence(0)
+    , remoteSequenceValid(false)
+    , lostBySequence(0)
+    , stalePackets(0)
+    , badPackets(0)
+    , maxMissedPings(3)
+    , outstandingPings(0)
+{
+    connect(&mqtt, &MqttClient::connected, this, &MqttUdpTransport::onMqttConnected);
+    connect(&mqtt, &MqttClient::disconnected, this, &MqttUdpTransport::onMqttDisconnected);
+    connect(&mqtt, &MqttClient::messageReceived, this, &MqttUdpTransport::onMqttMessage);
+    connect(&mqtt, &MqttClient::pingResponse, this, &MqttUdpTransport::onPingResponse);
+    connect(&mqtt, &MqttClient::errorOccurred, this, [this](const QString& error) {
+        if (onErrorCallback) {
+            onErrorCallback(error);
+        }
+    });
+    connect(&udpSocket, &QUdpSocket::readyRead, this, &MqttUdpTransport::onUdpReadyRead);
+
+    timeoutTimer.setSingleShot(true);
+    connect(&timeoutTimer, &QTimer::timeout, this, &MqttUdpTransport::checkTimeout);
+    connect(&keepAliveTimer, &QTimer::timeout, this, &MqttUdpTransport::sendKeepAlive);
+    keepAliveTimer.setInterval(DEFAULT_KEEPALIVE_MS);
+}
+
+MqttUdpTransport::~MqttUdpTransport()
+{
+    closeConnection();
+}
+
+bool MqttUdpTransport::connectToServer(const QString& url)
+{
+    if (!mqttConfig.isValid()) {
+        qDebug() << "MQTT 配置不完整，无法连接";
+        if (onErrorCallback) {
+            onErrorCallback("missing mqtt config");
+        }
+        return false;
+    }
+
+    const QUrl parsed(url.isEmpty() ? mqttConfig.url() : url);
+    MqttClient::Options options;
+    options.host = parsed.host();
+    options.port = static_cast<quint16>(parsed.port(DEFAULT_PORT));
+    options.useTls = parsed.scheme() != "mqtt";
+    options.clientId = mqttConfig.clientId;
+    options.username = mqttConfig.username;
+    options.password = mqttConfig.password;
+    options.keepAliveSec = mqttConfig.keepAliveSec;
+
+    serverHelloReceived = false;
+    mqtt.connectToHost(options);
+    timeoutTimer.start(TIMEOUT_MS);
+    return true;
+}
+
+void MqttUdpTransport::sendAudio(const QByteArray& opusData)
+{
+    if (!audioChannelOpen) {
+        return;
+    }
+
+    // nonce 头：模板中带 ssrc，填入长度、时间戳和序号
+    txPacket.resize(NONCE_SIZE + opusData.size());
+    uchar* header = reinterpret_cast<uchar*>(txPacket.data());
+    memcpy(header, nonceTemplate.constData(), NONCE_SIZE);
+    qToBigEndian<quint16>(static_cast<quint16>(opusData.size()), header + 2);
+    qToBigEndian<quint32>(static_cast<quint32>(sessionClock.elapsed()), header + 8);
+    qToBigEndian<quint32>(++localSequence, header + 12);
+
+    if (!aes.apply(header, opusData.constData(), opusData.size(), txPacket.data() + NONCE_SIZE)) {
+        qDebug() << "音频加密失败";
+        return;
+    }
+    udpSocket.write(txPacket);
+    wireStats.audioBytesSent += txPacket.size();
+}
+
+void MqttUdpTransport::sendText(const QString& text)
+{
+    if (!mqtt.isConnected()) {
+        return;
+    }
+    qDebug() << "发送文本消息:" << text;
+    const QByteArray payload = text.toUtf8();
+    mqtt.publish(mqttConfig.publishTopic, payload);
+    wireStats.jsonBytesSent += payload.size();
+    wireStats.textBytesSent += publishSize(mqttConfig.publishTopic, payload.size());
+}
+
+void MqttUdpTransport::closeConnection()
+{
+    timeoutTimer.stop();
+    keepAliveTimer.stop();
+    if (mqtt.isConnected() && audioChannelOpen) {
+        QJsonObject goodbye;
+        goodbye["type"] = "goodbye";
+        goodbye["session_id"] = sessionId;
+        mqtt.publish(mqttConfig.publishTopic, QJsonDocument(goodbye).toJson(QJsonDocument::Compact));
+    }
+    closeAudioChannel();
+    mqtt.disconnectFromHost();
+}
+
+bool MqttUdpTransport::isConnected() const
+{
+    return mqtt.isConnected() && serverHelloReceived;
+}
+
+void MqttUdpTransport::setKeepAlive(int intervalMs, int maxMissed)
+{
+    maxMissedPings = qMax(1, maxMissed);
+    keepAliveTimer.setInterval(intervalMs);
+    if (intervalMs <= 0) {
+        keepAliveTimer.stop();
+    } else if (serverHelloReceived) {
+        keepAliveTimer.start();
+    }
+}
+
+void MqttUdpTransport::onMqttConnected()
+{
+    qDebug() << "MQTT connected";
+    if (!mqttConfig.subscribeTopic.isEmpty()) {
+        mqtt.subscribe(mqttConfig.subscribeTopic);
+    }
+    sendHello();
+}
+
+void MqttUdpTransport::onMqttDisconnected()
+{
+    qDebug() << "MQTT disconnected";
+    const bool wasConnected = serverHelloReceived;
+    serverHelloReceived = false;
+    keepAliveTimer.stop();
+    closeAudioChannel();
+    if (wasConnected && onDisconnectedCallback) {
+        onDisconnectedCallback();
+    } else if (!wasConnected && onErrorCallback) {
+        onErrorCallback("mqtt disconnected before hello");
+    }
+}
+
+void MqttUdpTransport::onMqttMessage(const QString& topic, const QByteArray& payload)
+{
+    wireStats.jsonBytesReceived += payload.size();
+    wireStats.textBytesReceived += publishSize(topic, payload.size());
+    const QString message = QString::fromUtf8(payload);
+    Protocol::Message parsed = Protocol::parse(payload);
+    if (std::holds_alternative<std::monostate>(parsed)) {
+        qDebug() << "Invalid JSON received:" << message;
+        return;
+    }
+    qDebug() << "Received message:" << message;
+
+    if (const auto* hello = std::get_if<Protocol::HelloMessage>(&parsed)) {
+        if (hello->transport != "udp") {
+            return;
+        }
+        // 每次 hello 都会下发新的 UDP 参数和密钥
+        if (!openAudioChannel(*hello)) {
+            closeConnection();
+            if (onErrorCallback) {
+                onErrorCallback("invalid udp params");
+            }
+            return;
+        }
+        const bool first = !serverHelloReceived;
+        serverHelloReceived = true;
+        timeoutTimer.stop();
+        if (first) {
+            outstandingPings = 0;
+            resetRtt();
+            if (keepAliveTimer.interval() > 0) {
+                keepAliveTimer.start();
+            }
+            if (onConnectedCallback) {
+                onConnectedCallback();
+            }
+        }
+        deliverMessage(message, parsed);
+        if (hello->hasAudioParams && onAudioParamsCallback) {
+            onAudioParamsCallback(hello->audioParams);
+        }
+    } else if (std::holds_alternative<Protocol::GoodbyeMessage>(parsed)) {
+        // 服务器结束会话：关闭音频通道，由 ConnectionManager 重新建立
+        qDebug() << "Received goodbye from server";
+        deliverMessage(message, parsed);
+        closeConnection();
+    } else if (const auto* error = std::get_if<Protocol::ErrorMessage>(&parsed)) {
+        qDebug() << "Received error from server:" << error->message;
+        deliverMessage(message, parsed);
+        closeConnection();
+    } else {
+        deliverMessage(message, parsed);
+    }
+}
+
+bool MqttUdpTransport::openAudioChannel(const Protocol::HelloMessage& hello)
+{
+    if (!hello.hasUdp || hello.udp.server.isEmpty() || hello.udp.port <= 0 ||
+        hello.udp.nonce.size() != NONCE_SIZE || !aes.setKey(hello.udp.key)) {
+        qDebug() << "服务器 hello 中的 UDP 参数无效";
+        return false;
+    }
+
+    closeAudioChannel();
+    sessionId = hello.sessionId;
+    nonceTemplate = hello.udp.nonce;
+    localSequence = 0;
+    remoteSequence = 0;
+    remoteSequenceValid = false;
+
+    sessionClock.start();
+    downlinkStats.reset();
+    if (hello.hasAudioParams) {
+        downlinkStats.setFrameDuration(hello.audioParams.frameDuration);
+    }
+
+    // 连接式 UDP：只接收来自服务器地址的包，发送时不必每次指定地址
+    udpSocket.connectToHost(hello.udp.server, static_cast<quint16>(hello.udp.port));
+    audioChannelOpen = true;
+    qDebug() << "UDP 音频通道:" << hello.udp.server << hello.udp.port;
+    return true;
+}
+
+void MqttUdpTransport::closeAudioChannel()
+{
+    audioChannelOpen = false;
+    if (udpSocket.state() != QAbstractSocket::UnconnectedState) {
+        udpSocket.abort();
+    }
+}
+
+void MqttUdpTransport::onUdpReadyRead()
+{
+    while (udpSocket.hasPendingDatagrams()) {
+        const qint64 size = udpSocket.pendingDatagramSize();
+        rxPacket.resize(static_cast<int>(qMax<qint64>(size, 0)));
+        const qint64 read = udpSocket.readDatagram(rxPacket.data(), rxPacket.size());
+        if (!audioChannelOpen) {
+            continue;
+        }
+        wireStats.audioBytesReceived += qMax<qint64>(read, 0);
+
+        const uchar* header = reinterpret_cast<const uchar*>(rxPacket.constData());
+        if (read < NONCE_SIZE || header[0] != PACKET_TYPE_AUDIO) {
+            ++badPackets;
+            continue;
+        }
+        const int payloadSize = qFromBigEndian<quint16>(header + 2);
+        if (payloadSize > read - NONCE_SIZE) {
+            ++badPackets;
+            continue;
+        }
+        const quint32 timestamp = qFromBigEndian<quint32>(header + 8);
+        const quint32 sequence = qFromBigEndian<quint32>(header + 12);
+
+        // 序号不大于上一个包的是重复或迟到的包，直接丢弃；跳号计为丢包
+        if (remoteSequenceValid) {
+            const qint32 gap = static_cast<qint32>(sequence - remoteSequence);
+            if (gap <= 0) {
+                ++stalePackets;
+                continue;
+            }
+            lostBySequence += gap - 1;
+        }
+        remoteSequence = sequence;
+        remoteSequenceValid = true;
+
+        rxPayload.resize(payloadSize);
+        if (!aes.apply(header, rxPacket.constData() + NONCE_SIZE, payloadSize, rxPayload.data())) {
+            ++badPackets;
+            continue;
+        }
+
+        downlinkStats.onPacket(timestamp, sessionClock.elapsed());
+        deliverAudio(rxPayload.constData(), payloadSize, timestamp);
+    }
+}
+
+void MqttUdpTransport::sendKeepAlive()
+{
+    if (outstandingPings >= maxMissedPings) {
+        qDebug() << "连续" << outstandingPings << "次未收到 PINGRESP，断开连接";
+        keepAliveTimer.stop();
+        closeAudioChannel();
+        mqtt.abort();
+        if (onErrorCallback) {
+            onErrorCallback("keep-alive timeout");
+        }
+        return;
+    }
+
+    if (outstandingPings == 0) {
+        pingClock.start();
+    }
+    ++outstandingPings;
+    mqtt.ping();
+}
+
+void MqttUdpTransport::onPingResponse()
+{
+    // PINGRESP 不带标识，只用没有未完成 ping 时发出的那一个计算 RTT
+    if (outstandingPings > 0 && pingClock.isValid()) {
+        updateRtt(pingClock.elapsed());
+    }
+    outstandingPings = 0;
+}
+
+void MqttUdpTransport::checkTimeout()
+{
+    if (!serverHelloReceived) {
+        qDebug() << "Server hello timeout";
+        closeConnection();
+        if (onErrorCallback) {
+            onErrorCallback("hello timeout");
+        }
+    }
+}
+
+void MqttUdpTransport::sendHello()
+{
+    QJsonObject hello;
+    hello["type"] = "hello";
+    hello["version"] = 3;
+    hello["transport"] = "udp";
+
+    QJsonObject audioParams;
+    audioParams["format"] = "opus";
+    audioParams["sample_rate"] = 16000;
+    audioParams["channels"] = 1;
+    audioParams["frame_duration"] = OPUS_FRAME_DURATION_MS;
+    hello["audio_params"] = audioParams;
+
+    const QByteArray message = QJsonDocument(hello).toJson(QJsonDocument::Compact);
+    qDebug() << "Hello message:" << message;
+    mqtt.publish(mqttConfig.publishTopic, message);
+    wireStats.jsonBytesSent += message.size();
+    wireStats.textBytesSent += publishSize(mqttConfig.publishTopic, message.size());
+}
@@ -0,0 +1,108 @@
+#ifndef MQTT_UDP_TRANSPORT_H
+#define MQTT_UDP_TRANSPORT_H
+
+#include <QTimer>
+#include <QUdpSocket>
+#include <QJsonObject>
+#include "transport.h"
+#include "mqtt_client.h"
+#include "aes_ctr.h"
+
+// OTA 响应中的 mqtt 配置
+struct MqttConfig {
+    QString endpoint;        // host 或 host:port，未指定端口时为 8883（TLS）
+    QString clientId;
+    QString username;
+    QString password;
+    QString publishTopic;
+    QString subscribeTopic;
+    int keepAliveSec = 90;
+
+    bool isValid() const { return !endpoint.isEmpty() && !publishTopic.isEmpty(); }
+    // 与固件相同：8883 端口使用 TLS（mqtts://），其他端口为明文（mqtt://）
+    QString url() const;
+    static MqttConfig fromJson(const QJsonObject& mqtt);
+};
+
+// MQTT 控制通道 + 加密 UDP 音频通道（与小智固件的 MqttProtocol 相同）。
+// JSON 消息通过 MQTT 发布/订阅；服务器 hello 中下发 UDP 地址、AES 密钥和 nonce，
+// 音频包格式为 16 字节 nonce 头 + AES-128-CTR 加密的 Opus 数据：
+//   u8 type(0x01), u8 flags, u16 payload_size, u32 ssrc, u32 timestamp, u32 sequence
+// 整个 nonce 头同时作为 CTR 的初始计数器块。UDP 没有队头阻塞，丢包按序号检测，
+// 由音频线程的丢包补偿处理。
+class MqttUdpTransport : public Transport {
+    Q_OBJECT
+public:
+    explicit MqttUdpTransport(QObject *parent = nullptr);
+    ~MqttUdpTransport();
+
+    void setConfig(const MqttConfig& config) { mqttConfig = config; }
+    const MqttConfig& config() const { return mqttConfig; }
+
+    QString transportName() const override { return QStringLiteral("udp"); }
+
+    // url 可以为空（使用配置中的 endpoint），也可以是 mqtt://host:port 或 mqtts://host:port
+    bool connectToServer(const QString& url) override;
+    using Transport::sendAudio;
+    void sendAudio(const QByteArray& opusData) override;
+    void sendText(const QString& text) override;
+    void closeConnection() override;
+    bool isConnected() const override;
+
+    // 用 MQTT PINGREQ/PINGRESP 保活并测量 RTT
+    void setKeepAlive(int intervalMs, int maxMissed) override;
+
+    // UDP 统计：按序号检测到的丢包、过期（重复或乱序）丢弃、格式或解密错误
+    qint64 sequenceLost() const { return lostBySequence; }
+    qint64 staleDropped() const { return stalePackets; }
+    qint64 malformedPackets() const { return badPackets; }
+
+private slots:
+    void onMqttConnected();
+    void onMqttDisconnected();
+    void onMqttMessage(const QString& topic, const QByteArray& payload);
+    void onUdpReadyRead();
+    void onPingResponse();
+    void sendKeepAlive();
+    void checkTimeout();
+
+private:
+    void sendHello();
+    bool openAudioChannel(const Protocol::HelloMessage& hello);
+    void closeAudioChannel();
+
+    MqttConfig mqttConfig;
+    MqttClient mqtt;
+    QUdpSocket udpSocket;
+    AesCtr aes;
+    QByteArray nonceTemplate;     // 服务器下发的 16 字节包头模板
+    QString sessionId;
+    bool serverHelloReceived;
+    bool audioChannelOpen;
+
+    quint32 localSequence;
+    quint32 remoteSequence;
+    bool remoteSequenceValid;
+    qint64 lostBySequence;
+    qint64 stalePackets;
+    qint64 badPackets;
+
+    QByteArray txPacket;          // 发送缓冲区，复用容量
+    QByteArray rxPacket;          // 接收缓冲区（密文）
+    QByteArray rxPayload;         // 解密后的 Opus 数据
+
+    QTimer timeoutTimer;
+    QTimer keepAliveTimer;
+    QElapsedTimer pingClock;
+    int maxMissedPings;
+    int outstandingPings;
+
+    static constexpr int NONCE_SIZE = 16;
+    static constexpr quint8 PACKET_TYPE_AUDIO = 0x01;
+    static constexpr quint16 DEFAULT_PORT = 8883;
+    static constexpr int TIMEOUT_MS = 10000;
+    static constexpr int DEFAULT_KEEPALIVE_MS = 5000;
+    static constexpr int OPUS_FRAME_DURATION_MS = 60;
+};
+
+#endif // MQTT_UDP_TRANSPORT_H
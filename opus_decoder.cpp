@@ -74,6 +74,33 @@ QByteArray OpusDecoder::decode(const QByteArray& opusData)
     return pcmData;
 }
 
+QByteArray OpusDecoder::decodeLost()
+{
+    if (!decoder) {
+        return QByteArray();
+    }
+    
+    QByteArray pcmData(frameSize * channels * sizeof(opus_int16), 0);
+    
+    // 传入空数据时 opus 执行丢包补偿（PLC）
+    opus_int32 decodedSamples = opus_decode(
+        decoder,
+        nullptr,
+        0,
+        reinterpret_cast<opus_int16*>(pcmData.data()),
+        frameSize,
+        0
+    );
+    
+    if (decodedSamples < 0) {
+        qDebug() << "丢包补偿失败:" << decodedSamples;
+        return QByteArray();
+    }
+    
+    pcmData.resize(decodedSamples * channels * sizeof(opus_int16));
+    return pcmData;
+}
+
 void OpusDecoder::cleanup()
 {
     if (decoder) {
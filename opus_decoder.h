@@ -16,6 +16,9 @@ public:
     // 解码Opus数据
     QByteArray decode(const QByteArray& opusData);
     
+    // 丢包补偿：按解码器状态生成一帧替代数据
+    QByteArray decodeLost();
+    
     // 获取当前帧大小(采样数)
     int getFrameSize() const { return frameSize; }
 
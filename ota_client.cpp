@@ -0,0 +1,218 @@
+#include "ota_client.h"
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QStandardPaths>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <algorithm>
+#include <climits>
+
+OtaConfig OtaConfig::fromJson(const QJsonObject& root)
+{
+    OtaConfig config;
+    config.response = root;
+    const QJsonObject websocket = root.value("websocket").toObject();
+    config.websocketUrl = websocket.value("url").toString();
+    config.websocketToken = websocket.value("token").toString();
+    config.websocketVersion = websocket.value("version").toInt(0);
+    config.mqtt = root.value("mqtt").toObject();
+    config.firmwareVersion = root.value("firmware").toObject().value("version").toString();
+    const QJsonObject activation = root.value("activation").toObject();
+    config.activationCode = activation.value("code").toString();
+    config.activationMessage = activation.value("message").toString();
+    return config;
+}
+
+QJsonObject OtaConfig::toJson() const
+{
+    return response;
+}
+
+bool OtaConfig::sameConnection(const OtaConfig& other) const
+{
+    return websocketUrl == other.websocketUrl && websocketToken == other.websocketToken
+           && websocketVersion == other.websocketVersion && mqtt == other.mqtt;
+}
+
+OtaClient::OtaClient(QNetworkAccessManager* manager, const QString& url, const QString& cachePath, QObject *parent)
+    : QObject(parent)
+    , manager(manager)
+    , url(url)
+    , cachePath(cachePath)
+    , failures(0)
+    , maxAgeSec(3600)
+    , refreshIntervalSec(6 * 3600)
+    , baseDelayMs(2000)
+    , maxDelayMs(5 * 60 * 1000)
+{
+    timer.setSingleShot(true);
+    connect(&timer, &QTimer::timeout, this, [this]() { refresh(true); });
+}
+
+void OtaClient::setDevice(const QString& deviceId, const QString& clientId, const QByteArray& body)
+{
+    this->deviceId = deviceId;
+    this->clientId = clientId;
+    this->body = body;
+}
+
+void OtaClient::setFreshness(int maxAgeSec, int refreshIntervalSec)
+{
+    this->maxAgeSec = maxAgeSec;
+    this->refreshIntervalSec = refreshIntervalSec;
+}
+
+void OtaClient::setRetryDelays(int baseMs, int maxMs)
+{
+    baseDelayMs = baseMs;
+    maxDelayMs = maxMs;
+}
+
+QString OtaClient::defaultCachePath()
+{
+    const QString path = qEnvironmentVariable("XIAOZHI_OTA_CACHE");
+    if (!path.isEmpty()) {
+        return path;
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation) + "/ota_cache.json";
+}
+
+bool OtaClient::loadCache()
+{
+    QFile file(cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    const QJsonObject response = root.value("response").toObject();
+    const QDateTime fetchedAt = QDateTime::fromMSecsSinceEpoch(
+        static_cast<qint64>(root.value("fetched_at").toDouble()), Qt::UTC);
+    if (response.isEmpty() || root.value("fetched_at").toDouble() <= 0) {
+        qDebug() << "OTA 缓存无效:" << cachePath;
+        return false;
+    }
+
+    current = OtaConfig::fromJson(response);
+    current.fetchedAt = fetchedAt;
+    current.etag = root.value("etag").toString().toLatin1();
+    qDebug() << "OTA 缓存:" << fetchedAt.toLocalTime().toString(Qt::ISODate)
+             << "已过" << fetchedAt.secsTo(QDateTime::currentDateTimeUtc()) << "秒";
+    return true;
+}
+
+bool OtaClient::saveCache() const
+{
+    QDir().mkpath(QFileInfo(cachePath).absolutePath());
+    QJsonObject root;
+    root["fetched_at"] = static_cast<double>(current.fetchedAt.toMSecsSinceEpoch());
+    root["etag"] = QString::fromLatin1(current.etag);
+    root["response"] = current.toJson();
+
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+void OtaClient::refresh(bool force)
+{
+    if (isRefreshing()) {
+        return;
+    }
+
+    // 缓存足够新时不请求；设备待激活时需要尽快拿到激活结果
+    if (!force && current.isValid() && !current.needsActivation()) {
+        const qint64 age = current.fetchedAt.secsTo(QDateTime::currentDateTimeUtc());
+        if (age >= 0 && age < maxAgeSec) {
+            qDebug() << "OTA 缓存仍新鲜，" << (maxAgeSec - age) << "秒后刷新";
+            timer.start(static_cast<int>(std::min<qint64>((maxAgeSec - age) * 1000, INT_MAX)));
+            return;
+        }
+    }
+    sendRequest();
+}
+
+void OtaClient::sendRequest()
+{
+    timer.stop();
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setRawHeader("Device-Id", deviceId.toUtf8());
+    if (!clientId.isEmpty()) {
+        request.setRawHeader("Client-Id", clientId.toUtf8());
+    }
+    if (!current.etag.isEmpty()) {
+        request.setRawHeader("If-None-Match", current.etag);
+    }
+    request.setTransferTimeout(REQUEST_TIMEOUT_MS);
+
+    reply = manager->post(request, body);
+    connect(reply, &QNetworkReply::finished, this, &OtaClient::onFinished);
+}
+
+void OtaClient::onFinished()
+{
+    QNetworkReply* finished = reply;
+    reply = nullptr;
+    finished->deleteLater();
+
+    const int status = finished->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 304 && current.isValid()) {
+        // 配置未变，只更新时间
+        failures = 0;
+        current.fetchedAt = QDateTime::currentDateTimeUtc();
+        saveCache();
+        qDebug() << "OTA 配置未变化";
+        timer.start(refreshIntervalSec * 1000);
+        return;
+    }
+    if (finished->error() != QNetworkReply::NoError) {
+        scheduleRetry(finished->errorString());
+        return;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(finished->readAll(), &parseError);
+    if (!document.isObject()) {
+        scheduleRetry("响应不是 JSON 对象: " + parseError.errorString());
+        return;
+    }
+
+    OtaConfig updated = OtaConfig::fromJson(document.object());
+    updated.fetchedAt = QDateTime::currentDateTimeUtc();
+    updated.etag = finished->rawHeader("ETag");
+    const bool changed = !current.isValid() || !current.sameConnection(updated);
+    current = updated;
+    failures = 0;
+    if (!saveCache()) {
+        qDebug() << "OTA 缓存写入失败:" << cachePath;
+    }
+
+    // 待激活时缩短刷新间隔，激活后尽快拿到正式配置
+    timer.start(current.needsActivation() ? std::max(baseDelayMs, 30000) : refreshIntervalSec * 1000);
+    emit configUpdated(current, changed);
+}
+
+void OtaClient::scheduleRetry(const QString& error)
+{
+    ++failures;
+    const int delay = nextDelayMs();
+    qDebug() << "OTA 请求失败:" << error << "，" << delay << "ms 后重试";
+    timer.start(delay);
+    emit refreshFailed(error, delay);
+}
+
+int OtaClient::nextDelayMs() const
+{
+    // 与 ConnectionManager 相同：指数退避，在 [上限/2, 上限] 之间随机
+    const qint64 ceiling = std::min<qint64>(maxDelayMs, static_cast<qint64>(baseDelayMs) << std::min(failures - 1, 16));
+    const int half = static_cast<int>(ceiling / 2);
+    return half + QRandomGenerator::global()->bounded(half + 1);
+}
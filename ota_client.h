@@ -0,0 +1,102 @@
+#ifndef OTA_CLIENT_H
+#define OTA_CLIENT_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QTimer>
+#include <QPointer>
+#include <QNetworkReply>
+
+class QNetworkAccessManager;
+
+// OTA 接口返回的配置
+struct OtaConfig {
+    QString websocketUrl;        // websocket.url，空表示使用默认地址
+    QString websocketToken;      // websocket.token
+    int websocketVersion = 0;    // websocket.version，请求的二进制协议版本，0 表示未给出
+    QJsonObject mqtt;            // mqtt 段原样保存，由 MqttConfig::fromJson 解析
+    QString firmwareVersion;
+    QString activationCode;      // 设备未激活时非空
+    QString activationMessage;
+    QDateTime fetchedAt;         // 服务器响应的时间
+    QByteArray etag;             // 服务器给出的 ETag，刷新时用于条件请求
+
+    bool isValid() const { return fetchedAt.isValid(); }
+    bool hasMqtt() const { return !mqtt.isEmpty(); }
+    bool needsActivation() const { return !activationCode.isEmpty(); }
+
+    static OtaConfig fromJson(const QJsonObject& root);
+    QJsonObject toJson() const;
+
+    // 连接相关的配置是否相同（决定是否需要通知上层）
+    bool sameConnection(const OtaConfig& other) const;
+
+private:
+    QJsonObject response;        // 完整响应，写入缓存
+};
+
+// OTA 客户端：上一次的响应和时间一起缓存到磁盘。启动时先用缓存中的配置连接，
+// 不等 OTA 请求返回；随后在后台刷新，失败时按指数退避重试，成功后按固定间隔定期刷新。
+// 缓存足够新时跳过启动时的刷新（设备待激活时总是刷新）
+class OtaClient : public QObject
+{
+    Q_OBJECT
+public:
+    OtaClient(QNetworkAccessManager* manager, const QString& url, const QString& cachePath,
+              QObject *parent = nullptr);
+
+    // 请求头中的 Device-Id / Client-Id 和请求体（设备信息 JSON）
+    void setDevice(const QString& deviceId, const QString& clientId, const QByteArray& body);
+
+    // 缓存在 maxAgeSec 秒内视为新鲜；成功后每 refreshIntervalSec 秒刷新一次
+    void setFreshness(int maxAgeSec, int refreshIntervalSec);
+    // 失败重试的退避范围
+    void setRetryDelays(int baseMs, int maxMs);
+
+    // 同步读取缓存（一个小文件），成功时 config() 立即可用
+    bool loadCache();
+
+    // 后台刷新：缓存新鲜时跳过，force 为 true 时总是请求
+    void refresh(bool force = false);
+
+    const OtaConfig& config() const { return current; }
+    bool isRefreshing() const { return !reply.isNull(); }
+    int failureCount() const { return failures; }
+
+    // 缓存路径：XIAOZHI_OTA_CACHE，默认在应用配置目录下
+    static QString defaultCachePath();
+
+signals:
+    // 收到新的响应；connectionChanged 表示 WebSocket 地址或 MQTT 配置有变化
+    void configUpdated(const OtaConfig& config, bool connectionChanged);
+    // 请求失败，retryMs 后重试
+    void refreshFailed(const QString& error, int retryMs);
+
+private:
+    void sendRequest();
+    void onFinished();
+    void scheduleRetry(const QString& error);
+    bool saveCache() const;
+    int nextDelayMs() const;
+
+    QNetworkAccessManager* manager;
+    QString url;
+    QString cachePath;
+    QString deviceId;
+    QString clientId;
+    QByteArray body;
+
+    OtaConfig current;
+    QPointer<QNetworkReply> reply;
+    QTimer timer;               // 重试和定期刷新共用
+    int failures;
+    int maxAgeSec;
+    int refreshIntervalSec;
+    int baseDelayMs;
+    int maxDelayMs;
+
+    static constexpr int REQUEST_TIMEOUT_MS = 10000;
+};
+
+#endif // OTA_CLIENT_H
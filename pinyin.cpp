@@ -0,0 +1,90 @@
+#include "pinyin.h"
+#include "pinyin_table.h"
+#include <QHash>
+
+namespace {
+
+// 多音字在语音指令中更常见的读音，覆盖生成表中的默认读音
+const struct {
+    const char* syllable;
+    const char* chars;
+} OVERRIDES[] = {
+    {"tiao", "调"},   // 调大、调小
+    {"si", "似"},     // 似乎、好似
+    {"le", "勒"},
+};
+
+const QHash<QChar, QString>& table()
+{
+    // 局部静态变量的初始化是线程安全的
+    static const QHash<QChar, QString> map = []() {
+        QHash<QChar, QString> result;
+        result.reserve(7000);
+        for (const auto& entry : PINYIN_TABLE) {
+            const QString syllable = QString::fromLatin1(entry.syllable);
+            for (QChar c : QString::fromUtf8(entry.chars)) {
+                result.insert(c, syllable);
+            }
+        }
+        for (const auto& entry : OVERRIDES) {
+            const QString syllable = QString::fromLatin1(entry.syllable);
+            for (QChar c : QString::fromUtf8(entry.chars)) {
+                result.insert(c, syllable);
+            }
+        }
+        return result;
+    }();
+    return map;
+}
+
+// 拆成声母和韵母，零声母时声母为空
+void split(const QString& syllable, QString* initial, QString* final)
+{
+    int length = 0;
+    if (syllable.startsWith("zh") || syllable.startsWith("ch") || syllable.startsWith("sh")) {
+        length = 2;
+    } else if (!syllable.isEmpty() && QString("bpmfdtnlgkhjqxrzcsyw").contains(syllable[0])) {
+        length = 1;
+    }
+    *initial = syllable.left(length);
+    *final = syllable.mid(length);
+}
+
+bool similarPair(const QString& a, const QString& b, const char* const pairs[][2], int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if ((a == pairs[i][0] && b == pairs[i][1]) || (a == pairs[i][1] && b == pairs[i][0])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+namespace Pinyin {
+
+QString of(QChar c)
+{
+    return table().value(c);
+}
+
+bool similar(const QString& a, const QString& b)
+{
+    static const char* const INITIALS[][2] = {
+        {"zh", "z"}, {"ch", "c"}, {"sh", "s"}, {"n", "l"}, {"l", "r"}, {"f", "h"}
+    };
+    static const char* const FINALS[][2] = {
+        {"an", "ang"}, {"en", "eng"}, {"in", "ing"}, {"ian", "iang"}, {"uan", "uang"}
+    };
+
+    QString initialA, finalA, initialB, finalB;
+    split(a, &initialA, &finalA);
+    split(b, &initialB, &finalB);
+    if (initialA == initialB) {
+        return similarPair(finalA, finalB, FINALS, 5);
+    }
+    return finalA == finalB && similarPair(initialA, initialB, INITIALS, 6);
+}
+
+}
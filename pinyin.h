@@ -0,0 +1,22 @@
+#ifndef PINYIN_H
+#define PINYIN_H
+
+#include <QChar>
+#include <QString>
+
+// 唤醒词模糊匹配用的拼音（不带声调）。Vosk 中文模型输出汉字，同音或近音的误识别
+// （"小智" → "晓志"、"小子"）在拼音上相同或只差一个声母或韵母。
+// 内置表覆盖 GB2312 的全部 6763 个汉字（由 pinyin.sh 生成 pinyin_table.h，
+// 多音字取一个读音，ü 写作 v）；其他字可以在唤醒词配置的 "pinyin" 中补充
+namespace Pinyin {
+
+// 内置表中的读音，没有时返回空字符串
+QString of(QChar c);
+
+// 两个音节是否只差一组易混的声母（zh/z、ch/c、sh/s、n/l、l/r、f/h）
+// 或韵母（an/ang、en/eng、in/ing、ian/iang、uan/uang）
+bool similar(const QString& a, const QString& b);
+
+}
+
+#endif // PINYIN_H
@@ -0,0 +1,47 @@
+# 生成 pinyin_table.h：GB2312 全部 6763 个汉字的读音（不带声调，ü 写作 v）。
+# 多音字取 ICU Han-Latin 的默认读音，需要 iconv 和 uconv（ICU）
+set -e
+
+out=pinyin_table.h
+
+# GB2312 汉字区：一级字 B0A1–D7F9，二级字 D8A1–F7FE
+for row in $(seq 176 247); do
+    for col in $(seq 161 254); do
+        if [ $row -eq 215 ] && [ $col -gt 249 ]; then
+            continue
+        fi
+        printf "\\$(printf %o $row)\\$(printf %o $col)\n"
+    done
+done | iconv -f GB2312 -t UTF-8 > /tmp/pinyin_chars.txt
+
+uconv -f UTF-8 -t UTF-8 -x 'Han-Latin' < /tmp/pinyin_chars.txt \
+    | sed 's/ǖ/v/g; s/ǘ/v/g; s/ǚ/v/g; s/ǜ/v/g; s/ü/v/g' \
+    | uconv -f UTF-8 -t UTF-8 -x 'Latin-ASCII' > /tmp/pinyin_readings.txt
+
+{
+    echo "// 由 pinyin.sh 生成，不要手工修改"
+    echo "#ifndef PINYIN_TABLE_H"
+    echo "#define PINYIN_TABLE_H"
+    echo
+    echo "// 音节 → GB2312 汉字（按编码顺序），音节按字母顺序"
+    echo "static const struct {"
+    echo "    const char* syllable;"
+    echo "    const char* chars;"
+    echo "} PINYIN_TABLE[] = {"
+    # 只保留单个音节的读音（个别字没有读音或读作两个音节，如“瓩”）
+    paste /tmp/pinyin_readings.txt /tmp/pinyin_chars.txt \
+        | awk -F'\t' '$1 ~ /^[a-z]+$/ {
+              if (!($1 in chars)) order[n++] = $1
+              chars[$1] = chars[$1] $2
+          }
+          END {
+              for (i = 0; i < n; i++) print order[i] "\t" chars[order[i]]
+          }' \
+        | LC_ALL=C sort \
+        | awk -F'\t' '{ printf "    {\"%s\", \"%s\"},\n", $1, $2 }'
+    echo "};"
+    echo
+    echo "#endif // PINYIN_TABLE_H"
+} > $out
+
+rm -f /tmp/pinyin_chars.txt /tmp/pinyin_readings.txt
@@ -0,0 +1,141 @@
+#include "protocol.h"
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QHash>
+#include <QDebug>
+
+namespace Protocol {
+
+namespace {
+
+enum class Kind {
+    Hello,
+    Stt,
+    Tts,
+    Llm,
+    Iot,
+    Error,
+    Goodbye
+};
+
+// type 字符串只在这里比较一次，之后按枚举分支
+const QHash<QString, Kind>& kindTable()
+{
+    static const QHash<QString, Kind> table = {
+        {QStringLiteral("hello"), Kind::Hello},
+        {QStringLiteral("stt"), Kind::Stt},
+        {QStringLiteral("tts"), Kind::Tts},
+        {QStringLiteral("llm"), Kind::Llm},
+        {QStringLiteral("iot"), Kind::Iot},
+        {QStringLiteral("error"), Kind::Error},
+        {QStringLiteral("goodbye"), Kind::Goodbye},
+    };
+    return table;
+}
+
+const QHash<QString, TtsState>& ttsStateTable()
+{
+    static const QHash<QString, TtsState> table = {
+        {QStringLiteral("start"), TtsState::Start},
+        {QStringLiteral("stop"), TtsState::Stop},
+        {QStringLiteral("sentence_start"), TtsState::SentenceStart},
+    };
+    return table;
+}
+
+QString stringField(const QJsonObject& root, const char* key)
+{
+    return root.value(QLatin1String(key)).toString();
+}
+
+} // namespace
+
+Message parse(const QJsonObject& root)
+{
+    const QString type = stringField(root, "type");
+    if (type.isEmpty()) {
+        return std::monostate();
+    }
+
+    auto it = kindTable().constFind(type);
+    if (it == kindTable().constEnd()) {
+        return UnknownMessage{type};
+    }
+
+    switch (it.value()) {
+        case Kind::Hello: {
+            HelloMessage hello;
+            hello.hasVersion = root.contains(QLatin1String("version"));
+            hello.version = root.value(QLatin1String("version")).toInt(1);
+            hello.transport = stringField(root, "transport");
+            hello.sessionId = stringField(root, "session_id");
+            const QJsonValue params = root.value(QLatin1String("audio_params"));
+            if (params.isObject()) {
+                const QJsonObject object = params.toObject();
+                hello.hasAudioParams = true;
+                hello.audioParams.format = stringField(object, "format");
+                hello.audioParams.sampleRate = object.value(QLatin1String("sample_rate")).toInt();
+                hello.audioParams.channels = object.value(QLatin1String("channels")).toInt();
+                hello.audioParams.frameDuration = object.value(QLatin1String("frame_duration")).toInt();
+            }
+            const QJsonValue udp = root.value(QLatin1String("udp"));
+            if (udp.isObject()) {
+                const QJsonObject object = udp.toObject();
+                hello.hasUdp = true;
+                hello.udp.server = stringField(object, "server");
+                hello.udp.port = object.value(QLatin1String("port")).toInt();
+                hello.udp.key = QByteArray::fromHex(stringField(object, "key").toLatin1());
+                hello.udp.nonce = QByteArray::fromHex(stringField(object, "nonce").toLatin1());
+            }
+            const QJsonValue compression = root.value(QLatin1String("compression"));
+            if (compression.isObject()) {
+                const QJsonObject object = compression.toObject();
+                hello.compression = stringField(object, "algorithm");
+                hello.compressionThreshold = object.value(QLatin1String("threshold")).toInt();
+            }
+            return hello;
+        }
+        case Kind::Stt:
+            return SttMessage{stringField(root, "session_id"), stringField(root, "text")};
+        case Kind::Tts: {
+            TtsMessage tts;
+            tts.sessionId = stringField(root, "session_id");
+            tts.state = ttsStateTable().value(stringField(root, "state"), TtsState::Unknown);
+            tts.text = stringField(root, "text");
+            return tts;
+        }
+        case Kind::Llm:
+            return LlmMessage{stringField(root, "session_id"),
+                              stringField(root, "emotion"),
+                              stringField(root, "text")};
+        case Kind::Iot:
+            return IotMessage{stringField(root, "session_id"),
+                              root.value(QLatin1String("commands")).toArray()};
+        case Kind::Error:
+            return ErrorMessage{stringField(root, "message")};
+        case Kind::Goodbye:
+            return GoodbyeMessage{stringField(root, "session_id")};
+    }
+    return UnknownMessage{type};
+}
+
+Message parse(const QByteArray& json)
+{
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(json, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        qDebug() << "JSON 解析失败:" << error.errorString();
+        return std::monostate();
+    }
+    return parse(doc.object());
+}
+
+int negotiateVersion(const HelloMessage& hello, int requested)
+{
+    if (!hello.hasVersion) {
+        return requested;
+    }
+    return hello.version == 2 || hello.version == 3 ? hello.version : 1;
+}
+
+} // namespace Protocol
@@ -0,0 +1,139 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <QString>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <array>
+#include <functional>
+#include <variant>
+
+struct AudioParams {
+    QString format;
+    int sampleRate;
+    int channels;
+    int frameDuration;
+};
+
+// 服务器下发的 JSON 消息只解析一次，转换成带类型的结构体，
+// 再通过注册的处理函数表分发，避免各处重复解析和字符串比较
+namespace Protocol {
+
+enum class TtsState {
+    Unknown,
+    Start,
+    Stop,
+    SentenceStart
+};
+
+// MQTT 传输时服务器在 hello 中下发的 UDP 音频通道参数
+struct UdpParams {
+    QString server;
+    int port = 0;
+    QByteArray key;     // AES-128 密钥（已从十六进制解码）
+    QByteArray nonce;   // 16 字节包头模板（已从十六进制解码）
+};
+
+struct HelloMessage {
+    int version = 1;   // 服务器选择的二进制协议版本，缺省为 1
+    bool hasVersion = false;  // hello 中是否给出了 version
+    QString transport;
+    QString sessionId;
+    bool hasAudioParams = false;
+    AudioParams audioParams{};
+    bool hasUdp = false;
+    UdpParams udp;
+    QString compression;          // 服务器接受的 JSON 压缩算法（"deflate"），空表示不压缩
+    int compressionThreshold = 0; // 服务器压缩下行 JSON 的最小长度
+};
+
+struct SttMessage {
+    QString sessionId;
+    QString text;
+};
+
+struct TtsMessage {
+    QString sessionId;
+    TtsState state = TtsState::Unknown;
+    QString text;   // sentence_start 时的句子文本
+};
+
+struct LlmMessage {
+    QString sessionId;
+    QString emotion;
+    QString text;
+};
+
+struct IotMessage {
+    QString sessionId;
+    QJsonArray commands;
+};
+
+struct ErrorMessage {
+    QString message;
+};
+
+// 服务器结束会话（MQTT 传输时关闭 UDP 音频通道）
+struct GoodbyeMessage {
+    QString sessionId;
+};
+
+// 有 type 字段但不认识的消息
+struct UnknownMessage {
+    QString type;
+};
+
+// std::monostate 表示无效 JSON 或缺少 type
+using Message = std::variant<std::monostate,
+                             HelloMessage,
+                             SttMessage,
+                             TtsMessage,
+                             LlmMessage,
+                             IotMessage,
+                             ErrorMessage,
+                             GoodbyeMessage,
+                             UnknownMessage>;
+
+// 从已解析的 JSON 对象构造消息
+Message parse(const QJsonObject& root);
+
+// 解析 JSON 文本，失败时返回 std::monostate
+Message parse(const QByteArray& json);
+
+// 按服务器 hello 确定二进制协议版本：给出 2/3 时使用该版本，给出其他值时为 1；
+// 没有给出时沿用请求的版本。默认只请求版本 1，不回显 version 的旧服务器
+// 仍按裸 Opus 收发；请求 2/3 需要用户或 OTA 配置指定
+int negotiateVersion(const HelloMessage& hello, int requested);
+
+class MessageDispatcher
+{
+public:
+    // 为某一类消息注册处理函数，重复注册会覆盖之前的
+    template <typename T>
+    void on(std::function<void(const T&)> handler)
+    {
+        const size_t index = Message(std::in_place_type<T>).index();
+        handlers[index] = [handler](const Message& message) {
+            handler(std::get<T>(message));
+        };
+    }
+
+    // 按消息类型查表调用，没有注册处理函数时返回 false
+    bool dispatch(const Message& message) const
+    {
+        const auto& handler = handlers[message.index()];
+        if (!handler) {
+            return false;
+        }
+        handler(message);
+        return true;
+    }
+
+private:
+    std::array<std::function<void(const Message&)>, std::variant_size_v<Message>> handlers;
+};
+
+} // namespace Protocol
+
+#endif // PROTOCOL_H
@@ -1,21 +1,41 @@
 #include "speaker_manager.h"
 #include <QDebug>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <cmath>
 
 SpeakerManager::SpeakerManager(QObject *parent)
     : QObject(parent)
     , audioSink(nullptr)
     , audioOutput(nullptr)
+    , mediaDevices(new QMediaDevices(this))
+    , playoutTimer(new QTimer(this))
     , sampleRate(24000)  // 使用24kHz采样率
     , channels(1)
     , playing(false)
     , bufferSize(0)
+    , referenceWritten(0)
+    , lastSwitchMs(-1)
+    , maxSwitchMs(0)
+    , switchCount(0)
 {
     // 配置默认音频格式
     format.setSampleRate(sampleRate);
     format.setChannelCount(channels);
     format.setSampleFormat(QAudioFormat::Int16);
     
+    referenceRing.fill(0, sampleRate * REFERENCE_RING_MS / 1000);
+    
+    // 待播放数据的补充写入定时器
+    playoutTimer->setInterval(PLAYOUT_INTERVAL_MS);
+    playoutTimer->setTimerType(Qt::PreciseTimer);
+    connect(playoutTimer, &QTimer::timeout, this, &SpeakerManager::feedSink);
+    
     initializeAudioDevice();
+    
+    // 监听设备热插拔
+    connect(mediaDevices, &QMediaDevices::audioOutputsChanged,
+            this, &SpeakerManager::handleAudioOutputsChanged);
 }
 
 SpeakerManager::~SpeakerManager()
@@ -33,18 +53,26 @@ void SpeakerManager::calculateBufferSize()
 
 bool SpeakerManager::initializeAudioDevice()
 {
-    // 检查默认音频输出设备
-    QAudioDevice outputDevice = QMediaDevices::defaultAudioOutput();
-    if (!outputDevice.isFormatSupported(format)) {
-        qDebug() << "默认音频输出设备不支持当前格式";
+    return openDevice(QMediaDevices::defaultAudioOutput());
+}
+
+bool SpeakerManager::openDevice(const QAudioDevice& outputDevice)
+{
+    // 检查音频输出设备
+    if (outputDevice.isNull() || !outputDevice.isFormatSupported(format)) {
+        qDebug() << "音频输出设备不可用或不支持当前格式:" << outputDevice.description();
         return false;
     }
     
     // 创建音频输出接收器
+    audioOutput = nullptr;
     if (audioSink) {
+        disconnect(audioSink, &QAudioSink::stateChanged, this, &SpeakerManager::handleStateChanged);
+        audioSink->stop();
         delete audioSink;
     }
-    audioSink = new QAudioSink(format, this);
+    audioSink = new QAudioSink(outputDevice, format, this);
+    currentDevice = outputDevice;
     
     // 计算并设置缓冲区大小
     calculateBufferSize();
@@ -60,7 +88,7 @@ bool SpeakerManager::initializeAudioDevice()
              << "\n  通道数:" << channels
              << "\n  采样格式:" << format.sampleFormat()
              << "\n  缓冲区大小:" << bufferSize << "字节"
-             << "\n  设备名称:" << QMediaDevices::defaultAudioOutput().description();
+             << "\n  设备名称:" << outputDevice.description();
     
     return true;
 }
@@ -78,6 +106,13 @@ void SpeakerManager::configureAudioParams(int newSampleRate, int newChannels)
     format.setSampleRate(sampleRate);
     format.setChannelCount(channels);
     
+    // 采样率变化后旧的参考信号已无意义
+    {
+        QMutexLocker locker(&referenceMutex);
+        referenceRing.fill(0, sampleRate * REFERENCE_RING_MS / 1000);
+        referenceWritten = 0;
+    }
+    
     // 重新初始化设备
     if (playing) {
         stopPlaying();
@@ -96,6 +131,31 @@ void SpeakerManager::playPCM(const QByteArray& pcmData)
 
 void SpeakerManager::processAudioData(const QByteArray& data)
 {
+    pendingPlayback.append(data);
+    
+    // 积压过多时丢弃最旧的数据，避免延迟无限增长
+    const int maxPendingBytes = sampleRate * channels * sizeof(qint16) * MAX_PENDING_MS / 1000;
+    if (pendingPlayback.size() > maxPendingBytes) {
+        const int frameBytes = channels * sizeof(qint16);
+        int overflow = pendingPlayback.size() - maxPendingBytes;
+        overflow += (frameBytes - overflow % frameBytes) % frameBytes;
+        qDebug() << "待播放数据积压过多，丢弃:" << overflow << "字节";
+        pendingPlayback.remove(0, overflow);
+    }
+    
+    feedSink();
+    if (!pendingPlayback.isEmpty() && !playoutTimer->isActive()) {
+        playoutTimer->start();
+    }
+}
+
+void SpeakerManager::feedSink()
+{
+    if (pendingPlayback.isEmpty()) {
+        playoutTimer->stop();
+        return;
+    }
+    
     // 确保音频输出设备就绪
     if (!audioOutput || !audioOutput->isWritable()) {
         if (audioSink->state() != QAudio::StoppedState) {
@@ -104,29 +164,112 @@ void SpeakerManager::processAudioData(const QByteArray& data)
         audioOutput = audioSink->start();
         if (!audioOutput) {
             qDebug() << "无法启动音频输出设备";
+            pendingPlayback.clear();
+            playoutTimer->stop();
             return;
         }
     }
     
-    // 写入音频数据
-    qint64 written = audioOutput->write(data);
-    if (written != data.size()) {
-        qDebug() << "音频数据写入不完整:" << written << "/" << data.size();
+    // 只写入设备能容纳的整帧数据，其余留到下一次
+    const qint64 frameBytes = channels * sizeof(qint16);
+    qint64 bytes = qMin<qint64>(pendingPlayback.size(), audioSink->bytesFree());
+    bytes -= bytes % frameBytes;
+    if (bytes <= 0) {
+        return;
+    }
+    
+    qint64 written = audioOutput->write(pendingPlayback.constData(), bytes);
+    if (written != bytes) {
+        qDebug() << "音频数据写入不完整:" << written << "/" << bytes;
+    }
+    if (written > 0) {
+        appendReference(pendingPlayback, written);
+        pendingPlayback.remove(0, written);
     }
     
     playing = true;
+    if (pendingPlayback.isEmpty()) {
+        playoutTimer->stop();
+    }
+}
+
+int SpeakerManager::pendingPlaybackMs() const
+{
+    return pendingPlayback.size() * 1000 / (sampleRate * channels * sizeof(qint16));
+}
+
+void SpeakerManager::appendReference(const QByteArray& data, qint64 bytes)
+{
+    const qint16* samples = reinterpret_cast<const qint16*>(data.constData());
+    const int frames = bytes / (sizeof(qint16) * channels);
+    const int ringSize = referenceRing.size();
+    
+    QMutexLocker locker(&referenceMutex);
+    for (int i = 0; i < frames; ++i) {
+        // 多声道时只取第一个声道作为参考
+        referenceRing[(referenceWritten + i) % ringSize] = samples[i * channels];
+    }
+    referenceWritten += frames;
+}
+
+qint64 SpeakerManager::playbackPosition() const
+{
+    QMutexLocker locker(&referenceMutex);
+    qint64 queued = 0;
+    if (audioSink && audioSink->state() == QAudio::ActiveState) {
+        // 已写入但仍在设备缓冲区中等待播放的数据
+        queued = (audioSink->bufferSize() - audioSink->bytesFree()) / (sizeof(qint16) * channels);
+    }
+    return qMax<qint64>(0, referenceWritten - queued);
+}
+
+void SpeakerManager::copyPlaybackReference(qint64 endPosition, float* dst, int samples, int targetRate) const
+{
+    QMutexLocker locker(&referenceMutex);
+    const int ringSize = referenceRing.size();
+    const qint64 oldest = referenceWritten - ringSize;
+    const double ratio = static_cast<double>(sampleRate) / targetRate;
+    
+    for (int i = 0; i < samples; ++i) {
+        // 线性插值重采样到目标采样率
+        double pos = endPosition - (samples - i) * ratio;
+        qint64 index = static_cast<qint64>(std::floor(pos));
+        double frac = pos - index;
+        
+        float a = 0.0f;
+        float b = 0.0f;
+        if (index >= oldest && index >= 0 && index < referenceWritten) {
+            a = referenceRing[index % ringSize];
+        }
+        if (index + 1 >= oldest && index + 1 >= 0 && index + 1 < referenceWritten) {
+            b = referenceRing[(index + 1) % ringSize];
+        }
+        dst[i] = static_cast<float>(a + (b - a) * frac);
+    }
 }
 
 void SpeakerManager::handleStateChanged(QAudio::State state)
 {
     switch (state) {
         case QAudio::IdleState:
-            // 播放完成
+            // 播放完成，或者数据没有及时送达导致设备缓冲区播空
+            if (audioSink && audioSink->error() == QAudio::UnderrunError) {
+                underruns.ref();
+            }
             playing = false;
+            emit playbackIdle();
             break;
         case QAudio::StoppedState:
             // 播放停止
             playing = false;
+            if (audioSink && audioSink->error() != QAudio::NoError &&
+                audioSink->error() != QAudio::UnderrunError) {
+                // 设备失效（如被拔出），迁移到当前默认设备
+                qDebug() << "音频输出设备错误:" << audioSink->error();
+                QMetaObject::invokeMethod(this, [this]() {
+                    migrateToDevice(QMediaDevices::defaultAudioOutput());
+                }, Qt::QueuedConnection);
+            }
             break;
         default:
             break;
@@ -135,6 +278,8 @@ void SpeakerManager::handleStateChanged(QAudio::State state)
 
 void SpeakerManager::stopPlaying()
 {
+    pendingPlayback.clear();
+    playoutTimer->stop();
     if (audioOutput) {
         audioOutput = nullptr;
     }
@@ -143,4 +288,116 @@ void SpeakerManager::stopPlaying()
     }
     
     playing = false;
-} 
\ No newline at end of file
+} 
+void SpeakerManager::stopWithFade(int fadeMs)
+{
+    // 尚未写入设备的数据直接丢弃
+    pendingPlayback.clear();
+    playoutTimer->stop();
+    
+    if (!audioSink || !audioOutput || !playing) {
+        stopPlaying();
+        emit playbackIdle();
+        return;
+    }
+    
+    // 从播放环形缓冲区取出紧接当前播放位置的一小段，做线性淡出
+    const qint64 position = playbackPosition();
+    QByteArray faded;
+    {
+        QMutexLocker locker(&referenceMutex);
+        const int ringSize = referenceRing.size();
+        const qint64 remaining = referenceWritten - position;
+        const int fadeSamples = static_cast<int>(qMin<qint64>(remaining, sampleRate * fadeMs / 1000));
+        
+        faded.resize(fadeSamples * channels * sizeof(qint16));
+        qint16* out = reinterpret_cast<qint16*>(faded.data());
+        for (int i = 0; i < fadeSamples; ++i) {
+            const float gain = 1.0f - static_cast<float>(i + 1) / fadeSamples;
+            const qint16 sample = static_cast<qint16>(referenceRing[(position + i) % ringSize] * gain);
+            for (int c = 0; c < channels; ++c) {
+                out[i * channels + c] = sample;
+            }
+        }
+        
+        // 未播放的部分被丢弃，参考信号也随之回退
+        referenceWritten = position;
+    }
+    
+    // 丢弃设备缓冲区中的剩余数据，只写入淡出段
+    audioSink->stop();
+    audioOutput = nullptr;
+    if (faded.isEmpty()) {
+        playing = false;
+        emit playbackIdle();
+        return;
+    }
+    processAudioData(faded);
+}
+
+void SpeakerManager::handleAudioOutputsChanged()
+{
+    QAudioDevice defaultDevice = QMediaDevices::defaultAudioOutput();
+    bool currentPresent = false;
+    for (const QAudioDevice& device : QMediaDevices::audioOutputs()) {
+        if (device.id() == currentDevice.id()) {
+            currentPresent = true;
+            break;
+        }
+    }
+    
+    // 当前设备被拔出或默认设备发生变化时迁移
+    if (!currentPresent || defaultDevice.id() != currentDevice.id()) {
+        qDebug() << "音频输出设备变化:" << currentDevice.description()
+                 << "->" << defaultDevice.description();
+        migrateToDevice(defaultDevice);
+    }
+}
+
+void SpeakerManager::migrateToDevice(const QAudioDevice& outputDevice)
+{
+    QElapsedTimer switchTimer;
+    switchTimer.start();
+    
+    // 取出旧设备缓冲区中尚未播放的数据
+    const bool wasPlaying = playing;
+    QByteArray unplayed;
+    if (wasPlaying) {
+        const qint64 position = playbackPosition();
+        QMutexLocker locker(&referenceMutex);
+        const int ringSize = referenceRing.size();
+        const int remaining = static_cast<int>(qMin<qint64>(referenceWritten - position, ringSize));
+        
+        unplayed.resize(remaining * channels * sizeof(qint16));
+        qint16* out = reinterpret_cast<qint16*>(unplayed.data());
+        for (int i = 0; i < remaining; ++i) {
+            const qint16 sample = referenceRing[(position + i) % ringSize];
+            for (int c = 0; c < channels; ++c) {
+                out[i * channels + c] = sample;
+            }
+        }
+        // 这部分会重新写入新设备，参考信号回退到播放位置
+        referenceWritten = position;
+    }
+    // 还没写入旧设备的数据接在后面
+    unplayed.append(pendingPlayback);
+    pendingPlayback.clear();
+    playoutTimer->stop();
+    
+    bool opened = openDevice(outputDevice);
+    playing = false;
+    if (opened && !unplayed.isEmpty()) {
+        processAudioData(unplayed);
+    }
+    
+    lastSwitchMs = switchTimer.elapsed();
+    maxSwitchMs = qMax(maxSwitchMs, lastSwitchMs);
+    ++switchCount;
+    
+    qDebug() << "音频输出设备切换" << (opened ? "完成" : "失败") << ":" << outputDevice.description()
+             << "耗时:" << lastSwitchMs << "ms"
+             << "携带数据:" << unplayed.size() << "字节";
+    if (opened) {
+        emit deviceSwitched(outputDevice.description(), lastSwitchMs);
+    }
+}
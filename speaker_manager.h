@@ -7,6 +7,9 @@
 #include <QQueue>
 #include <QMutex>
 #include <QMediaDevices>
+#include <QVector>
+#include <QTimer>
+#include <QAtomicInt>
 
 class SpeakerManager : public QObject {
     Q_OBJECT
@@ -20,34 +23,95 @@ public:
     // 停止播放
     void stopPlaying();
     
+    // 丢弃未播放的数据，只保留 fadeMs 的淡出后停止（用于打断）
+    void stopWithFade(int fadeMs = 30);
+    
     // 是否正在播放
     bool isPlaying() const { return playing; }
     
     // 配置音频参数
     void configureAudioParams(int sampleRate, int channels);
 
+    // 回声消除参考信号：当前播放位置（以扬声器采样点计，单声道）
+    qint64 playbackPosition() const;
+
+    // 回声消除参考信号：读取以 endPosition 结尾的 samples 个参考采样点，
+    // 并重采样到 targetRate；超出播放环形缓冲区范围的部分填 0
+    void copyPlaybackReference(qint64 endPosition, float* dst, int samples, int targetRate) const;
+
+    int getSampleRate() const { return sampleRate; }
+    
+    // 设备切换指标：最近一次切换耗时（毫秒）、最大耗时和切换次数
+    qint64 lastDeviceSwitchMs() const { return lastSwitchMs; }
+    qint64 maxDeviceSwitchMs() const { return maxSwitchMs; }
+    int deviceSwitchCount() const { return switchCount; }
+    
+    // 设备缓冲区播空的次数（包含每段播放正常结束时的一次），可跨线程读取
+    int underrunCount() const { return underruns.loadRelaxed(); }
+    
+    // 尚未写入设备的待播放数据时长（毫秒）
+    int pendingPlaybackMs() const;
+
+signals:
+    // 缓冲区数据播放完毕进入空闲
+    void playbackIdle();
+    
+    // 输出设备热插拔后已迁移到新的默认设备
+    void deviceSwitched(const QString& deviceName, qint64 latencyMs);
+
 private slots:
     void handleStateChanged(QAudio::State state);
+    void handleAudioOutputsChanged();
+    
+    // 把待播放数据按设备空闲空间写入，由定时器周期补充
+    void feedSink();
 
 private:
     // 初始化音频设备
     bool initializeAudioDevice();
+    bool openDevice(const QAudioDevice& outputDevice);
     
-    // 处理音频数据
+    // 把播放迁移到新设备，尚未播放的数据在新设备上继续播放
+    void migrateToDevice(const QAudioDevice& outputDevice);
+    
+    // 处理音频数据：追加到待播放缓冲区并尽量写入设备
     void processAudioData(const QByteArray& data);
 
     // 计算缓冲区大小
     void calculateBufferSize();
 
+    // 记录写入播放设备的数据，供回声消除使用
+    void appendReference(const QByteArray& data, qint64 bytes);
+
     QAudioSink* audioSink;
     QIODevice* audioOutput;
+    QMediaDevices* mediaDevices;
+    QAudioDevice currentDevice;
     QAudioFormat format;
     QByteArray currentAudioData;
     
+    // 设备缓冲区只有 60ms，超出部分先放在这里，由 playoutTimer 补充写入，
+    // 避免一次写入超过空闲空间时数据被截断
+    QByteArray pendingPlayback;
+    QTimer* playoutTimer;
+    static constexpr int PLAYOUT_INTERVAL_MS = 10;
+    static constexpr int MAX_PENDING_MS = 5000;
+    QAtomicInt underruns;
+    
     int sampleRate;
     int channels;
     bool playing;
     int bufferSize;  // 缓冲区大小（字节）
+
+    // 播放环形缓冲区（单声道），保存最近 REFERENCE_RING_MS 写入的数据
+    static constexpr int REFERENCE_RING_MS = 2000;
+    QVector<qint16> referenceRing;
+    qint64 referenceWritten;  // 累计写入的采样点数
+    mutable QMutex referenceMutex;
+    
+    qint64 lastSwitchMs;
+    qint64 maxSwitchMs;
+    int switchCount;
 };
 
 #endif // SPEAKER_MANAGER_H 
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "stream_stats.h"
+#include <QtMath>
+
+StreamStats::StreamStats(int frameDurationMs)
+    : frameDurationMs(frameDurationMs)
+{
+    reset();
+}
+
+void StreamStats::reset()
+{
+    started = false;
+    expectedTimestamp = 0;
+    lastTransit = 0;
+    minTransit = 0;
+    received = 0;
+    lost = 0;
+    reordered = 0;
+    resyncs = 0;
+    jitter = 0.0;
+    lastQueuingDelay = 0;
+    maxQueuingDelay = 0;
+}
+
+void StreamStats::onPacket(quint32 timestampMs, qint64 arrivalMs)
+{
+    ++received;
+    const qint64 transit = arrivalMs - static_cast<qint64>(timestampMs);
+
+    if (!started) {
+        started = true;
+        expectedTimestamp = timestampMs + frameDurationMs;
+        lastTransit = transit;
+        minTransit = transit;
+        return;
+    }
+
+    // 按无符号差值计算，时间戳回绕时仍然正确
+    const qint64 gap = static_cast<qint32>(timestampMs - expectedTimestamp);
+    if (qAbs(gap) > RESYNC_THRESHOLD_MS) {
+        // 新的流，重新建立基准
+        ++resyncs;
+        expectedTimestamp = timestampMs + frameDurationMs;
+        lastTransit = transit;
+        minTransit = transit;
+        return;
+    }
+
+    if (gap < 0) {
+        // 比期望更早的时间戳：乱序或重复到达
+        ++reordered;
+    } else {
+        lost += gap / frameDurationMs;
+        expectedTimestamp = timestampMs + frameDurationMs;
+    }
+
+    // RFC 3550 到达抖动：相邻包传输时间差的指数平均
+    const qint64 d = transit - lastTransit;
+    jitter += (qAbs(d) - jitter) / 16.0;
+    lastTransit = transit;
+
+    minTransit = qMin(minTransit, transit);
+    lastQueuingDelay = transit - minTransit;
+    maxQueuingDelay = qMax(maxQueuingDelay, lastQueuingDelay);
+}
+
+QString StreamStats::summary() const
+{
+    return QString("包 %1，丢失 %2，乱序 %3，抖动 %4 ms，排队延迟 %5 ms（最大 %6 ms）")
+        .arg(received)
+        .arg(lost)
+        .arg(reordered)
+        .arg(jitter, 0, 'f', 1)
+        .arg(lastQueuingDelay)
+        .arg(maxQueuingDelay);
+}
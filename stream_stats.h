@@ -0,0 +1,48 @@
+#ifndef STREAM_STATS_H
+#define STREAM_STATS_H
+
+#include <QtGlobal>
+#include <QString>
+
+// 带时间戳的音频流统计：由包时间戳推算序号，检测丢包、乱序，
+// 按 RFC 3550 估计到达抖动，并以最小传输时间为基准估计排队延迟
+class StreamStats
+{
+public:
+    explicit StreamStats(int frameDurationMs = 60);
+
+    void reset();
+    void setFrameDuration(int ms) { frameDurationMs = ms > 0 ? ms : 60; }
+
+    // timestampMs 为包内时间戳，arrivalMs 为本地到达时刻（单调时钟）
+    void onPacket(quint32 timestampMs, qint64 arrivalMs);
+
+    qint64 packets() const { return received; }
+    qint64 lostPackets() const { return lost; }
+    qint64 reorderedPackets() const { return reordered; }
+    double jitterMs() const { return jitter; }
+    // 当前包相对于历史最小传输时间多出的延迟（毫秒）
+    qint64 queuingDelayMs() const { return lastQueuingDelay; }
+    qint64 maxQueuingDelayMs() const { return maxQueuingDelay; }
+
+    QString summary() const;
+
+private:
+    int frameDurationMs;
+    bool started;
+    quint32 expectedTimestamp;
+    qint64 lastTransit;
+    qint64 minTransit;
+    qint64 received;
+    qint64 lost;
+    qint64 reordered;
+    qint64 resyncs;
+    double jitter;
+    qint64 lastQueuingDelay;
+    qint64 maxQueuingDelay;
+
+    // 时间戳跳变超过该值视为新的流（例如服务器开始新一句）
+    static constexpr qint64 RESYNC_THRESHOLD_MS = 5000;
+};
+
+#endif // STREAM_STATS_H
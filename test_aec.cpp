@@ -0,0 +1,152 @@
+#include <QCoreApplication>
+#include <QFile>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "aec_processor.h"
+
+// 离线回声消除测试：
+//   test_aec                          使用合成的远端/近端信号
+//   test_aec far.pcm near.pcm [out]   使用录制的一对 16kHz 单声道 s16le 数据
+// 输出 ERLE（回声损耗增强）、估计延迟和实时率
+
+const int SAMPLE_RATE = 16000;
+const int FRAME_SIZE = 960;  // 60ms
+
+static std::vector<qint16> readPcm(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "无法打开文件:" << path;
+        return {};
+    }
+    QByteArray data = file.readAll();
+    std::vector<qint16> samples(data.size() / sizeof(qint16));
+    memcpy(samples.data(), data.constData(), samples.size() * sizeof(qint16));
+    return samples;
+}
+
+// 生成远端（类语音的调制噪声）和近端（回声 + 底噪 + 一段双讲）
+static void synthesize(std::vector<qint16>& far, std::vector<qint16>& near, std::vector<bool>& doubleTalk)
+{
+    const int total = SAMPLE_RATE * 20;
+    const int echoDelay = SAMPLE_RATE * 60 / 1000;
+    std::mt19937 rng(42);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    std::vector<double> farSignal(total);
+    double lowpass = 0.0;
+    for (int i = 0; i < total; ++i) {
+        lowpass = 0.7 * lowpass + 0.3 * noise(rng);
+        // 4Hz 的音节包络
+        double envelope = 0.5 + 0.5 * std::sin(2.0 * M_PI * 4.0 * i / SAMPLE_RATE);
+        farSignal[i] = 6000.0 * lowpass * envelope;
+    }
+
+    // 指数衰减的房间冲激响应
+    std::vector<double> roomIr(512);
+    for (size_t k = 0; k < roomIr.size(); ++k) {
+        roomIr[k] = 0.05 * noise(rng) * std::exp(-static_cast<double>(k) / 80.0);
+    }
+    roomIr[0] = 0.5;
+
+    far.resize(total);
+    near.resize(total);
+    doubleTalk.assign(total, false);
+    for (int i = 0; i < total; ++i) {
+        far[i] = static_cast<qint16>(std::clamp(farSignal[i], -32768.0, 32767.0));
+
+        double echo = 0.0;
+        for (size_t k = 0; k < roomIr.size(); ++k) {
+            int index = i - echoDelay - static_cast<int>(k);
+            if (index >= 0) {
+                echo += roomIr[k] * farSignal[index];
+            }
+        }
+        double local = 20.0 * noise(rng);
+        // 12~14 秒插入近端说话（双讲）
+        if (i >= SAMPLE_RATE * 12 && i < SAMPLE_RATE * 14) {
+            local += 3000.0 * std::sin(2.0 * M_PI * 220.0 * i / SAMPLE_RATE);
+            doubleTalk[i] = true;
+        }
+        near[i] = static_cast<qint16>(std::clamp(echo + local, -32768.0, 32767.0));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    std::vector<qint16> far;
+    std::vector<qint16> near;
+    std::vector<bool> doubleTalk;
+    const bool synthetic = argc < 3;
+
+    if (synthetic) {
+        qDebug() << "使用合成信号: 回声延迟 60ms, 房间冲激响应 32ms";
+        synthesize(far, near, doubleTalk);
+    } else {
+        far = readPcm(argv[1]);
+        near = readPcm(argv[2]);
+        doubleTalk.assign(near.size(), false);
+    }
+    if (far.empty() || near.empty()) {
+        return 1;
+    }
+
+    AecProcessor aec;
+    aec.initialize(SAMPLE_RATE);
+
+    QFile outFile(argc > 3 ? argv[3] : "aec_out.pcm");
+    outFile.open(QIODevice::WriteOnly);
+
+    // 前 5 秒视为收敛期，之后统计 ERLE
+    const size_t convergeSamples = SAMPLE_RATE * 5;
+    double nearEnergy = 0.0;
+    double outEnergy = 0.0;
+    qint64 processNs = 0;
+    QElapsedTimer timer;
+
+    const size_t frames = std::min(far.size(), near.size()) / FRAME_SIZE;
+    for (size_t f = 0; f < frames; ++f) {
+        QByteArray nearFrame(reinterpret_cast<const char*>(near.data() + f * FRAME_SIZE),
+                             FRAME_SIZE * sizeof(qint16));
+        QByteArray farFrame(reinterpret_cast<const char*>(far.data() + f * FRAME_SIZE),
+                            FRAME_SIZE * sizeof(qint16));
+
+        timer.start();
+        QByteArray outFrame = aec.process(nearFrame, farFrame);
+        processNs += timer.nsecsElapsed();
+
+        outFile.write(outFrame);
+
+        const qint16* out = reinterpret_cast<const qint16*>(outFrame.constData());
+        for (int i = 0; i < FRAME_SIZE; ++i) {
+            const size_t index = f * FRAME_SIZE + i;
+            if (index < convergeSamples || doubleTalk[index]) {
+                continue;
+            }
+            nearEnergy += static_cast<double>(near[index]) * near[index];
+            outEnergy += static_cast<double>(out[i]) * out[i];
+        }
+    }
+
+    const double erle = 10.0 * std::log10((nearEnergy + 1.0) / (outEnergy + 1.0));
+    const double audioSeconds = static_cast<double>(frames * FRAME_SIZE) / SAMPLE_RATE;
+    const double rtf = processNs / 1e9 / audioSeconds;
+
+    qDebug() << "处理时长:" << audioSeconds << "秒";
+    qDebug() << "估计回声延迟:" << aec.estimatedDelayMs() << "ms";
+    qDebug() << "ERLE(收敛后):" << erle << "dB";
+    qDebug() << "实时率(RTF):" << rtf;
+
+    if (synthetic && erle < 10.0) {
+        qDebug() << "测试失败: ERLE 低于 10dB";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include "audio_backlog.h"
+
+// 唤醒词检测音频积压测试（时间由测试注入，每块 60ms）：
+// 1. 未超过上限时按顺序取出，不丢弃
+// 2. 最早一块等待超过上限时只保留最新一块，并标记为不连续
+// 3. 取出前检查积压（采集停止后不再入队的情况），只剩一块时不丢弃
+// 4. 上限为 0 时不限制
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+static AudioBacklog::Clock::time_point at(int ms)
+{
+    return AudioBacklog::Clock::time_point(std::chrono::milliseconds(ms));
+}
+
+static QByteArray chunk(int index)
+{
+    return QByteArray(1920, static_cast<char>(index));
+}
+
+static void testInOrder()
+{
+    AudioBacklog backlog(1000);
+    int dropped = 0;
+    for (int i = 0; i < 5; ++i) {
+        dropped += backlog.push(chunk(i), at(i * 60));
+    }
+    check(dropped == 0, "未超过上限不丢弃");
+    check(backlog.size() == 5, "全部排队");
+    for (int i = 0; i < 5; ++i) {
+        const AudioBacklog::Chunk first = backlog.takeFirst();
+        check(first.data == chunk(i), "按顺序取出");
+        check(first.enqueued == at(i * 60), "入队时间");
+        check(!first.discontinuity, "没有丢弃时连续");
+    }
+    check(backlog.isEmpty(), "取空");
+}
+
+static void testShedOnPush()
+{
+    // 识别卡住，一直没有取出
+    AudioBacklog backlog(1000);
+    int dropped = 0;
+    int firstDrop = -1;
+    for (int i = 0; i < 20; ++i) {
+        const int n = backlog.push(chunk(i), at(i * 60));
+        if (n > 0 && firstDrop < 0) {
+            firstDrop = i;
+        }
+        dropped += n;
+    }
+    // 第 17 块（1020ms）入队时最早一块已等待超过 1000ms
+    check(firstDrop == 17, "超过上限时丢弃");
+    check(dropped == 17, "丢弃除最新以外的全部");
+    check(backlog.size() == 3, "之后继续排队");
+
+    const AudioBacklog::Chunk newest = backlog.takeFirst();
+    check(newest.data == chunk(17), "保留丢弃时最新的一块");
+    check(newest.discontinuity, "保留的一块标记为不连续");
+    check(!backlog.takeFirst().discontinuity, "之后的块连续");
+}
+
+static void testShedOnTake()
+{
+    AudioBacklog backlog(1000);
+    backlog.push(chunk(0), at(0));
+    backlog.push(chunk(1), at(60));
+    backlog.push(chunk(2), at(120));
+    check(backlog.shed(at(500)) == 0, "未超过上限");
+    check(backlog.shed(at(1100)) == 2, "取出前丢弃积压");
+    check(backlog.size() == 1 && backlog.takeFirst().data == chunk(2), "只剩最新一块");
+
+    backlog.push(chunk(3), at(1200));
+    check(backlog.shed(at(5000)) == 0, "只剩一块时不丢弃");
+}
+
+static void testUnlimited()
+{
+    AudioBacklog backlog(0);
+    int dropped = 0;
+    for (int i = 0; i < 200; ++i) {
+        dropped += backlog.push(chunk(i), at(i * 60));
+    }
+    check(dropped == 0 && backlog.size() == 200, "上限为 0 时不限制");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    testInOrder();
+    testShedOnPush();
+    testShedOnTake();
+    testUnlimited();
+
+    if (failures > 0) {
+        qDebug() << "音频积压测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "音频积压测试通过";
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <ogg/ogg.h>
+#include <opus/opus.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "audio_file.h"
+
+// 离线工具的录音读取测试：在内存中把 1 秒 440Hz 正弦波编码成 Ogg Opus
+// （48kHz 单声道和立体声两种），再用 AudioFile::decodeOggOpus 解码，检查
+// 1. 去掉 pre-skip 和结尾填充后长度正好是 1 秒
+// 2. 解码结果与原始信号一致（相关系数接近 1）
+// 3. 非 Ogg Opus 数据返回错误
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+static void writeLe16(unsigned char* p, int value)
+{
+    p[0] = value & 0xff;
+    p[1] = (value >> 8) & 0xff;
+}
+
+static void writeLe32(unsigned char* p, quint32 value)
+{
+    for (int i = 0; i < 4; ++i) {
+        p[i] = (value >> (8 * i)) & 0xff;
+    }
+}
+
+static void appendPages(ogg_stream_state* stream, QByteArray* out, bool flush)
+{
+    ogg_page page;
+    while (flush ? ogg_stream_flush(stream, &page) : ogg_stream_pageout(stream, &page)) {
+        out->append(reinterpret_cast<const char*>(page.header), page.header_len);
+        out->append(reinterpret_cast<const char*>(page.body), page.body_len);
+    }
+}
+
+// 48kHz、20ms 帧编码，结尾补零，最后一页的 granulepos 标出实际长度
+static QByteArray encodeOggOpus(const std::vector<opus_int16>& samples, int channels)
+{
+    const int rate = 48000;
+    const int frame = rate / 50;
+    int error = OPUS_OK;
+    OpusEncoder* encoder = opus_encoder_create(rate, channels, OPUS_APPLICATION_AUDIO, &error);
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(encoder, OPUS_GET_LOOKAHEAD(&lookahead));
+
+    ogg_stream_state stream;
+    ogg_stream_init(&stream, 1234);
+    QByteArray out;
+
+    unsigned char head[19] = {'O', 'p', 'u', 's', 'H', 'e', 'a', 'd', 1};
+    head[9] = static_cast<unsigned char>(channels);
+    writeLe16(head + 10, lookahead);
+    writeLe32(head + 12, rate);
+    ogg_packet packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.packet = head;
+    packet.bytes = sizeof(head);
+    packet.b_o_s = 1;
+    ogg_stream_packetin(&stream, &packet);
+    appendPages(&stream, &out, true);
+
+    unsigned char tags[16] = {'O', 'p', 'u', 's', 'T', 'a', 'g', 's'};
+    memset(&packet, 0, sizeof(packet));
+    packet.packet = tags;
+    packet.bytes = sizeof(tags);
+    packet.packetno = 1;
+    ogg_stream_packetin(&stream, &packet);
+    appendPages(&stream, &out, true);
+
+    const int total = static_cast<int>(samples.size()) / channels;
+    std::vector<opus_int16> pcm(frame * channels);
+    unsigned char data[4000];
+    // 结尾多编码 lookahead 长度的静音，把编码器延迟中的样本也送出来
+    for (int pos = 0, index = 2; pos < total + lookahead; pos += frame, ++index) {
+        std::fill(pcm.begin(), pcm.end(), 0);
+        const int count = std::max(0, std::min(frame, total - pos));
+        std::copy(samples.begin() + pos * channels, samples.begin() + (pos + count) * channels, pcm.begin());
+        const int bytes = opus_encode(encoder, pcm.data(), frame, data, sizeof(data));
+        const bool last = pos + frame >= total + lookahead;
+        memset(&packet, 0, sizeof(packet));
+        packet.packet = data;
+        packet.bytes = bytes;
+        packet.packetno = index;
+        packet.granulepos = last ? total + lookahead : pos + frame + lookahead;
+        packet.e_o_s = last;
+        ogg_stream_packetin(&stream, &packet);
+        appendPages(&stream, &out, last);
+    }
+    ogg_stream_clear(&stream);
+    opus_encoder_destroy(encoder);
+    return out;
+}
+
+static double correlation(const int16_t* a, const int16_t* b, int count)
+{
+    double ab = 0.0, aa = 0.0, bb = 0.0;
+    for (int i = 0; i < count; ++i) {
+        ab += static_cast<double>(a[i]) * b[i];
+        aa += static_cast<double>(a[i]) * a[i];
+        bb += static_cast<double>(b[i]) * b[i];
+    }
+    return aa > 0 && bb > 0 ? ab / std::sqrt(aa * bb) : 0.0;
+}
+
+static void testRoundTrip(int channels)
+{
+    // 48kHz 原始信号，另外生成同一正弦波的 16kHz 版本用于比较
+    std::vector<opus_int16> input(48000 * channels);
+    std::vector<int16_t> expected(AudioFile::SAMPLE_RATE);
+    for (int i = 0; i < 48000; ++i) {
+        const double value = 8000.0 * std::sin(2 * M_PI * 440.0 * i / 48000);
+        for (int c = 0; c < channels; ++c) {
+            input[i * channels + c] = static_cast<opus_int16>(value);
+        }
+    }
+    for (int i = 0; i < AudioFile::SAMPLE_RATE; ++i) {
+        expected[i] = static_cast<int16_t>(8000.0 * std::sin(2 * M_PI * 440.0 * i / AudioFile::SAMPLE_RATE));
+    }
+
+    QByteArray pcm;
+    QString error;
+    const bool ok = AudioFile::decodeOggOpus(encodeOggOpus(input, channels), &pcm, &error);
+    check(ok, "解码 Ogg Opus");
+    if (!ok) {
+        qDebug() << error;
+        return;
+    }
+    const int samples = pcm.size() / 2;
+    qDebug() << channels << "声道: 解码" << samples << "个样本";
+    check(samples == AudioFile::SAMPLE_RATE, "长度正好 1 秒");
+
+    // 跳过开头 20ms 的编码器过渡，比较中间部分；允许重采样带来的 1 个样本以内的偏移
+    const int16_t* decoded = reinterpret_cast<const int16_t*>(pcm.constData());
+    const int start = 320, count = qMin(samples, AudioFile::SAMPLE_RATE) - 2 * start;
+    double best = 0.0;
+    for (int shift = -1; shift <= 1 && count > 0; ++shift) {
+        best = std::max(best, correlation(decoded + start + shift, expected.data() + start, count));
+    }
+    qDebug() << "与原始信号的相关系数:" << best;
+    check(best > 0.95, "解码结果与原始信号一致");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    testRoundTrip(1);
+    testRoundTrip(2);
+
+    QByteArray pcm;
+    QString error;
+    check(!AudioFile::decodeOggOpus(QByteArray("not an ogg file"), &pcm, &error), "非 Ogg 数据返回错误");
+
+    if (failures > 0) {
+        qDebug() << "录音读取测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "录音读取测试通过";
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QMediaDevices>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QThread>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include "audio_engine.h"
+#include "opus_encoder.h"
+
+// 音频线程压力测试：
+//   主线程模拟 GUI 线程，按实时节奏（约 300ms 提前量）向音频线程送下行 Opus 包，
+//   同时每秒人为阻塞 200ms。播放和采集都在音频线程中进行，期间不应出现播空。
+//   之后在播放中多次打断（全双工 barge-in），统计打断到播放静音、打断到首帧上行的延迟。
+//   test_audio_thread [时长毫秒] [打断次数]
+//   可用环境变量 XIAOZHI_AUDIO_RT / XIAOZHI_AUDIO_NICE / XIAOZHI_AUDIO_CPU 设置线程优先级和绑核
+
+const int SAMPLE_RATE = 16000;
+const int CHANNELS = 1;
+const int FRAME_DURATION = 60;
+const int LEAD_MS = 300;
+const int BLOCK_INTERVAL_MS = 1000;
+const int BLOCK_MS = 200;
+const int BARGE_IN_PLAY_MS = 400;  // 打断前先播放的时长
+
+static void waitMs(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+static QString summary(QVector<qint64> values)
+{
+    if (values.isEmpty()) {
+        return "无";
+    }
+    std::sort(values.begin(), values.end());
+    qint64 sum = 0;
+    for (qint64 value : values) {
+        sum += value;
+    }
+    return QString("平均 %1ms，中位数 %2ms，最大 %3ms（%4 次）")
+        .arg(sum / values.size()).arg(values[values.size() / 2]).arg(values.last()).arg(values.size());
+}
+
+// 播放中发出打断，音频线程回报打断到淡出后播放静音、到补发首帧上行的延迟
+static void measureBargeIn(AudioEngine& engine, const QVector<QByteArray>& packets, int rounds)
+{
+    QVector<qint64> silenceMs;
+    QVector<qint64> uploadMs;
+    QObject context;
+    QObject::connect(&engine, &AudioEngine::eventReady, &context, [&]() {
+        engine.drainEvents([&](const AudioEngine::Event& event) {
+            if (event.type == AudioEngine::EventType::BargeInSilence) {
+                silenceMs.append(event.value);
+            } else if (event.type == AudioEngine::EventType::BargeInUpload) {
+                uploadMs.append(event.value);
+            }
+        });
+    });
+
+    const int frames = qMin<int>(packets.size(), 2 * BARGE_IN_PLAY_MS / FRAME_DURATION);
+    for (int round = 0; round < rounds; ++round) {
+        // 播放期间不上传（全双工下 TTS 开始时停止上传）
+        engine.setUploading(false);
+        for (int i = 0; i < frames; ++i) {
+            engine.pushDownlink(packets[i]);
+        }
+        waitMs(BARGE_IN_PLAY_MS);
+        engine.bargeIn(30);
+        waitMs(300);
+    }
+
+    qDebug().noquote() << "打断延迟:"
+                       << "\n  打断到播放静音:" << summary(silenceMs)
+                       << "\n  打断到首帧上行:" << summary(uploadMs);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    if (QMediaDevices::defaultAudioOutput().isNull()) {
+        qDebug() << "没有音频输出设备，跳过测试";
+        return 0;
+    }
+
+    const int durationMs = argc > 1 ? QString(argv[1]).toInt() : 10000;
+    const int bargeInRounds = argc > 2 ? QString(argv[2]).toInt() : 20;
+
+    // 预先编码 440Hz 正弦波
+    OpusEncoder encoder;
+    if (!encoder.initialize(SAMPLE_RATE, CHANNELS, FRAME_DURATION)) {
+        qDebug() << "Opus编码器初始化失败";
+        return 1;
+    }
+    const int frameSize = SAMPLE_RATE * FRAME_DURATION / 1000;
+    QVector<QByteArray> packets;
+    for (int frame = 0; frame < durationMs / FRAME_DURATION; ++frame) {
+        QByteArray pcm(frameSize * sizeof(qint16), 0);
+        qint16* samples = reinterpret_cast<qint16*>(pcm.data());
+        for (int i = 0; i < frameSize; ++i) {
+            double t = static_cast<double>(frame * frameSize + i) / SAMPLE_RATE;
+            samples[i] = static_cast<qint16>(8000.0 * std::sin(2.0 * M_PI * 440.0 * t));
+        }
+        packets.append(encoder.encode(pcm));
+    }
+
+    AudioEngine engine;
+    if (!engine.start(AudioEngine::Options::fromEnvironment(), SAMPLE_RATE, CHANNELS, FRAME_DURATION)) {
+        qDebug() << "音频线程启动失败";
+        return 1;
+    }
+
+    // 同时打开采集并上传，验证采集也不受 GUI 阻塞影响
+    int uplinkPackets = 0;
+    QObject::connect(&engine, &AudioEngine::uplinkReady, &app, [&]() {
+        uplinkPackets += engine.drainUplink([](const QByteArray&) {});
+    });
+    engine.setFullDuplex(true);
+    engine.setUploading(true);
+    engine.startCapture();
+
+    QElapsedTimer clock;
+    clock.start();
+    int nextPacket = 0;
+    int underrunsAtEnd = -1;
+    int blockCount = 0;
+    qint64 maxBlockMs = 0;
+
+    // 生产者：保持约 LEAD_MS 的提前量
+    QTimer feeder;
+    feeder.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&feeder, &QTimer::timeout, &app, [&]() {
+        while (nextPacket < packets.size() &&
+               static_cast<qint64>(nextPacket) * FRAME_DURATION < clock.elapsed() + LEAD_MS) {
+            engine.pushDownlink(packets[nextPacket++]);
+        }
+        if (nextPacket == packets.size() && underrunsAtEnd < 0) {
+            // 此时还有约 LEAD_MS 的数据未播放，正常结束的那次播空不计入
+            underrunsAtEnd = engine.underrunCount();
+            feeder.stop();
+            QTimer::singleShot(LEAD_MS + 500, &app, &QCoreApplication::quit);
+        }
+    });
+    feeder.start(20);
+
+    // 周期性阻塞“GUI 线程”
+    QTimer blocker;
+    QObject::connect(&blocker, &QTimer::timeout, &app, [&]() {
+        QElapsedTimer blockTimer;
+        blockTimer.start();
+        QThread::msleep(BLOCK_MS);
+        maxBlockMs = qMax(maxBlockMs, blockTimer.elapsed());
+        ++blockCount;
+    });
+    blocker.start(BLOCK_INTERVAL_MS);
+
+    app.exec();
+
+    const int droppedPackets = engine.droppedPackets();
+    measureBargeIn(engine, packets, bargeInRounds);
+    engine.stop();
+
+    qDebug() << "测试结果:"
+             << "\n  播放时长:" << packets.size() * FRAME_DURATION << "ms"
+             << "\n  GUI 阻塞次数:" << blockCount << "最长:" << maxBlockMs << "ms"
+             << "\n  播空次数:" << underrunsAtEnd
+             << "\n  上行包数:" << uplinkPackets << "/ 期望约" << clock.elapsed() / FRAME_DURATION
+             << "\n  队列丢弃:" << droppedPackets;
+
+    if (underrunsAtEnd != 0 || droppedPackets != 0) {
+        qDebug() << "失败: GUI 线程阻塞期间音频线程出现播空或丢包";
+        return 1;
+    }
+    qDebug() << "通过";
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "buffer_pool.h"
+#include "spsc_queue.h"
+
+// 缓冲区池测试：
+// 1. 同一线程中取出、归还后再取出复用已分配的内存
+// 2. 与音频包队列相同的用法：一个线程取出缓冲区、写入后经 SPSC 队列交给另一个线程，
+//    另一个线程校验内容后归还。稳态下分配次数不超过同时在途的缓冲区数量，
+//    并给出每个包的平均耗时
+//   test_buffer_pool [包数]
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+static void testReuse()
+{
+    BufferPool pool(4096, 4);
+    QByteArray first = pool.acquire(100);
+    check(first.size() == 100 && pool.allocationCount() == 1, "首次分配");
+    pool.release(std::move(first));
+    for (int i = 0; i < 10; ++i) {
+        QByteArray buffer = pool.acquire(1000 + i);
+        check(buffer.size() == 1000 + i, "大小");
+        pool.release(std::move(buffer));
+    }
+    check(pool.allocationCount() == 1, "复用同一块内存");
+
+    // 池满时多出的缓冲区直接释放
+    QByteArray buffers[6];
+    for (QByteArray& buffer : buffers) {
+        buffer = pool.acquire(100);
+    }
+    for (QByteArray& buffer : buffers) {
+        pool.release(std::move(buffer));
+    }
+    const int allocated = pool.allocationCount();
+    for (int i = 0; i < 4; ++i) {
+        buffers[i] = pool.acquire(100);
+    }
+    check(pool.allocationCount() == allocated, "池中保留 maxBuffers 个");
+    buffers[4] = pool.acquire(100);
+    check(pool.allocationCount() == allocated + 1, "超出 maxBuffers 的没有保留");
+}
+
+static void testAcrossThreads(int packets)
+{
+    // 池容量不小于队列容量时，归还时池不会满，缓冲区只在循环中复用
+    constexpr int QUEUE_SIZE = 128;
+    BufferPool pool(4096, BufferPool::MAX_BUFFERS);
+    SpscQueue<QByteArray, QUEUE_SIZE> queue;
+    std::atomic<bool> corrupted(false);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 归还方（对应音频线程）
+    std::thread consumer([&]() {
+        QByteArray buffer;
+        int received = 0;
+        while (received < packets) {
+            if (!queue.pop(buffer)) {
+                std::this_thread::yield();
+                continue;
+            }
+            const char expected = static_cast<char>(received);
+            if (buffer.size() != 20 + received % 1400 || buffer.constData()[0] != expected
+                || buffer.constData()[buffer.size() - 1] != expected) {
+                corrupted = true;
+            }
+            pool.release(std::move(buffer));
+            ++received;
+        }
+    });
+
+    // 取用方（对应网络线程）
+    for (int i = 0; i < packets; ++i) {
+        QByteArray buffer = pool.acquire(20 + i % 1400);
+        memset(buffer.data(), static_cast<char>(i), buffer.size());
+        // push() 按值接收，满时缓冲区也已被移走，先等到有空位
+        while (queue.size() == QUEUE_SIZE) {
+            std::this_thread::yield();
+        }
+        queue.push(std::move(buffer));
+    }
+    consumer.join();
+    const qint64 elapsedNs = timer.nsecsElapsed();
+
+    check(!corrupted, "跨线程传递的内容完整");
+    // 池空时所有缓冲区都在队列中或两端手上
+    check(pool.allocationCount() <= QUEUE_SIZE + 2, "稳态下不再分配");
+    qDebug() << "跨线程" << packets << "个包，分配" << pool.allocationCount() << "次，平均"
+             << elapsedNs / packets << "ns/包";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int packets = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    testReuse();
+    testAcrossThreads(packets);
+
+    if (failures > 0) {
+        qDebug() << "缓冲区池测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "缓冲区池测试通过";
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "capture_converter.h"
+
+// 采集格式转换测试：
+// 1. 设备格式与流水线格式相同时原样返回
+// 2. 48kHz 双声道 float、44.1kHz 双声道 s32、8kHz u8 转换为 16kHz 单声道 s16，
+//    输出长度与采样率之比一致，正弦波与直接按 16kHz 生成的相差很小
+// 3. 按任意大小分块（包括从采样点中间切开）与整块转换的结果逐位相同
+// 4. 不支持的格式被拒绝
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+using SampleFormat = CaptureConverter::SampleFormat;
+
+// 两个声道相位相同的 440Hz 正弦波，幅度 0.5
+static QByteArray sine(const CaptureConverter::Format& format, int ms)
+{
+    const int frames = format.sampleRate * ms / 1000;
+    const int bytes = CaptureConverter::bytesPerSample(format.sampleFormat);
+    QByteArray data(frames * format.channels * bytes, 0);
+    char* p = data.data();
+    for (int i = 0; i < frames; ++i) {
+        const double value = 0.5 * std::sin(2.0 * M_PI * 440.0 * i / format.sampleRate);
+        for (int c = 0; c < format.channels; ++c) {
+            if (format.sampleFormat == SampleFormat::Float) {
+                const float sample = static_cast<float>(value);
+                std::memcpy(p, &sample, sizeof(sample));
+            } else if (format.sampleFormat == SampleFormat::Int32) {
+                const int32_t sample = static_cast<int32_t>(value * 2147483647.0);
+                std::memcpy(p, &sample, sizeof(sample));
+            } else if (format.sampleFormat == SampleFormat::Int16) {
+                const int16_t sample = static_cast<int16_t>(std::lround(value * 32767.0));
+                std::memcpy(p, &sample, sizeof(sample));
+            } else {
+                *p = static_cast<char>(static_cast<uint8_t>(std::lround(128 + value * 127)));
+            }
+            p += bytes;
+        }
+    }
+    return data;
+}
+
+static std::vector<int16_t> samples(const QByteArray& data)
+{
+    std::vector<int16_t> result(data.size() / sizeof(int16_t));
+    std::memcpy(result.data(), data.constData(), result.size() * sizeof(int16_t));
+    return result;
+}
+
+static void testPassthrough()
+{
+    CaptureConverter converter;
+    check(converter.configure({16000, 1, SampleFormat::Int16}, 16000, 1), "配置流水线格式");
+    check(converter.isPassthrough(), "相同格式不转换");
+    const QByteArray data = sine({16000, 1, SampleFormat::Int16}, 60);
+    check(converter.convert(data) == data, "原样返回");
+}
+
+static void testConvert(const CaptureConverter::Format& device, const char* name)
+{
+    CaptureConverter converter;
+    check(converter.configure(device, 16000, 1), name);
+    check(!converter.isPassthrough(), name);
+
+    const int ms = 1000;
+    const std::vector<int16_t> output = samples(converter.convert(sine(device, ms)));
+    const std::vector<int16_t> expected = samples(sine({16000, 1, SampleFormat::Int16}, ms));
+
+    // 长度：最后一个输入样点之后的输出留到下一块
+    const int difference = static_cast<int>(expected.size()) - static_cast<int>(output.size());
+    check(difference >= 0 && difference <= 16000 / device.sampleRate + 1, name);
+
+    // 线性插值在 440Hz 下的误差远小于幅度
+    int maxError = 0;
+    for (size_t i = 0; i < output.size(); ++i) {
+        maxError = qMax(maxError, std::abs(output[i] - expected[i]));
+    }
+    const int limit = device.sampleFormat == SampleFormat::UInt8 ? 700 : 250;
+    qDebug() << name << "输出" << output.size() << "个样点，最大误差" << maxError;
+    check(maxError < limit, name);
+}
+
+static void testChunking()
+{
+    const CaptureConverter::Format device{44100, 2, SampleFormat::Int32};
+    const QByteArray input = sine(device, 500);
+
+    CaptureConverter whole;
+    whole.configure(device, 16000, 1);
+    const QByteArray expected = whole.convert(input);
+
+    CaptureConverter chunked;
+    chunked.configure(device, 16000, 1);
+    QByteArray output;
+    int offset = 0;
+    int size = 1;
+    while (offset < input.size()) {
+        // 1、8、57、...字节，大多不是采样点的整数倍
+        const int n = qMin(size, static_cast<int>(input.size()) - offset);
+        output.append(chunked.convert(input.mid(offset, n)));
+        offset += n;
+        size = size * 7 + 1;
+        if (size > 5000) {
+            size = 3;
+        }
+    }
+    check(output == expected, "分块转换与整块相同");
+}
+
+static void testUnsupported()
+{
+    CaptureConverter converter;
+    check(!converter.configure({16000, 1, SampleFormat::Unknown}, 16000, 1), "拒绝未知采样格式");
+    check(!converter.configure({0, 1, SampleFormat::Int16}, 16000, 1), "拒绝无效采样率");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    testPassthrough();
+    testConvert({48000, 2, SampleFormat::Float}, "48kHz 双声道 float");
+    testConvert({44100, 2, SampleFormat::Int32}, "44.1kHz 双声道 s32");
+    testConvert({8000, 1, SampleFormat::UInt8}, "8kHz 单声道 u8");
+    testChunking();
+    testUnsupported();
+
+    if (failures > 0) {
+        qDebug() << "采集格式转换测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "采集格式转换测试通过";
+    return 0;
+}
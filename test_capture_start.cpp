@@ -0,0 +1,159 @@
+#include <QCoreApplication>
+#include <QAudioFormat>
+#include <QAudioSource>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QMediaDevices>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <cstdlib>
+#include "microphone_manager.h"
+
+// 录音启动延迟测试（需要输入设备）：反复开始/停止录音，统计 startRecording
+// 到第一帧（60ms）送出的延迟：
+// 1. 每次开始录音都新建 QAudioSource（4096 字节缓冲区），停止时释放——原来的做法
+// 2. MicrophoneManager：设备只打开一次，开始/停止只是 resume/suspend
+// 两种方式每轮都要收到第一帧，之后给出各自的平均、中位数和最大值。
+// 没有输入设备时跳过
+//   test_capture_start [轮数]
+
+const int SAMPLE_RATE = 16000;
+const int FRAME_MS = 60;
+const int FRAME_BYTES = SAMPLE_RATE * FRAME_MS / 1000 * 2;
+const int IDLE_MS = 300;         // 两轮之间停顿，让设备回到挂起/空闲状态
+const int TIMEOUT_MS = 3000;
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+template <typename Predicate>
+static bool waitFor(Predicate done, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!done()) {
+        if (timer.elapsed() > timeoutMs) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+        QThread::msleep(1);
+    }
+    return true;
+}
+
+static void waitMs(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+static QString summary(QVector<qint64> values)
+{
+    if (values.isEmpty()) {
+        return "无";
+    }
+    std::sort(values.begin(), values.end());
+    qint64 sum = 0;
+    for (qint64 value : values) {
+        sum += value;
+    }
+    return QString("平均 %1ms，中位数 %2ms，最大 %3ms（%4 次）")
+        .arg(sum / values.size()).arg(values[values.size() / 2]).arg(values.last()).arg(values.size());
+}
+
+// 原来的做法：每次开始录音新建音频源并打开设备
+static QVector<qint64> measureReopen(const QAudioDevice& device, int rounds)
+{
+    QAudioFormat format;
+    format.setSampleRate(SAMPLE_RATE);
+    format.setChannelCount(1);
+    format.setSampleFormat(QAudioFormat::Int16);
+    QVector<qint64> latencies;
+    if (!device.isFormatSupported(format)) {
+        qDebug() << "设备不支持 16kHz 单声道 s16，跳过每次新建音频源的对比";
+        return latencies;
+    }
+
+    for (int i = 0; i < rounds; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        QAudioSource* source = new QAudioSource(device, format);
+        source->setBufferSize(4096);
+        QIODevice* io = source->start();
+        qint64 received = 0;
+        const bool gotFrame = io && waitFor([&]() {
+            received += io->readAll().size();
+            return received >= FRAME_BYTES;
+        }, TIMEOUT_MS);
+        check(gotFrame, "新建音频源后收到第一帧");
+        if (gotFrame) {
+            latencies.append(timer.elapsed());
+        }
+        source->stop();
+        delete source;
+        waitMs(IDLE_MS);
+    }
+    return latencies;
+}
+
+// 设备保持打开，开始/停止只是 resume/suspend
+static QVector<qint64> measureResume(int rounds)
+{
+    MicrophoneManager microphone;
+    int frames = 0;
+    QObject::connect(&microphone, &MicrophoneManager::pcmDataReady, [&frames](const QByteArray&) {
+        ++frames;
+    });
+    waitMs(IDLE_MS);
+
+    QVector<qint64> latencies;
+    for (int i = 0; i < rounds; ++i) {
+        frames = 0;
+        check(microphone.startRecording(), "开始录音");
+        const bool gotFrame = waitFor([&]() { return frames > 0; }, TIMEOUT_MS);
+        check(gotFrame, "恢复录音后收到第一帧");
+        if (gotFrame) {
+            check(microphone.lastStartLatencyMs() >= 0, "记录了启动延迟");
+            latencies.append(microphone.lastStartLatencyMs());
+        }
+        microphone.stopRecording();
+        waitMs(IDLE_MS);
+    }
+    return latencies;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int rounds = argc > 1 ? qMax(1, atoi(argv[1])) : 20;
+
+    const QAudioDevice device = QMediaDevices::defaultAudioInput();
+    if (device.isNull()) {
+        qDebug() << "没有输入设备，跳过录音启动延迟测试";
+        return 0;
+    }
+    qDebug() << "输入设备:" << device.description();
+
+    const QVector<qint64> reopen = measureReopen(device, rounds);
+    const QVector<qint64> resume = measureResume(rounds);
+    qDebug() << "每次新建音频源，启动到第一帧:" << summary(reopen);
+    qDebug() << "保持打开、resume/suspend，启动到第一帧:" << summary(resume);
+
+    if (failures > 0) {
+        qDebug() << "录音启动延迟测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "录音启动延迟测试通过";
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+#include "device_identity.h"
+
+// 设备标识测试：在临时目录中构造 /proc/net/route、/proc/net/ipv6_route 和
+// /sys/class/net/<网卡>/address，检查默认路由网卡的选择、缓存的读写，并比较
+// 首次解析与读缓存的耗时
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+static void writeFile(const QString& path, const QByteArray& content)
+{
+    QDir().mkpath(path.left(path.lastIndexOf('/')));
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write(content);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTemporaryDir dir;
+    const QString proc = dir.path() + "/proc";
+    const QString sys = dir.path() + "/sys";
+
+    // docker0 不是默认路由；两条默认路由中 wlan0 跃点数更小；eth1 的默认路由未启用
+    writeFile(proc + "/net/route",
+              "Iface\tDestination\tGateway \tFlags\tRefCnt\tUse\tMetric\tMask\t\tMTU\tWindow\tIRTT\n"
+              "eth0\t00000000\t0101A8C0\t0003\t0\t0\t600\t00000000\t0\t0\t0\n"
+              "wlan0\t00000000\t0100000A\t0003\t0\t0\t100\t00000000\t0\t0\t0\n"
+              "eth1\t00000000\t0102A8C0\t0002\t0\t0\t10\t00000000\t0\t0\t0\n"
+              "docker0\t000011AC\t00000000\t0001\t0\t0\t0\t0000FFFF\t0\t0\t0\n");
+    writeFile(sys + "/class/net/eth0/address", "AA:BB:CC:00:00:01\n");
+    writeFile(sys + "/class/net/wlan0/address", "AA:BB:CC:00:00:02\n");
+    check(DeviceIdentity::defaultRouteInterface(proc) == "wlan0", "选择跃点数最小的默认路由");
+    check(DeviceIdentity::interfaceAddress("wlan0", sys) == "aa:bb:cc:00:00:02", "MAC 地址转为小写");
+    check(DeviceIdentity::interfaceAddress("../../etc", sys).isEmpty(), "拒绝带路径的网卡名");
+
+    // 只有 IPv6 默认路由（lo 上的 unreachable 默认路由忽略）
+    const QString proc6 = dir.path() + "/proc6";
+    writeFile(proc6 + "/net/route", "Iface\tDestination\tGateway \tFlags\tRefCnt\tUse\tMetric\tMask\t\tMTU\tWindow\tIRTT\n");
+    writeFile(proc6 + "/net/ipv6_route",
+              "00000000000000000000000000000000 00 00000000000000000000000000000000 00 "
+              "00000000000000000000000000000000 ffffffff 00000001 00000000 00200200       lo\n"
+              "00000000000000000000000000000000 00 00000000000000000000000000000000 00 "
+              "fe800000000000000000000000000001 00000400 00000001 00000000 00450003     eth0\n");
+    check(DeviceIdentity::defaultRouteInterface(proc6) == "eth0", "IPv6 默认路由");
+
+    // Client-Id 与原来按 MAC 生成的一致
+    const QString clientId = DeviceIdentity::clientIdFor("aa:bb:cc:00:00:02");
+    check(clientId.size() == 36 && clientId[8] == '-' && clientId[23] == '-', "Client-Id 格式");
+
+    // 首次解析写入缓存，之后从缓存读取
+    const QString cache = dir.path() + "/config/device_identity.json";
+    QElapsedTimer timer;
+    timer.start();
+    const DeviceIdentity cold = DeviceIdentity::load(cache, proc, sys);
+    const qint64 coldNs = timer.nsecsElapsed();
+    check(cold.source == "route" && cold.deviceId == "aa:bb:cc:00:00:02" && cold.clientId == clientId, "首次解析");
+    check(QFile::exists(cache), "写入缓存");
+
+    timer.restart();
+    const DeviceIdentity warm = DeviceIdentity::load(cache, proc, sys);
+    const qint64 warmNs = timer.nsecsElapsed();
+    check(warm.source == "cache" && warm.deviceId == cold.deviceId && warm.clientId == cold.clientId, "读取缓存");
+
+    // 损坏的缓存重新解析
+    writeFile(cache, "{broken");
+    check(DeviceIdentity::load(cache, proc, sys).source == "route", "缓存损坏时重新解析");
+
+    qDebug().noquote() << QString("首次解析 %1 us，读缓存 %2 us").arg(coldNs / 1000).arg(warmNs / 1000);
+
+    if (failures > 0) {
+        qDebug() << "设备标识测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "设备标识测试通过";
+    return 0;
+}
@@ -0,0 +1,267 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <fvad.h>
+
+extern "C" {
+#include "signal_processing_library.h"
+}
+
+// 多路批量 VAD 测试：
+// 1. 每一路的判决必须和单独的 Fvad 实例逐帧完全一致
+//    （8/16/32/48kHz，10/20/30ms，模式 0-3，路数不是 16 的整数倍，中途重置某一路）
+// 2. 基准：16kHz 10ms 帧，单核能实时处理的路数，N 次 fvad_process 对比 fvad_batch_process
+
+const int BASE_RATE = 16000;
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+struct Level {
+    int features;
+    const char* name;
+};
+
+static std::vector<Level> availableLevels()
+{
+    const Level all[] = {
+        {kSplCpuSse41, "SSE4.1"},
+        {kSplCpuSse41 | kSplCpuAvx2, "AVX2"},
+        {kSplCpuNeon, "NEON"},
+    };
+    const int supported = WebRtcSpl_CpuFeatures();
+    std::vector<Level> levels = {{0, "C"}};
+    for (const Level& level : all) {
+        if ((level.features & supported) == level.features) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+// 类语音信号：基频脉冲串经过随机共振峰，按音节起落，音节之间静音；
+// gain 为 0 的段落只有很弱的底噪，用来覆盖能量过低不更新模型的帧
+static std::vector<int16_t> synthesizeSpeech(int seconds, double gain, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<int16_t> out(BASE_RATE * seconds);
+
+    double phase = 0.0, f1 = 700, f2 = 1200;
+    double y[2][2] = {{0, 0}, {0, 0}};
+    int left = 0, length = 1;
+    bool voiced = false;
+    double level = gain;
+    for (size_t i = 0; i < out.size(); ++i) {
+        if (left-- <= 0) {
+            length = BASE_RATE * (80 + static_cast<int>(uniform(rng) * 250)) / 1000;
+            left = length;
+            voiced = uniform(rng) < 0.6;
+            f1 = 300 + uniform(rng) * 600;
+            f2 = 900 + uniform(rng) * 1500;
+            level = uniform(rng) < 0.1 ? 0.0 : gain * (0.3 + uniform(rng) * 2);
+        }
+        phase += (110 + 40 * uniform(rng)) / BASE_RATE;
+        double sample = voiced ? noise(rng) * 0.3 : noise(rng) * 2;
+        if (phase >= 1.0) {
+            phase -= 1.0;
+            sample += voiced ? 40.0 : 0.0;
+        }
+        const double freqs[2] = {f1, f2};
+        for (int k = 0; k < 2; ++k) {
+            const double c = 2 * 0.97 * std::cos(2 * M_PI * freqs[k] / BASE_RATE);
+            const double v = sample + c * y[k][0] - 0.97 * 0.97 * y[k][1];
+            y[k][1] = y[k][0];
+            y[k][0] = v;
+            sample = v * 0.05;
+        }
+        const double envelope = voiced ? std::sin(M_PI * (length - left) / length) : 0.3;
+        const double value = level * sample * envelope * 3000 + noise(rng) * (level > 0 ? 10 : 0.4);
+        out[i] = static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, value)));
+    }
+    return out;
+}
+
+// 由 16kHz 信号得到其它采样率（抽取或重复样本），对 VAD 来说足够
+static int16_t sampleAt(const std::vector<int16_t>& base, size_t index, int rate)
+{
+    const size_t i = rate >= BASE_RATE ? index * BASE_RATE / rate : index * (BASE_RATE / rate);
+    return base[i % base.size()];
+}
+
+// 把 streams 路信号按 rate/frameMs 分帧，分别交给独立实例和批量接口，比较每一帧
+static void testRate(const std::vector<std::vector<int16_t>>& sources, int rate, int frameMs, int mode)
+{
+    const size_t streams = sources.size();
+    const size_t length = static_cast<size_t>(rate / 1000 * frameMs);
+    const size_t frames = 6000 / frameMs;  // 6 秒
+    const size_t resetFrame = frames / 2;
+
+    std::vector<Fvad*> singles(streams);
+    for (Fvad*& vad : singles) {
+        vad = fvad_new();
+        fvad_set_sample_rate(vad, rate);
+        fvad_set_mode(vad, mode);
+    }
+    FvadBatch* batch = fvad_batch_new(streams);
+    check(batch != nullptr, "创建批量实例");
+    check(fvad_batch_set_sample_rate(batch, rate) == 0, "设置采样率");
+    check(fvad_batch_set_mode(batch, mode) == 0, "设置模式");
+
+    std::vector<std::vector<int16_t>> buffers(streams, std::vector<int16_t>(length));
+    std::vector<const int16_t*> pointers(streams);
+    std::vector<int> decisions(streams);
+    size_t mismatches = 0, speech = 0;
+    for (size_t f = 0; f < frames; ++f) {
+        if (f == resetFrame) {
+            // 中途重置第 3 路，之后两边仍应一致
+            fvad_reset(singles[3]);
+            fvad_set_sample_rate(singles[3], rate);
+            fvad_set_mode(singles[3], mode);
+            check(fvad_batch_reset_stream(batch, 3) == 0, "重置单路");
+        }
+        for (size_t s = 0; s < streams; ++s) {
+            for (size_t i = 0; i < length; ++i) {
+                buffers[s][i] = sampleAt(sources[s], (f * length + i) + s * 977 * rate / 1000, rate);
+            }
+            pointers[s] = buffers[s].data();
+        }
+        check(fvad_batch_process(batch, pointers.data(), length, decisions.data()) == 0, "批量处理");
+        for (size_t s = 0; s < streams; ++s) {
+            const int expected = fvad_process(singles[s], pointers[s], length);
+            speech += expected;
+            if (decisions[s] != expected && mismatches++ == 0) {
+                qDebug() << "不一致:" << rate << "Hz" << frameMs << "ms 模式" << mode << "第" << s << "路第" << f << "帧";
+            }
+        }
+    }
+    check(mismatches == 0, "批量判决与独立实例一致");
+    check(speech > 0 && speech < streams * frames, "信号同时包含语音帧和非语音帧");
+
+    for (Fvad* vad : singles) {
+        fvad_free(vad);
+    }
+    fvad_batch_free(batch);
+}
+
+static void testApi()
+{
+    check(fvad_batch_new(0) == nullptr, "0 路返回 NULL");
+    FvadBatch* batch = fvad_batch_new(5);
+    check(fvad_batch_num_streams(batch) == 5, "路数");
+    check(fvad_batch_set_mode(batch, 4) == -1, "非法模式");
+    check(fvad_batch_set_sample_rate(batch, 44100) == -1, "非法采样率");
+    check(fvad_batch_reset_stream(batch, 5) == -1, "越界重置");
+    std::vector<int16_t> frame(160);
+    const int16_t* frames[5] = {frame.data(), frame.data(), frame.data(), frame.data(), frame.data()};
+    int decisions[5];
+    check(fvad_batch_process(batch, frames, 100, decisions) == -1, "非法帧长");
+    check(fvad_batch_process(batch, frames, 80, decisions) == 0, "8kHz 10ms");
+    fvad_batch_free(batch);
+}
+
+// 16kHz 10ms 帧：单核每秒处理的帧数除以 100 就是能实时处理的路数
+static void benchmark(const std::vector<Level>& levels, const std::vector<std::vector<int16_t>>& sources)
+{
+    const size_t streams = sources.size();
+    const size_t frame = BASE_RATE / 100;
+    const size_t frames = 1000;  // 每路 10 秒
+    for (const Level& level : levels) {
+        WebRtcSpl_InitWithFeatures(level.features);
+        std::vector<Fvad*> singles(streams);
+        for (Fvad*& vad : singles) {
+            vad = fvad_new();
+            fvad_set_sample_rate(vad, BASE_RATE);
+        }
+        FvadBatch* batch = fvad_batch_new(streams);
+        fvad_batch_set_sample_rate(batch, BASE_RATE);
+        std::vector<const int16_t*> pointers(streams);
+        std::vector<int> decisions(streams);
+
+        double singleRate = 0.0, batchRate = 0.0;
+        for (int repeat = 0; repeat < 3; ++repeat) {
+            QElapsedTimer timer;
+            timer.start();
+            int sink = 0;
+            for (size_t f = 0; f < frames; ++f) {
+                for (size_t s = 0; s < streams; ++s) {
+                    sink += fvad_process(singles[s], &sources[s][f * frame], frame);
+                }
+            }
+            singleRate = std::max(singleRate, streams * frames / (timer.nsecsElapsed() / 1e9));
+            check(sink >= 0, "基准处理成功");
+
+            timer.restart();
+            for (size_t f = 0; f < frames; ++f) {
+                for (size_t s = 0; s < streams; ++s) {
+                    pointers[s] = &sources[s][f * frame];
+                }
+                sink += fvad_batch_process(batch, pointers.data(), frame, decisions.data());
+            }
+            batchRate = std::max(batchRate, streams * frames / (timer.nsecsElapsed() / 1e9));
+            check(sink >= 0, "基准处理成功");
+        }
+        qDebug().noquote() << QString("%1: fvad_process %2 路/核，fvad_batch_process %3 路/核，%4x")
+                                  .arg(level.name, -7)
+                                  .arg(singleRate / 100, 0, 'f', 0)
+                                  .arg(batchRate / 100, 0, 'f', 0)
+                                  .arg(batchRate / singleRate, 0, 'f', 2);
+        for (Fvad* vad : singles) {
+            fvad_free(vad);
+        }
+        fvad_batch_free(batch);
+    }
+    WebRtcSpl_InitWithFeatures(0);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // 先完成一次性的自动选择，之后 fvad_new() 不会覆盖测试指定的实现
+    WebRtcSpl_Init();
+
+    const std::vector<Level> levels = availableLevels();
+    testApi();
+
+    // 37 路：两组满的加一组部分填充
+    std::vector<std::vector<int16_t>> sources;
+    for (unsigned s = 0; s < 37; ++s) {
+        const double gains[] = {1.0, 0.2, 4.0, 10.0};
+        sources.push_back(synthesizeSpeech(12, gains[s % 4], s + 1));
+    }
+
+    for (const Level& level : levels) {
+        WebRtcSpl_InitWithFeatures(level.features);
+        const int before = failures;
+        for (int rate : {8000, 16000, 32000, 48000}) {
+            for (int frameMs : {10, 20, 30}) {
+                testRate(sources, rate, frameMs, (rate / 8000 + frameMs / 10) % 4);
+            }
+        }
+        for (int mode = 0; mode < 4; ++mode) {
+            testRate(sources, 16000, 10, mode);
+        }
+        qDebug() << level.name << (failures == before ? "一致" : "不一致");
+    }
+    WebRtcSpl_InitWithFeatures(0);
+
+    benchmark(levels, std::vector<std::vector<int16_t>>(sources.begin(), sources.begin() + 32));
+
+    if (failures > 0) {
+        qDebug() << "批量 VAD 测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "批量 VAD 测试通过";
+    return 0;
+}
@@ -0,0 +1,316 @@
+#include <QCoreApplication>
+#include <QFile>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <fvad.h>
+
+extern "C" {
+#include "signal_processing_library.h"
+#include "vad_filterbank.h"
+}
+
+// libfvad SIMD 内核测试：
+//   test_fvad_simd              使用随机噪声和合成的类语音信号
+//   test_fvad_simd audio.pcm    另外使用录制的 16kHz 单声道 s16le 数据
+// 1. 逐个内核与 C 版本对比（随机长度和幅度，包括 -32768/32767）
+// 2. 整个 VAD 流程对比：每帧的 6 个子带特征、总能量和判决必须完全一致
+// 3. 基准：每个实现单核每秒处理的帧数
+
+const int SAMPLE_RATE = 16000;
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+struct Level {
+    int features;
+    const char* name;
+};
+
+// 本机可用的实现，第一个是 C 版本
+static std::vector<Level> availableLevels()
+{
+    const Level all[] = {
+        {kSplCpuSse41, "SSE4.1"},
+        {kSplCpuSse41 | kSplCpuAvx2, "AVX2"},
+        {kSplCpuNeon, "NEON"},
+    };
+    const int supported = WebRtcSpl_CpuFeatures();
+    std::vector<Level> levels = {{0, "C"}};
+    for (const Level& level : all) {
+        if ((level.features & supported) == level.features) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+static std::vector<int16_t> readPcm(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "无法打开文件:" << path;
+        return {};
+    }
+    QByteArray data = file.readAll();
+    std::vector<int16_t> samples(data.size() / sizeof(int16_t));
+    memcpy(samples.data(), data.constData(), samples.size() * sizeof(int16_t));
+    return samples;
+}
+
+// 类语音信号：基频抖动的脉冲串经过两个共振峰，按音节包络起落，中间有静音和底噪
+static std::vector<int16_t> synthesizeSpeech(int seconds, double gain, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<int16_t> out(SAMPLE_RATE * seconds);
+
+    double phase = 0.0;
+    double f1 = 700, f2 = 1200;
+    double y1[2] = {0, 0}, y2[2] = {0, 0};
+    int syllableLeft = 0, syllableLength = 1;
+    bool voiced = false;
+    for (size_t i = 0; i < out.size(); ++i) {
+        if (syllableLeft-- <= 0) {
+            syllableLength = SAMPLE_RATE * (80 + static_cast<int>(uniform(rng) * 250)) / 1000;
+            syllableLeft = syllableLength;
+            voiced = uniform(rng) < 0.7;
+            f1 = 300 + uniform(rng) * 600;
+            f2 = 900 + uniform(rng) * 1500;
+        }
+        const double t = static_cast<double>(i) / SAMPLE_RATE;
+        const double pitch = 120 + 30 * std::sin(2 * M_PI * 3 * t);
+        phase += pitch / SAMPLE_RATE;
+        double excitation = 0.0;
+        if (phase >= 1.0) {
+            phase -= 1.0;
+            excitation = 1.0;
+        }
+        excitation = voiced ? excitation * 40 + noise(rng) * 0.3 : noise(rng) * 2;
+
+        // 两个二阶谐振器串联
+        double sample = excitation;
+        double* states[2] = {y1, y2};
+        const double freqs[2] = {f1, f2};
+        for (int k = 0; k < 2; ++k) {
+            const double r = 0.97;
+            const double c = 2 * r * std::cos(2 * M_PI * freqs[k] / SAMPLE_RATE);
+            const double y = sample + c * states[k][0] - r * r * states[k][1];
+            states[k][1] = states[k][0];
+            states[k][0] = y;
+            sample = y * 0.05;
+        }
+        const double envelope = voiced ? std::sin(M_PI * (syllableLength - syllableLeft) / syllableLength) : 0.0;
+        const double value = gain * (sample * envelope * 3000 + noise(rng) * 10);
+        out[i] = static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, value)));
+    }
+    return out;
+}
+
+static std::vector<int16_t> randomNoise(int seconds, int amplitude, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(-amplitude, amplitude);
+    std::vector<int16_t> out(SAMPLE_RATE * seconds);
+    for (int16_t& sample : out) {
+        sample = static_cast<int16_t>(std::max(-32768, std::min(32767, dist(rng))));
+    }
+    return out;
+}
+
+// 内核逐个对比：长度覆盖向量宽度的各种余数，幅度覆盖不缩放和缩放两条路径
+static void testKernels(const std::vector<Level>& levels)
+{
+    std::mt19937 rng(7);
+    for (int round = 0; round < 20000; ++round) {
+        const size_t length = rng() % 300;
+        const int amplitudes[] = {0, 1, 100, 3000, 20000, 32768};
+        const int amplitude = amplitudes[rng() % 6];
+        std::uniform_int_distribution<int> dist(-amplitude, amplitude);
+        std::vector<int16_t> a(length), b(length);
+        for (size_t i = 0; i < length; ++i) {
+            a[i] = static_cast<int16_t>(std::min(32767, dist(rng)));
+            b[i] = static_cast<int16_t>(std::min(32767, dist(rng)));
+        }
+        // 偶尔放入极值
+        if (length > 0 && round % 5 == 0) {
+            a[rng() % length] = -32768;
+            b[rng() % length] = 32767;
+        }
+        const size_t times = 1 + rng() % 1000;
+
+        WebRtcSpl_InitWithFeatures(0);
+        const int16_t expectedScaling = WebRtcSpl_GetScalingSquare(a.data(), length, times);
+        int expectedScale = 0;
+        const int32_t expectedEnergy = WebRtcSpl_Energy(a.data(), length, &expectedScale);
+        std::vector<int16_t> expectedHp = a, expectedLp = b;
+        WebRtcSpl_AddSubW16(expectedHp.data(), expectedLp.data(), length);
+
+        for (size_t l = 1; l < levels.size(); ++l) {
+            WebRtcSpl_InitWithFeatures(levels[l].features);
+            int scale = 0;
+            std::vector<int16_t> hp = a, lp = b;
+            WebRtcSpl_AddSubW16(hp.data(), lp.data(), length);
+            const bool same = WebRtcSpl_GetScalingSquare(a.data(), length, times) == expectedScaling &&
+                              WebRtcSpl_Energy(a.data(), length, &scale) == expectedEnergy &&
+                              scale == expectedScale && hp == expectedHp && lp == expectedLp;
+            if (!same) {
+                qDebug() << levels[l].name << "内核结果不一致，长度" << length << "幅度" << amplitude;
+                ++failures;
+                WebRtcSpl_InitWithFeatures(0);
+                return;
+            }
+        }
+    }
+    WebRtcSpl_InitWithFeatures(0);
+}
+
+struct FrameResult {
+    int16_t features[kNumChannels];
+    int16_t totalEnergy;
+    int decision;
+
+    bool operator==(const FrameResult& other) const
+    {
+        return memcmp(features, other.features, sizeof(features)) == 0 &&
+               totalEnergy == other.totalEnergy && decision == other.decision;
+    }
+};
+
+// 以 8kHz 计算子带特征（滤波器组只在 8kHz 上运行），同时用 16kHz 的原始数据做判决
+static std::vector<FrameResult> runPipeline(const std::vector<int16_t>& audio, int frameMs)
+{
+    const size_t frame16 = SAMPLE_RATE / 1000 * frameMs;
+    const size_t frame8 = frame16 / 2;
+    VadInstT core;
+    WebRtcVad_InitCore(&core);
+    Fvad* vad = fvad_new();
+    fvad_set_sample_rate(vad, SAMPLE_RATE);
+    fvad_set_mode(vad, 2);
+
+    std::vector<FrameResult> results;
+    std::vector<int16_t> down(frame8);
+    for (size_t pos = 0; pos + frame16 <= audio.size(); pos += frame16) {
+        for (size_t i = 0; i < frame8; ++i) {
+            down[i] = audio[pos + 2 * i];
+        }
+        FrameResult result;
+        result.totalEnergy = WebRtcVad_CalculateFeatures(&core, down.data(), frame8, result.features);
+        result.decision = fvad_process(vad, &audio[pos], frame16);
+        results.push_back(result);
+    }
+    fvad_free(vad);
+    return results;
+}
+
+static void testPipeline(const std::vector<Level>& levels, const char* name, const std::vector<int16_t>& audio)
+{
+    for (int frameMs : {10, 20, 30}) {
+        WebRtcSpl_InitWithFeatures(0);
+        const std::vector<FrameResult> expected = runPipeline(audio, frameMs);
+        int speech = 0;
+        for (const FrameResult& result : expected) {
+            speech += result.decision;
+        }
+        for (size_t l = 1; l < levels.size(); ++l) {
+            WebRtcSpl_InitWithFeatures(levels[l].features);
+            const std::vector<FrameResult> actual = runPipeline(audio, frameMs);
+            size_t mismatch = 0;
+            while (mismatch < expected.size() && actual[mismatch] == expected[mismatch]) {
+                ++mismatch;
+            }
+            if (mismatch != expected.size()) {
+                qDebug() << levels[l].name << name << frameMs << "ms 第" << mismatch << "帧与 C 版本不一致";
+                ++failures;
+            }
+        }
+        if (frameMs == 10) {
+            qDebug().noquote() << QString("%1：%2 帧，语音帧 %3").arg(name).arg(expected.size()).arg(speech);
+        }
+    }
+    WebRtcSpl_InitWithFeatures(0);
+}
+
+// 每个实现单线程处理 16kHz 10ms 帧的速度
+static void benchmark(const std::vector<Level>& levels, const std::vector<int16_t>& audio)
+{
+    const size_t frame = SAMPLE_RATE / 100;
+    const size_t frames = audio.size() / frame;
+    double baseline = 0.0;
+    for (const Level& level : levels) {
+        WebRtcSpl_InitWithFeatures(level.features);
+        Fvad* vad = fvad_new();
+        fvad_set_sample_rate(vad, SAMPLE_RATE);
+        double best = 0.0;
+        for (int repeat = 0; repeat < 5; ++repeat) {
+            QElapsedTimer timer;
+            timer.start();
+            int sink = 0;
+            for (size_t i = 0; i < frames; ++i) {
+                sink += fvad_process(vad, &audio[i * frame], frame);
+            }
+            const double seconds = timer.nsecsElapsed() / 1e9;
+            best = std::max(best, frames / seconds);
+            check(sink >= 0, "基准处理成功");
+        }
+        fvad_free(vad);
+        if (baseline == 0.0) {
+            baseline = best;
+        }
+        qDebug().noquote() << QString("%1: %2 帧/秒/核 (10ms @ 16kHz)，相对 C %3x")
+                                  .arg(level.name, -7)
+                                  .arg(best, 0, 'f', 0)
+                                  .arg(best / baseline, 0, 'f', 2);
+    }
+    WebRtcSpl_InitWithFeatures(0);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // 先完成一次性的自动选择，之后 fvad_new() 不会覆盖测试指定的实现
+    WebRtcSpl_Init();
+
+    const std::vector<Level> levels = availableLevels();
+    QStringList names;
+    for (const Level& level : levels) {
+        names << level.name;
+    }
+    qDebug() << "可用实现:" << names.join(", ");
+    if (levels.size() == 1) {
+        qDebug() << "本机没有可用的 SIMD 实现，只运行基准";
+    }
+
+    testKernels(levels);
+
+    const std::vector<int16_t> speech = synthesizeSpeech(60, 1.0, 1);
+    testPipeline(levels, "合成语音", speech);
+    testPipeline(levels, "合成语音（大音量）", synthesizeSpeech(20, 8.0, 2));
+    testPipeline(levels, "随机噪声", randomNoise(20, 2000, 3));
+    testPipeline(levels, "满幅噪声", randomNoise(10, 32768, 4));
+    if (argc > 1) {
+        const std::vector<int16_t> recorded = readPcm(argv[1]);
+        check(!recorded.empty(), "读取录音");
+        testPipeline(levels, "录音", recorded);
+    }
+
+    benchmark(levels, speech);
+
+    if (failures > 0) {
+        qDebug() << "libfvad SIMD 测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "libfvad SIMD 测试通过";
+    return 0;
+}
@@ -0,0 +1,246 @@
+#include <QCoreApplication>
+#include <QThread>
+#include <QWebSocketServer>
+#include <QWebSocket>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QDebug>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include "websocket_client.h"
+#include "threaded_transport.h"
+#include "binary_protocol.h"
+
+// 网络线程端到端测试：服务器在独立线程中每 20ms 下发一帧版本 2 音频，
+// 主线程（相当于 GUI 线程）每 500ms 被阻塞 150ms，模拟界面绘制卡顿，
+// 阻塞期间不停读取统计快照（与网络线程争用快照的锁）。
+// 在“解码器”入口（音频包回调）记录到达间隔，比较三种方式：
+//   - GUI 线程中的 WebSocketClient（原来的方式）
+//   - ThreadedTransport，下行音频转到 GUI 线程
+//   - ThreadedTransport，下行音频在网络线程中直接交给解码器
+//   test_network_thread [帧数] [卡顿ms] [卡顿周期ms]
+
+static int failures = 0;
+
+static void check(bool condition, const QString& what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+// 服务器线程：hello 握手后按 20ms 间隔发送带时间戳的音频帧
+class PacedServer : public QThread
+{
+public:
+    explicit PacedServer(int frames) : frames(frames), port(0) {}
+
+    quint16 serverPort()
+    {
+        while (port.load() == 0) {
+            QThread::msleep(1);
+        }
+        return port.load();
+    }
+
+protected:
+    void run() override
+    {
+        QWebSocketServer server("paced", QWebSocketServer::NonSecureMode);
+        server.listen(QHostAddress::LocalHost);
+        QTimer pacer;
+        pacer.setTimerType(Qt::PreciseTimer);
+        QWebSocket* socket = nullptr;
+        int sent = 0;
+        QByteArray frame;
+        const QByteArray payload(120, 'a');
+
+        QObject::connect(&server, &QWebSocketServer::newConnection, [&]() {
+            socket = server.nextPendingConnection();
+            QObject::connect(socket, &QWebSocket::textMessageReceived, [&](const QString& text) {
+                if (QJsonDocument::fromJson(text.toUtf8()).object().value("type").toString() == "hello") {
+                    socket->sendTextMessage(R"({"type":"hello","transport":"websocket","version":2,"session_id":"paced"})");
+                    pacer.start(20);
+                }
+            });
+            QObject::connect(socket, &QWebSocket::disconnected, [&]() { quit(); });
+        });
+        QObject::connect(&pacer, &QTimer::timeout, [&]() {
+            if (sent >= frames) {
+                pacer.stop();
+                return;
+            }
+            BinaryProtocol::build(2, BinaryProtocol::Audio, static_cast<quint32>(sent * 20),
+                                  payload.constData(), payload.size(), frame);
+            socket->sendBinaryMessage(frame);
+            ++sent;
+        });
+
+        port.store(server.serverPort());
+        exec();
+        delete socket;
+    }
+
+private:
+    int frames;
+    std::atomic<quint16> port;
+};
+
+struct ArrivalLog {
+    QMutex mutex;
+    QVector<qint64> arrivalNs;
+};
+
+struct JitterResult {
+    int received = 0;
+    double meanMs = 0;
+    double stddevMs = 0;
+    double maxGapMs = 0;
+};
+
+static JitterResult summarize(const QVector<qint64>& arrivalNs)
+{
+    JitterResult result;
+    result.received = arrivalNs.size();
+    if (arrivalNs.size() < 2) {
+        return result;
+    }
+    QVector<double> gaps;
+    for (int i = 1; i < arrivalNs.size(); ++i) {
+        gaps.append((arrivalNs[i] - arrivalNs[i - 1]) / 1e6);
+    }
+    double sum = 0;
+    for (double gap : gaps) {
+        sum += gap;
+        result.maxGapMs = qMax(result.maxGapMs, gap);
+    }
+    result.meanMs = sum / gaps.size();
+    double variance = 0;
+    for (double gap : gaps) {
+        variance += (gap - result.meanMs) * (gap - result.meanMs);
+    }
+    result.stddevMs = std::sqrt(variance / gaps.size());
+    return result;
+}
+
+static bool waitFor(const std::function<bool()>& condition, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition() && timer.elapsed() < timeoutMs) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    return condition();
+}
+
+static JitterResult runStream(Transport& transport, int frames, int stallMs, int stallPeriodMs)
+{
+    PacedServer server(frames);
+    server.start();
+
+    ArrivalLog log;
+    QElapsedTimer clock;
+    clock.start();
+    // 回调可能在网络线程中调用
+    transport.setOnAudioPacketCallback([&](const QByteArray& payload, qint64) {
+        Q_UNUSED(payload);
+        QMutexLocker locker(&log.mutex);
+        log.arrivalNs.append(clock.nsecsElapsed());
+    });
+
+    transport.connectToServer(QString("ws://127.0.0.1:%1").arg(server.serverPort()));
+    if (!waitFor([&]() { return transport.isConnected(); }, 5000)) {
+        qDebug() << "连接失败";
+        ++failures;
+    }
+
+    // 模拟 GUI 线程负载
+    QTimer load;
+    QObject::connect(&load, &QTimer::timeout, [&transport, stallMs]() {
+        QElapsedTimer busy;
+        busy.start();
+        while (busy.elapsed() < stallMs) {
+            transport.downlinkStatistics();
+            transport.wireStatistics();
+        }
+    });
+    load.start(stallPeriodMs);
+
+    waitFor([&]() {
+        QMutexLocker locker(&log.mutex);
+        return log.arrivalNs.size() >= frames;
+    }, frames * 20 + 5000);
+    load.stop();
+
+    // 一轮结束时发送的 JSON 消息刷新统计快照，之前的音频包都已计入
+    transport.sendText(R"({"type":"listen","state":"stop"})");
+    waitFor([&]() { return transport.downlinkStatistics().packets() >= frames; }, 2000);
+    const StreamStats stats = transport.downlinkStatistics();
+    check(stats.packets() == frames, QString("统计快照应包含全部 %1 帧（%2）").arg(frames).arg(stats.packets()));
+
+    transport.closeConnection();
+    waitFor([&]() { return server.isFinished(); }, 2000);
+    server.quit();
+    server.wait();
+    transport.setOnAudioPacketCallback(nullptr);
+
+    QMutexLocker locker(&log.mutex);
+    return summarize(log.arrivalNs);
+}
+
+static void printResult(const char* name, const JitterResult& result)
+{
+    qDebug().noquote() << QString("  %1 收到 %2  平均间隔 %3 ms  标准差 %4 ms  最大间隔 %5 ms")
+                          .arg(name, -16)
+                          .arg(result.received)
+                          .arg(result.meanMs, 0, 'f', 1)
+                          .arg(result.stddevMs, 0, 'f', 1)
+                          .arg(result.maxGapMs, 0, 'f', 1);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int frames = argc > 1 ? QString(argv[1]).toInt() : 250;
+    const int stallMs = argc > 2 ? QString(argv[2]).toInt() : 150;
+    const int stallPeriodMs = argc > 3 ? QString(argv[3]).toInt() : 500;
+    qDebug().noquote() << QString("%1 帧，GUI 线程每 %2 ms 阻塞 %3 ms").arg(frames).arg(stallPeriodMs).arg(stallMs);
+
+    WebSocketClient guiClient;
+    guiClient.setKeepAlive(0, 3);
+    const JitterResult gui = runStream(guiClient, frames, stallMs, stallPeriodMs);
+    printResult("GUI 线程", gui);
+
+    ThreadedTransport queued([]() { return new WebSocketClient(); });
+    queued.setKeepAlive(0, 3);
+    const JitterResult viaGui = runStream(queued, frames, stallMs, stallPeriodMs);
+    printResult("网络线程→GUI", viaGui);
+
+    ThreadedTransport direct([]() { return new WebSocketClient(); });
+    direct.setKeepAlive(0, 3);
+    direct.setAudioCallbackOnNetworkThread(true);
+    const JitterResult network = runStream(direct, frames, stallMs, stallPeriodMs);
+    printResult("网络线程直达", network);
+
+    check(gui.received == frames && viaGui.received == frames && network.received == frames, "所有帧都应到达");
+    check(queued.droppedDownlink() == 0, "下行队列不应溢出");
+    // 经过 GUI 线程时最大间隔接近卡顿时长；直达解码器时只剩网络和调度抖动
+    check(network.maxGapMs < 20 + stallMs / 2.0,
+          QString("网络线程直达的最大间隔 %1 ms 不应受 GUI 卡顿影响").arg(network.maxGapMs));
+    check(network.stddevMs < gui.stddevMs, "网络线程直达的到达间隔应比 GUI 线程平稳");
+
+    if (failures > 0) {
+        qDebug() << "网络线程测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "网络线程测试通过";
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include <QCoreApplication>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QNetworkAccessManager>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QFile>
+#include <QQueue>
+#include <QDebug>
+#include <functional>
+#include "ota_client.h"
+
+// OTA 客户端测试：本地 HTTP 服务器按预设依次回复（失败、成功、304），检查
+//   - 失败后按退避重试，成功后写入缓存
+//   - 新的客户端从缓存立即得到配置，缓存新鲜时不发请求
+//   - 强制刷新时带 If-None-Match，304 只更新时间
+//   - OTA 服务器很慢时，读缓存与等待首个响应的耗时对比
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+static bool waitFor(const std::function<bool()>& condition, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition() && timer.elapsed() < timeoutMs) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    return condition();
+}
+
+struct Reply {
+    int status = 200;
+    QByteArray body;
+    QByteArray etag;
+    int delayMs = 0;
+};
+
+// 每个连接处理一个请求，按队列中的预设回复；队列空时回复 500
+class FakeOtaServer
+{
+public:
+    FakeOtaServer()
+    {
+        server.listen(QHostAddress::LocalHost);
+        QObject::connect(&server, &QTcpServer::newConnection, [this]() {
+            while (QTcpSocket* socket = server.nextPendingConnection()) {
+                QObject::connect(socket, &QTcpSocket::readyRead, [this, socket]() { onReadyRead(socket); });
+                QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            }
+        });
+    }
+
+    QString url() const { return QString("http://127.0.0.1:%1/xiaozhi/ota/").arg(server.serverPort()); }
+
+    QQueue<Reply> replies;
+    int requests = 0;
+    QByteArray lastIfNoneMatch;
+    QByteArray lastDeviceId;
+
+private:
+    void onReadyRead(QTcpSocket* socket)
+    {
+        QByteArray& buffer = buffers[socket];
+        buffer += socket->readAll();
+        const int headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+        int contentLength = 0;
+        QByteArray ifNoneMatch;
+        QByteArray deviceId;
+        for (const QByteArray& line : buffer.left(headerEnd).split('\n')) {
+            const int colon = line.indexOf(':');
+            const QByteArray name = line.left(colon).trimmed().toLower();
+            const QByteArray value = line.mid(colon + 1).trimmed();
+            if (name == "content-length") {
+                contentLength = value.toInt();
+            } else if (name == "if-none-match") {
+                ifNoneMatch = value;
+            } else if (name == "device-id") {
+                deviceId = value;
+            }
+        }
+        if (buffer.size() < headerEnd + 4 + contentLength) {
+            return;
+        }
+        buffers.remove(socket);
+        ++requests;
+        lastIfNoneMatch = ifNoneMatch;
+        lastDeviceId = deviceId;
+
+        Reply reply;
+        reply.status = 500;
+        if (!replies.isEmpty()) {
+            reply = replies.dequeue();
+        }
+        QByteArray response = "HTTP/1.1 " + QByteArray::number(reply.status) +
+                              (reply.status == 200 ? " OK" : reply.status == 304 ? " Not Modified" : " Error") + "\r\n";
+        response += "Content-Type: application/json\r\nConnection: close\r\n";
+        if (!reply.etag.isEmpty()) {
+            response += "ETag: " + reply.etag + "\r\n";
+        }
+        response += "Content-Length: " + QByteArray::number(reply.body.size()) + "\r\n\r\n" + reply.body;
+        QTimer::singleShot(reply.delayMs, socket, [socket, response]() {
+            socket->write(response);
+            socket->disconnectFromHost();
+        });
+    }
+
+    QTcpServer server;
+    QHash<QTcpSocket*, QByteArray> buffers;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTemporaryDir dir;
+    const QString cache = dir.path() + "/ota_cache.json";
+    const QByteArray response = R"({"websocket":{"url":"wss://example.com/xiaozhi/v1/","token":"abc","version":2},)"
+                                R"("mqtt":{"endpoint":"mqtt.example.com:8883","client_id":"c1"},)"
+                                R"("firmware":{"version":"1.6.0"}})";
+    QNetworkAccessManager manager;
+    FakeOtaServer server;
+
+    // 1. 两次失败后成功
+    server.replies.enqueue({500, "", "", 0});
+    server.replies.enqueue({503, "", "", 0});
+    server.replies.enqueue({200, response, "\"v1\"", 0});
+    {
+        OtaClient client(&manager, server.url(), cache);
+        client.setDevice("aa:bb:cc:00:00:01", "client", "{}");
+        client.setRetryDelays(50, 200);
+        int failed = 0;
+        bool changed = false;
+        QObject::connect(&client, &OtaClient::refreshFailed, [&](const QString&, int retryMs) {
+            ++failed;
+            check(retryMs >= 25 && retryMs <= 200, "退避时间在范围内");
+        });
+        QObject::connect(&client, &OtaClient::configUpdated, [&](const OtaConfig&, bool connectionChanged) {
+            changed = connectionChanged;
+        });
+        check(!client.loadCache(), "初始没有缓存");
+        client.refresh();
+        check(waitFor([&]() { return client.config().isValid(); }, 5000), "重试后拿到配置");
+        check(failed == 2 && server.requests == 3, "失败两次后成功");
+        check(changed, "首次配置视为变化");
+        check(client.config().websocketUrl == "wss://example.com/xiaozhi/v1/" &&
+              client.config().websocketToken == "abc" && client.config().websocketVersion == 2
+              && client.config().hasMqtt(), "解析 OTA 配置");
+        check(server.lastDeviceId == "aa:bb:cc:00:00:01", "请求带 Device-Id");
+        check(QFile::exists(cache), "写入缓存");
+    }
+
+    // 2. 从缓存启动，缓存新鲜时不请求
+    {
+        OtaClient client(&manager, server.url(), cache);
+        QElapsedTimer timer;
+        timer.start();
+        check(client.loadCache(), "读取缓存");
+        const qint64 cacheUs = timer.nsecsElapsed() / 1000;
+        check(client.config().websocketUrl == "wss://example.com/xiaozhi/v1/" && client.config().etag == "\"v1\"",
+              "缓存内容完整");
+        const int before = server.requests;
+        client.refresh();
+        check(!client.isRefreshing() && server.requests == before, "缓存新鲜时不请求");
+
+        // 3. 强制刷新：条件请求，304 不通知上层
+        server.replies.enqueue({304, "", "", 0});
+        bool updated = false;
+        QObject::connect(&client, &OtaClient::configUpdated, [&]() { updated = true; });
+        const QDateTime previous = client.config().fetchedAt;
+        client.refresh(true);
+        check(waitFor([&]() { return !client.isRefreshing(); }, 5000), "304 响应");
+        check(server.lastIfNoneMatch == "\"v1\"", "请求带 If-None-Match");
+        check(!updated && client.config().fetchedAt >= previous && client.config().isValid(), "304 只更新时间");
+
+        // 4. OTA 服务器很慢：没有缓存时连接要等首个响应
+        server.replies.enqueue({200, response, "", 1500});
+        OtaClient cold(&manager, server.url(), dir.path() + "/cold.json");
+        timer.restart();
+        cold.refresh();
+        waitFor([&]() { return cold.config().isValid(); }, 5000);
+        const qint64 coldMs = timer.elapsed();
+        qDebug().noquote() << QString("配置可用耗时：读缓存 %1 us，等待 OTA 响应 %2 ms").arg(cacheUs).arg(coldMs);
+        check(cold.config().isValid() && coldMs >= 1500, "慢速 OTA 响应");
+    }
+
+    if (failures > 0) {
+        qDebug() << "OTA 客户端测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "OTA 客户端测试通过";
+    return 0;
+}
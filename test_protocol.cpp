@@ -0,0 +1,368 @@
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QDebug>
+#include "protocol.h"
+#include "binary_protocol.h"
+#include "message_deflate.h"
+#include "stream_stats.h"
+
+// 协议层测试：
+//   1. 各类服务器消息解析成对应的结构体，二进制帧（版本 1/2/3）的构造和解析，
+//      按时间戳统计丢包、乱序和抖动，JSON 消息压缩（与 RFC 7692 示例一致）及一轮对话的字节数
+//   2. 高消息率下（长文本 sentence_start 流）对比旧的“两次解析 + 字符串比较”与
+//      新的“一次解析 + 类型表分发”的吞吐
+//   test_protocol [消息数] [文本长度]
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+static void testParse()
+{
+    using namespace Protocol;
+
+    Message hello = parse(QByteArray(R"({"type":"hello","transport":"websocket","session_id":"abc",)"
+                                     R"("audio_params":{"format":"opus","sample_rate":24000,"channels":1,"frame_duration":60}})"));
+    const HelloMessage* h = std::get_if<HelloMessage>(&hello);
+    check(h && h->transport == "websocket" && h->sessionId == "abc", "hello");
+    check(h && h->hasAudioParams && h->audioParams.sampleRate == 24000 && h->audioParams.frameDuration == 60,
+          "hello audio_params");
+    check(h && h->version == 1 && !h->hasVersion, "hello 缺省版本");
+    Message hello2 = parse(QByteArray(R"({"type":"hello","version":2,"transport":"websocket"})"));
+    check(std::get_if<HelloMessage>(&hello2) && std::get<HelloMessage>(hello2).version == 2
+          && std::get<HelloMessage>(hello2).hasVersion, "hello version");
+
+    // 只实现版本 1 的服务器不回显 version：默认请求 1，仍按裸 Opus 收发
+    check(h && negotiateVersion(*h, 1) == 1, "旧服务器不给出版本时为 1");
+    check(h && negotiateVersion(*h, 2) == 2, "指定版本 2 且服务器不给出时沿用");
+    const HelloMessage& v2 = std::get<HelloMessage>(hello2);
+    check(negotiateVersion(v2, 1) == 2, "服务器确认版本 2");
+    Message hello1 = parse(QByteArray(R"({"type":"hello","version":1,"transport":"websocket"})"));
+    Message hello9 = parse(QByteArray(R"({"type":"hello","version":9,"transport":"websocket"})"));
+    check(negotiateVersion(std::get<HelloMessage>(hello1), 3) == 1, "服务器只支持版本 1 时回退");
+    check(negotiateVersion(std::get<HelloMessage>(hello9), 2) == 1, "不认识的版本回退到 1");
+
+    Message stt = parse(QByteArray(R"({"type":"stt","text":"你好小智"})"));
+    check(std::holds_alternative<SttMessage>(stt) && std::get<SttMessage>(stt).text == "你好小智", "stt");
+
+    Message start = parse(QByteArray(R"({"type":"tts","state":"start"})"));
+    Message stop = parse(QByteArray(R"({"type":"tts","state":"stop"})"));
+    Message sentence = parse(QByteArray(R"({"type":"tts","state":"sentence_start","text":"今天天气不错"})"));
+    check(std::get_if<TtsMessage>(&start) && std::get<TtsMessage>(start).state == TtsState::Start, "tts start");
+    check(std::get_if<TtsMessage>(&stop) && std::get<TtsMessage>(stop).state == TtsState::Stop, "tts stop");
+    check(std::get_if<TtsMessage>(&sentence) && std::get<TtsMessage>(sentence).state == TtsState::SentenceStart &&
+          std::get<TtsMessage>(sentence).text == "今天天气不错", "tts sentence_start");
+
+    Message llm = parse(QByteArray(R"({"type":"llm","emotion":"happy","text":"😀"})"));
+    check(std::get_if<LlmMessage>(&llm) && std::get<LlmMessage>(llm).emotion == "happy", "llm");
+
+    Message iot = parse(QByteArray(R"({"type":"iot","commands":[{"name":"Lamp","method":"TurnOn"}]})"));
+    check(std::get_if<IotMessage>(&iot) && std::get<IotMessage>(iot).commands.size() == 1, "iot");
+
+    Message error = parse(QByteArray(R"({"type":"error","message":"bad token"})"));
+    check(std::get_if<ErrorMessage>(&error) && std::get<ErrorMessage>(error).message == "bad token", "error");
+
+    Message goodbye = parse(QByteArray(R"({"type":"goodbye","session_id":"abc"})"));
+    check(std::get_if<GoodbyeMessage>(&goodbye) && std::get<GoodbyeMessage>(goodbye).sessionId == "abc", "goodbye");
+
+    Message udpHello = parse(QByteArray(R"({"type":"hello","transport":"udp","session_id":"s1",)"
+                                        R"("udp":{"server":"10.0.0.1","port":8888,)"
+                                        R"("key":"000102030405060708090a0b0c0d0e0f",)"
+                                        R"("nonce":"01000000aabbccdd0000000000000000"}})"));
+    const HelloMessage* u = std::get_if<HelloMessage>(&udpHello);
+    check(u && u->hasUdp && u->udp.server == "10.0.0.1" && u->udp.port == 8888, "hello udp");
+    check(u && u->udp.key.size() == 16 && u->udp.key[15] == 0x0f && u->udp.nonce.size() == 16, "hello udp key/nonce");
+
+    Message unknown = parse(QByteArray(R"({"type":"custom"})"));
+    check(std::get_if<UnknownMessage>(&unknown) && std::get<UnknownMessage>(unknown).type == "custom", "unknown");
+
+    check(std::holds_alternative<std::monostate>(parse(QByteArray("not json"))), "invalid json");
+    check(std::holds_alternative<std::monostate>(parse(QByteArray(R"({"text":"no type"})"))), "missing type");
+
+    // 分发表只调用对应类型的处理函数
+    MessageDispatcher dispatcher;
+    int ttsCount = 0;
+    int sttCount = 0;
+    dispatcher.on<TtsMessage>([&](const TtsMessage&) { ++ttsCount; });
+    dispatcher.on<SttMessage>([&](const SttMessage&) { ++sttCount; });
+    dispatcher.dispatch(sentence);
+    dispatcher.dispatch(stt);
+    bool handled = dispatcher.dispatch(llm);
+    check(ttsCount == 1 && sttCount == 1 && !handled, "dispatcher");
+}
+
+static void testBinaryFrames()
+{
+    using namespace BinaryProtocol;
+
+    const QByteArray opus("\x58\x01\x02\x03\x04", 5);
+    QByteArray frame;
+    PacketView view;
+
+    // 版本 2：16 字节帧头，带时间戳
+    build(2, Audio, 0x01020304u, opus.constData(), opus.size(), frame);
+    check(frame.size() == HEADER_SIZE_V2 + opus.size(), "v2 帧长");
+    check(static_cast<quint8>(frame[1]) == 2 && static_cast<quint8>(frame[8]) == 0x01, "v2 大端字段");
+    check(parse(2, frame, view) && view.type == Audio && view.hasTimestamp && view.timestamp == 0x01020304u &&
+          view.payloadSize == opus.size() && QByteArray(view.payload, view.payloadSize) == opus, "v2 解析");
+    check(view.payload == frame.constData() + HEADER_SIZE_V2, "v2 不拷贝负载");
+
+    // 复用同一个缓冲区构造更短的帧
+    const char* buffer = frame.constData();
+    build(2, Json, 7, "{}", 2, frame);
+    check(frame.constData() == buffer, "v2 复用缓冲区");
+    check(parse(2, frame, view) && view.type == Json && view.payloadSize == 2, "v2 JSON 帧");
+
+    // 版本 3：4 字节帧头，无时间戳
+    build(3, Audio, 0, opus.constData(), opus.size(), frame);
+    check(frame.size() == HEADER_SIZE_V3 + opus.size(), "v3 帧长");
+    check(parse(3, frame, view) && view.type == Audio && !view.hasTimestamp &&
+          QByteArray(view.payload, view.payloadSize) == opus, "v3 解析");
+
+    // 版本 1：整帧就是 Opus 数据
+    check(parse(1, opus, view) && view.type == Audio && view.payloadSize == opus.size(), "v1 解析");
+
+    // 截断和长度不符的帧
+    check(!parse(2, frame.left(HEADER_SIZE_V2 - 1), view), "v2 帧头不完整");
+    build(3, Audio, 0, opus.constData(), opus.size(), frame);
+    check(!parse(3, frame.left(frame.size() - 1), view), "v3 负载不完整");
+}
+
+static void testStreamStats()
+{
+    StreamStats stats(60);
+    // 时间戳 0, 60, 180（丢 120）, 120（乱序）, 240；到达时间有 0/10 ms 的抖动
+    stats.onPacket(0, 1000);
+    stats.onPacket(60, 1070);
+    stats.onPacket(180, 1180);
+    stats.onPacket(120, 1190);
+    stats.onPacket(240, 1240);
+    check(stats.packets() == 5, "统计包数");
+    check(stats.lostPackets() == 1, "统计丢包");
+    check(stats.reorderedPackets() == 1, "统计乱序");
+    check(stats.jitterMs() > 0.0, "统计抖动");
+    check(stats.maxQueuingDelayMs() == 70, "统计排队延迟");
+
+    // 时间戳大跳变视为新的一句，不计为丢包
+    stats.onPacket(100000, 2000);
+    check(stats.lostPackets() == 1, "时间戳跳变重新同步");
+}
+
+// 旧实现：WebSocketClient 和 MainWindow 各解析一次，再逐个比较字符串
+static int legacyHandle(const QString& message)
+{
+    int handled = 0;
+    QJsonDocument first = QJsonDocument::fromJson(message.toUtf8());
+    if (first.isNull()) {
+        return 0;
+    }
+    QString type = first.object()["type"].toString();
+    if (type == "hello" || type == "error" || type.isEmpty()) {
+        return 0;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(message.toUtf8());
+    QJsonObject root = doc.object();
+    type = root["type"].toString();
+    if (type == "hello") {
+        handled = 1;
+    } else if (type == "stt") {
+        handled = root["text"].toString().size();
+    } else if (type == "tts") {
+        QString state = root["state"].toString();
+        if (state == "start") {
+            handled = 1;
+        } else if (state == "stop") {
+            handled = 2;
+        } else if (state == "sentence_start") {
+            handled = root["text"].toString().size();
+        }
+    }
+    return handled;
+}
+
+static void testMessageDeflate()
+{
+    MessageDeflate sender;
+    MessageDeflate receiver;
+    QByteArray compressed;
+    QByteArray restored;
+
+    // RFC 7692 7.2.3.2：同一条 "Hello" 连续压缩两次，第二次引用第一次的内容
+    check(sender.compress("Hello", 5, compressed) &&
+          compressed == QByteArray::fromHex("f248cdc9c90700"), "deflate 第一条消息");
+    check(receiver.decompress(compressed.constData(), compressed.size(), restored) && restored == "Hello",
+          "inflate 第一条消息");
+    check(sender.compress("Hello", 5, compressed) &&
+          compressed == QByteArray::fromHex("f200110000"), "deflate 复用滑动窗口");
+    check(receiver.decompress(compressed.constData(), compressed.size(), restored) && restored == "Hello",
+          "inflate 复用滑动窗口");
+
+    // 错误的数据和超过上限的消息
+    MessageDeflate broken;
+    check(!broken.decompress("\xff\xff\xff", 3, restored), "损坏的压缩数据");
+    const QByteArray large(100000, 'x');
+    MessageDeflate largeSender;
+    MessageDeflate largeReceiver;
+    largeSender.compress(large.constData(), large.size(), compressed);
+    check(!largeReceiver.decompress(compressed.constData(), compressed.size(), restored, 1000), "解压长度上限");
+
+    // 服务器 hello 中的压缩确认
+    const Protocol::Message parsed = Protocol::parse(QByteArray(
+        R"({"type":"hello","transport":"websocket","version":2,"compression":{"algorithm":"deflate","threshold":128}})"));
+    const auto* hello = std::get_if<Protocol::HelloMessage>(&parsed);
+    check(hello && hello->compression == "deflate" && hello->compressionThreshold == 128, "hello 压缩参数");
+
+    // 一轮对话的下行控制消息：缩进格式、紧凑格式、紧凑格式 + 压缩（不小于 128 字节的消息）
+    QList<QJsonObject> turn;
+    QJsonObject object;
+    object["session_id"] = "0f3c9a52";
+    object["type"] = "stt";
+    object["text"] = QStringLiteral("明天北京的天气怎么样");
+    turn.append(object);
+    object = QJsonObject{{"session_id", "0f3c9a52"}, {"type", "llm"}, {"emotion", "happy"}, {"text", "😀"}};
+    turn.append(object);
+    object = QJsonObject{{"session_id", "0f3c9a52"}, {"type", "tts"}, {"state", "start"}};
+    turn.append(object);
+    const QStringList sentences = {
+        QStringLiteral("明天北京晴转多云，气温十二到二十三度，北风二三级。"),
+        QStringLiteral("早晚温差比较大，出门记得带一件外套。"),
+        QStringLiteral("空气质量良好，适合户外活动，紫外线强度中等，注意防晒。"),
+        QStringLiteral("后天开始有一次降温过程，最高气温降到十六度左右，还可能有小雨。"),
+    };
+    for (const QString& sentence : sentences) {
+        object = QJsonObject{{"session_id", "0f3c9a52"}, {"type", "tts"}, {"state", "sentence_start"}, {"text", sentence}};
+        turn.append(object);
+        object["state"] = "sentence_end";
+        turn.append(object);
+    }
+    object = QJsonObject{{"session_id", "0f3c9a52"}, {"type", "tts"}, {"state", "stop"}};
+    turn.append(object);
+
+    MessageDeflate server;
+    MessageDeflate client;
+    int indentedBytes = 0;
+    int compactBytes = 0;
+    int deflatedBytes = 0;
+    for (const QJsonObject& message : turn) {
+        indentedBytes += QJsonDocument(message).toJson(QJsonDocument::Indented).size();
+        const QByteArray compact = QJsonDocument(message).toJson(QJsonDocument::Compact);
+        compactBytes += compact.size();
+        if (compact.size() < 128) {
+            deflatedBytes += compact.size();
+            continue;
+        }
+        server.compress(compact.constData(), compact.size(), compressed);
+        deflatedBytes += compressed.size();
+        check(client.decompress(compressed.constData(), compressed.size(), restored) && restored == compact,
+              "一轮对话的压缩消息往返");
+    }
+    check(compactBytes < indentedBytes && deflatedBytes < compactBytes, "紧凑格式和压缩应减少字节数");
+    qDebug().noquote() << QString("一轮对话 %1 条控制消息：缩进 %2 B，紧凑 %3 B，紧凑 + deflate %4 B")
+                          .arg(turn.size()).arg(indentedBytes).arg(compactBytes).arg(deflatedBytes);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    testParse();
+    testBinaryFrames();
+    testStreamStats();
+    testMessageDeflate();
+    if (failures > 0) {
+        qDebug() << "解析测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "解析测试通过";
+
+    const int messageCount = argc > 1 ? QString(argv[1]).toInt() : 200000;
+    const int textLength = argc > 2 ? QString(argv[2]).toInt() : 200;
+
+    // sentence_start 为主，夹杂 start/stop/stt/llm
+    QString longText;
+    const QString phrase = QStringLiteral("今天的天气非常适合出去散步，");
+    while (longText.size() < textLength) {
+        longText += phrase;
+    }
+    longText.truncate(textLength);
+
+    QStringList messages;
+    for (int i = 0; i < 1000; ++i) {
+        QJsonObject object;
+        object["session_id"] = "0f3c9a52";
+        switch (i % 10) {
+            case 0:
+                object["type"] = "tts";
+                object["state"] = "start";
+                break;
+            case 8:
+                object["type"] = "llm";
+                object["emotion"] = "happy";
+                object["text"] = "😀";
+                break;
+            case 9:
+                object["type"] = "stt";
+                object["text"] = longText.left(20);
+                break;
+            default:
+                object["type"] = "tts";
+                object["state"] = "sentence_start";
+                object["text"] = longText;
+                break;
+        }
+        messages.append(QString::fromUtf8(QJsonDocument(object).toJson(QJsonDocument::Compact)));
+    }
+
+    // 旧路径
+    qint64 legacySum = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < messageCount; ++i) {
+        legacySum += legacyHandle(messages[i % messages.size()]);
+    }
+    const qint64 legacyNs = timer.nsecsElapsed();
+
+    // 新路径
+    qint64 typedSum = 0;
+    Protocol::MessageDispatcher dispatcher;
+    dispatcher.on<Protocol::SttMessage>([&](const Protocol::SttMessage& stt) {
+        typedSum += stt.text.size();
+    });
+    dispatcher.on<Protocol::TtsMessage>([&](const Protocol::TtsMessage& tts) {
+        switch (tts.state) {
+            case Protocol::TtsState::Start: typedSum += 1; break;
+            case Protocol::TtsState::Stop: typedSum += 2; break;
+            case Protocol::TtsState::SentenceStart: typedSum += tts.text.size(); break;
+            default: break;
+        }
+    });
+    timer.restart();
+    for (int i = 0; i < messageCount; ++i) {
+        dispatcher.dispatch(Protocol::parse(messages[i % messages.size()].toUtf8()));
+    }
+    const qint64 typedNs = timer.nsecsElapsed();
+
+    auto rate = [messageCount](qint64 ns) { return messageCount * 1e9 / qMax<qint64>(ns, 1); };
+    qDebug() << "消息数:" << messageCount << "文本长度:" << textLength
+             << "\n  两次解析 + 字符串比较:" << qRound(rate(legacyNs)) << "条/秒"
+             << (legacyNs / 1000.0 / messageCount) << "us/条"
+             << "\n  一次解析 + 类型分发:  " << qRound(rate(typedNs)) << "条/秒"
+             << (typedNs / 1000.0 / messageCount) << "us/条"
+             << "\n  加速比:" << static_cast<double>(legacyNs) / qMax<qint64>(typedNs, 1);
+
+    if (legacySum != typedSum) {
+        qDebug() << "两种路径结果不一致:" << legacySum << typedSum;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,570 @@
+#include <QCoreApplication>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QWebSocketServer>
+#include <QWebSocket>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QQueue>
+#include <QSet>
+#include <QVector>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+#include <functional>
+#include "websocket_client.h"
+#include "mqtt_udp_transport.h"
+#include "connection_manager.h"
+#include "aes_ctr.h"
+
+// 传输层对比测试，全部在本机完成：
+//   - 模拟 MQTT 服务器（CONNECT/SUBSCRIBE/PUBLISH/PINGREQ）回复带 UDP 参数的 hello，
+//     UDP 回显服务器按丢包率丢弃加密音频包，其余原样回送
+//   - WebSocket 回显服务器回送二进制帧。回环网卡上 TCP 不会丢包，按 TCP 的行为模拟：
+//     “丢失”的帧在 RTO 后才重传到达，其后的帧必须按序等待（队头阻塞）
+//   两条路径使用相同的单程延迟，比较音频帧往返延迟的分布，并检查 UDP 的解密和按序号检测丢包。
+//   最后汇总成一张表，并检查预期的结论：UDP 的 p95 不随丢包增大（只丢帧），
+//   丢包率不低于 5% 时 WebSocket 的 p95 因重传和队头阻塞明显高于 UDP。
+//   UDP 音频加密先用 NIST SP 800-38A 的 AES-128-CTR 向量核对。
+//   另外检查保活间隔为 0 时 WebSocket 收到 hello 后不会启动保活；
+//   WebSocket 服务器反复断开并在随机时长内拒绝连接（抖动的链路），ConnectionManager
+//   每次都能自动重连，给出断线到重新可用耗时的 p50/p95。
+//   test_transport [帧数] [单程延迟ms] [RTO ms] [断线次数]
+
+static int failures = 0;
+
+static void check(bool condition, const QString& what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+// 按到期时间依次发出；到期时间单调不减，用 FIFO 即可保持顺序
+class DelayLine
+{
+public:
+    explicit DelayLine(const QElapsedTimer& clock) : clock(clock)
+    {
+        timer.setSingleShot(true);
+        timer.setTimerType(Qt::PreciseTimer);
+        QObject::connect(&timer, &QTimer::timeout, [this]() { flush(); });
+    }
+
+    void push(qint64 dueMs, std::function<void()> action)
+    {
+        queue.enqueue({dueMs, std::move(action)});
+        if (!timer.isActive()) {
+            timer.start(qMax<qint64>(0, queue.head().first - clock.elapsed()));
+        }
+    }
+
+private:
+    void flush()
+    {
+        while (!queue.isEmpty() && queue.head().first <= clock.elapsed()) {
+            queue.dequeue().second();
+        }
+        if (!queue.isEmpty()) {
+            timer.start(qMax<qint64>(0, queue.head().first - clock.elapsed()));
+        }
+    }
+
+    const QElapsedTimer& clock;
+    QTimer timer;
+    QQueue<QPair<qint64, std::function<void()>>> queue;
+};
+
+struct LinkModel {
+    double lossRate = 0.0;
+    int oneWayMs = 20;
+    int rtoMs = 200;
+};
+
+static void writeMqttPacket(QTcpSocket* socket, quint8 header, const QByteArray& body)
+{
+    QByteArray packet;
+    packet.append(static_cast<char>(header));
+    int remaining = body.size();
+    do {
+        quint8 byte = remaining % 128;
+        remaining /= 128;
+        if (remaining > 0) {
+            byte |= 0x80;
+        }
+        packet.append(static_cast<char>(byte));
+    } while (remaining > 0);
+    packet.append(body);
+    socket->write(packet);
+}
+
+static bool takeMqttPacket(QByteArray& buffer, quint8& header, QByteArray& body)
+{
+    int remaining = 0;
+    int multiplier = 1;
+    int pos = 1;
+    while (pos < buffer.size()) {
+        const quint8 byte = static_cast<quint8>(buffer[pos++]);
+        remaining += (byte & 0x7F) * multiplier;
+        multiplier *= 128;
+        if ((byte & 0x80) == 0) {
+            if (buffer.size() < pos + remaining) {
+                return false;
+            }
+            header = static_cast<quint8>(buffer[0]);
+            body = buffer.mid(pos, remaining);
+            buffer.remove(0, pos + remaining);
+            return true;
+        }
+    }
+    return false;
+}
+
+// 模拟 MQTT 服务器 + UDP 回显
+class FakeMqttUdpServer
+{
+public:
+    FakeMqttUdpServer(const QElapsedTimer& clock, const LinkModel& link, quint64 seed)
+        : link(link), delay(clock), clock(clock), random(seed)
+    {
+        tcp.listen(QHostAddress::LocalHost);
+        udp.bind(QHostAddress::LocalHost, 0);
+        QObject::connect(&tcp, &QTcpServer::newConnection, [this]() { onConnection(); });
+        QObject::connect(&udp, &QUdpSocket::readyRead, [this]() { onDatagram(); });
+    }
+
+    quint16 mqttPort() const { return tcp.serverPort(); }
+    const QSet<quint32>& droppedSequences() const { return dropped; }
+
+private:
+    void onConnection()
+    {
+        QTcpSocket* socket = tcp.nextPendingConnection();
+        QObject::connect(socket, &QTcpSocket::readyRead, [this, socket]() {
+            buffer.append(socket->readAll());
+            quint8 header;
+            QByteArray body;
+            while (takeMqttPacket(buffer, header, body)) {
+                onPacket(socket, header, body);
+            }
+        });
+    }
+
+    void onPacket(QTcpSocket* socket, quint8 header, const QByteArray& body)
+    {
+        switch (header & 0xF0) {
+            case 0x10:  // CONNECT
+                writeMqttPacket(socket, 0x20, QByteArray("\x00\x00", 2));
+                break;
+            case 0x80:  // SUBSCRIBE
+                writeMqttPacket(socket, 0x90, body.left(2) + QByteArray(1, '\0'));
+                break;
+            case 0xC0:  // PINGREQ
+                writeMqttPacket(socket, 0xD0, QByteArray());
+                break;
+            case 0x30: {  // PUBLISH
+                const int topicLength = qFromBigEndian<quint16>(body.constData());
+                const QJsonObject message = QJsonDocument::fromJson(body.mid(2 + topicLength)).object();
+                if (message.value("type").toString() != "hello") {
+                    break;
+                }
+                QJsonObject udpParams;
+                udpParams["server"] = "127.0.0.1";
+                udpParams["port"] = udp.localPort();
+                udpParams["key"] = "2b7e151628aed2a6abf7158809cf4f3c";
+                udpParams["nonce"] = "01000000123456780000000000000000";
+                QJsonObject hello;
+                hello["type"] = "hello";
+                hello["transport"] = "udp";
+                hello["session_id"] = "udp-session";
+                hello["udp"] = udpParams;
+                QByteArray reply;
+                const QByteArray topic("device/sub");
+                reply.append(static_cast<char>(0));
+                reply.append(static_cast<char>(topic.size()));
+                reply.append(topic);
+                reply.append(QJsonDocument(hello).toJson(QJsonDocument::Compact));
+                writeMqttPacket(socket, 0x30, reply);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void onDatagram()
+    {
+        while (udp.hasPendingDatagrams()) {
+            QByteArray datagram(static_cast<int>(udp.pendingDatagramSize()), 0);
+            QHostAddress sender;
+            quint16 senderPort = 0;
+            udp.readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
+            if (datagram.size() < 16) {
+                continue;
+            }
+            const quint32 sequence = qFromBigEndian<quint32>(datagram.constData() + 12);
+            if (random.generateDouble() < link.lossRate) {
+                dropped.insert(sequence);
+                continue;
+            }
+            delay.push(clock.elapsed() + 2 * link.oneWayMs, [this, datagram, sender, senderPort]() {
+                udp.writeDatagram(datagram, sender, senderPort);
+            });
+        }
+    }
+
+    LinkModel link;
+    DelayLine delay;
+    const QElapsedTimer& clock;
+    QRandomGenerator random;
+    QTcpServer tcp;
+    QUdpSocket udp;
+    QByteArray buffer;
+    QSet<quint32> dropped;
+};
+
+// WebSocket 回显，按 TCP 重传和队头阻塞模拟丢包
+class FakeWebSocketServer
+{
+public:
+    FakeWebSocketServer(const QElapsedTimer& clock, const LinkModel& link, quint64 seed)
+        : server("fake", QWebSocketServer::NonSecureMode), link(link), delay(clock), clock(clock), random(seed)
+    {
+        server.listen(QHostAddress::LocalHost);
+        port = server.serverPort();
+        QObject::connect(&server, &QWebSocketServer::newConnection, [this]() { onConnection(); });
+    }
+
+    ~FakeWebSocketServer() { qDeleteAll(sockets); }
+
+    QString url() const { return QString("ws://127.0.0.1:%1").arg(port); }
+    int retransmissions() const { return retransmitted; }
+
+    // 模拟断网：断开所有连接并停止监听，恢复前的连接尝试都被拒绝
+    void setDown(bool down)
+    {
+        if (down) {
+            server.close();
+            for (QWebSocket* socket : sockets) {
+                socket->abort();
+            }
+        } else {
+            server.listen(QHostAddress::LocalHost, port);
+        }
+    }
+
+private:
+    void onConnection()
+    {
+        QWebSocket* socket = server.nextPendingConnection();
+        sockets.append(socket);
+        QObject::connect(socket, &QWebSocket::textMessageReceived, [socket](const QString& text) {
+            if (QJsonDocument::fromJson(text.toUtf8()).object().value("type").toString() == "hello") {
+                socket->sendTextMessage(R"({"type":"hello","transport":"websocket","version":2,"session_id":"ws-session"})");
+            }
+        });
+        QObject::connect(socket, &QWebSocket::binaryMessageReceived, [this, socket](const QByteArray& frame) {
+            qint64 due = clock.elapsed() + 2 * link.oneWayMs;
+            if (random.generateDouble() < link.lossRate) {
+                due += link.rtoMs;
+                ++retransmitted;
+            }
+            // TCP 按序交付：后面的帧不能早于前面的帧到达
+            due = qMax(due, lastDue);
+            lastDue = due;
+            delay.push(due, [socket, frame]() { socket->sendBinaryMessage(frame); });
+        });
+    }
+
+    QWebSocketServer server;
+    quint16 port = 0;
+    LinkModel link;
+    DelayLine delay;
+    const QElapsedTimer& clock;
+    QRandomGenerator random;
+    QList<QWebSocket*> sockets;
+    qint64 lastDue = 0;
+    int retransmitted = 0;
+};
+
+struct RunResult {
+    int sent = 0;
+    int received = 0;
+    int corrupt = 0;
+    QVector<double> latencies;
+
+    double percentile(double p) const
+    {
+        if (latencies.isEmpty()) {
+            return -1;
+        }
+        QVector<double> sorted = latencies;
+        std::sort(sorted.begin(), sorted.end());
+        const int index = qBound(0, static_cast<int>(p / 100.0 * sorted.size()), sorted.size() - 1);
+        return sorted[index];
+    }
+};
+
+static bool waitFor(const std::function<bool()>& condition, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition() && timer.elapsed() < timeoutMs) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    return condition();
+}
+
+// 每 20ms 发送一帧，负载前 4 字节为帧序号，其余为可校验的填充
+static RunResult runFrames(Transport& transport, const QString& url, int frames, int drainMs)
+{
+    RunResult result;
+    QVector<qint64> sentNs(frames, -1);
+    QElapsedTimer clock;
+    clock.start();
+
+    transport.setOnAudioPacketCallback([&](const QByteArray& payload, qint64) {
+        if (payload.size() < 4) {
+            ++result.corrupt;
+            return;
+        }
+        const int index = qFromBigEndian<qint32>(payload.constData());
+        bool intact = index >= 0 && index < frames;
+        for (int i = 4; intact && i < payload.size(); ++i) {
+            intact = static_cast<quint8>(payload[i]) == static_cast<quint8>(index + i);
+        }
+        if (!intact || sentNs[index] < 0) {
+            ++result.corrupt;
+            return;
+        }
+        ++result.received;
+        result.latencies.append((clock.nsecsElapsed() - sentNs[index]) / 1e6);
+    });
+
+    transport.connectToServer(url);
+    if (!waitFor([&]() { return transport.isConnected(); }, 5000)) {
+        qDebug() << "连接失败:" << url;
+        ++failures;
+        return result;
+    }
+
+    QTimer sender;
+    sender.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&sender, &QTimer::timeout, [&]() {
+        if (result.sent >= frames) {
+            sender.stop();
+            return;
+        }
+        QByteArray payload(60, 0);
+        qToBigEndian<qint32>(result.sent, payload.data());
+        for (int i = 4; i < payload.size(); ++i) {
+            payload[i] = static_cast<char>(static_cast<quint8>(result.sent + i));
+        }
+        sentNs[result.sent] = clock.nsecsElapsed();
+        transport.sendAudio(payload);
+        ++result.sent;
+    });
+    sender.start(20);
+
+    waitFor([&]() { return result.sent >= frames; }, frames * 40 + 5000);
+    waitFor([&]() { return false; }, drainMs);
+    transport.closeConnection();
+    transport.setOnAudioPacketCallback(nullptr);
+    return result;
+}
+
+static void printResult(const char* name, const RunResult& result)
+{
+    qDebug().noquote() << QString("  %1 收到 %2/%3  p50 %4 ms  p95 %5 ms  p99 %6 ms  最大 %7 ms")
+                          .arg(name, -10)
+                          .arg(result.received)
+                          .arg(result.sent)
+                          .arg(result.percentile(50), 0, 'f', 1)
+                          .arg(result.percentile(95), 0, 'f', 1)
+                          .arg(result.percentile(99), 0, 'f', 1)
+                          .arg(result.percentile(100), 0, 'f', 1);
+}
+
+static QByteArray fromHex(const char* hex)
+{
+    return QByteArray::fromHex(QByteArray(hex));
+}
+
+// NIST SP 800-38A F.5.1/F.5.2：CTR-AES128 加密和解密（同一操作）
+static void testAesCtrVector()
+{
+    AesCtr aes;
+    check(aes.setKey(fromHex("2b7e151628aed2a6abf7158809cf4f3c")), "AES 密钥");
+    const QByteArray iv = fromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    const QByteArray plain = fromHex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51");
+    const QByteArray cipher = fromHex("874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff");
+    QByteArray out(plain.size(), 0);
+    check(aes.apply(reinterpret_cast<const uchar*>(iv.constData()), plain.constData(), plain.size(), out.data())
+          && out == cipher, "AES-128-CTR 加密与 NIST 向量一致");
+    // 原地解密
+    check(aes.apply(reinterpret_cast<const uchar*>(iv.constData()), out.constData(), out.size(), out.data())
+          && out == plain, "AES-128-CTR 解密与 NIST 向量一致");
+}
+
+// 保活间隔为 0 时关闭保活：收到服务器 hello 后也不能启动定时器，
+// 否则 0ms 定时器连续发送 ping，立即超过允许丢失的响应数而断开
+static void testKeepAliveDisabled(const QElapsedTimer& clock)
+{
+    FakeWebSocketServer server(clock, LinkModel(), 1234);
+    WebSocketClient client;
+    client.setKeepAlive(0, 3);
+    QString error;
+    client.setOnErrorCallback([&](const QString& message) { error = message; });
+    client.connectToServer(server.url());
+    check(waitFor([&]() { return client.isConnected(); }, 5000), "保活关闭时应能连接");
+    waitFor([&]() { return !error.isEmpty() || !client.isConnected(); }, 500);
+    check(error.isEmpty() && client.isConnected(), "保活关闭时收到 hello 后不应断开: " + error);
+    client.closeConnection();
+    client.setOnErrorCallback(nullptr);
+}
+
+// 抖动的链路：连接保持 200-800ms 后断开，服务器再拒绝连接 0-1500ms。
+// 每次断线后 ConnectionManager 按退避自动重连，统计断线到收到 hello 的耗时
+static void testReconnectFlapping(const QElapsedTimer& clock, int flaps)
+{
+    FakeWebSocketServer server(clock, LinkModel(), 4321);
+    WebSocketClient client;
+    client.setKeepAlive(0, 3);
+    ConnectionManager manager(&client);
+    int reconnects = 0;
+    QObject::connect(&manager, &ConnectionManager::reconnected, [&reconnects](qint64) { ++reconnects; });
+
+    manager.start(server.url());
+    check(waitFor([&]() { return client.isConnected(); }, 5000), "抖动链路：首次连接");
+
+    QRandomGenerator random(4321);
+    qint64 maxDownMs = 0;
+    for (int i = 0; i < flaps; ++i) {
+        waitFor([]() { return false; }, 200 + random.bounded(600));
+        const int downMs = random.bounded(1500);
+        maxDownMs = qMax<qint64>(maxDownMs, downMs);
+        server.setDown(true);
+        waitFor([]() { return false; }, downMs);
+        server.setDown(false);
+        // 退避最多翻倍到 2 秒左右，这里的上限远大于正常的重连耗时
+        if (!waitFor([&]() { return reconnects == i + 1 && client.isConnected(); }, 20000)) {
+            check(false, QString("抖动链路：第 %1 次断线后没有重连").arg(i + 1));
+            break;
+        }
+    }
+    manager.stop();
+
+    check(manager.reconnectCount() == flaps, QString("抖动链路：重连 %1 次，应为 %2 次")
+          .arg(manager.reconnectCount()).arg(flaps));
+    qDebug().noquote() << QString("抖动链路 %1 次断线（拒绝连接最长 %2 ms）：重连耗时 p50 %3 ms  p95 %4 ms  最大 %5 ms")
+                          .arg(flaps).arg(maxDownMs)
+                          .arg(manager.reconnectPercentile(50))
+                          .arg(manager.reconnectPercentile(95))
+                          .arg(manager.reconnectPercentile(100));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const int frames = argc > 1 ? QString(argv[1]).toInt() : 250;
+    LinkModel link;
+    link.oneWayMs = argc > 2 ? QString(argv[2]).toInt() : 20;
+    link.rtoMs = argc > 3 ? QString(argv[3]).toInt() : 200;
+    const int drainMs = 2 * link.oneWayMs + 4 * link.rtoMs + 500;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    testAesCtrVector();
+    testKeepAliveDisabled(clock);
+    testReconnectFlapping(clock, argc > 4 ? QString(argv[4]).toInt() : 20);
+
+    struct Comparison {
+        double loss;
+        RunResult ws;
+        RunResult udp;
+    };
+    QVector<Comparison> comparisons;
+
+    const double lossRates[] = {0.0, 0.02, 0.05, 0.10};
+    for (double loss : lossRates) {
+        link.lossRate = loss;
+        qDebug().noquote() << QString("丢包率 %1%，单程延迟 %2 ms，RTO %3 ms")
+                              .arg(loss * 100, 0, 'f', 0).arg(link.oneWayMs).arg(link.rtoMs);
+
+        // WebSocket：丢失的帧重传后仍会到达，但延迟和后续帧一起增大
+        FakeWebSocketServer wsServer(clock, link, 1234);
+        WebSocketClient wsClient;
+        wsClient.setKeepAlive(0, 3);
+        const RunResult ws = runFrames(wsClient, wsServer.url(), frames, drainMs);
+        printResult("WebSocket", ws);
+        check(ws.received == ws.sent && ws.corrupt == 0, QString("WebSocket 丢包率 %1 时应全部按序到达").arg(loss));
+
+        // MQTT+UDP：丢失的帧不再到达，其余帧延迟不受影响
+        FakeMqttUdpServer udpServer(clock, link, 1234);
+        MqttConfig config;
+        config.endpoint = QString("127.0.0.1:%1").arg(udpServer.mqttPort());
+        config.clientId = "test-client";
+        config.publishTopic = "device/pub";
+        config.subscribeTopic = "device/sub";
+        MqttUdpTransport udpTransport;
+        udpTransport.setConfig(config);
+        udpTransport.setKeepAlive(0, 3);
+        const RunResult udp = runFrames(udpTransport, QString(), frames, drainMs);
+        printResult("MQTT+UDP", udp);
+
+        const QSet<quint32>& dropped = udpServer.droppedSequences();
+        check(udp.corrupt == 0 && udpTransport.malformedPackets() == 0, "UDP 解密后负载应完整");
+        check(udp.received + dropped.size() == udp.sent, "UDP 收到数 + 丢弃数应等于发送数");
+        // 序号从 1 开始；末尾连续丢失的包之后没有新包，无法按序号发现
+        quint32 lastDelivered = static_cast<quint32>(udp.sent);
+        while (dropped.contains(lastDelivered)) {
+            --lastDelivered;
+        }
+        qint64 detectable = 0;
+        for (quint32 sequence : dropped) {
+            if (sequence < lastDelivered) {
+                ++detectable;
+            }
+        }
+        check(udpTransport.sequenceLost() == detectable,
+              QString("按序号检测到的丢包 %1，应为 %2").arg(udpTransport.sequenceLost()).arg(detectable));
+        check(udpTransport.staleDropped() == 0, "UDP 回显按序，不应有过期包");
+        comparisons.append({loss, ws, udp});
+    }
+
+    qDebug().noquote() << QString("汇总（单程延迟 %1 ms，RTO %2 ms，每种 %3 帧），往返延迟 p50/p95/p99 ms：")
+                          .arg(link.oneWayMs).arg(link.rtoMs).arg(frames);
+    qDebug().noquote() << "  丢包率   WebSocket               MQTT+UDP                UDP 到达率";
+    for (const Comparison& c : comparisons) {
+        qDebug().noquote() << QString("  %1%   %2/%3/%4   %5/%6/%7   %8%")
+                              .arg(c.loss * 100, 4, 'f', 0)
+                              .arg(c.ws.percentile(50), 6, 'f', 1).arg(c.ws.percentile(95), 6, 'f', 1)
+                              .arg(c.ws.percentile(99), 6, 'f', 1)
+                              .arg(c.udp.percentile(50), 6, 'f', 1).arg(c.udp.percentile(95), 6, 'f', 1)
+                              .arg(c.udp.percentile(99), 6, 'f', 1)
+                              .arg(c.udp.sent > 0 ? 100.0 * c.udp.received / c.udp.sent : 0.0, 5, 'f', 1);
+        // UDP 只丢帧，到达的帧不等待重传；计时器在回环上的抖动留 RTO 的一半余量
+        check(c.udp.percentile(95) < 2 * link.oneWayMs + link.rtoMs / 2,
+              QString("丢包率 %1 时 UDP 的 p95 不应受丢包影响").arg(c.loss));
+        // RTO 较短时重传的影响和计时抖动相当，只在默认量级的 RTO 下检查
+        if (c.loss >= 0.05 && link.rtoMs >= 100) {
+            check(c.ws.percentile(95) > c.udp.percentile(95) + link.rtoMs / 2,
+                  QString("丢包率 %1 时 WebSocket 的 p95 应因重传明显高于 UDP").arg(c.loss));
+        }
+    }
+
+    if (failures > 0) {
+        qDebug() << "传输层测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "传输层测试通过";
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "vad_engine.h"
+
+// VAD 引擎测试：
+// 1. 概率与 libfvad 判决对应：概率不低于 0.5 的帧 fvad_process 必然判为语音
+// 2. 任意分块大小（1 个样本到数百毫秒）得到完全相同的概率和事件
+// 3. 合成的 "静音-语音-静音" 信号上，开始/结束事件落在真实边界附近，
+//    结束事件的判决延迟正好是拖尾时长
+// 4. 语音中的短停顿：拖尾长于停顿时只有一段，短于停顿时分成两段
+// 5. 对比原来 "连续 100 个非语音帧" 的判停方式，说话结束到判停的延迟
+
+const int RATE = 16000;
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+// 按段生成信号：voiced 为 true 的段落是带共振峰的浊音，其余只有弱底噪
+struct Segment {
+    double seconds;
+    bool voiced;
+};
+
+static std::vector<int16_t> synthesize(const std::vector<Segment>& segments, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::vector<int16_t> out;
+    double phase = 0.0;
+    double y[2][2] = {{0, 0}, {0, 0}};
+    for (const Segment& segment : segments) {
+        const size_t count = static_cast<size_t>(segment.seconds * RATE);
+        for (size_t i = 0; i < count; ++i) {
+            double sample = noise(rng) * 0.3;
+            phase += 120.0 / RATE;
+            if (phase >= 1.0) {
+                phase -= 1.0;
+                sample += 40.0;
+            }
+            const double freqs[2] = {600.0 + 200.0 * std::sin(out.size() * 2e-4), 1500.0};
+            for (int k = 0; k < 2; ++k) {
+                const double c = 2 * 0.97 * std::cos(2 * M_PI * freqs[k] / RATE);
+                const double v = sample + c * y[k][0] - 0.97 * 0.97 * y[k][1];
+                y[k][1] = y[k][0];
+                y[k][0] = v;
+                sample = v * 0.05;
+            }
+            const double value = (segment.voiced ? sample * 6000 : 0.0) + noise(rng) * 20;
+            out.push_back(static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, value))));
+        }
+    }
+    return out;
+}
+
+struct Result {
+    std::vector<float> probabilities;
+    std::vector<VadEngine::Event> events;
+};
+
+static Result run(const std::vector<int16_t>& signal, size_t chunk, const VadEngine::Config& config)
+{
+    VadEngine engine(config);
+    check(engine.isValid(), "创建引擎");
+    Result result;
+    for (size_t pos = 0; pos < signal.size(); pos += chunk) {
+        const size_t count = std::min(chunk, signal.size() - pos);
+        engine.process(signal.data() + pos, count, &result.probabilities, &result.events);
+    }
+    check(engine.samplesProcessed() == static_cast<qint64>(signal.size() / 160 * 160), "已处理样本数");
+    return result;
+}
+
+static void testProbability(const std::vector<int16_t>& signal)
+{
+    check(VadEngine::scoreToProbability(0) == 0.5f, "得分 0 对应概率 0.5");
+    check(VadEngine::scoreToProbability(-1) < 0.5f, "得分 -1 低于 0.5");
+    check(VadEngine::scoreToProbability(-32768) < 1e-6f, "静音帧概率接近 0");
+
+    // 关闭预门限，引擎内的 libfvad 实例与独立实例看到完全相同的帧
+    VadEngine::Config config;
+    config.gate = false;
+    const Result result = run(signal, 160, config);
+
+    // 独立实例的判决包含 libfvad 自身的拖尾，是引擎逐帧判决的超集
+    Fvad* vad = fvad_new();
+    fvad_set_sample_rate(vad, RATE);
+    fvad_set_mode(vad, config.mode);
+    size_t mismatches = 0, speech = 0;
+    for (size_t f = 0; f < result.probabilities.size(); ++f) {
+        const int decision = fvad_process(vad, &signal[f * 160], 160);
+        if (result.probabilities[f] >= 0.5f) {
+            ++speech;
+            mismatches += decision != 1;
+        }
+    }
+    fvad_free(vad);
+    check(mismatches == 0, "概率 >= 0.5 的帧 fvad_process 判为语音");
+    check(speech > 0 && speech < result.probabilities.size(), "同时有语音帧和非语音帧");
+}
+
+static void testChunking(const std::vector<int16_t>& signal)
+{
+    VadEngine::Config config;
+    const Result reference = run(signal, 160, config);
+    for (size_t chunk : {1, 37, 159, 161, 480, 960, 4801}) {
+        const Result result = run(signal, chunk, config);
+        bool same = result.probabilities == reference.probabilities
+                    && result.events.size() == reference.events.size();
+        for (size_t i = 0; same && i < result.events.size(); ++i) {
+            same = result.events[i].type == reference.events[i].type
+                   && result.events[i].sample == reference.events[i].sample
+                   && result.events[i].detectedAt == reference.events[i].detectedAt;
+        }
+        if (!same) {
+            qDebug() << "分块" << chunk << "样本时结果不同";
+        }
+        check(same, "分块大小不影响结果");
+    }
+}
+
+static void testEvents()
+{
+    const std::vector<int16_t> signal = synthesize({{1.0, false}, {1.5, true}, {1.5, false}}, 1);
+    VadEngine::Config config;
+    const Result result = run(signal, 960, config);
+
+    check(result.events.size() == 2, "一段语音产生一对事件");
+    if (result.events.size() != 2) {
+        return;
+    }
+    const VadEngine::Event& start = result.events[0];
+    const VadEngine::Event& end = result.events[1];
+    qDebug() << "语音开始:" << start.sample * 1000 / RATE << "ms（真实 1000ms），判决于" << start.detectedAt * 1000 / RATE << "ms";
+    qDebug() << "语音结束:" << end.sample * 1000 / RATE << "ms（真实 2500ms），判决于" << end.detectedAt * 1000 / RATE << "ms";
+    check(start.type == VadEngine::Event::SpeechStart && end.type == VadEngine::Event::SpeechEnd, "事件类型");
+    check(std::abs(start.sample - RATE) <= RATE * 30 / 1000, "开始位置误差不超过 30ms");
+    check(start.detectedAt - start.sample >= config.onsetMs * RATE / 1000, "开始判决至少晚起始时长");
+    check(std::abs(end.sample - RATE * 5 / 2) <= RATE * 30 / 1000, "结束位置误差不超过 30ms");
+    check(end.detectedAt - end.sample == config.hangoverMs * RATE / 1000, "结束判决延迟等于拖尾时长");
+}
+
+static void testHangover()
+{
+    // 语音中间停顿 300ms
+    const std::vector<int16_t> signal = synthesize({{0.5, false}, {1.0, true}, {0.3, false}, {1.0, true}, {1.0, false}}, 2);
+    VadEngine::Config config;
+    config.hangoverMs = 500;
+    check(run(signal, 320, config).events.size() == 2, "拖尾 500ms 时停顿 300ms 不断开");
+    config.hangoverMs = 150;
+    check(run(signal, 320, config).events.size() == 4, "拖尾 150ms 时停顿 300ms 分成两段");
+}
+
+// 原来的判停方式：10ms 帧 fvad_process（含 libfvad 自身拖尾）连续 100 帧为 0
+static qint64 legacyStopSample(const std::vector<int16_t>& signal, size_t speechEnd)
+{
+    Fvad* vad = fvad_new();
+    fvad_set_sample_rate(vad, RATE);
+    fvad_set_mode(vad, 2);
+    int silent = 0;
+    qint64 stop = -1;
+    for (size_t pos = 0; pos + 160 <= signal.size(); pos += 160) {
+        silent = fvad_process(vad, &signal[pos], 160) ? 0 : silent + 1;
+        if (pos >= speechEnd && silent >= 100) {
+            stop = pos + 160;
+            break;
+        }
+    }
+    fvad_free(vad);
+    return stop;
+}
+
+static void testLatency()
+{
+    const std::vector<int16_t> signal = synthesize({{1.0, false}, {1.5, true}, {2.5, false}}, 3);
+    const size_t speechEnd = RATE * 5 / 2;
+    const Result result = run(signal, 960, VadEngine::Config());
+    qint64 stop = -1;
+    for (const VadEngine::Event& event : result.events) {
+        if (event.type == VadEngine::Event::SpeechEnd) {
+            stop = event.detectedAt;
+        }
+    }
+    const qint64 legacy = legacyStopSample(signal, speechEnd);
+    check(stop > 0 && legacy > 0, "两种方式都判停");
+    qDebug() << "说话结束到判停: 原方式" << (legacy - static_cast<qint64>(speechEnd)) * 1000 / RATE
+             << "ms，VAD 引擎" << (stop - static_cast<qint64>(speechEnd)) * 1000 / RATE << "ms";
+    check(stop < legacy, "判停早于原方式");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const std::vector<int16_t> mixed = synthesize({{0.7, false}, {0.9, true}, {0.4, false}, {1.3, true}, {0.8, false}}, 4);
+    testProbability(mixed);
+    testChunking(mixed);
+    testEvents();
+    testHangover();
+    testLatency();
+
+    if (failures > 0) {
+        qDebug() << "VAD 引擎测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "VAD 引擎测试通过";
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "vad_engine.h"
+
+// VAD 预门限测试：长时间环境噪声（默认合成 10 分钟，`test_vad_gate ambient.pcm`
+// 改用 16kHz 单声道 s16le 录音）中每隔一段插入一句合成语音，
+// 对比打开/关闭能量和过零率预门限时：
+// 1. 跳过的帧比例和每帧耗时（CPU）
+// 2. 每句语音都被检测到，开始/结束位置与不开预门限时的差距
+// 3. 噪声段上多出或少掉的语音段数
+
+const int RATE = 16000;
+const int SPEECH_PERIOD_S = 20;  // 每 20 秒插入一句
+const double SPEECH_SECONDS = 1.5;
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+// 环境噪声：偏低频的宽带噪声（空调、风扇）+ 50Hz 工频嗡声，电平按分钟级缓慢起伏，
+// 偶尔有几十毫秒的敲击声
+static std::vector<int16_t> synthesizeAmbient(int seconds, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<int16_t> out(static_cast<size_t>(seconds) * RATE);
+    double low = 0.0, knock = 0.0;
+    for (size_t i = 0; i < out.size(); ++i) {
+        const double t = static_cast<double>(i) / RATE;
+        low = 0.9 * low + 0.45 * noise(rng);
+        const double level = 25.0 * std::pow(10.0, 0.3 * std::sin(2 * M_PI * t / 97.0));
+        if (uniform(rng) < 1.0 / (RATE * 30)) {
+            knock = 2000.0;  // 约每 30 秒一次
+        }
+        knock *= 0.995;
+        const double value = level * (low + 0.3 * noise(rng)) + 8.0 * std::sin(2 * M_PI * 50 * t)
+                             + knock * noise(rng);
+        out[i] = static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, value)));
+    }
+    return out;
+}
+
+// 合成浊音：基频脉冲串经过两个共振峰，音节之间有短暂停顿
+static void mixSpeech(std::vector<int16_t>& signal, size_t start, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    double phase = 0.0;
+    double y[2][2] = {{0, 0}, {0, 0}};
+    const size_t count = static_cast<size_t>(SPEECH_SECONDS * RATE);
+    for (size_t i = 0; i < count && start + i < signal.size(); ++i) {
+        double sample = noise(rng) * 0.3;
+        phase += (110.0 + 20.0 * std::sin(i * 1e-3)) / RATE;
+        if (phase >= 1.0) {
+            phase -= 1.0;
+            sample += 40.0;
+        }
+        const double freqs[2] = {500.0 + 300.0 * std::sin(i * 3e-4 + seed), 1400.0};
+        for (int k = 0; k < 2; ++k) {
+            const double c = 2 * 0.97 * std::cos(2 * M_PI * freqs[k] / RATE);
+            const double v = sample + c * y[k][0] - 0.97 * 0.97 * y[k][1];
+            y[k][1] = y[k][0];
+            y[k][0] = v;
+            sample = v * 0.05;
+        }
+        const double syllable = std::max(0.0, std::sin(M_PI * i / (0.25 * RATE)));
+        const double value = signal[start + i] + sample * 5000 * syllable;
+        signal[start + i] = static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, value)));
+    }
+}
+
+struct Segment {
+    qint64 start;
+    qint64 end;
+};
+
+struct Run {
+    std::vector<Segment> segments;
+    double nsPerFrame;
+    qint64 gated;
+    qint64 frames;
+};
+
+static Run runEngine(const std::vector<int16_t>& signal, bool gate)
+{
+    VadEngine::Config config;
+    config.gate = gate;
+    VadEngine engine(config);
+    std::vector<VadEngine::Event> events;
+    const size_t chunk = RATE * 60 / 1000;  // 与采集一致的 60ms 块
+
+    QElapsedTimer timer;
+    timer.start();
+    for (size_t pos = 0; pos < signal.size(); pos += chunk) {
+        engine.process(signal.data() + pos, std::min(chunk, signal.size() - pos), nullptr, &events);
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    Run run;
+    for (const VadEngine::Event& event : events) {
+        if (event.type == VadEngine::Event::SpeechStart) {
+            run.segments.push_back({event.sample, -1});
+        } else if (!run.segments.empty()) {
+            run.segments.back().end = event.sample;
+        }
+    }
+    run.frames = engine.totalFrames();
+    run.gated = engine.gatedFrames();
+    run.nsPerFrame = static_cast<double>(elapsed) / run.frames;
+    return run;
+}
+
+// 与真实语音区间重叠的段视为命中
+static bool overlaps(const Segment& segment, qint64 start, qint64 end)
+{
+    const qint64 segmentEnd = segment.end < 0 ? start + 1 : segment.end;
+    return segment.start < end && segmentEnd > start;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    std::vector<int16_t> signal;
+    if (argc > 1) {
+        QFile file(argv[1]);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qDebug() << "无法打开" << argv[1];
+            return 1;
+        }
+        const QByteArray data = file.readAll();
+        signal.assign(reinterpret_cast<const int16_t*>(data.constData()),
+                      reinterpret_cast<const int16_t*>(data.constData()) + data.size() / 2);
+    } else {
+        signal = synthesizeAmbient(600, 1);
+    }
+
+    std::vector<Segment> truth;
+    for (size_t s = SPEECH_PERIOD_S / 2; (s + 2) * RATE < signal.size(); s += SPEECH_PERIOD_S) {
+        mixSpeech(signal, s * RATE, static_cast<unsigned>(s));
+        truth.push_back({static_cast<qint64>(s * RATE), static_cast<qint64>((s + SPEECH_SECONDS) * RATE)});
+    }
+
+    // 先各跑一遍预热缓存，再取第二遍的耗时
+    runEngine(signal, false);
+    runEngine(signal, true);
+    const Run full = runEngine(signal, false);
+    const Run gated = runEngine(signal, true);
+
+    const double skipped = 100.0 * gated.gated / gated.frames;
+    qDebug().noquote() << QString("%1 秒音频，%2 句语音；预门限跳过 %3% 的帧")
+                              .arg(signal.size() / RATE).arg(truth.size()).arg(skipped, 0, 'f', 1);
+    qDebug().noquote() << QString("每帧耗时: 关闭 %1 ns，打开 %2 ns（%3x）；每小时音频 CPU: %4 s -> %5 s")
+                              .arg(full.nsPerFrame, 0, 'f', 0)
+                              .arg(gated.nsPerFrame, 0, 'f', 0)
+                              .arg(full.nsPerFrame / gated.nsPerFrame, 0, 'f', 2)
+                              .arg(full.nsPerFrame * 360000 / 1e9, 0, 'f', 2)
+                              .arg(gated.nsPerFrame * 360000 / 1e9, 0, 'f', 2);
+
+    // 每句语音：两种方式都要检测到，开始/结束位置的差距
+    int missedFull = 0, missedGated = 0;
+    qint64 maxStartDiff = 0, maxEndDiff = 0;
+    for (const Segment& speech : truth) {
+        const Segment* a = nullptr;
+        const Segment* b = nullptr;
+        for (const Segment& segment : full.segments) {
+            if (!a && overlaps(segment, speech.start, speech.end)) a = &segment;
+        }
+        for (const Segment& segment : gated.segments) {
+            if (!b && overlaps(segment, speech.start, speech.end)) b = &segment;
+        }
+        missedFull += a == nullptr;
+        missedGated += b == nullptr;
+        if (a && b) {
+            maxStartDiff = std::max(maxStartDiff, std::abs(a->start - b->start));
+            maxEndDiff = std::max(maxEndDiff, std::abs(a->end - b->end));
+        }
+    }
+    auto extra = [&truth](const Run& run) {
+        int count = 0;
+        for (const Segment& segment : run.segments) {
+            bool hit = false;
+            for (const Segment& speech : truth) {
+                hit = hit || overlaps(segment, speech.start, speech.end);
+            }
+            count += !hit;
+        }
+        return count;
+    };
+    qDebug().noquote() << QString("漏检: 关闭 %1 句，打开 %2 句；噪声误检: 关闭 %3 段，打开 %4 段")
+                              .arg(missedFull).arg(missedGated).arg(extra(full)).arg(extra(gated));
+    qDebug().noquote() << QString("开始/结束位置最大差距: %1 ms / %2 ms")
+                              .arg(maxStartDiff * 1000 / RATE).arg(maxEndDiff * 1000 / RATE);
+
+    check(missedGated <= missedFull, "预门限不增加漏检");
+    check(extra(gated) <= extra(full), "预门限不增加误检");
+    check(maxStartDiff <= RATE * 30 / 1000, "开始位置差距不超过 30ms");
+    if (argc <= 1) {
+        check(skipped > 50.0, "合成环境噪声中跳过一半以上的帧");
+        check(gated.nsPerFrame < full.nsPerFrame, "打开预门限后更省 CPU");
+    }
+
+    if (failures > 0) {
+        qDebug() << "VAD 预门限测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "VAD 预门限测试通过";
+    return 0;
+}
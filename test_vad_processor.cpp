@@ -0,0 +1,302 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QQueue>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "vad_processor.h"
+
+// VAD 处理线程测试（真实线程和事件循环）：
+// 1. 送入 "静音-语音-静音"：开始/结束事件各一次，带 reset() 的编号，位置在真实边界附近
+// 2. 大量语音排队时 reset()：重置前排队的音频被丢弃，引擎从头计数，
+//    重置前已取出的音频产生的事件只带旧编号，按编号过滤后不会误判
+// 3. 排空：每次送入都对应一次 processingFinished，stop() 之后送入的音频被忽略
+// 4. 给出实时节奏下每块从送入到处理完的延迟，以及一次送入大量音频时的处理速度
+//   test_vad_processor [实时送入的秒数]
+
+const int RATE = 16000;
+const int CHUNK_MS = 60;
+const int CHUNK_SAMPLES = RATE * CHUNK_MS / 1000;
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+// 按段生成信号：voiced 为 true 的段落是带共振峰的浊音，其余只有弱底噪
+struct Segment {
+    double seconds;
+    bool voiced;
+};
+
+static std::vector<int16_t> synthesize(const std::vector<Segment>& segments, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::vector<int16_t> out;
+    double phase = 0.0;
+    double y[2][2] = {{0, 0}, {0, 0}};
+    for (const Segment& segment : segments) {
+        const size_t count = static_cast<size_t>(segment.seconds * RATE);
+        for (size_t i = 0; i < count; ++i) {
+            double sample = noise(rng) * 0.3;
+            phase += 120.0 / RATE;
+            if (phase >= 1.0) {
+                phase -= 1.0;
+                sample += 40.0;
+            }
+            const double freqs[2] = {600.0 + 200.0 * std::sin(out.size() * 2e-4), 1500.0};
+            for (int k = 0; k < 2; ++k) {
+                const double c = 2 * 0.97 * std::cos(2 * M_PI * freqs[k] / RATE);
+                const double v = sample + c * y[k][0] - 0.97 * 0.97 * y[k][1];
+                y[k][1] = y[k][0];
+                y[k][0] = v;
+                sample = v * 0.05;
+            }
+            const double value = (segment.voiced ? sample * 6000 : 0.0) + noise(rng) * 20;
+            out.push_back(static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, value))));
+        }
+    }
+    return out;
+}
+
+static QVector<QByteArray> chunks(const std::vector<int16_t>& signal, int samples)
+{
+    QVector<QByteArray> result;
+    for (size_t offset = 0; offset < signal.size(); offset += samples) {
+        const size_t count = std::min(static_cast<size_t>(samples), signal.size() - offset);
+        result.append(QByteArray(reinterpret_cast<const char*>(signal.data() + offset),
+                                 static_cast<int>(count * sizeof(int16_t))));
+    }
+    return result;
+}
+
+// 在界面线程收集处理器的信号
+struct Recorder {
+    struct Event {
+        bool start;
+        qint64 sample;
+        qint64 delayMs;
+        int utterance;
+    };
+    QVector<Event> events;
+    int finished = 0;
+
+    void attach(VadProcessor& processor, QObject* context)
+    {
+        QObject::connect(&processor, &VadProcessor::speechStarted, context,
+                         [this](qint64 sample, int utterance) {
+            events.append({true, sample, 0, utterance});
+        });
+        QObject::connect(&processor, &VadProcessor::silenceDetected, context,
+                         [this](qint64 sample, qint64 delayMs, int utterance) {
+            events.append({false, sample, delayMs, utterance});
+        });
+        QObject::connect(&processor, &VadProcessor::processingFinished, context, [this]() {
+            ++finished;
+        });
+    }
+
+    QVector<Event> of(int utterance) const
+    {
+        QVector<Event> result;
+        for (const Event& event : events) {
+            if (event.utterance == utterance) {
+                result.append(event);
+            }
+        }
+        return result;
+    }
+};
+
+// 处理事件直到 done() 或超时，返回是否完成
+template <typename Predicate>
+static bool waitFor(Predicate done, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!done()) {
+        if (timer.elapsed() > timeoutMs) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        QThread::msleep(1);
+    }
+    return true;
+}
+
+static void waitMs(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+static QString summary(QVector<qint64> values)
+{
+    if (values.isEmpty()) {
+        return "无";
+    }
+    std::sort(values.begin(), values.end());
+    qint64 sum = 0;
+    for (qint64 value : values) {
+        sum += value;
+    }
+    return QString("平均 %1us，中位数 %2us，p95 %3us，最大 %4us（%5 块）")
+        .arg(sum / values.size()).arg(values[values.size() / 2])
+        .arg(values[values.size() * 95 / 100]).arg(values.last()).arg(values.size());
+}
+
+static void testFeed(QObject* context)
+{
+    VadProcessor processor;
+    Recorder recorder;
+    recorder.attach(processor, context);
+    processor.start();
+
+    const int utterance = processor.reset();
+    const QVector<QByteArray> audio = chunks(synthesize({{0.5, false}, {1.5, true}, {1.0, false}}, 1),
+                                             CHUNK_SAMPLES);
+    for (const QByteArray& chunk : audio) {
+        processor.processAudioData(chunk);
+    }
+    check(waitFor([&]() { return recorder.finished == audio.size(); }, 5000), "送入的音频全部处理完");
+
+    const QVector<Recorder::Event> events = recorder.of(utterance);
+    check(events.size() == 2 && events.size() == recorder.events.size(), "一次开始一次结束，都带本轮编号");
+    if (events.size() == 2) {
+        const VadEngine::Config config;
+        check(events[0].start && !events[1].start, "先开始后结束");
+        check(std::abs(events[0].sample - RATE / 2) <= RATE / 10, "开始位置在语音起点附近");
+        check(std::abs(events[1].sample - 2 * RATE) <= RATE / 10, "结束位置在语音终点附近");
+        check(std::abs(events[1].delayMs - config.hangoverMs) <= 20, "结束判决延迟为拖尾时长");
+        qDebug() << "开始位置误差" << (events[0].sample - RATE / 2) * 1000 / RATE << "ms，结束位置误差"
+                 << (events[1].sample - 2 * RATE) * 1000 / RATE << "ms，结束判决延迟" << events[1].delayMs << "ms";
+    }
+    processor.stop();
+}
+
+static void testResetDiscardsQueued(QObject* context)
+{
+    VadProcessor processor;
+    Recorder recorder;
+    recorder.attach(processor, context);
+    processor.start();
+
+    // 一次送入 10 秒连续语音（远超工作线程处理一块的时间），紧接着重置
+    const int oldUtterance = processor.reset();
+    const QVector<QByteArray> speech = chunks(synthesize({{10.0, true}}, 2), CHUNK_SAMPLES);
+    for (const QByteArray& chunk : speech) {
+        processor.processAudioData(chunk);
+    }
+    const int newUtterance = processor.reset();
+    check(newUtterance == oldUtterance + 1, "编号递增");
+
+    // 重置后：1 秒静音，再一句话
+    const QVector<QByteArray> after = chunks(synthesize({{1.0, false}, {1.0, true}, {1.0, false}}, 3),
+                                             CHUNK_SAMPLES);
+    for (const QByteArray& chunk : after) {
+        processor.processAudioData(chunk);
+    }
+    // 被清空的音频仍有一次排队调用，每次送入都对应一次 processingFinished
+    const int fed = speech.size() + after.size();
+    check(waitFor([&]() { return recorder.finished == fed; }, 5000), "排队调用全部完成");
+
+    // 重置前已取出的音频可能产生旧编号的开始事件，但不会有新编号的事件早于新的语音
+    const QVector<Recorder::Event> stale = recorder.of(oldUtterance);
+    const QVector<Recorder::Event> current = recorder.of(newUtterance);
+    check(stale.size() + current.size() == recorder.events.size(), "事件只带这两个编号");
+    for (const Recorder::Event& event : stale) {
+        check(event.start, "旧编号只可能有开始事件（语音未结束就被重置）");
+    }
+    check(current.size() == 2, "新编号一次开始一次结束");
+    if (current.size() == 2) {
+        // 引擎在重置后从 0 计数；若排队的 10 秒语音没有被丢弃，位置会偏后
+        check(current[0].start && std::abs(current[0].sample - RATE) <= RATE / 10,
+              "重置后的开始位置从新音频算起");
+        check(!current[1].start && std::abs(current[1].sample - 2 * RATE) <= RATE / 10,
+              "重置后的结束位置从新音频算起");
+    }
+    qDebug() << "重置前排队" << speech.size() << "块，旧编号事件" << stale.size() << "个，新编号事件"
+             << current.size() << "个";
+    processor.stop();
+}
+
+static void testDrain(QObject* context, int seconds)
+{
+    VadProcessor processor;
+    Recorder recorder;
+    recorder.attach(processor, context);
+    processor.start();
+    processor.reset();
+
+    // 实时节奏：每 CHUNK_MS 送入一块，记下送入到 processingFinished 的时间
+    const QVector<QByteArray> audio = chunks(synthesize({{seconds / 2.0, true}, {seconds / 2.0, false}}, 4),
+                                             CHUNK_SAMPLES);
+    QElapsedTimer clock;
+    clock.start();
+    QQueue<qint64> fedAt;
+    QVector<qint64> latencyUs;
+    QObject::connect(&processor, &VadProcessor::processingFinished, context, [&]() {
+        if (!fedAt.isEmpty()) {
+            latencyUs.append(clock.nsecsElapsed() / 1000 - fedAt.dequeue());
+        }
+    });
+    for (const QByteArray& chunk : audio) {
+        fedAt.enqueue(clock.nsecsElapsed() / 1000);
+        processor.processAudioData(chunk);
+        waitMs(CHUNK_MS);
+    }
+    check(waitFor([&]() { return recorder.finished == audio.size(); }, 5000), "实时送入的音频全部处理完");
+    qDebug() << "实时送入" << CHUNK_MS << "ms 块，送入到处理完:" << summary(latencyUs);
+
+    // 一次送入 60 秒音频，排空所需时间
+    const QVector<QByteArray> burst = chunks(synthesize({{30.0, true}, {30.0, false}}, 5), CHUNK_SAMPLES);
+    const int before = recorder.finished;
+    fedAt.clear();
+    QElapsedTimer timer;
+    timer.start();
+    for (const QByteArray& chunk : burst) {
+        processor.processAudioData(chunk);
+    }
+    check(waitFor([&]() { return recorder.finished == before + burst.size(); }, 30000), "积压的音频全部处理完");
+    const qint64 elapsedMs = qMax<qint64>(1, timer.elapsed());
+    qDebug() << "积压" << burst.size() << "块（60 秒音频）排空用时" << elapsedMs << "ms，实时的"
+             << 60000 / elapsedMs << "倍";
+
+    // 停止后送入的音频被忽略，不会再有 processingFinished
+    processor.stop();
+    const int stopped = recorder.finished;
+    processor.processAudioData(burst.first());
+    waitMs(100);
+    check(recorder.finished == stopped, "停止后忽略送入的音频");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int seconds = argc > 1 ? qMax(2, atoi(argv[1])) : 6;
+
+    testFeed(&app);
+    testResetDiscardsQueued(&app);
+    testDrain(&app, seconds);
+
+    if (failures > 0) {
+        qDebug() << "VAD 处理线程测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "VAD 处理线程测试通过";
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QTemporaryDir>
+#include "wake_word_matcher.h"
+#include "pinyin.h"
+
+// 唤醒词匹配测试（时间由测试注入）：
+// 1. 忽略空格按拼音模糊匹配，"小子小子" 等近音误识别不用列出，其他名字不匹配
+// 2. 编辑距离上限、拼音写法的唤醒词、配置中补充的读音
+// 3. 部分结果只处理变化的部分：重复的部分结果不会拼成 "小智小智"，改写后从分叉处重新匹配
+// 4. 端点之后的下一句在时间窗口内接着匹配，超过窗口重新开始
+// 5. 一次送入超过预算的长文本时只处理末尾
+// 6. 同一组时间戳和部分结果重复回放得到相同的判决
+// 7. 读取 JSON 配置文件
+// 8. 内置拼音表覆盖 GB2312 二级字，ü 写作 v，多音字取指令中常见的读音
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition) {
+        qDebug() << "检查失败:" << what;
+        ++failures;
+    }
+}
+
+static void testMatches()
+{
+    WakeWordMatcher matcher{WakeWordMatcher::Config()};
+    check(matcher.matches("你好 小智"), "忽略空格");
+    check(matcher.matches("嗯 小子 小子 在吗"), "近音误识别");
+    check(matcher.matches("尼好晓志"), "每个字都是近音字");
+    check(!matcher.matches("你好 小明"), "其他名字不匹配");
+    check(!matcher.matches("小事小事"), "不易混的声母不匹配");
+    check(!matcher.matches("你好小"), "缺少音节不匹配");
+
+    WakeWordMatcher::Config config;
+    config.patterns = QStringList{"小 智 同学"};
+    WakeWordMatcher custom(config);
+    check(custom.matches("小智同学"), "自定义唤醒词");
+    check(!custom.matches("你好小智"), "自定义后不再匹配默认唤醒词");
+}
+
+static void testDistance()
+{
+    WakeWordMatcher::Config exact;
+    exact.maxDistance = 0;
+    WakeWordMatcher matcher(exact);
+    check(matcher.matches("你好小智"), "距离 0 时精确匹配");
+    check(!matcher.matches("你好小子"), "距离 0 时不容错");
+
+    WakeWordMatcher::Config latin;
+    latin.patterns = QStringList{"xiao zhi tong xue"};
+    check(WakeWordMatcher(latin).matches("小知同学"), "拼音写法的唤醒词");
+
+    WakeWordMatcher::Config unknown;
+    unknown.patterns = QStringList{"你好小喆"};
+    WakeWordMatcher withoutPinyin(unknown);
+    check(withoutPinyin.warnings() == QStringList{"喆"}, "报告没有读音的字");
+    check(withoutPinyin.matches("你好小喆"), "没有读音的字按原字匹配");
+    unknown.pinyin.insert(QChar(0x5586), "zhe");  // 喆（不在 GB2312 中）
+    check(WakeWordMatcher(unknown).warnings().isEmpty(), "配置补充读音");
+}
+
+static void testIncremental()
+{
+    WakeWordMatcher matcher{WakeWordMatcher::Config()};
+    check(!matcher.feed("你", 0), "部分结果 1");
+    check(!matcher.feed("你好", 60), "部分结果 2");
+    check(!matcher.feed("你好 小", 120), "部分结果 3");
+    check(matcher.feed("你好 小子", 180), "部分结果增长到唤醒词");
+    check(matcher.matchedPattern() == "你好小智" && matcher.matchedDistance() == 1, "匹配的唤醒词和距离");
+    check(matcher.accumulatedText() == "你好小子", "当前一句");
+
+    // 同一句的部分结果重复出现不算说了两遍
+    matcher.reset(180);
+    check(!matcher.feed("小智", 240), "第一次部分结果");
+    check(!matcher.feed("小智", 300), "重复的部分结果");
+
+    // 末尾改写后从分叉处重新匹配
+    matcher.reset(300);
+    check(!matcher.feed("你好小事", 360), "改写前不匹配");
+    check(matcher.feed("你好小智", 420), "改写后匹配");
+}
+
+static void testWindow()
+{
+    WakeWordMatcher::Config config;
+    config.windowMs = 1000;
+    WakeWordMatcher matcher(config);
+
+    // "你好" 和 "小智" 被端点分成两句，间隔 600ms 在窗口内
+    check(!matcher.feed("你好", 100), "第一句不匹配");
+    matcher.endUtterance();
+    check(matcher.feed("小智", 700), "窗口内接着上一句匹配");
+
+    // 间隔 1600ms 超过窗口，上一句被丢弃
+    matcher.reset(700);
+    check(!matcher.feed("你好", 1000), "重置后第一句不匹配");
+    matcher.endUtterance();
+    check(!matcher.feed("小智", 2600), "超过窗口不拼接");
+}
+
+static void testBudget()
+{
+    WakeWordMatcher::Config config;
+    config.budgetSyllables = 4;
+    WakeWordMatcher matcher(config);
+    check(matcher.feed("今天天气很好我们出去玩吧你好小智", 0), "超出预算时末尾仍能匹配");
+    check(!matcher.feed("你好小智今天天气很好我们出去玩吧", 60), "超出预算的开头不再检查");
+}
+
+static void testReplay()
+{
+    // partial 为空表示端点
+    const struct {
+        qint64 ms;
+        const char* partial;
+    } steps[] = {{60, "你"}, {120, "你好"}, {900, "你好 小"}, {960, "你好 小子"}, {1500, ""},
+                 {2000, "小智"}, {2060, "小智"}, {2120, ""}, {2400, "小智"}};
+
+    QList<bool> first, second;
+    for (QList<bool>* decisions : {&first, &second}) {
+        WakeWordMatcher matcher{WakeWordMatcher::Config()};
+        for (const auto& step : steps) {
+            if (!*step.partial) {
+                matcher.endUtterance();
+                continue;
+            }
+            const bool detected = matcher.feed(QString::fromUtf8(step.partial), step.ms);
+            decisions->append(detected);
+            if (detected) {
+                matcher.reset(step.ms);
+            }
+        }
+    }
+    check(first == second, "回放结果可重复");
+    check(first.count(true) == 2, "两次触发");
+    check(first.last(), "两句各说一次小智");
+}
+
+static void testLoad()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("wake_words.json");
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write(R"({"wake_words": ["小喵小喵", "你好小智"], "max_distance": 1, "pinyin": {"喵": "MIAO"}})");
+    file.close();
+
+    WakeWordMatcher::Config config;
+    QString error;
+    check(WakeWordMatcher::Config::load(path, &config, &error), "读取配置");
+    check(config.patterns == QStringList({"小喵小喵", "你好小智"}), "唤醒词");
+    check(config.maxDistance == 1 && config.windowMs == WakeWordMatcher::Config().windowMs, "距离和默认窗口");
+    check(config.pinyin.value(QChar(0x55b5)) == "miao", "补充的读音");
+
+    file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    file.write("[1, 2");
+    file.close();
+    check(!WakeWordMatcher::Config::load(path, &config, &error) && !error.isEmpty(), "无效配置返回错误");
+    check(!WakeWordMatcher::Config::load(dir.filePath("missing.json"), &config, &error), "缺少文件返回错误");
+}
+
+static void testPinyin()
+{
+    check(Pinyin::of(QChar(0x55b5)) == "miao", "二级字");       // 喵
+    check(Pinyin::of(QChar(0x9a74)) == "lv", "ü 写作 v");       // 驴
+    check(Pinyin::of(QChar(0x8650)) == "nve", "üe 写作 ve");    // 虐
+    check(Pinyin::of(QChar(0x8c03)) == "tiao", "多音字覆盖");   // 调
+    check(Pinyin::of(QChar(0x5586)).isEmpty(), "GB2312 以外的字没有读音");  // 喆
+    check(Pinyin::of(QChar('a')).isEmpty(), "非汉字没有读音");
+
+    // 近音二级字的误识别（"小智" → "小痣"）也能匹配
+    check(WakeWordMatcher(WakeWordMatcher::Config()).matches("小痣小痣"), "二级字近音匹配");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    testMatches();
+    testDistance();
+    testIncremental();
+    testWindow();
+    testBudget();
+    testReplay();
+    testLoad();
+    testPinyin();
+
+    if (failures > 0) {
+        qDebug() << "唤醒词匹配测试失败:" << failures;
+        return 1;
+    }
+    qDebug() << "唤醒词匹配测试通过";
+    return 0;
+}
@@ -89,6 +89,81 @@ int fvad_set_sample_rate(Fvad* inst, int sample_rate);
  */
 int fvad_process(Fvad* inst, const int16_t* frame, size_t length);
 
+
+/*
+ * Returns the speech score of the last frame passed to fvad_process(), before
+ * the hangover that keeps reporting speech for a few frames after it ends.
+ *
+ * The score is the margin of the weighted log2 likelihood ratio of speech
+ * versus noise over the six sub-bands against the threshold of the current
+ * mode and frame length; it is non-negative exactly when the frame itself was
+ * classified as speech. One unit per sub-band and log2 step adds about 66
+ * (the sum of the band weights). Frames too quiet to be evaluated, and a
+ * fresh instance, give -32768.
+ */
+int fvad_get_speech_score(const Fvad* inst);
+
+
+/*
+ * Type for a batch of independent VAD streams, an opaque object created using
+ * fvad_batch_new(). The streams are processed together, several of them per
+ * SIMD instruction, and each stream gives exactly the decisions of its own
+ * Fvad instance fed with the same frames.
+ */
+typedef struct FvadBatch FvadBatch;
+
+/*
+ * Creates a batch of `num_streams` VAD streams, each initialized like
+ * fvad_new(). Mode and sample rate are shared by all streams.
+ *
+ * Returns NULL if `num_streams` is 0 or in case of a memory allocation error.
+ */
+FvadBatch *fvad_batch_new(size_t num_streams);
+
+/*
+ * Frees the dynamic memory of a batch.
+ */
+void fvad_batch_free(FvadBatch *batch);
+
+/*
+ * Returns the number of streams of a batch.
+ */
+size_t fvad_batch_num_streams(const FvadBatch *batch);
+
+/*
+ * Clears the state of stream `stream`, like fvad_reset() but keeping the
+ * batch mode and sample rate.
+ *
+ * Returns 0 on success, or -1 if `stream` is out of range.
+ */
+int fvad_batch_reset_stream(FvadBatch *batch, size_t stream);
+
+/*
+ * Changes the operating mode of all streams, see fvad_set_mode().
+ *
+ * Returns 0 on success, or -1 if the specified mode is invalid.
+ */
+int fvad_batch_set_mode(FvadBatch *batch, int mode);
+
+/*
+ * Sets the input sample rate in Hz of all streams, see fvad_set_sample_rate().
+ *
+ * Returns 0 on success, or -1 if the passed value is invalid.
+ */
+int fvad_batch_set_sample_rate(FvadBatch *batch, int sample_rate);
+
+/*
+ * Calculates a VAD decision for one frame of every stream.
+ *
+ * `frames` holds one pointer per stream to `length` samples; the length rules
+ * of fvad_process() apply. `decisions` receives one value per stream, 1 for
+ * active voice and 0 for non-active voice.
+ *
+ * Returns 0 on success, or -1 for an invalid frame length.
+ */
+int fvad_batch_process(FvadBatch *batch, const int16_t *const *frames,
+                       size_t length, int *decisions);
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,7 +12,10 @@
 #include "../include/fvad.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include "vad/vad_core.h"
+#include "vad/vad_batch.h"
+#include "signal_processing/signal_processing_library.h"
 
 // valid sample rates in kHz
 static const int valid_rates[] = { 8, 16, 32, 48 };
@@ -37,6 +40,9 @@ struct Fvad {
 
 Fvad *fvad_new(void)
 {
+    // pick the SIMD kernels for this CPU once per process
+    WebRtcSpl_Init();
+
     Fvad *inst = (Fvad *)malloc(sizeof *inst);
     if (inst) fvad_reset(inst);
     return inst;
@@ -105,3 +111,200 @@ int fvad_process(Fvad* inst, const int16_t* frame, size_t length)
 
     return rv;
 }
+
+
+int fvad_get_speech_score(const Fvad* inst)
+{
+    assert(inst);
+    return inst->core.speech_score;
+}
+
+
+struct FvadBatch {
+    size_t num_streams;
+    size_t num_groups;
+    size_t rate_idx;
+    VadBatchMode mode;
+    const VadBatchFunctions *funcs;
+    VadBatchGroup *groups;
+    // 48 kHz streams are resampled one by one, see WebRtcVad_CalcVad48khz()
+    WebRtcSpl_State48khzTo8khz *states_48_to_8;
+    // one group of frames in structure-of-arrays layout
+    LaneW16 frame[960];  // 30 ms at 32 kHz
+    LaneW16 frame_wb[480];
+    LaneW16 frame_nb[240];
+};
+
+
+FvadBatch *fvad_batch_new(size_t num_streams)
+{
+    if (num_streams == 0)
+        return NULL;
+
+    WebRtcSpl_Init();
+
+    FvadBatch *batch = (FvadBatch *)calloc(1, sizeof *batch);
+    if (!batch)
+        return NULL;
+    batch->num_streams = num_streams;
+    batch->num_groups = (num_streams + kBatchLanes - 1) / kBatchLanes;
+    batch->groups = (VadBatchGroup *)malloc(batch->num_groups *
+                                            sizeof *batch->groups);
+    batch->states_48_to_8 = (WebRtcSpl_State48khzTo8khz *)malloc(
+        num_streams * sizeof *batch->states_48_to_8);
+    if (!batch->groups || !batch->states_48_to_8) {
+        fvad_batch_free(batch);
+        return NULL;
+    }
+    batch->funcs = WebRtcVad_BatchFunctions();
+
+    // unused lanes of the last group run on silence like real streams
+    for (size_t group = 0; group < batch->num_groups; group++) {
+        for (int lane = 0; lane < kBatchLanes; lane++) {
+            VadInstT core;
+            int rv = WebRtcVad_InitCore(&core);
+            assert(rv == 0);
+            WebRtcVad_BatchSetLane(&batch->groups[group], lane, &core);
+            if (group == 0 && lane == 0)
+                WebRtcVad_BatchSetMode(&batch->mode, &core);
+        }
+    }
+    for (size_t i = 0; i < num_streams; i++)
+        WebRtcSpl_ResetResample48khzTo8khz(&batch->states_48_to_8[i]);
+    return batch;
+}
+
+
+void fvad_batch_free(FvadBatch *batch)
+{
+    if (!batch)
+        return;
+    free(batch->groups);
+    free(batch->states_48_to_8);
+    free(batch);
+}
+
+
+size_t fvad_batch_num_streams(const FvadBatch *batch)
+{
+    assert(batch);
+    return batch->num_streams;
+}
+
+
+int fvad_batch_reset_stream(FvadBatch *batch, size_t stream)
+{
+    assert(batch);
+    if (stream >= batch->num_streams)
+        return -1;
+
+    VadInstT core;
+    int rv = WebRtcVad_InitCore(&core);
+    assert(rv == 0);
+    WebRtcVad_BatchSetLane(&batch->groups[stream / kBatchLanes],
+                           (int)(stream % kBatchLanes), &core);
+    WebRtcSpl_ResetResample48khzTo8khz(&batch->states_48_to_8[stream]);
+    return 0;
+}
+
+
+int fvad_batch_set_mode(FvadBatch *batch, int mode)
+{
+    assert(batch);
+    VadInstT core;
+    int rv = WebRtcVad_set_mode_core(&core, mode);
+    assert(rv == 0 || rv == -1);
+    if (rv == 0)
+        WebRtcVad_BatchSetMode(&batch->mode, &core);
+    return rv;
+}
+
+
+int fvad_batch_set_sample_rate(FvadBatch *batch, int sample_rate)
+{
+    assert(batch);
+    for (size_t i = 0; i < arraysize(valid_rates); i++) {
+        if (valid_rates[i] * 1000 == sample_rate) {
+            batch->rate_idx = i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+
+// Transposes `length` samples of up to kBatchLanes streams into `out`,
+// filling the lanes without a stream with zeros.
+static void transpose_frames(const int16_t *const *frames, size_t streams,
+                             size_t length, LaneW16 *out)
+{
+    if (streams < kBatchLanes)
+        memset(out, 0, length * sizeof *out);
+    for (size_t lane = 0; lane < streams; lane++) {
+        const int16_t *frame = frames[lane];
+        for (size_t i = 0; i < length; i++)
+            out[i][lane] = frame[i];
+    }
+}
+
+
+int fvad_batch_process(FvadBatch *batch, const int16_t *const *frames,
+                       size_t length, int *decisions)
+{
+    assert(batch);
+    if (!valid_length(batch->rate_idx, length))
+        return -1;
+
+    const VadBatchFunctions *funcs = batch->funcs;
+    const size_t nb_length = length / (size_t)(valid_rates[batch->rate_idx] / 8);
+
+    for (size_t group = 0; group < batch->num_groups; group++) {
+        const size_t first = group * kBatchLanes;
+        const size_t remaining = batch->num_streams - first;
+        const size_t streams = remaining < kBatchLanes ? remaining : kBatchLanes;
+        VadBatchGroup *g = &batch->groups[group];
+        LaneW16 *nb = batch->frame_nb;
+        int16_t vad[kBatchLanes];
+
+        switch (valid_rates[batch->rate_idx]) {
+        case 8:
+            transpose_frames(&frames[first], streams, length, batch->frame_nb);
+            break;
+        case 16:
+            transpose_frames(&frames[first], streams, length, batch->frame);
+            funcs->downsampling(batch->frame, nb,
+                                g->downsampling_filter_states, length);
+            break;
+        case 32:
+            transpose_frames(&frames[first], streams, length, batch->frame);
+            funcs->downsampling(batch->frame, batch->frame_wb,
+                                &g->downsampling_filter_states[2], length);
+            funcs->downsampling(batch->frame_wb, nb,
+                                g->downsampling_filter_states, length / 2);
+            break;
+        default: {
+            // the resampler is not batched; do what WebRtcVad_CalcVad48khz()
+            // does per stream (it resamples the first 10 ms of longer frames
+            // again, kept for identical decisions), then transpose
+            int16_t speech_nb[kBatchLanes][240];
+            const int16_t *resampled[kBatchLanes];
+            for (size_t lane = 0; lane < streams; lane++) {
+                int32_t tmp_mem[480 + 256] = { 0 };
+                for (size_t i = 0; i < length / 480; i++) {
+                    WebRtcSpl_Resample48khzTo8khz(
+                        frames[first + lane], &speech_nb[lane][i * 80],
+                        &batch->states_48_to_8[first + lane], tmp_mem);
+                }
+                resampled[lane] = speech_nb[lane];
+            }
+            transpose_frames(resampled, streams, nb_length, nb);
+            break;
+        }
+        }
+
+        funcs->calc_vad_8khz(g, &batch->mode, nb, nb_length, vad);
+        for (size_t lane = 0; lane < streams; lane++)
+            decisions[first + lane] = vad[lane] > 0;
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * This file contains the function WebRtcSpl_AddSubW16C(), the last step of
+ * the band split in vad_filterbank.c.
+ * The description header can be found in signal_processing_library.h
+ *
+ */
+
+#include "signal_processing_library.h"
+
+void WebRtcSpl_AddSubW16C(int16_t* hp, int16_t* lp, size_t length)
+{
+    size_t i;
+    int16_t tmp_out;
+
+    for (i = 0; i < length; i++)
+    {
+        tmp_out = *hp;
+        *hp++ -= *lp;
+        *lp++ += tmp_out;
+    }
+}
@@ -10,21 +10,21 @@
 
 
 /*
- * This file contains the function WebRtcSpl_Energy().
+ * This file contains the function WebRtcSpl_EnergyC().
  * The description header can be found in signal_processing_library.h
  *
  */
 
 #include "signal_processing_library.h"
 
-int32_t WebRtcSpl_Energy(int16_t* vector,
-                         size_t vector_length,
-                         int* scale_factor)
+int32_t WebRtcSpl_EnergyC(int16_t* vector,
+                          size_t vector_length,
+                          int* scale_factor)
 {
     int32_t en = 0;
     size_t i;
     int scaling =
-        WebRtcSpl_GetScalingSquare(vector, vector_length, vector_length);
+        WebRtcSpl_GetScalingSquareC(vector, vector_length, vector_length);
     size_t looptimes = vector_length;
     int16_t *vectorptr = vector;
 
@@ -33,18 +33,95 @@
 // inline functions:
 #include "spl_inl.h"
 
-int16_t WebRtcSpl_GetScalingSquare(int16_t* in_vector,
-                                   size_t in_vector_length,
-                                   size_t times);
+/*
+ * Initialize SPL. Selects the fastest implementation of the function pointers
+ * below for the running CPU (SSE4.1/AVX2 on x86, NEON on ARM). All versions
+ * give bit-exact results. Called by fvad_new(); safe to call more than once.
+ */
+void WebRtcSpl_Init(void);
+
+// CPU features used for selecting the implementations.
+enum {
+  kSplCpuSse41 = 1 << 0,
+  kSplCpuAvx2 = 1 << 1,
+  kSplCpuNeon = 1 << 2,
+};
+
+// Returns the features that are both compiled in and supported by the CPU.
+int WebRtcSpl_CpuFeatures(void);
+
+// Selects the implementations as if only |features| (masked with
+// WebRtcSpl_CpuFeatures()) were available; 0 selects the generic C versions.
+// For tests and benchmarks only: call WebRtcSpl_Init() first so that a later
+// fvad_new() keeps this choice, and do not race with VAD processing.
+void WebRtcSpl_InitWithFeatures(int features);
+
+// Returns the features of the implementations currently selected.
+int WebRtcSpl_SelectedFeatures(void);
+
+// Scaling for summing |times| squares of values whose largest magnitude is
+// |smax|. The vectorized WebRtcSpl_GetScalingSquare() versions find |smax| and
+// finish here, exactly like the C version (-32768 wraps and is never the max).
+static __inline int16_t WebRtcSpl_ScalingForMaxAbs(int16_t smax, size_t times) {
+  int16_t nbits = WebRtcSpl_GetSizeInBits((uint32_t)times);
+  int16_t t = WebRtcSpl_NormW32(WEBRTC_SPL_MUL(smax, smax));
+  if (smax == 0) {
+    return 0;  // Since norm(0) returns 0
+  }
+  return (t > nbits) ? 0 : nbits - t;
+}
+
+// Returns the number of right shifts needed so that summing |times| squares
+// of |in_vector| elements does not overflow 32 bits.
+typedef int16_t (*GetScalingSquare)(int16_t* in_vector,
+                                    size_t in_vector_length,
+                                    size_t times);
+extern GetScalingSquare WebRtcSpl_GetScalingSquare;
+int16_t WebRtcSpl_GetScalingSquareC(int16_t* in_vector,
+                                    size_t in_vector_length,
+                                    size_t times);
+int16_t WebRtcSpl_GetScalingSquareSSE41(int16_t* in_vector,
+                                        size_t in_vector_length,
+                                        size_t times);
+int16_t WebRtcSpl_GetScalingSquareAVX2(int16_t* in_vector,
+                                       size_t in_vector_length,
+                                       size_t times);
+int16_t WebRtcSpl_GetScalingSquareNeon(int16_t* in_vector,
+                                       size_t in_vector_length,
+                                       size_t times);
 
 // Divisions. Implementations collected in division_operations.c and
 // descriptions at bottom of this file.
 int32_t WebRtcSpl_DivW32W16(int32_t num, int16_t den);
 // End: Divisions.
 
-int32_t WebRtcSpl_Energy(int16_t* vector,
-                         size_t vector_length,
-                         int* scale_factor);
+// Energy of |vector|, each square right shifted by |scale_factor| which is
+// chosen by WebRtcSpl_GetScalingSquare().
+typedef int32_t (*Energy)(int16_t* vector,
+                          size_t vector_length,
+                          int* scale_factor);
+extern Energy WebRtcSpl_Energy;
+int32_t WebRtcSpl_EnergyC(int16_t* vector,
+                          size_t vector_length,
+                          int* scale_factor);
+int32_t WebRtcSpl_EnergySSE41(int16_t* vector,
+                              size_t vector_length,
+                              int* scale_factor);
+int32_t WebRtcSpl_EnergyAVX2(int16_t* vector,
+                             size_t vector_length,
+                             int* scale_factor);
+int32_t WebRtcSpl_EnergyNeon(int16_t* vector,
+                             size_t vector_length,
+                             int* scale_factor);
+
+// Band split butterfly: hp[i] = hp[i] - lp[i] and lp[i] = lp[i] + hp[i]
+// (using the old hp[i]), both wrapping to 16 bits.
+typedef void (*AddSubW16)(int16_t* hp, int16_t* lp, size_t length);
+extern AddSubW16 WebRtcSpl_AddSubW16;
+void WebRtcSpl_AddSubW16C(int16_t* hp, int16_t* lp, size_t length);
+void WebRtcSpl_AddSubW16SSE41(int16_t* hp, int16_t* lp, size_t length);
+void WebRtcSpl_AddSubW16AVX2(int16_t* hp, int16_t* lp, size_t length);
+void WebRtcSpl_AddSubW16Neon(int16_t* hp, int16_t* lp, size_t length);
 
 
 /************************************************************
@@ -0,0 +1,137 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * AVX2 versions of WebRtcSpl_GetScalingSquare(), WebRtcSpl_Energy() and
+ * WebRtcSpl_AddSubW16(). This file is compiled with -mavx2 and the functions
+ * are only called when the CPU and OS support it (see spl_init.c). The band
+ * split remainder goes to the SSE4.1 version, which AVX2 implies.
+ * The results are bit-exact with the C versions.
+ *
+ */
+
+#include <immintrin.h>
+
+#include "signal_processing_library.h"
+
+// Horizontal maximum of 16 int16_t lanes and of |extra|.
+static int16_t HorizontalMaxW16(__m256i v, __m128i extra) {
+  __m128i m = _mm_max_epi16(_mm256_castsi256_si128(v),
+                            _mm256_extracti128_si256(v, 1));
+  m = _mm_max_epi16(m, extra);
+  m = _mm_max_epi16(m, _mm_srli_si128(m, 8));
+  m = _mm_max_epi16(m, _mm_srli_si128(m, 4));
+  m = _mm_max_epi16(m, _mm_srli_si128(m, 2));
+  return (int16_t)_mm_cvtsi128_si32(m);
+}
+
+// Horizontal sum of 8 int32_t lanes and of |extra|, wrapping like the C
+// accumulator.
+static int32_t HorizontalSumW32(__m256i v, __m128i extra) {
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v),
+                            _mm256_extracti128_si256(v, 1));
+  s = _mm_add_epi32(s, extra);
+  s = _mm_add_epi32(s, _mm_srli_si128(s, 8));
+  s = _mm_add_epi32(s, _mm_srli_si128(s, 4));
+  return _mm_cvtsi128_si32(s);
+}
+
+// Largest |x| over the vector; see MaxAbsW16() in spl_sse41.c. The VAD bands
+// are 10 to 120 samples long, so an 8 sample step is taken before the scalar
+// remainder.
+static int16_t MaxAbsW16(const int16_t* vector, size_t length) {
+  __m256i vmax = _mm256_set1_epi16(-1);
+  __m128i extra = _mm_set1_epi16(-1);
+  int16_t smax;
+  size_t i = 0;
+
+  for (; i + 16 <= length; i += 16) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)&vector[i]);
+    vmax = _mm256_max_epi16(vmax, _mm256_abs_epi16(v));
+  }
+  if (i + 8 <= length) {
+    extra = _mm_abs_epi16(_mm_loadu_si128((const __m128i*)&vector[i]));
+    i += 8;
+  }
+  smax = HorizontalMaxW16(vmax, extra);
+
+  for (; i < length; i++) {
+    int16_t sabs = (int16_t)(vector[i] > 0 ? vector[i] : -vector[i]);
+    smax = (sabs > smax ? sabs : smax);
+  }
+  return smax;
+}
+
+int16_t WebRtcSpl_GetScalingSquareAVX2(int16_t* in_vector,
+                                       size_t in_vector_length,
+                                       size_t times) {
+  return WebRtcSpl_ScalingForMaxAbs(MaxAbsW16(in_vector, in_vector_length),
+                                    times);
+}
+
+int32_t WebRtcSpl_EnergyAVX2(int16_t* vector,
+                             size_t vector_length,
+                             int* scale_factor) {
+  int scaling = WebRtcSpl_ScalingForMaxAbs(
+      MaxAbsW16(vector, vector_length), vector_length);
+  __m256i acc = _mm256_setzero_si256();
+  __m128i extra = _mm_setzero_si128();
+  int32_t en;
+  size_t i = 0;
+
+  if (scaling == 0) {
+    for (; i + 16 <= vector_length; i += 16) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)&vector[i]);
+      acc = _mm256_add_epi32(acc, _mm256_madd_epi16(v, v));
+    }
+    if (i + 8 <= vector_length) {
+      __m128i v = _mm_loadu_si128((const __m128i*)&vector[i]);
+      extra = _mm_madd_epi16(v, v);
+      i += 8;
+    }
+  } else {
+    __m128i shift = _mm_cvtsi32_si128(scaling);
+    for (; i + 16 <= vector_length; i += 16) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)&vector[i]);
+      __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v));
+      __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1));
+      lo = _mm256_sra_epi32(_mm256_mullo_epi32(lo, lo), shift);
+      hi = _mm256_sra_epi32(_mm256_mullo_epi32(hi, hi), shift);
+      acc = _mm256_add_epi32(acc, _mm256_add_epi32(lo, hi));
+    }
+    if (i + 8 <= vector_length) {
+      __m256i v = _mm256_cvtepi16_epi32(
+          _mm_loadu_si128((const __m128i*)&vector[i]));
+      v = _mm256_sra_epi32(_mm256_mullo_epi32(v, v), shift);
+      acc = _mm256_add_epi32(acc, v);
+      i += 8;
+    }
+  }
+  en = HorizontalSumW32(acc, extra);
+
+  for (; i < vector_length; i++) {
+    en += (vector[i] * vector[i]) >> scaling;
+  }
+  *scale_factor = scaling;
+  return en;
+}
+
+void WebRtcSpl_AddSubW16AVX2(int16_t* hp, int16_t* lp, size_t length) {
+  size_t i = 0;
+
+  for (; i + 16 <= length; i += 16) {
+    __m256i h = _mm256_loadu_si256((const __m256i*)&hp[i]);
+    __m256i l = _mm256_loadu_si256((const __m256i*)&lp[i]);
+    _mm256_storeu_si256((__m256i*)&hp[i], _mm256_sub_epi16(h, l));
+    _mm256_storeu_si256((__m256i*)&lp[i], _mm256_add_epi16(l, h));
+  }
+  WebRtcSpl_AddSubW16SSE41(&hp[i], &lp[i], length - i);
+}
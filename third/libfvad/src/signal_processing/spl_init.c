@@ -0,0 +1,120 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/* The global function contained in this file initializes SPL function
+ * pointers, currently only for SSE4.1/AVX2 on x86 and NEON on ARM.
+ *
+ * The SIMD versions are compiled in when the build defines WEBRTC_HAS_SSE41,
+ * WEBRTC_HAS_AVX2 or WEBRTC_HAS_NEON, and selected at run time only if the
+ * CPU supports them. Until WebRtcSpl_Init() runs the C versions are used.
+ */
+
+#include "signal_processing_library.h"
+
+#if defined(WEBRTC_HAS_NEON) && defined(__arm__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#if defined(WEBRTC_POSIX)
+#include <pthread.h>
+#endif
+
+/* Declare function pointers. */
+GetScalingSquare WebRtcSpl_GetScalingSquare = WebRtcSpl_GetScalingSquareC;
+Energy WebRtcSpl_Energy = WebRtcSpl_EnergyC;
+AddSubW16 WebRtcSpl_AddSubW16 = WebRtcSpl_AddSubW16C;
+
+static int selected_features = 0;
+
+int WebRtcSpl_CpuFeatures(void) {
+  int features = 0;
+#if (defined(WEBRTC_HAS_SSE41) || defined(WEBRTC_HAS_AVX2)) && \
+    defined(__GNUC__)
+  __builtin_cpu_init();
+#endif
+#if defined(WEBRTC_HAS_SSE41) && defined(__GNUC__)
+  if (__builtin_cpu_supports("sse4.1")) {
+    features |= kSplCpuSse41;
+  }
+#endif
+#if defined(WEBRTC_HAS_AVX2) && defined(__GNUC__)
+  // Also checks that the OS saves the YMM registers. The AVX2 versions fall
+  // back to the SSE4.1 ones for short remainders.
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.1")) {
+    features |= kSplCpuAvx2;
+  }
+#endif
+#if defined(WEBRTC_HAS_NEON)
+#if defined(__aarch64__)
+  features |= kSplCpuNeon;
+#elif defined(__arm__) && defined(__linux__)
+  if (getauxval(AT_HWCAP) & HWCAP_NEON) {
+    features |= kSplCpuNeon;
+  }
+#endif
+#endif
+  return features;
+}
+
+void WebRtcSpl_InitWithFeatures(int features) {
+  features &= WebRtcSpl_CpuFeatures();
+  selected_features = features;
+
+  WebRtcSpl_GetScalingSquare = WebRtcSpl_GetScalingSquareC;
+  WebRtcSpl_Energy = WebRtcSpl_EnergyC;
+  WebRtcSpl_AddSubW16 = WebRtcSpl_AddSubW16C;
+
+#if defined(WEBRTC_HAS_SSE41)
+  if (features & kSplCpuSse41) {
+    WebRtcSpl_GetScalingSquare = WebRtcSpl_GetScalingSquareSSE41;
+    WebRtcSpl_Energy = WebRtcSpl_EnergySSE41;
+    WebRtcSpl_AddSubW16 = WebRtcSpl_AddSubW16SSE41;
+  }
+#endif
+#if defined(WEBRTC_HAS_AVX2) && defined(WEBRTC_HAS_SSE41)
+  if ((features & kSplCpuAvx2) && (features & kSplCpuSse41)) {
+    WebRtcSpl_GetScalingSquare = WebRtcSpl_GetScalingSquareAVX2;
+    WebRtcSpl_Energy = WebRtcSpl_EnergyAVX2;
+    WebRtcSpl_AddSubW16 = WebRtcSpl_AddSubW16AVX2;
+  }
+#endif
+#if defined(WEBRTC_HAS_NEON)
+  if (features & kSplCpuNeon) {
+    WebRtcSpl_GetScalingSquare = WebRtcSpl_GetScalingSquareNeon;
+    WebRtcSpl_Energy = WebRtcSpl_EnergyNeon;
+    WebRtcSpl_AddSubW16 = WebRtcSpl_AddSubW16Neon;
+  }
+#endif
+}
+
+int WebRtcSpl_SelectedFeatures(void) {
+  return selected_features;
+}
+
+static void InitFunctionPointers(void) {
+  WebRtcSpl_InitWithFeatures(WebRtcSpl_CpuFeatures());
+}
+
+#if defined(WEBRTC_POSIX)
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+void WebRtcSpl_Init(void) {
+  pthread_once(&once, InitFunctionPointers);
+}
+#else
+void WebRtcSpl_Init(void) {
+  static int initialized = 0;
+  if (!initialized) {
+    InitFunctionPointers();
+    initialized = 1;
+  }
+}
+#endif
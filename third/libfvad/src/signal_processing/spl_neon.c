@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * NEON versions of WebRtcSpl_GetScalingSquare(), WebRtcSpl_Energy() and
+ * WebRtcSpl_AddSubW16(). NEON is always available on AArch64; on 32-bit ARM
+ * this file is compiled with -mfpu=neon and the functions are only called
+ * when the CPU supports it (see spl_init.c).
+ * The results are bit-exact with the C versions.
+ *
+ */
+
+#include <arm_neon.h>
+
+#include "signal_processing_library.h"
+
+static int16_t HorizontalMaxW16(int16x8_t v) {
+#if defined(__aarch64__)
+  return vmaxvq_s16(v);
+#else
+  int16x4_t m = vpmax_s16(vget_low_s16(v), vget_high_s16(v));
+  m = vpmax_s16(m, m);
+  m = vpmax_s16(m, m);
+  return vget_lane_s16(m, 0);
+#endif
+}
+
+static int32_t HorizontalSumW32(int32x4_t v) {
+#if defined(__aarch64__)
+  return vaddvq_s32(v);
+#else
+  int32x2_t s = vadd_s32(vget_low_s32(v), vget_high_s32(v));
+  s = vpadd_s32(s, s);
+  return vget_lane_s32(s, 0);
+#endif
+}
+
+// Largest |x| over the vector; vabsq_s16() wraps -32768 to -32768 like the
+// int16_t negation in the C version, so it never becomes the maximum.
+static int16_t MaxAbsW16(const int16_t* vector, size_t length) {
+  int16x8_t vmax = vdupq_n_s16(-1);
+  int16_t smax;
+  size_t i = 0;
+
+  for (; i + 8 <= length; i += 8) {
+    vmax = vmaxq_s16(vmax, vabsq_s16(vld1q_s16(&vector[i])));
+  }
+  smax = HorizontalMaxW16(vmax);
+
+  for (; i < length; i++) {
+    int16_t sabs = (int16_t)(vector[i] > 0 ? vector[i] : -vector[i]);
+    smax = (sabs > smax ? sabs : smax);
+  }
+  return smax;
+}
+
+int16_t WebRtcSpl_GetScalingSquareNeon(int16_t* in_vector,
+                                       size_t in_vector_length,
+                                       size_t times) {
+  return WebRtcSpl_ScalingForMaxAbs(MaxAbsW16(in_vector, in_vector_length),
+                                    times);
+}
+
+int32_t WebRtcSpl_EnergyNeon(int16_t* vector,
+                             size_t vector_length,
+                             int* scale_factor) {
+  int scaling = WebRtcSpl_ScalingForMaxAbs(
+      MaxAbsW16(vector, vector_length), vector_length);
+  // vshlq_s32() with a negative count is an arithmetic right shift.
+  int32x4_t shift = vdupq_n_s32(-scaling);
+  int32x4_t acc = vdupq_n_s32(0);
+  int32_t en;
+  size_t i = 0;
+
+  for (; i + 8 <= vector_length; i += 8) {
+    int16x8_t v = vld1q_s16(&vector[i]);
+    int32x4_t lo = vmull_s16(vget_low_s16(v), vget_low_s16(v));
+    int32x4_t hi = vmull_s16(vget_high_s16(v), vget_high_s16(v));
+    acc = vaddq_s32(acc, vshlq_s32(lo, shift));
+    acc = vaddq_s32(acc, vshlq_s32(hi, shift));
+  }
+  en = HorizontalSumW32(acc);
+
+  for (; i < vector_length; i++) {
+    en += (vector[i] * vector[i]) >> scaling;
+  }
+  *scale_factor = scaling;
+  return en;
+}
+
+void WebRtcSpl_AddSubW16Neon(int16_t* hp, int16_t* lp, size_t length) {
+  size_t i = 0;
+
+  for (; i + 8 <= length; i += 8) {
+    int16x8_t h = vld1q_s16(&hp[i]);
+    int16x8_t l = vld1q_s16(&lp[i]);
+    vst1q_s16(&hp[i], vsubq_s16(h, l));
+    vst1q_s16(&lp[i], vaddq_s16(l, h));
+  }
+  WebRtcSpl_AddSubW16C(&hp[i], &lp[i], length - i);
+}
@@ -0,0 +1,102 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * SSE4.1 versions of WebRtcSpl_GetScalingSquare(), WebRtcSpl_Energy() and
+ * WebRtcSpl_AddSubW16(). This file is compiled with -msse4.1 and the
+ * functions are only called when the CPU supports it (see spl_init.c).
+ * The results are bit-exact with the C versions.
+ *
+ */
+
+#include <smmintrin.h>
+
+#include "signal_processing_library.h"
+
+// Largest |x| over the vector; _mm_abs_epi16() wraps -32768 to -32768 like
+// the int16_t negation in the C version, so it never becomes the maximum.
+static int16_t MaxAbsW16(const int16_t* vector, size_t length) {
+  __m128i vmax = _mm_set1_epi16(-1);
+  int16_t smax;
+  size_t i = 0;
+
+  for (; i + 8 <= length; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)&vector[i]);
+    vmax = _mm_max_epi16(vmax, _mm_abs_epi16(v));
+  }
+  vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 8));
+  vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 4));
+  vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 2));
+  smax = (int16_t)_mm_cvtsi128_si32(vmax);
+
+  for (; i < length; i++) {
+    int16_t sabs = (int16_t)(vector[i] > 0 ? vector[i] : -vector[i]);
+    smax = (sabs > smax ? sabs : smax);
+  }
+  return smax;
+}
+
+int16_t WebRtcSpl_GetScalingSquareSSE41(int16_t* in_vector,
+                                        size_t in_vector_length,
+                                        size_t times) {
+  return WebRtcSpl_ScalingForMaxAbs(MaxAbsW16(in_vector, in_vector_length),
+                                    times);
+}
+
+int32_t WebRtcSpl_EnergySSE41(int16_t* vector,
+                              size_t vector_length,
+                              int* scale_factor) {
+  int scaling = WebRtcSpl_ScalingForMaxAbs(
+      MaxAbsW16(vector, vector_length), vector_length);
+  __m128i acc = _mm_setzero_si128();
+  int32_t en;
+  size_t i = 0;
+
+  if (scaling == 0) {
+    // Without scaling the squares of a pair can be summed directly.
+    for (; i + 8 <= vector_length; i += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i*)&vector[i]);
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(v, v));
+    }
+  } else {
+    // Each square is shifted before summing, as in the C version.
+    __m128i shift = _mm_cvtsi32_si128(scaling);
+    for (; i + 8 <= vector_length; i += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i*)&vector[i]);
+      __m128i lo = _mm_cvtepi16_epi32(v);
+      __m128i hi = _mm_cvtepi16_epi32(_mm_srli_si128(v, 8));
+      lo = _mm_sra_epi32(_mm_mullo_epi32(lo, lo), shift);
+      hi = _mm_sra_epi32(_mm_mullo_epi32(hi, hi), shift);
+      acc = _mm_add_epi32(acc, _mm_add_epi32(lo, hi));
+    }
+  }
+  acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+  acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 4));
+  en = _mm_cvtsi128_si32(acc);
+
+  for (; i < vector_length; i++) {
+    en += (vector[i] * vector[i]) >> scaling;
+  }
+  *scale_factor = scaling;
+  return en;
+}
+
+void WebRtcSpl_AddSubW16SSE41(int16_t* hp, int16_t* lp, size_t length) {
+  size_t i = 0;
+
+  for (; i + 8 <= length; i += 8) {
+    __m128i h = _mm_loadu_si128((const __m128i*)&hp[i]);
+    __m128i l = _mm_loadu_si128((const __m128i*)&lp[i]);
+    _mm_storeu_si128((__m128i*)&hp[i], _mm_sub_epi16(h, l));
+    _mm_storeu_si128((__m128i*)&lp[i], _mm_add_epi16(l, h));
+  }
+  WebRtcSpl_AddSubW16C(&hp[i], &lp[i], length - i);
+}
@@ -0,0 +1,89 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// Generic C version of the batched VAD, plus the lane setup and the
+// selection of the SSE4.1/AVX2 builds of the same code.
+
+#include <string.h>
+
+#define VAD_BATCH_DOWNSAMPLING WebRtcVad_BatchDownsamplingC
+#define VAD_BATCH_CALC_VAD_8KHZ WebRtcVad_BatchCalcVad8khzC
+#include "vad_batch_impl.h"
+
+void WebRtcVad_BatchSetLane(VadBatchGroup* group, int lane,
+                            const VadInstT* inst) {
+  int i;
+
+  RTC_DCHECK_LT(lane, kBatchLanes);
+
+  for (i = 0; i < 4; i++) {
+    group->downsampling_filter_states[i][lane] =
+        inst->downsampling_filter_states[i];
+    group->hp_filter_state[i][lane] = inst->hp_filter_state[i];
+  }
+  for (i = 0; i < kTableSize; i++) {
+    group->noise_means[i][lane] = inst->noise_means[i];
+    group->speech_means[i][lane] = inst->speech_means[i];
+    group->noise_stds[i][lane] = inst->noise_stds[i];
+    group->speech_stds[i][lane] = inst->speech_stds[i];
+  }
+  group->frame_counter[lane] = inst->frame_counter;
+  group->over_hang[lane] = inst->over_hang;
+  group->num_of_speech[lane] = inst->num_of_speech;
+  for (i = 0; i < 16 * kNumChannels; i++) {
+    group->index_vector[i][lane] = inst->index_vector[i];
+    group->low_value_vector[i][lane] = inst->low_value_vector[i];
+  }
+  for (i = 0; i < kNumChannels; i++) {
+    group->mean_value[i][lane] = inst->mean_value[i];
+  }
+  for (i = 0; i < 5; i++) {
+    group->upper_state[i][lane] = inst->upper_state[i];
+    group->lower_state[i][lane] = inst->lower_state[i];
+  }
+}
+
+void WebRtcVad_BatchSetMode(VadBatchMode* mode, const VadInstT* inst) {
+  memcpy(mode->over_hang_max_1, inst->over_hang_max_1,
+         sizeof(mode->over_hang_max_1));
+  memcpy(mode->over_hang_max_2, inst->over_hang_max_2,
+         sizeof(mode->over_hang_max_2));
+  memcpy(mode->individual, inst->individual, sizeof(mode->individual));
+  memcpy(mode->total, inst->total, sizeof(mode->total));
+}
+
+static const VadBatchFunctions kBatchFunctionsC = {
+  WebRtcVad_BatchDownsamplingC, WebRtcVad_BatchCalcVad8khzC };
+#if defined(WEBRTC_HAS_SSE41)
+static const VadBatchFunctions kBatchFunctionsSSE41 = {
+  WebRtcVad_BatchDownsamplingSSE41, WebRtcVad_BatchCalcVad8khzSSE41 };
+#endif
+#if defined(WEBRTC_HAS_AVX2)
+static const VadBatchFunctions kBatchFunctionsAVX2 = {
+  WebRtcVad_BatchDownsamplingAVX2, WebRtcVad_BatchCalcVad8khzAVX2 };
+#endif
+
+const VadBatchFunctions* WebRtcVad_BatchFunctions(void) {
+  const int features = WebRtcSpl_SelectedFeatures();
+
+  (void) features;
+#if defined(WEBRTC_HAS_AVX2)
+  if (features & kSplCpuAvx2) {
+    return &kBatchFunctionsAVX2;
+  }
+#endif
+#if defined(WEBRTC_HAS_SSE41)
+  if (features & kSplCpuSse41) {
+    return &kBatchFunctionsSSE41;
+  }
+#endif
+  // On ARM the C version is auto-vectorized for NEON already.
+  return &kBatchFunctionsC;
+}
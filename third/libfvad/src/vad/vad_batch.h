@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// Batched VAD: the state of |kBatchLanes| VAD instances laid out as
+// structure-of-arrays, so that the filterbank and the GMM run across streams
+// in SIMD lanes. Every lane gives bit-exact the same decisions as VadInstT
+// fed with the same frames.
+
+#ifndef COMMON_AUDIO_VAD_VAD_BATCH_H_
+#define COMMON_AUDIO_VAD_VAD_BATCH_H_
+
+#include "vad_core.h"
+
+enum { kBatchLanes = 16 };  // One AVX2 register of int16_t.
+
+// One sample (or one state value) for each lane.
+typedef int16_t LaneW16[kBatchLanes];
+typedef int32_t LaneW32[kBatchLanes];
+
+// The fields of VadInstT that change while processing, one row per field
+// element and one column per lane.
+typedef struct {
+    LaneW32 downsampling_filter_states[4];
+    LaneW16 noise_means[kTableSize];
+    LaneW16 speech_means[kTableSize];
+    LaneW16 noise_stds[kTableSize];
+    LaneW16 speech_stds[kTableSize];
+    LaneW32 frame_counter;
+    LaneW16 over_hang;
+    LaneW16 num_of_speech;
+    LaneW16 index_vector[16 * kNumChannels];
+    LaneW16 low_value_vector[16 * kNumChannels];
+    LaneW16 mean_value[kNumChannels];
+    LaneW16 upper_state[5];
+    LaneW16 lower_state[5];
+    LaneW16 hp_filter_state[4];
+} VadBatchGroup;
+
+// Aggressiveness thresholds, shared by all lanes (see VadInstT).
+typedef struct {
+    int16_t over_hang_max_1[3];
+    int16_t over_hang_max_2[3];
+    int16_t individual[3];
+    int16_t total[3];
+} VadBatchMode;
+
+// Copies the state of |inst| into |lane| of |group|.
+void WebRtcVad_BatchSetLane(VadBatchGroup* group, int lane,
+                            const VadInstT* inst);
+
+// Copies the thresholds of |inst|, set by WebRtcVad_set_mode_core().
+void WebRtcVad_BatchSetMode(VadBatchMode* mode, const VadInstT* inst);
+
+// Downsamples all lanes by 2, see WebRtcVad_Downsampling().
+//
+// - signal_in    [i]   : |in_length| samples per lane.
+// - signal_out   [o]   : |in_length| / 2 samples per lane.
+// - filter_state [i/o] : Two filter states per lane.
+typedef void (*VadBatchDownsampling)(const LaneW16* signal_in,
+                                     LaneW16* signal_out,
+                                     LaneW32* filter_state,
+                                     size_t in_length);
+
+// Calculates the VAD decision of all lanes for an 8 kHz frame of
+// |frame_length| (80, 160 or 240) samples, see WebRtcVad_CalcVad8khz().
+//
+// - vad          [o]   : Decision per lane, 0 - noise, 1-6 - speech.
+typedef void (*VadBatchCalcVad8khz)(VadBatchGroup* group,
+                                    const VadBatchMode* mode,
+                                    const LaneW16* speech_frame,
+                                    size_t frame_length,
+                                    int16_t* vad);
+
+typedef struct {
+    VadBatchDownsampling downsampling;
+    VadBatchCalcVad8khz calc_vad_8khz;
+} VadBatchFunctions;
+
+// Returns the implementation for the SPL features selected by
+// WebRtcSpl_Init() / WebRtcSpl_InitWithFeatures().
+const VadBatchFunctions* WebRtcVad_BatchFunctions(void);
+
+void WebRtcVad_BatchDownsamplingC(const LaneW16* signal_in,
+                                  LaneW16* signal_out,
+                                  LaneW32* filter_state, size_t in_length);
+void WebRtcVad_BatchCalcVad8khzC(VadBatchGroup* group,
+                                 const VadBatchMode* mode,
+                                 const LaneW16* speech_frame,
+                                 size_t frame_length, int16_t* vad);
+void WebRtcVad_BatchDownsamplingSSE41(const LaneW16* signal_in,
+                                      LaneW16* signal_out,
+                                      LaneW32* filter_state,
+                                      size_t in_length);
+void WebRtcVad_BatchCalcVad8khzSSE41(VadBatchGroup* group,
+                                     const VadBatchMode* mode,
+                                     const LaneW16* speech_frame,
+                                     size_t frame_length, int16_t* vad);
+void WebRtcVad_BatchDownsamplingAVX2(const LaneW16* signal_in,
+                                     LaneW16* signal_out,
+                                     LaneW32* filter_state,
+                                     size_t in_length);
+void WebRtcVad_BatchCalcVad8khzAVX2(VadBatchGroup* group,
+                                    const VadBatchMode* mode,
+                                    const LaneW16* speech_frame,
+                                    size_t frame_length, int16_t* vad);
+
+#endif  // COMMON_AUDIO_VAD_VAD_BATCH_H_
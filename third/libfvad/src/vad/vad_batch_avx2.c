@@ -0,0 +1,16 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// AVX2 build of the batched VAD. This file is compiled with -mavx2 and
+// is only used when the CPU supports it (see WebRtcVad_BatchFunctions()).
+
+#define VAD_BATCH_DOWNSAMPLING WebRtcVad_BatchDownsamplingAVX2
+#define VAD_BATCH_CALC_VAD_8KHZ WebRtcVad_BatchCalcVad8khzAVX2
+#include "vad_batch_impl.h"
@@ -0,0 +1,758 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// Lane-parallel versions of vad_filterbank.c, vad_gmm.c, vad_sp.c and
+// GmmProbability() in vad_core.c. Every statement of the originals is applied
+// to all lanes in an inner loop over |kBatchLanes|, which the compiler turns
+// into SIMD code. Branches become selects, and states of lanes that the
+// original would not touch are kept. The integer divisions are done in double
+// precision, which truncates to the same quotient (see DivW32W16Lanes()).
+//
+// This file is included by vad_batch.c, vad_batch_sse41.c and
+// vad_batch_avx2.c, each compiled for a different instruction set, after
+// defining VAD_BATCH_DOWNSAMPLING and VAD_BATCH_CALC_VAD_8KHZ to the function
+// names. They are built with -O3 -fno-trapping-math: the latter lets GCC
+// vectorize the loops that contain a double division, whose results do not
+// depend on floating-point exceptions.
+
+#ifndef VAD_BATCH_DOWNSAMPLING
+#error "Define VAD_BATCH_DOWNSAMPLING and VAD_BATCH_CALC_VAD_8KHZ first"
+#endif
+
+#include "vad_batch.h"
+
+// Loop over the lanes. GCC would unroll these short loops completely before
+// vectorizing them, and then fails to vectorize the recursive filters.
+#if defined(__GNUC__)
+#define LANES(n) _Pragma("GCC unroll 1") for (n = 0; n < kBatchLanes; n++)
+#else
+#define LANES(n) for (n = 0; n < kBatchLanes; n++)
+#endif
+
+// Constants from vad_sp.c.
+static const int16_t kAllPassCoefsQ13[2] = { 5243, 1392 };  // Q13.
+static const int16_t kSmoothingDown = 6553;  // 0.2 in Q15.
+static const int16_t kSmoothingUp = 32439;  // 0.99 in Q15.
+
+// Constants from vad_filterbank.c.
+static const int16_t kLogConst = 24660;  // 160*log10(2) in Q9.
+static const int16_t kLogEnergyIntPart = 14336;  // 14 in Q10
+static const int16_t kHpZeroCoefs[3] = { 6631, -13262, 6631 };
+static const int16_t kHpPoleCoefs[3] = { 16384, -7756, 5620 };
+static const int16_t kAllPassCoefsQ15[2] = { 20972, 5571 };
+static const int16_t kOffsetVector[6] = { 368, 368, 272, 176, 176, 176 };
+
+// Constants from vad_gmm.c.
+static const int32_t kCompVar = 22005;
+static const int16_t kLog2Exp = 5909;  // log2(exp(1)) in Q12.
+
+// Constants from vad_core.c.
+static const int16_t kSpectrumWeight[kNumChannels] = { 6, 8, 10, 12, 14, 16 };
+static const int16_t kNoiseUpdateConst = 655; // Q15
+static const int16_t kSpeechUpdateConst = 6554; // Q15
+static const int16_t kBackEta = 154; // Q8
+static const int16_t kMinimumDifference[kNumChannels] = {
+    544, 544, 576, 576, 576, 576 };
+static const int16_t kMaximumSpeech[kNumChannels] = {
+    11392, 11392, 11520, 11520, 11520, 11520 };
+static const int16_t kMinimumMean[kNumGaussians] = { 640, 768 };
+static const int16_t kMaximumNoise[kNumChannels] = {
+    9216, 9088, 8960, 8832, 8704, 8576 };
+static const int16_t kNoiseDataWeights[kTableSize] = {
+    34, 62, 72, 66, 53, 25, 94, 66, 56, 62, 75, 103 };
+static const int16_t kSpeechDataWeights[kTableSize] = {
+    48, 82, 45, 87, 50, 47, 80, 46, 83, 41, 78, 81 };
+static const int16_t kMaxSpeechFrames = 6;
+static const int16_t kMinStd = 384;
+
+// Returns |a| where |condition| is non-zero, else |b|. Written as a bit blend:
+// GCC turns "x = c ? y : x" into a conditional store, and moves conversions
+// to double into the arms of "c ? y : z", both of which block the
+// vectorization of the loop.
+static __inline int16_t SelectW16(int condition, int16_t a, int16_t b) {
+  const int16_t mask = (int16_t) -(condition != 0);
+  return (int16_t) ((a & mask) | (b & ~mask));
+}
+
+static __inline int32_t SelectW32(int condition, int32_t a, int32_t b) {
+  const int32_t mask = -(int32_t) (condition != 0);
+  return (a & mask) | (b & ~mask);
+}
+
+// WebRtcSpl_DivW32W16() without an integer divide instruction. For
+// |num| < 2^31 and 0 < |den| <= 2^15 a non-integer quotient is at least
+// 1 / |den| away from the next integer, while the rounding error of the
+// double division is below 2^-22, so truncation gives the same result.
+static __inline int32_t DivW32W16Lanes(int32_t num, int16_t den) {
+  // Divide by 1 instead of 0, so that the division needs no branch.
+  const int32_t quotient =
+      (int32_t) ((double) num / (double) SelectW16(den != 0, den, 1));
+  return SelectW32(den != 0, quotient, (int32_t) 0x7FFFFFFF);
+}
+
+// WebRtcSpl_NormW32() through the exponent of a double, which the compiler
+// can vectorize unlike a count of leading zeros.
+static __inline int16_t NormW32Lanes(int32_t a) {
+  const int32_t v = a < 0 ? ~a : a;
+  union { double d; uint64_t u; } bits;
+  int16_t norm;
+  bits.d = (double)v;
+  // floor(log2(v)) for v > 0, from the exponent field.
+  norm = (int16_t) (30 - ((int)(bits.u >> 52) - 1023));
+  norm = SelectW16(v == 0, 31, norm);
+  return SelectW16(a == 0, 0, norm);
+}
+
+// WebRtcVad_Downsampling() for all lanes.
+void VAD_BATCH_DOWNSAMPLING(const LaneW16* signal_in, LaneW16* signal_out,
+                            LaneW32* filter_state, size_t in_length) {
+  int32_t state_1[kBatchLanes], state_2[kBatchLanes];
+  size_t half_length = (in_length >> 1);
+  size_t i;
+  int n;
+
+  LANES(n) {
+    state_1[n] = filter_state[0][n];
+    state_2[n] = filter_state[1][n];
+  }
+  for (i = 0; i < half_length; i++) {
+    const int16_t* in_1 = signal_in[2 * i];
+    const int16_t* in_2 = signal_in[2 * i + 1];
+    int16_t* out = signal_out[i];
+    LANES(n) {
+      // All-pass filtering upper and lower branch.
+      int16_t tmp16_1 = (int16_t) ((state_1[n] >> 1) +
+          ((kAllPassCoefsQ13[0] * in_1[n]) >> 14));
+      int16_t tmp16_2 = (int16_t) ((state_2[n] >> 1) +
+          ((kAllPassCoefsQ13[1] * in_2[n]) >> 14));
+      state_1[n] = (int32_t) in_1[n] - ((kAllPassCoefsQ13[0] * tmp16_1) >> 12);
+      state_2[n] = (int32_t) in_2[n] - ((kAllPassCoefsQ13[1] * tmp16_2) >> 12);
+      out[n] = (int16_t) (tmp16_1 + tmp16_2);
+    }
+  }
+  LANES(n) {
+    filter_state[0][n] = state_1[n];
+    filter_state[1][n] = state_2[n];
+  }
+}
+
+// HighPassFilter() of vad_filterbank.c for all lanes.
+static void HighPassFilterLanes(const LaneW16* data_in, size_t data_length,
+                                LaneW16* filter_state, LaneW16* data_out) {
+  int16_t state[4][kBatchLanes];
+  size_t i;
+  int k, n;
+
+  for (k = 0; k < 4; k++) {
+    LANES(n) {
+      state[k][n] = filter_state[k][n];
+    }
+  }
+  for (i = 0; i < data_length; i++) {
+    const int16_t* in = data_in[i];
+    int16_t* out = data_out[i];
+    LANES(n) {
+      // All-zero section (filter coefficients in Q14).
+      int32_t tmp32 = kHpZeroCoefs[0] * in[n];
+      tmp32 += kHpZeroCoefs[1] * state[0][n];
+      tmp32 += kHpZeroCoefs[2] * state[1][n];
+      state[1][n] = state[0][n];
+      state[0][n] = in[n];
+
+      // All-pole section (filter coefficients in Q14).
+      tmp32 -= kHpPoleCoefs[1] * state[2][n];
+      tmp32 -= kHpPoleCoefs[2] * state[3][n];
+      state[3][n] = state[2][n];
+      state[2][n] = (int16_t) (tmp32 >> 14);
+      out[n] = state[2][n];
+    }
+  }
+  for (k = 0; k < 4; k++) {
+    LANES(n) {
+      filter_state[k][n] = state[k][n];
+    }
+  }
+}
+
+// SplitFilter() of vad_filterbank.c for all lanes. The two AllPassFilter()
+// branches run in the same loop, so that their recursions overlap.
+static void SplitFilterLanes(const LaneW16* data_in, size_t data_length,
+                             int16_t* upper_state, int16_t* lower_state,
+                             LaneW16* hp_data_out, LaneW16* lp_data_out) {
+  const int16_t upper_coefficient = kAllPassCoefsQ15[0];
+  const int16_t lower_coefficient = kAllPassCoefsQ15[1];
+  size_t half_length = data_length >> 1;  // Downsampling by 2.
+  int32_t upper32[kBatchLanes], lower32[kBatchLanes];
+  size_t i;
+  int n;
+
+  LANES(n) {
+    upper32[n] = ((int32_t) upper_state[n] * (1 << 16));  // Q15
+    lower32[n] = ((int32_t) lower_state[n] * (1 << 16));  // Q15
+  }
+  for (i = 0; i < half_length; i++) {
+    const int16_t* upper_in = data_in[2 * i];
+    const int16_t* lower_in = data_in[2 * i + 1];
+    int16_t* hp = hp_data_out[i];
+    int16_t* lp = lp_data_out[i];
+    LANES(n) {
+      // All-pass filtering, with the wrapping arithmetic of the original.
+      int32_t upper_tmp32 = (int32_t) ((uint32_t) upper32[n] +
+          (uint32_t) (upper_coefficient * upper_in[n]));
+      int32_t lower_tmp32 = (int32_t) ((uint32_t) lower32[n] +
+          (uint32_t) (lower_coefficient * lower_in[n]));
+      int16_t upper16 = (int16_t) (upper_tmp32 >> 16);  // Q(-1)
+      int16_t lower16 = (int16_t) (lower_tmp32 >> 16);  // Q(-1)
+      upper_tmp32 = (upper_in[n] * (1 << 14)) -
+          upper_coefficient * upper16;  // Q14
+      lower_tmp32 = (lower_in[n] * (1 << 14)) -
+          lower_coefficient * lower16;  // Q14
+      upper32[n] = (int32_t) ((uint32_t) upper_tmp32 * 2);  // Q15.
+      lower32[n] = (int32_t) ((uint32_t) lower_tmp32 * 2);  // Q15.
+
+      // Make LP and HP signals.
+      hp[n] = (int16_t) (upper16 - lower16);
+      lp[n] = (int16_t) (lower16 + upper16);
+    }
+  }
+  LANES(n) {
+    upper_state[n] = (int16_t) (upper32[n] >> 16);  // Q(-1)
+    lower_state[n] = (int16_t) (lower32[n] >> 16);  // Q(-1)
+  }
+}
+
+// LogOfEnergy() of vad_filterbank.c for all lanes, including the energy and
+// scaling of WebRtcSpl_Energy().
+static void LogOfEnergyLanes(const LaneW16* data_in, size_t data_length,
+                             int16_t offset, int16_t* total_energy,
+                             int16_t* log_energy) {
+  int16_t smax[kBatchLanes];
+  int scaling[kBatchLanes];
+  int any_scaling = 0;
+  uint32_t energy[kBatchLanes];
+  size_t i;
+  int n;
+
+  LANES(n) {
+    smax[n] = -1;
+    energy[n] = 0;
+  }
+  for (i = 0; i < data_length; i++) {
+    const int16_t* in = data_in[i];
+    LANES(n) {
+      int16_t sabs = (int16_t) (in[n] > 0 ? in[n] : -in[n]);
+      smax[n] = (sabs > smax[n] ? sabs : smax[n]);
+    }
+  }
+  LANES(n) {
+    int16_t nbits = WebRtcSpl_GetSizeInBits((uint32_t) data_length);
+    int16_t t = NormW32Lanes(WEBRTC_SPL_MUL(smax[n], smax[n]));
+    scaling[n] = (smax[n] == 0 || t > nbits) ? 0 : nbits - t;
+    any_scaling |= scaling[n];
+  }
+  // Scaling is only needed for loud bands; without it there is no per-lane
+  // shift, which SSE lacks.
+  if (any_scaling) {
+    for (i = 0; i < data_length; i++) {
+      const int16_t* in = data_in[i];
+      LANES(n) {
+        energy[n] += (uint32_t) ((in[n] * in[n]) >> scaling[n]);
+      }
+    }
+  } else {
+    for (i = 0; i < data_length; i++) {
+      const int16_t* in = data_in[i];
+      LANES(n) {
+        energy[n] += (uint32_t) (in[n] * in[n]);
+      }
+    }
+  }
+
+  LANES(n) {
+    int tot_rshifts = scaling[n];
+    uint32_t value = energy[n];
+    int16_t result = offset;
+    int16_t added = 0;
+    if (value != 0) {
+      int normalizing_rshifts = 17 - WebRtcSpl_NormU32(value);
+      int16_t log2_energy = kLogEnergyIntPart;
+
+      tot_rshifts += normalizing_rshifts;
+      if (normalizing_rshifts < 0) {
+        value <<= -normalizing_rshifts;
+      } else {
+        value >>= normalizing_rshifts;
+      }
+      log2_energy += (int16_t) ((value & 0x00003FFF) >> 4);
+      result = (int16_t) (((kLogConst * log2_energy) >> 19) +
+          ((tot_rshifts * kLogConst) >> 9));
+      if (result < 0) {
+        result = 0;
+      }
+      result += offset;
+
+      if (total_energy[n] <= kMinEnergy) {
+        if (tot_rshifts >= 0) {
+          added = kMinEnergy + 1;
+        } else {
+          added = (int16_t) (value >> -tot_rshifts);  // Q0.
+        }
+      }
+    }
+    log_energy[n] = result;
+    total_energy[n] += added;
+  }
+}
+
+// WebRtcVad_CalculateFeatures() for all lanes.
+static void CalculateFeaturesLanes(VadBatchGroup* self,
+                                   const LaneW16* data_in,
+                                   size_t data_length,
+                                   LaneW16* features,
+                                   int16_t* total_energy) {
+  LaneW16 hp_120[120], lp_120[120];
+  LaneW16 hp_60[60], lp_60[60];
+  const size_t half_data_length = data_length >> 1;
+  size_t length = half_data_length;
+  int n;
+
+  RTC_DCHECK_LE(data_length, 240);
+
+  LANES(n) {
+    total_energy[n] = 0;
+  }
+
+  // Split at 2000 Hz and downsample.
+  SplitFilterLanes(data_in, data_length, self->upper_state[0],
+                   self->lower_state[0], hp_120, lp_120);
+
+  // For the upper band (2000 Hz - 4000 Hz) split at 3000 Hz and downsample.
+  SplitFilterLanes(hp_120, length, self->upper_state[1],
+                   self->lower_state[1], hp_60, lp_60);
+
+  // Energy in 3000 Hz - 4000 Hz and 2000 Hz - 3000 Hz.
+  length >>= 1;
+  LogOfEnergyLanes(hp_60, length, kOffsetVector[5], total_energy, features[5]);
+  LogOfEnergyLanes(lp_60, length, kOffsetVector[4], total_energy, features[4]);
+
+  // For the lower band (0 Hz - 2000 Hz) split at 1000 Hz and downsample.
+  length = half_data_length;
+  SplitFilterLanes(lp_120, length, self->upper_state[2],
+                   self->lower_state[2], hp_60, lp_60);
+
+  // Energy in 1000 Hz - 2000 Hz.
+  length >>= 1;
+  LogOfEnergyLanes(hp_60, length, kOffsetVector[3], total_energy, features[3]);
+
+  // For the lower band (0 Hz - 1000 Hz) split at 500 Hz and downsample.
+  SplitFilterLanes(lp_60, length, self->upper_state[3],
+                   self->lower_state[3], hp_120, lp_120);
+
+  // Energy in 500 Hz - 1000 Hz.
+  length >>= 1;
+  LogOfEnergyLanes(hp_120, length, kOffsetVector[2], total_energy,
+                   features[2]);
+
+  // For the lower band (0 Hz - 500 Hz) split at 250 Hz and downsample.
+  SplitFilterLanes(lp_120, length, self->upper_state[4],
+                   self->lower_state[4], hp_60, lp_60);
+
+  // Energy in 250 Hz - 500 Hz.
+  length >>= 1;
+  LogOfEnergyLanes(hp_60, length, kOffsetVector[1], total_energy, features[1]);
+
+  // Remove 0 Hz - 80 Hz, by high pass filtering the lower band.
+  HighPassFilterLanes(lp_60, length, self->hp_filter_state, hp_120);
+
+  // Energy in 80 Hz - 250 Hz.
+  LogOfEnergyLanes(hp_120, length, kOffsetVector[0], total_energy,
+                   features[0]);
+}
+
+// WebRtcVad_GaussianProbability() for one lane, written without branches.
+static __inline int32_t GaussianProbabilityLane(int16_t input, int16_t mean,
+                                                int16_t std, int16_t* delta) {
+  int16_t tmp16, inv_std, inv_std2, exp_value, shift;
+  int32_t tmp32;
+  union { float f; uint32_t u; } scale;
+
+  tmp32 = (int32_t) 131072 + (int32_t) (std >> 1);
+  inv_std = (int16_t) DivW32W16Lanes(tmp32, std);
+  tmp16 = (inv_std >> 2);  // Q10 -> Q8.
+  inv_std2 = (int16_t)((tmp16 * tmp16) >> 2);
+
+  tmp16 = (int16_t) (input * (1 << 3));  // Q4 -> Q7
+  tmp16 = tmp16 - mean;  // Q7 - Q7 = Q7
+  *delta = (int16_t)((inv_std2 * tmp16) >> 10);
+  tmp32 = (*delta * tmp16) >> 9;
+
+  // exp_value ~= exp2(-log2(exp(1)) * |tmp32|) when |tmp32| < kCompVar, else
+  // 0. The exponent is clamped first so that the unused result can't overflow.
+  tmp16 = (int16_t)((kLog2Exp * (tmp32 < kCompVar ? tmp32 : 0)) >> 12);
+  tmp16 = -tmp16;
+  exp_value = (0x0400 | (tmp16 & 0x03FF));
+  shift = (int16_t) (tmp16 ^ 0xFFFF);
+  shift >>= 10;
+  shift += 1;
+  // |exp_value| >> |shift| as a multiplication by 2^-|shift|, since SSE has no
+  // per-lane shift. |exp_value| has 11 bits, so the float product is exact.
+  scale.u = (uint32_t) (127 - shift) << 23;
+  exp_value = (int16_t) ((float) exp_value * scale.f);
+  exp_value = tmp32 < kCompVar ? exp_value : 0;
+
+  return inv_std * exp_value;
+}
+
+// WebRtcVad_FindMinimum() for all lanes; lanes with |active| zero are left
+// untouched, like frames the original does not update.
+static void FindMinimumLanes(VadBatchGroup* self, const int16_t* feature_value,
+                             int channel, const int16_t* active,
+                             int16_t* minimum) {
+  const int offset = (channel << 4);
+  int16_t (*age)[kBatchLanes] = &self->index_vector[offset];
+  int16_t (*smallest_values)[kBatchLanes] = &self->low_value_vector[offset];
+  int16_t position[kBatchLanes];
+  int i, j, n;
+
+  // Each value gets one frame older. A value reaching 100 is removed and the
+  // larger values shift down, in the lanes where that happens.
+  for (i = 0; i < 16; i++) {
+    int16_t expired[kBatchLanes];
+    int any_expired = 0;
+    LANES(n) {
+      expired[n] = active[n] & (age[i][n] == 100);
+      any_expired |= expired[n];
+    }
+    LANES(n) {
+      age[i][n] = (int16_t) (age[i][n] + (active[n] & !expired[n]));
+    }
+    if (!any_expired) {
+      continue;
+    }
+    for (j = i; j < 15; j++) {
+      LANES(n) {
+        smallest_values[j][n] = SelectW16(expired[n], smallest_values[j + 1][n],
+                                          smallest_values[j][n]);
+        age[j][n] = SelectW16(expired[n], age[j + 1][n], age[j][n]);
+      }
+    }
+    LANES(n) {
+      smallest_values[15][n] = SelectW16(expired[n], 10000,
+                                         smallest_values[15][n]);
+      age[15][n] = SelectW16(expired[n], 101, age[15][n]);
+    }
+  }
+
+  // The values are kept sorted (features are far below the 10000 used for
+  // empty slots), so the binary search of the original finds the number of
+  // values not larger than |feature_value|; 16 means no insertion.
+  LANES(n) {
+    position[n] = active[n] ? 0 : 16;
+  }
+  for (i = 0; i < 16; i++) {
+    LANES(n) {
+      position[n] += active[n] & (smallest_values[i][n] <= feature_value[n]);
+    }
+  }
+
+  // Insert the new value and shift larger values up.
+  for (i = 15; i > 0; i--) {
+    LANES(n) {
+      const int16_t value = SelectW16(i == position[n], feature_value[n],
+                                      smallest_values[i - 1][n]);
+      const int16_t value_age = SelectW16(i == position[n], 1, age[i - 1][n]);
+      smallest_values[i][n] =
+          SelectW16(i >= position[n], value, smallest_values[i][n]);
+      age[i][n] = SelectW16(i >= position[n], value_age, age[i][n]);
+    }
+  }
+  LANES(n) {
+    smallest_values[0][n] =
+        SelectW16(position[n] == 0, feature_value[n], smallest_values[0][n]);
+    age[0][n] = SelectW16(position[n] == 0, 1, age[0][n]);
+  }
+
+  // Get the median and smooth it.
+  LANES(n) {
+    const int32_t frame_counter = self->frame_counter[n];
+    const int16_t mean_value = self->mean_value[channel][n];
+    const int16_t current_median = SelectW16(frame_counter > 2,
+        smallest_values[2][n],
+        SelectW16(frame_counter > 0, smallest_values[0][n], 1600));
+    const int16_t alpha = frame_counter <= 0 ? 0 :
+        (current_median < mean_value ? kSmoothingDown : kSmoothingUp);
+    int32_t tmp32;
+
+    tmp32 = (alpha + 1) * mean_value;
+    tmp32 += (WEBRTC_SPL_WORD16_MAX - alpha) * current_median;
+    tmp32 += 16384;
+    minimum[n] = SelectW16(active[n], (int16_t) (tmp32 >> 15), mean_value);
+    self->mean_value[channel][n] = minimum[n];
+  }
+}
+
+// GmmProbability() of vad_core.c for all lanes.
+static void GmmProbabilityLanes(VadBatchGroup* self, const VadBatchMode* mode,
+                                const LaneW16* features,
+                                const int16_t* total_power,
+                                size_t frame_length, int16_t* vad) {
+  LaneW16 deltaN[kTableSize], deltaS[kTableSize];
+  LaneW16 ngprvec[kTableSize], sgprvec[kTableSize];
+  int16_t active[kBatchLanes], vadflag[kBatchLanes];
+  int16_t feature_minimum[kBatchLanes];
+  int32_t sum_log_likelihood_ratios[kBatchLanes];
+  int16_t overhead1, overhead2, individualTest, totalTest;
+  int channel, k, n;
+  const int index = frame_length == 80 ? 0 : (frame_length == 160 ? 1 : 2);
+
+  overhead1 = mode->over_hang_max_1[index];
+  overhead2 = mode->over_hang_max_2[index];
+  individualTest = mode->individual[index];
+  totalTest = mode->total[index];
+
+  LANES(n) {
+    active[n] = total_power[n] > kMinEnergy;
+    vadflag[n] = 0;
+    sum_log_likelihood_ratios[n] = 0;
+  }
+
+  // Likelihood ratio test per channel and the local decisions.
+  for (channel = 0; channel < kNumChannels; channel++) {
+    const int g0 = channel, g1 = channel + kNumChannels;
+    LANES(n) {
+      const int16_t feature = features[channel][n];
+      int32_t noise_probability[kNumGaussians];
+      int32_t speech_probability[kNumGaussians];
+      int32_t h0_test, h1_test, tmp1_s32;
+      int16_t shifts_h0, shifts_h1, log_likelihood_ratio, h0, h1, ngpr, sgpr;
+
+      noise_probability[0] = kNoiseDataWeights[g0] * GaussianProbabilityLane(
+          feature, self->noise_means[g0][n], self->noise_stds[g0][n],
+          &deltaN[g0][n]);
+      noise_probability[1] = kNoiseDataWeights[g1] * GaussianProbabilityLane(
+          feature, self->noise_means[g1][n], self->noise_stds[g1][n],
+          &deltaN[g1][n]);
+      speech_probability[0] = kSpeechDataWeights[g0] * GaussianProbabilityLane(
+          feature, self->speech_means[g0][n], self->speech_stds[g0][n],
+          &deltaS[g0][n]);
+      speech_probability[1] = kSpeechDataWeights[g1] * GaussianProbabilityLane(
+          feature, self->speech_means[g1][n], self->speech_stds[g1][n],
+          &deltaS[g1][n]);
+      h0_test = noise_probability[0] + noise_probability[1];  // Q27
+      h1_test = speech_probability[0] + speech_probability[1];  // Q27
+
+      shifts_h0 = SelectW16(h0_test == 0, 31, NormW32Lanes(h0_test));
+      shifts_h1 = SelectW16(h1_test == 0, 31, NormW32Lanes(h1_test));
+      log_likelihood_ratio = shifts_h0 - shifts_h1;
+      sum_log_likelihood_ratios[n] +=
+          (int32_t) (log_likelihood_ratio * kSpectrumWeight[channel]);
+      vadflag[n] |= ((log_likelihood_ratio * 4) > individualTest);
+
+      // Conditional probabilities for updating the GMM.
+      h0 = (int16_t) (h0_test >> 12);  // Q15
+      tmp1_s32 = (int32_t) (((uint32_t) noise_probability[0] & 0xFFFFF000) << 2);
+      ngpr = (int16_t) DivW32W16Lanes(tmp1_s32, h0);  // Q14
+      ngprvec[g0][n] = SelectW16(h0 > 0, ngpr, 16384);
+      ngprvec[g1][n] = SelectW16(h0 > 0, 16384 - ngpr, 0);
+
+      h1 = (int16_t) (h1_test >> 12);  // Q15
+      tmp1_s32 = (int32_t) (((uint32_t) speech_probability[0] & 0xFFFFF000) << 2);
+      sgpr = (int16_t) DivW32W16Lanes(tmp1_s32, h1);  // Q14
+      sgprvec[g0][n] = SelectW16(h1 > 0, sgpr, 0);
+      sgprvec[g1][n] = SelectW16(h1 > 0, 16384 - sgpr, 0);
+    }
+  }
+
+  // Make a global VAD decision; quiet frames are noise and not updated.
+  LANES(n) {
+    vadflag[n] |= (sum_log_likelihood_ratios[n] >= totalTest);
+    vadflag[n] &= active[n];
+  }
+
+  // Update the model parameters. The lanes are the innermost loop everywhere,
+  // so that the compiler vectorizes them.
+  for (channel = 0; channel < kNumChannels; channel++) {
+    // |maxspe| is the speech limit of the previous channel.
+    const int16_t maxspe = channel == 0 ? 12800 : kMaximumSpeech[channel - 1];
+    const int16_t maxmu = maxspe + 640;
+    const int c0 = channel, c1 = channel + kNumChannels;
+    int16_t noise_means[kNumGaussians][kBatchLanes];
+    int16_t speech_means[kNumGaussians][kBatchLanes];
+    int16_t noise_mean_q8[kBatchLanes];
+
+    FindMinimumLanes(self, features[channel], channel, active,
+                     feature_minimum);
+
+    LANES(n) {
+      const int32_t noise_global_mean =
+          self->noise_means[c0][n] * kNoiseDataWeights[c0] +
+          self->noise_means[c1][n] * kNoiseDataWeights[c1];
+      noise_mean_q8[n] = (int16_t) (noise_global_mean >> 6);  // Q8
+    }
+
+    for (k = 0; k < kNumGaussians; k++) {
+      const int gaussian = channel + k * kNumChannels;
+      const int16_t min_noise = (int16_t) ((k + 5) << 7);
+      const int16_t max_noise = (int16_t) ((72 + k - channel) << 7);
+
+      LANES(n) {
+        const int16_t feature = features[channel][n];
+        const int16_t nmk = self->noise_means[gaussian][n];
+        const int16_t smk = self->speech_means[gaussian][n];
+        const int16_t nsk = self->noise_stds[gaussian][n];
+        const int16_t ssk = self->speech_stds[gaussian][n];
+        int16_t nmk2, nmk3, smk2, nsk2, ssk2, delt, ndelt, tmp_s16, quotient;
+        int32_t tmp1_s32, tmp2_s32;
+
+        // Noise mean, updated by the frame only when it is noise.
+        delt = (int16_t)((ngprvec[gaussian][n] * deltaN[gaussian][n]) >> 11);
+        nmk2 = SelectW16(vadflag[n], nmk,
+                         nmk + (int16_t)((delt * kNoiseUpdateConst) >> 22));
+
+        // Long term correction of the noise mean.
+        ndelt = (int16_t) ((feature_minimum[n] * (1 << 4)) - noise_mean_q8[n]);
+        nmk3 = nmk2 + (int16_t)((ndelt * kBackEta) >> 9);
+        nmk3 = nmk3 < min_noise ? min_noise : nmk3;
+        nmk3 = nmk3 > max_noise ? max_noise : nmk3;
+        noise_means[k][n] = nmk3;
+
+        // Speech mean and std, used for speech frames.
+        delt = (int16_t)((sgprvec[gaussian][n] * deltaS[gaussian][n]) >> 11);
+        tmp_s16 = (int16_t)((delt * kSpeechUpdateConst) >> 21);
+        smk2 = smk + ((tmp_s16 + 1) >> 1);
+        smk2 = smk2 < kMinimumMean[k] ? kMinimumMean[k] : smk2;
+        smk2 = smk2 > maxmu ? maxmu : smk2;
+
+        tmp_s16 = ((smk + 4) >> 3);
+        tmp_s16 = feature - tmp_s16;  // Q4
+        tmp1_s32 = (deltaS[gaussian][n] * tmp_s16) >> 3;
+        tmp2_s32 = tmp1_s32 - 4096;
+        tmp_s16 = sgprvec[gaussian][n] >> 2;
+        tmp1_s32 = (int32_t) ((uint32_t) tmp_s16 * (uint32_t) tmp2_s32);
+        tmp2_s32 = tmp1_s32 >> 4;  // Q20
+        quotient = (int16_t) DivW32W16Lanes(
+            SelectW32(tmp2_s32 > 0, tmp2_s32, -tmp2_s32), (int16_t) (ssk * 10));
+        tmp_s16 = SelectW16(tmp2_s32 > 0, quotient, -quotient);
+        tmp_s16 += 128;  // Rounding.
+        ssk2 = ssk + (tmp_s16 >> 8);
+        ssk2 = ssk2 < kMinStd ? kMinStd : ssk2;
+
+        // Noise std, used for noise frames.
+        tmp_s16 = feature - (nmk >> 3);
+        tmp1_s32 = (deltaN[gaussian][n] * tmp_s16) >> 3;
+        tmp1_s32 -= 4096;
+        tmp_s16 = (ngprvec[gaussian][n] + 2) >> 2;
+        tmp2_s32 = (int32_t) ((uint32_t) tmp_s16 * (uint32_t) tmp1_s32);
+        tmp1_s32 = tmp2_s32 >> 14;
+        quotient = (int16_t) DivW32W16Lanes(
+            SelectW32(tmp1_s32 > 0, tmp1_s32, -tmp1_s32), nsk);
+        tmp_s16 = SelectW16(tmp1_s32 > 0, quotient, -quotient);
+        tmp_s16 += 32;  // Rounding
+        nsk2 = nsk + (tmp_s16 >> 6);  // Q13 >> 6 = Q7.
+        nsk2 = nsk2 < kMinStd ? kMinStd : nsk2;
+
+        speech_means[k][n] = SelectW16(vadflag[n], smk2, smk);
+        self->speech_stds[gaussian][n] = SelectW16(vadflag[n], ssk2, ssk);
+        self->noise_stds[gaussian][n] =
+            SelectW16(active[n] & !vadflag[n], nsk2, nsk);
+      }
+    }
+
+    LANES(n) {
+      int16_t noise_0 = noise_means[0][n], noise_1 = noise_means[1][n];
+      int16_t speech_0 = speech_means[0][n], speech_1 = speech_means[1][n];
+      int32_t noise_global_mean, speech_global_mean;
+      int16_t diff, tmp_s16, tmp1_s16, tmp2_s16;
+
+      // Separate models if they are too close.
+      noise_global_mean = noise_0 * kNoiseDataWeights[c0] +
+          noise_1 * kNoiseDataWeights[c1];
+      speech_global_mean = speech_0 * kSpeechDataWeights[c0] +
+          speech_1 * kSpeechDataWeights[c1];
+      diff = (int16_t) (speech_global_mean >> 9) -
+          (int16_t) (noise_global_mean >> 9);
+      tmp_s16 = diff < kMinimumDifference[channel] ?
+          kMinimumDifference[channel] - diff : 0;
+      tmp1_s16 = (int16_t)((13 * tmp_s16) >> 2);
+      tmp2_s16 = (int16_t)((3 * tmp_s16) >> 2);
+      speech_0 += tmp1_s16;
+      speech_1 += tmp1_s16;
+      noise_0 -= tmp2_s16;
+      noise_1 -= tmp2_s16;
+      speech_global_mean = speech_0 * kSpeechDataWeights[c0] +
+          speech_1 * kSpeechDataWeights[c1];
+      noise_global_mean = noise_0 * kNoiseDataWeights[c0] +
+          noise_1 * kNoiseDataWeights[c1];
+
+      // Control that the speech & noise means do not drift to much.
+      tmp2_s16 = (int16_t) (speech_global_mean >> 7);
+      tmp2_s16 = tmp2_s16 > kMaximumSpeech[channel] ?
+          tmp2_s16 - kMaximumSpeech[channel] : 0;
+      speech_0 -= tmp2_s16;
+      speech_1 -= tmp2_s16;
+      tmp2_s16 = (int16_t) (noise_global_mean >> 7);
+      tmp2_s16 = tmp2_s16 > kMaximumNoise[channel] ?
+          tmp2_s16 - kMaximumNoise[channel] : 0;
+      noise_0 -= tmp2_s16;
+      noise_1 -= tmp2_s16;
+
+      self->noise_means[c0][n] =
+          SelectW16(active[n], noise_0, self->noise_means[c0][n]);
+      self->noise_means[c1][n] =
+          SelectW16(active[n], noise_1, self->noise_means[c1][n]);
+      self->speech_means[c0][n] =
+          SelectW16(active[n], speech_0, self->speech_means[c0][n]);
+      self->speech_means[c1][n] =
+          SelectW16(active[n], speech_1, self->speech_means[c1][n]);
+    }
+  }
+
+  LANES(n) {
+    self->frame_counter[n] += active[n];
+  }
+
+  // Smooth with respect to transition hysteresis.
+  LANES(n) {
+    int16_t flag = vadflag[n];
+    int16_t over_hang = self->over_hang[n];
+    int16_t num_of_speech = self->num_of_speech[n];
+    if (!flag) {
+      if (over_hang > 0) {
+        flag = 2 + over_hang;
+        over_hang--;
+      }
+      num_of_speech = 0;
+    } else {
+      num_of_speech++;
+      if (num_of_speech > kMaxSpeechFrames) {
+        num_of_speech = kMaxSpeechFrames;
+        over_hang = overhead2;
+      } else {
+        over_hang = overhead1;
+      }
+    }
+    self->over_hang[n] = over_hang;
+    self->num_of_speech[n] = num_of_speech;
+    vad[n] = flag;
+  }
+}
+
+void VAD_BATCH_CALC_VAD_8KHZ(VadBatchGroup* group, const VadBatchMode* mode,
+                             const LaneW16* speech_frame, size_t frame_length,
+                             int16_t* vad) {
+  LaneW16 features[kNumChannels];
+  int16_t total_power[kBatchLanes];
+
+  CalculateFeaturesLanes(group, speech_frame, frame_length, features,
+                         total_power);
+  GmmProbabilityLanes(group, mode, features, total_power, frame_length, vad);
+}
+
+#undef LANES
@@ -151,6 +151,7 @@ static int16_t GmmProbability(VadInstT* self, int16_t* features,
   int32_t noise_global_mean, speech_global_mean;
   int32_t noise_probability[kNumGaussians], speech_probability[kNumGaussians];
   int16_t overhead1, overhead2, individualTest, totalTest;
+  int16_t max_log_likelihood_ratio = -32768;
 
   // Set various thresholds based on frame lengths (80, 160 or 240 samples).
   if (frame_length == 80) {
@@ -237,6 +238,10 @@ static int16_t GmmProbability(VadInstT* self, int16_t* features,
       sum_log_likelihood_ratios +=
           (int32_t) (log_likelihood_ratio * kSpectrumWeight[channel]);
 
+      if (log_likelihood_ratio > max_log_likelihood_ratio) {
+        max_log_likelihood_ratio = log_likelihood_ratio;
+      }
+
       // Local VAD decision.
       if ((log_likelihood_ratio * 4) > individualTest) {
         vadflag = 1;
@@ -272,6 +277,13 @@ static int16_t GmmProbability(VadInstT* self, int16_t* features,
     // Make a global VAD decision.
     vadflag |= (sum_log_likelihood_ratios >= totalTest);
 
+    // Margin of the global and the strongest local test, non-negative exactly
+    // when |vadflag| is set. The local margin is scaled by 16, roughly the sum
+    // of |kSpectrumWeight| over the per-channel factor 4.
+    tmp1_s32 = sum_log_likelihood_ratios - totalTest;
+    tmp2_s32 = (max_log_likelihood_ratio * 4 - individualTest - 1) * 16;
+    self->speech_score = tmp1_s32 > tmp2_s32 ? tmp1_s32 : tmp2_s32;
+
     // Update the model parameters.
     maxspe = 12800;
     for (channel = 0; channel < kNumChannels; channel++) {
@@ -464,6 +476,8 @@ static int16_t GmmProbability(VadInstT* self, int16_t* features,
       }
     }
     self->frame_counter++;
+  } else {
+    self->speech_score = kSpeechScoreQuiet;
   }
 
   // Smooth with respect to transition hysteresis.
@@ -496,6 +510,7 @@ int WebRtcVad_InitCore(VadInstT* self) {
   // Initialization of general struct variables.
   self->vad = 1;  // Speech active (=1).
   self->frame_counter = 0;
+  self->speech_score = kSpeechScoreQuiet;
   self->over_hang = 0;
   self->num_of_speech = 0;
 
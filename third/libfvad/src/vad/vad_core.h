@@ -22,6 +22,7 @@ enum { kNumChannels = 6 };  // Number of frequency bands (named channels).
 enum { kNumGaussians = 2 };  // Number of Gaussians per channel in the GMM.
 enum { kTableSize = kNumChannels * kNumGaussians };
 enum { kMinEnergy = 10 };  // Minimum energy required to trigger audio signal.
+enum { kSpeechScoreQuiet = -32768 };  // Score of frames below |kMinEnergy|.
 
 typedef struct VadInstT_ {
     int vad;
@@ -50,6 +51,9 @@ typedef struct VadInstT_ {
 
     int16_t feature_vector[kNumChannels];
     int16_t total_power;
+    // Margin of the last frame's likelihood ratio tests, before the hangover
+    // smoothing. Non-negative when the frame itself was classified as speech.
+    int32_t speech_score;
 
     int init_flag;
 } VadInstT;
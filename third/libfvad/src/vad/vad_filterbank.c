@@ -115,9 +115,7 @@ static void AllPassFilter(const int16_t* data_in, size_t data_length,
 static void SplitFilter(const int16_t* data_in, size_t data_length,
                         int16_t* upper_state, int16_t* lower_state,
                         int16_t* hp_data_out, int16_t* lp_data_out) {
-  size_t i;
   size_t half_length = data_length >> 1;  // Downsampling by 2.
-  int16_t tmp_out;
 
   // All-pass filtering upper branch.
   AllPassFilter(&data_in[0], half_length, kAllPassCoefsQ15[0], upper_state,
@@ -127,12 +125,9 @@ static void SplitFilter(const int16_t* data_in, size_t data_length,
   AllPassFilter(&data_in[1], half_length, kAllPassCoefsQ15[1], lower_state,
                 lp_data_out);
 
-  // Make LP and HP signals.
-  for (i = 0; i < half_length; i++) {
-    tmp_out = *hp_data_out;
-    *hp_data_out++ -= *lp_data_out;
-    *lp_data_out++ += tmp_out;
-  }
+  // Make LP and HP signals. The all-pass filters above are recursive and stay
+  // scalar; this step is independent per sample and uses SIMD when available.
+  WebRtcSpl_AddSubW16(hp_data_out, lp_data_out, half_length);
 }
 
 // Calculates the energy of |data_in| in dB, and also updates an overall
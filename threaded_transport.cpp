@@ -0,0 +1,247 @@
+#include "threaded_transport.h"
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QDebug>
+#include <cstring>
+
+ThreadedTransport::ThreadedTransport(const std::function<Transport*()>& factory, QObject *parent)
+    : Transport(parent)
+    , inner(nullptr)
+    , directAudio(false)
+    , uplinkPool(4096, 64)
+    , downlinkPool(4096, BufferPool::MAX_BUFFERS)
+    , uplinkPending(false)
+    , downlinkPending(false)
+    , uplinkDropped(0)
+    , downlinkDropped(0)
+    , connected(false)
+    , version(1)
+{
+    thread.setObjectName("xiaozhi-net");
+    thread.start();
+
+    // 内部传输层（包括其中的 socket 和定时器）在网络线程中创建，线程归属随之确定
+    QObject* context = new QObject();
+    context->moveToThread(&thread);
+    QMetaObject::invokeMethod(context, [this, &factory]() {
+        inner = factory();
+        name = inner->transportName();
+        bindInner();
+    }, Qt::BlockingQueuedConnection);
+    context->deleteLater();
+}
+
+ThreadedTransport::~ThreadedTransport()
+{
+    if (inner) {
+        QMetaObject::invokeMethod(inner, [this]() {
+            inner->closeConnection();
+            delete inner;
+            inner = nullptr;
+        }, Qt::BlockingQueuedConnection);
+    }
+    thread.quit();
+    thread.wait();
+}
+
+void ThreadedTransport::bindInner()
+{
+    // 以下回调都在网络线程中执行，状态先更新再投递到 GUI 线程
+    inner->setOnConnectedCallback([this]() {
+        version.store(inner->protocolVersion(), std::memory_order_relaxed);
+        {
+            QMutexLocker locker(&stateMutex);
+            ticketSnapshot = inner->sslSessionTicket();
+        }
+        updateSnapshots();
+        connected.store(true, std::memory_order_release);
+        post([this]() {
+            resetRtt();
+            if (onConnectedCallback) {
+                onConnectedCallback();
+            }
+        });
+    });
+    inner->setOnDisconnectedCallback([this]() {
+        connected.store(false, std::memory_order_release);
+        post([this]() {
+            if (onDisconnectedCallback) {
+                onDisconnectedCallback();
+            }
+        });
+    });
+    inner->setOnErrorCallback([this](const QString& error) {
+        connected.store(inner->isConnected(), std::memory_order_release);
+        post([this, error]() {
+            if (onErrorCallback) {
+                onErrorCallback(error);
+            }
+        });
+    });
+    inner->setOnMessageCallback([this](const QString& raw, const Protocol::Message& parsed) {
+        updateSnapshots();
+        if (networkObserver) {
+            networkObserver(parsed);
+        }
+        // 消息在网络线程中解析一次，GUI 线程直接按类型分发
+        post([this, raw, parsed]() {
+            deliverMessage(raw, parsed);
+        });
+    });
+    inner->setOnAudioParamsCallback([this](const AudioParams& params) {
+        post([this, params]() {
+            if (onAudioParamsCallback) {
+                onAudioParamsCallback(params);
+            }
+        });
+    });
+    inner->setOnRttCallback([this](qint64 sampleMs, double srttMs) {
+        Q_UNUSED(srttMs);
+        // 在 GUI 线程按同样的样本序列平滑，结果与内部传输层一致
+        post([this, sampleMs]() {
+            updateRtt(sampleMs);
+        });
+    });
+    inner->setOnAudioPacketCallback([this](const QByteArray& payload, qint64 timestamp) {
+        onInnerAudio(payload, timestamp);
+    });
+}
+
+void ThreadedTransport::updateSnapshots()
+{
+    // 只在收发 JSON 消息时刷新（每轮对话几次到几十次），不在每个音频包上加锁复制；
+    // 统计在一轮结束（tts stop）时读取，此前的音频包都已计入
+    QMutexLocker locker(&stateMutex);
+    statsSnapshot = inner->downlinkStatistics();
+    wireSnapshot = inner->wireStatistics();
+}
+
+void ThreadedTransport::post(std::function<void()> task)
+{
+    // 以 this（GUI 线程对象）为上下文，析构后未执行的任务自动丢弃
+    QMetaObject::invokeMethod(this, std::move(task), Qt::QueuedConnection);
+}
+
+bool ThreadedTransport::connectToServer(const QString& url)
+{
+    QMetaObject::invokeMethod(inner, [this, url]() {
+        inner->connectToServer(url);
+    }, Qt::QueuedConnection);
+    return true;
+}
+
+void ThreadedTransport::sendAudio(const QByteArray& opusData)
+{
+    if (!isConnected()) {
+        return;
+    }
+
+    QByteArray buffer = uplinkPool.acquire(opusData.size());
+    memcpy(buffer.data(), opusData.constData(), opusData.size());
+    if (!uplink.push(std::move(buffer))) {
+        uplinkDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // 网络线程取空队列之前只投递一次
+    if (!uplinkPending.exchange(true)) {
+        QMetaObject::invokeMethod(inner, [this]() { drainUplink(); }, Qt::QueuedConnection);
+    }
+}
+
+void ThreadedTransport::drainUplink()
+{
+    uplinkPending.store(false);
+    QByteArray buffer;
+    while (uplink.pop(buffer)) {
+        inner->sendAudio(buffer);
+        uplinkPool.release(std::move(buffer));
+    }
+}
+
+void ThreadedTransport::onInnerAudio(const QByteArray& payload, qint64 timestamp)
+{
+    if (directAudio) {
+        if (onAudioPacketCallback) {
+            onAudioPacketCallback(payload, timestamp);
+        }
+        return;
+    }
+
+    // payload 只在回调期间有效，复制到缓冲池后交给 GUI 线程
+    Packet packet;
+    packet.timestamp = timestamp;
+    packet.payload = downlinkPool.acquire(payload.size());
+    memcpy(packet.payload.data(), payload.constData(), payload.size());
+    if (!downlink.push(std::move(packet))) {
+        downlinkDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!downlinkPending.exchange(true)) {
+        QMetaObject::invokeMethod(this, [this]() { drainDownlink(); }, Qt::QueuedConnection);
+    }
+}
+
+void ThreadedTransport::drainDownlink()
+{
+    downlinkPending.store(false);
+    Packet packet;
+    while (downlink.pop(packet)) {
+        deliverAudio(packet.payload.constData(), packet.payload.size(), packet.timestamp);
+        downlinkPool.release(std::move(packet.payload));
+    }
+}
+
+void ThreadedTransport::sendText(const QString& text)
+{
+    QMetaObject::invokeMethod(inner, [this, text]() {
+        inner->sendText(text);
+        updateSnapshots();
+    }, Qt::QueuedConnection);
+}
+
+void ThreadedTransport::closeConnection()
+{
+    QMetaObject::invokeMethod(inner, [this]() {
+        inner->closeConnection();
+    }, Qt::QueuedConnection);
+}
+
+void ThreadedTransport::setKeepAlive(int intervalMs, int maxMissed)
+{
+    QMetaObject::invokeMethod(inner, [this, intervalMs, maxMissed]() {
+        inner->setKeepAlive(intervalMs, maxMissed);
+    }, Qt::QueuedConnection);
+}
+
+void ThreadedTransport::setSslSessionTicket(const QByteArray& ticket)
+{
+    QMetaObject::invokeMethod(inner, [this, ticket]() {
+        inner->setSslSessionTicket(ticket);
+    }, Qt::QueuedConnection);
+}
+
+QByteArray ThreadedTransport::sslSessionTicket() const
+{
+    QMutexLocker locker(&stateMutex);
+    return ticketSnapshot;
+}
+
+StreamStats ThreadedTransport::downlinkStatistics() const
+{
+    QMutexLocker locker(&stateMutex);
+    return statsSnapshot;
+}
+
+WireStats ThreadedTransport::wireStatistics() const
+{
+    QMutexLocker locker(&stateMutex);
+    return wireSnapshot;
+}
+
+void ThreadedTransport::runInNetworkThread(std::function<void(Transport*)> task)
+{
+    QMetaObject::invokeMethod(inner, [this, task]() {
+        task(inner);
+    }, Qt::QueuedConnection);
+}
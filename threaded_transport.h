@@ -0,0 +1,96 @@
+#ifndef THREADED_TRANSPORT_H
+#define THREADED_TRANSPORT_H
+
+#include <QThread>
+#include <QMutex>
+#include <atomic>
+#include <functional>
+#include "transport.h"
+#include "spsc_queue.h"
+#include "buffer_pool.h"
+
+// 把一个传输层放到独立的网络线程中运行（TLS 加解密、帧解析不再和界面绘制争用 GUI 线程）。
+// 内部传输层由 factory 在网络线程中创建，只在网络线程中使用；对外接口与 Transport 相同：
+//   - 上行音频经无锁队列（缓冲池中的内存）交给网络线程发送
+//   - 连接状态、JSON 消息、RTT 等回调仍在 GUI 线程中调用，顺序与网络线程中一致
+//   - 下行音频默认同样转到 GUI 线程；setAudioCallbackOnNetworkThread(true) 后直接在网络线程中
+//     调用音频回调，不经过 GUI 线程，回调内只能做线程安全的操作（例如 AudioEngine::pushDownlink）
+class ThreadedTransport : public Transport {
+    Q_OBJECT
+public:
+    explicit ThreadedTransport(const std::function<Transport*()>& factory, QObject *parent = nullptr);
+    ~ThreadedTransport() override;
+
+    QString transportName() const override { return name; }
+    bool connectToServer(const QString& url) override;
+    using Transport::sendAudio;
+    void sendAudio(const QByteArray& opusData) override;
+    void sendText(const QString& text) override;
+    void closeConnection() override;
+    bool isConnected() const override { return connected.load(std::memory_order_acquire); }
+    void setKeepAlive(int intervalMs, int maxMissed) override;
+    void setSslSessionTicket(const QByteArray& ticket) override;
+    QByteArray sslSessionTicket() const override;
+    int protocolVersion() const override { return version.load(std::memory_order_relaxed); }
+    // 统计快照在网络线程收发 JSON 消息时刷新，音频包不触发刷新
+    StreamStats downlinkStatistics() const override;
+    WireStats wireStatistics() const override;
+
+    // 连接前设置：下行音频回调是否直接在网络线程中调用
+    void setAudioCallbackOnNetworkThread(bool enabled) { directAudio = enabled; }
+
+    // 连接前设置：消息投递到 GUI 线程之前先在网络线程中调用，
+    // 用于需要与网络线程中的下行音频保持先后顺序的状态（回调内只能做线程安全的操作）
+    void setNetworkMessageObserver(std::function<void(const Protocol::Message&)> observer) {
+        networkObserver = observer;
+    }
+
+    // 在网络线程中对内部传输层执行操作（异步），用于设置具体传输层特有的参数
+    void runInNetworkThread(std::function<void(Transport*)> task);
+
+    // 统计：因队列满而丢弃的上行/下行包数
+    int droppedUplink() const { return uplinkDropped.load(std::memory_order_relaxed); }
+    int droppedDownlink() const { return downlinkDropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Packet {
+        QByteArray payload;
+        qint64 timestamp = -1;
+    };
+
+    // 网络线程
+    void bindInner();
+    void drainUplink();
+    void onInnerAudio(const QByteArray& payload, qint64 timestamp);
+    void updateSnapshots();
+
+    // GUI 线程
+    void drainDownlink();
+
+    // 把回调投递到 GUI 线程执行
+    void post(std::function<void()> task);
+
+    QThread thread;
+    Transport* inner;       // 只在网络线程中使用
+    QString name;
+    bool directAudio;
+    std::function<void(const Protocol::Message&)> networkObserver;
+
+    SpscQueue<QByteArray, 256> uplink;      // GUI 线程 -> 网络线程
+    SpscQueue<Packet, 256> downlink;        // 网络线程 -> GUI 线程
+    BufferPool uplinkPool;                  // GUI 线程取用，网络线程归还
+    BufferPool downlinkPool;                // 网络线程取用，GUI 线程归还
+    std::atomic<bool> uplinkPending;
+    std::atomic<bool> downlinkPending;
+    std::atomic<int> uplinkDropped;
+    std::atomic<int> downlinkDropped;
+
+    std::atomic<bool> connected;
+    std::atomic<int> version;
+    mutable QMutex stateMutex;              // 保护以下快照，收发 JSON 消息时刷新
+    QByteArray ticketSnapshot;
+    StreamStats statsSnapshot;
+    WireStats wireSnapshot;
+};
+
+#endif // THREADED_TRANSPORT_H
@@ -0,0 +1,83 @@
+#include "transport.h"
+
+WireStats WireStats::operator-(const WireStats& other) const
+{
+    WireStats delta;
+    delta.textBytesSent = textBytesSent - other.textBytesSent;
+    delta.textBytesReceived = textBytesReceived - other.textBytesReceived;
+    delta.jsonBytesSent = jsonBytesSent - other.jsonBytesSent;
+    delta.jsonBytesReceived = jsonBytesReceived - other.jsonBytesReceived;
+    delta.audioBytesSent = audioBytesSent - other.audioBytesSent;
+    delta.audioBytesReceived = audioBytesReceived - other.audioBytesReceived;
+    delta.compressedSent = compressedSent - other.compressedSent;
+    delta.compressedReceived = compressedReceived - other.compressedReceived;
+    return delta;
+}
+
+QString WireStats::summary() const
+{
+    return QString("上行 %1 B（控制 %2 B，压缩前 %3 B；音频 %4 B） 下行 %5 B（控制 %6 B，压缩前 %7 B；音频 %8 B） 压缩消息 %9/%10")
+        .arg(textBytesSent + audioBytesSent).arg(textBytesSent).arg(jsonBytesSent).arg(audioBytesSent)
+        .arg(textBytesReceived + audioBytesReceived).arg(textBytesReceived).arg(jsonBytesReceived).arg(audioBytesReceived)
+        .arg(compressedSent).arg(compressedReceived);
+}
+
+Transport::Transport(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void Transport::sendAudio(const std::vector<uint8_t>& data)
+{
+    if (!isConnected()) {
+        return;
+    }
+    QByteArray byteArray(reinterpret_cast<const char*>(data.data()), data.size());
+    sendAudio(byteArray);
+}
+
+void Transport::deliverMessage(const QString& raw, const Protocol::Message& parsed)
+{
+    if (onMessageCallback) {
+        onMessageCallback(raw, parsed);
+        return;
+    }
+    if (onJsonCallback) {
+        onJsonCallback(raw);
+    }
+    messageDispatcher.dispatch(parsed);
+}
+
+void Transport::deliverAudio(const char* payload, int size, qint64 timestamp)
+{
+    if (onAudioPacketCallback) {
+        // 不拷贝负载，接收方需要时自行复制
+        const QByteArray view = QByteArray::fromRawData(payload, size);
+        onAudioPacketCallback(view, timestamp);
+    } else if (onAudioCallback) {
+        std::vector<uint8_t> data(payload, payload + size);
+        onAudioCallback(data);
+    }
+}
+
+void Transport::updateRtt(qint64 sampleMs)
+{
+    const double sample = static_cast<double>(sampleMs);
+    if (srtt < 0) {
+        srtt = sample;
+        rttvar = sample / 2;
+    } else {
+        rttvar = 0.75 * rttvar + 0.25 * qAbs(srtt - sample);
+        srtt = 0.875 * srtt + 0.125 * sample;
+    }
+
+    if (onRttCallback) {
+        onRttCallback(sampleMs, srtt);
+    }
+}
+
+void Transport::resetRtt()
+{
+    srtt = -1.0;
+    rttvar = -1.0;
+}
@@ -0,0 +1,149 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QElapsedTimer>
+#include <functional>
+#include <vector>
+#include "protocol.h"
+#include "stream_stats.h"
+
+// 线上字节统计（包含帧头等协议开销），用于估算每轮对话的流量
+struct WireStats {
+    qint64 textBytesSent = 0;        // 控制消息（JSON，可能已压缩）
+    qint64 textBytesReceived = 0;
+    qint64 jsonBytesSent = 0;        // 控制消息压缩前的 JSON 长度
+    qint64 jsonBytesReceived = 0;
+    qint64 audioBytesSent = 0;
+    qint64 audioBytesReceived = 0;
+    int compressedSent = 0;          // 压缩发送/接收的消息数
+    int compressedReceived = 0;
+
+    WireStats operator-(const WireStats& other) const;
+    QString summary() const;
+};
+
+// 与服务器之间的传输层接口。WebSocketClient 在一条连接上传输 JSON 和音频，
+// MqttUdpTransport 用 MQTT 传输 JSON、用加密 UDP 传输音频。
+// 上层（MainWindow、ConnectionManager）只通过这里的接口和回调使用传输层。
+class Transport : public QObject {
+    Q_OBJECT
+public:
+    explicit Transport(QObject *parent = nullptr);
+    ~Transport() override = default;
+
+    // hello 消息中的 transport 字段
+    virtual QString transportName() const = 0;
+
+    // 连接到服务器，收到服务器 hello 后才算连接成功
+    virtual bool connectToServer(const QString& url) = 0;
+
+    // 发送一帧 Opus 数据
+    virtual void sendAudio(const QByteArray& opusData) = 0;
+    void sendAudio(const std::vector<uint8_t>& data);
+
+    // 发送 JSON 文本消息
+    virtual void sendText(const QString& text) = 0;
+
+    // 关闭连接
+    virtual void closeConnection() = 0;
+
+    // 是否已连接（已收到服务器 hello）
+    virtual bool isConnected() const = 0;
+
+    // 保活：每 intervalMs 探测一次，连续 maxMissed 次无响应时断开连接
+    virtual void setKeepAlive(int intervalMs, int maxMissed) = 0;
+
+    // TLS 会话复用，不支持的传输层忽略
+    virtual void setSslSessionTicket(const QByteArray& ticket) { Q_UNUSED(ticket); }
+    virtual QByteArray sslSessionTicket() const { return QByteArray(); }
+
+    // 二进制帧协议版本（见 binary_protocol.h），不使用该帧格式的传输层返回 1
+    virtual int protocolVersion() const { return 1; }
+
+    // 设置回调函数
+    void setOnAudioCallback(std::function<void(const std::vector<uint8_t>&)> callback) {
+        onAudioCallback = callback;
+    }
+
+    void setOnJsonCallback(std::function<void(const QString&)> callback) {
+        onJsonCallback = callback;
+    }
+
+    void setOnConnectedCallback(std::function<void()> callback) {
+        onConnectedCallback = callback;
+    }
+
+    void setOnDisconnectedCallback(std::function<void()> callback) {
+        onDisconnectedCallback = callback;
+    }
+
+    void setOnAudioParamsCallback(std::function<void(const AudioParams&)> callback) {
+        onAudioParamsCallback = callback;
+    }
+
+    // 下行音频包回调：payload 不拷贝，只在回调期间有效；
+    // timestamp 为包时间戳（毫秒），没有时为 -1。设置后代替 onAudioCallback
+    void setOnAudioPacketCallback(std::function<void(const QByteArray&, qint64)> callback) {
+        onAudioPacketCallback = callback;
+    }
+
+    void setOnErrorCallback(std::function<void(const QString&)> callback) {
+        onErrorCallback = callback;
+    }
+
+    // RTT 回调：每次保活探测得到响应时调用，参数为本次样本和平滑后的 RTT（毫秒）
+    void setOnRttCallback(std::function<void(qint64, double)> callback) {
+        onRttCallback = callback;
+    }
+
+    // RTT 指标（毫秒），尚无样本时为 -1；供抖动缓冲和码率决策使用
+    double smoothedRttMs() const { return srtt; }
+    double rttVariationMs() const { return rttvar; }
+
+    // 下行音频流统计（丢包、乱序、抖动、排队延迟），只在包带时间戳时更新
+    virtual StreamStats downlinkStatistics() const { return downlinkStats; }
+
+    // 累计线上字节数，跨连接累加；按轮统计时取两次的差
+    virtual WireStats wireStatistics() const { return wireStats; }
+
+    // 已解析消息回调：设置后代替 onJsonCallback 和分发表，由包装类转发到其他线程
+    void setOnMessageCallback(std::function<void(const QString&, const Protocol::Message&)> callback) {
+        onMessageCallback = callback;
+    }
+
+    // 已解析消息的分发表，在这里按消息类型注册处理函数
+    Protocol::MessageDispatcher& dispatcher() { return messageDispatcher; }
+
+protected:
+    // 派生类收到服务器消息后调用：先交给原始 JSON 回调，再按类型分发
+    void deliverMessage(const QString& raw, const Protocol::Message& parsed);
+    // 派生类收到下行音频后调用，timestamp 为 -1 表示没有时间戳
+    void deliverAudio(const char* payload, int size, qint64 timestamp);
+    // 与 TCP 相同的平滑方式：srtt 权重 1/8，偏差权重 1/4
+    void updateRtt(qint64 sampleMs);
+    void resetRtt();
+
+    std::function<void(const std::vector<uint8_t>&)> onAudioCallback;
+    std::function<void(const QString&)> onJsonCallback;
+    std::function<void()> onConnectedCallback;
+    std::function<void()> onDisconnectedCallback;
+    std::function<void(const AudioParams&)> onAudioParamsCallback;
+    std::function<void(const QString&)> onErrorCallback;
+    std::function<void(qint64, double)> onRttCallback;
+    std::function<void(const QByteArray&, qint64)> onAudioPacketCallback;
+    std::function<void(const QString&, const Protocol::Message&)> onMessageCallback;
+
+    QElapsedTimer sessionClock;   // 会话内时间戳基准
+    StreamStats downlinkStats;
+    WireStats wireStats;
+    Protocol::MessageDispatcher messageDispatcher;
+
+private:
+    double srtt = -1.0;     // 平滑 RTT
+    double rttvar = -1.0;   // RTT 平均偏差
+};
+
+#endif // TRANSPORT_H
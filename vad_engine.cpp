@@ -0,0 +1,266 @@
+#include "vad_engine.h"
+#include <QDebug>
+#include <QString>
+#include <cmath>
+
+namespace {
+// 预门限参数
+constexpr double GATE_ENERGY_RATIO = 2.0;   // 低于噪底均值 +3dB 的帧才可能跳过
+constexpr double GATE_ZCR_TOLERANCE = 0.1;  // 且过零率接近噪声的过零率
+constexpr double GATE_MIN_FLOOR = 4.0;      // 数字静音时的噪底下限（均方）
+constexpr double FLOOR_RISE = 1.005;        // 高于门限时噪底每帧上升约 0.02dB（每秒约 2dB）
+constexpr double FLOOR_SMOOTHING = 0.05;    // 门限以内的帧做指数平均（约 0.2 秒）
+constexpr double ZCR_SMOOTHING = 0.05;
+constexpr int GATE_WARMUP_FRAMES = 50;      // 前 0.5 秒全部交给 libfvad 建立噪声模型
+constexpr int GATE_REFRESH_FRAMES = 8;      // 连续跳过时每 8 帧完整处理一帧
+
+// 均方能量和过零率，写成简单循环以便编译器向量化
+void measureFrame(const int16_t* frame, int length, double* energy, double* zcr)
+{
+    // 每个平方先右移 8 位，10ms@48kHz 的 480 个样本累加也不会溢出 int32
+    int32_t sum = 0;
+    for (int i = 0; i < length; ++i) {
+        sum += (static_cast<int32_t>(frame[i]) * frame[i]) >> 8;
+    }
+    int crossings = 0;
+    for (int i = 1; i < length; ++i) {
+        crossings += (frame[i] ^ frame[i - 1]) < 0;
+    }
+    *energy = sum * 256.0 / length;
+    *zcr = static_cast<double>(crossings) / (length - 1);
+}
+}
+
+VadEngine::Config VadEngine::Config::fromEnvironment()
+{
+    Config config;
+    bool ok = false;
+
+    int mode = qEnvironmentVariableIntValue("XIAOZHI_VAD_MODE", &ok);
+    if (ok && mode >= 0 && mode <= 3) {
+        config.mode = mode;
+    }
+    double onset = qEnvironmentVariable("XIAOZHI_VAD_ONSET").toDouble(&ok);
+    if (ok && onset > 0.0 && onset < 1.0) {
+        config.onsetThreshold = onset;
+    }
+    double offset = qEnvironmentVariable("XIAOZHI_VAD_OFFSET").toDouble(&ok);
+    if (ok && offset > 0.0 && offset < 1.0) {
+        config.offsetThreshold = offset;
+    }
+    int onsetMs = qEnvironmentVariableIntValue("XIAOZHI_VAD_ONSET_MS", &ok);
+    if (ok && onsetMs >= 0) {
+        config.onsetMs = onsetMs;
+    }
+    int hangoverMs = qEnvironmentVariableIntValue("XIAOZHI_VAD_HANGOVER_MS", &ok);
+    if (ok && hangoverMs >= 0) {
+        config.hangoverMs = hangoverMs;
+    }
+    int gate = qEnvironmentVariableIntValue("XIAOZHI_VAD_GATE", &ok);
+    if (ok) {
+        config.gate = gate != 0;
+    }
+    // 结束阈值不能高于开始阈值，否则状态机会来回抖动
+    if (config.offsetThreshold > config.onsetThreshold) {
+        config.offsetThreshold = config.onsetThreshold;
+    }
+    return config;
+}
+
+VadEngine::VadEngine(const Config& config)
+    : cfg(config)
+    , handle(fvad_new())
+    , frameLength(config.sampleRate / 100)
+    , onsetFrames(qMax(1, config.onsetMs / 10))
+    , hangoverFrames(qMax(1, config.hangoverMs / 10))
+    , processed(0)
+    , state(State::Silence)
+    , runStart(0)
+    , runFrames(0)
+    , floorEnergy(0.0)
+    , floorZcr(0.0)
+    , gateWarmup(0)
+    , gatedRun(0)
+    , gated(0)
+{
+    if (!handle) {
+        qDebug() << "创建VAD实例失败";
+        return;
+    }
+    if (fvad_set_sample_rate(handle, config.sampleRate) < 0 || fvad_set_mode(handle, config.mode) < 0) {
+        qDebug() << "VAD参数不合法，采样率:" << config.sampleRate << "模式:" << config.mode;
+        fvad_free(handle);
+        handle = nullptr;
+        return;
+    }
+    pending.reserve(frameLength);
+}
+
+VadEngine::~VadEngine()
+{
+    if (handle) {
+        fvad_free(handle);
+        handle = nullptr;
+    }
+}
+
+void VadEngine::reset()
+{
+    if (handle) {
+        fvad_reset(handle);
+        fvad_set_sample_rate(handle, cfg.sampleRate);
+        fvad_set_mode(handle, cfg.mode);
+    }
+    pending.clear();
+    processed = 0;
+    state = State::Silence;
+    runStart = 0;
+    runFrames = 0;
+    floorEnergy = 0.0;
+    floorZcr = 0.0;
+    gateWarmup = 0;
+    gatedRun = 0;
+    gated = 0;
+}
+
+float VadEngine::scoreToProbability(int score)
+{
+    // 得分每 66 约等于每个子带的似然比翻一倍，按对数几率换算
+    constexpr double LOG_ODDS_PER_SCORE = 0.69314718055994531 / 66.0;
+    return static_cast<float>(1.0 / (1.0 + std::exp(-score * LOG_ODDS_PER_SCORE)));
+}
+
+void VadEngine::process(const int16_t* samples, size_t count,
+                        std::vector<float>* probabilities, std::vector<Event>* events)
+{
+    if (!handle) {
+        return;
+    }
+
+    // 先补齐上次剩下的半帧
+    if (!pending.empty()) {
+        const size_t take = qMin(count, static_cast<size_t>(frameLength) - pending.size());
+        pending.insert(pending.end(), samples, samples + take);
+        samples += take;
+        count -= take;
+        if (pending.size() < static_cast<size_t>(frameLength)) {
+            return;
+        }
+        processFrame(pending.data(), probabilities, events);
+        pending.clear();
+    }
+
+    // 完整的帧直接在输入上处理，不拷贝
+    while (count >= static_cast<size_t>(frameLength)) {
+        processFrame(samples, probabilities, events);
+        samples += frameLength;
+        count -= frameLength;
+    }
+
+    pending.assign(samples, samples + count);
+}
+
+void VadEngine::processFrame(const int16_t* frame, std::vector<float>* probabilities,
+                             std::vector<Event>* events)
+{
+    float probability = 0.0f;
+    if (cfg.gate && gateFrame(frame)) {
+        ++gated;
+    } else {
+        // 只用 libfvad 未经拖尾的得分，拖尾由下面的状态机按配置完成
+        fvad_process(handle, frame, frameLength);
+        probability = scoreToProbability(fvad_get_speech_score(handle));
+    }
+    if (probabilities) {
+        probabilities->push_back(probability);
+    }
+
+    const qint64 frameStart = processed;
+    processed += frameLength;
+    const bool speech = probability >= cfg.onsetThreshold;
+    const bool silence = probability < cfg.offsetThreshold;
+
+    switch (state) {
+    case State::Silence:
+        if (!speech) {
+            break;
+        }
+        state = State::Onset;
+        runStart = frameStart;
+        runFrames = 0;
+        // fall through
+    case State::Onset:
+        if (speech) {
+            ++runFrames;
+        } else if (silence) {
+            state = State::Silence;
+            break;
+        }
+        if (runFrames >= onsetFrames) {
+            state = State::Speech;
+            if (events) {
+                events->push_back({Event::SpeechStart, runStart, processed});
+            }
+        }
+        break;
+    case State::Speech:
+        if (!silence) {
+            break;
+        }
+        state = State::Hangover;
+        runStart = frameStart;
+        runFrames = 0;
+        // fall through
+    case State::Hangover:
+        if (speech) {
+            state = State::Speech;
+            break;
+        }
+        if (++runFrames >= hangoverFrames) {
+            state = State::Silence;
+            if (events) {
+                events->push_back({Event::SpeechEnd, runStart, processed});
+            }
+        }
+        break;
+    }
+}
+
+bool VadEngine::gateFrame(const int16_t* frame)
+{
+    double energy = 0.0, zcr = 0.0;
+    measureFrame(frame, frameLength, &energy, &zcr);
+
+    if (gateWarmup == 0) {
+        floorEnergy = energy;
+        floorZcr = zcr;
+    }
+    const double threshold = qMax(floorEnergy, GATE_MIN_FLOOR) * GATE_ENERGY_RATIO;
+    const bool nearFloor = energy < threshold;
+
+    // 噪底取噪声帧能量的平滑均值；明显高于噪底（语音、敲击）的帧不参与平均，
+    // 只让噪底缓慢爬升，环境变吵后几秒内能跟上
+    if (nearFloor) {
+        floorEnergy += (energy - floorEnergy) * FLOOR_SMOOTHING;
+    } else {
+        floorEnergy = qMax(floorEnergy, GATE_MIN_FLOOR) * FLOOR_RISE;
+    }
+    if (nearFloor) {
+        floorZcr += (zcr - floorZcr) * ZCR_SMOOTHING;
+    }
+
+    // 只在静音状态下跳过，起始确认和拖尾期间每帧都要 libfvad 的概率
+    if (gateWarmup < GATE_WARMUP_FRAMES) {
+        ++gateWarmup;
+        return false;
+    }
+    if (state != State::Silence || !nearFloor || std::abs(zcr - floorZcr) >= GATE_ZCR_TOLERANCE) {
+        gatedRun = 0;
+        return false;
+    }
+    // 定期完整处理一帧，libfvad 的噪声模型和滤波器状态跟着环境噪声更新
+    if (++gatedRun % GATE_REFRESH_FRAMES == 0) {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+#ifndef VAD_ENGINE_H
+#define VAD_ENGINE_H
+
+#include <QtGlobal>
+#include <fvad.h>
+#include <vector>
+
+// VAD 引擎：接受任意长度的 PCM 块，内部按 10ms 帧调用 libfvad，
+// 给出每帧的语音概率，并用起止两个阈值加时长的状态机产生语音开始/结束事件。
+// 事件时间以流开始以来的采样点计，与送入的块大小无关。
+// 静音状态下先用能量和过零率做一级门限：明显处于噪底的帧不进 libfvad，
+// 每隔几帧仍完整处理一帧，让 libfvad 的噪声模型跟上环境变化
+class VadEngine
+{
+public:
+    struct Config {
+        int sampleRate = 16000;
+        int mode = 2;                  // libfvad 激进程度 0-3
+        double onsetThreshold = 0.5;   // 概率不低于此值的帧算作语音
+        double offsetThreshold = 0.3;  // 语音中概率低于此值的帧算作静音
+        int onsetMs = 200;             // 累计这么长的语音帧才确认开始
+        int hangoverMs = 500;          // 语音后持续这么长的静音才确认结束
+        bool gate = true;              // 能量/过零率预门限
+
+        // XIAOZHI_VAD_MODE、XIAOZHI_VAD_ONSET、XIAOZHI_VAD_OFFSET（概率）、
+        // XIAOZHI_VAD_ONSET_MS、XIAOZHI_VAD_HANGOVER_MS、XIAOZHI_VAD_GATE（0 关闭）
+        static Config fromEnvironment();
+    };
+
+    struct Event {
+        enum Type { SpeechStart, SpeechEnd };
+        Type type;
+        qint64 sample;      // 语音实际开始/结束的位置（帧边界）
+        qint64 detectedAt;  // 做出判断时已处理到的位置，两者之差即判决延迟
+    };
+
+    explicit VadEngine(const Config& config);
+    ~VadEngine();
+
+    VadEngine(const VadEngine&) = delete;
+    VadEngine& operator=(const VadEngine&) = delete;
+
+    bool isValid() const { return handle != nullptr; }
+    const Config& config() const { return cfg; }
+
+    // 清空模型、缓冲和状态机，时间重新从 0 开始
+    void reset();
+
+    // 处理一块 PCM，probabilities 追加本次完成的每个 10ms 帧的语音概率，
+    // events 追加本次产生的事件（均可为 nullptr）
+    void process(const int16_t* samples, size_t count,
+                 std::vector<float>* probabilities, std::vector<Event>* events);
+
+    bool inSpeech() const { return state == State::Speech || state == State::Hangover; }
+    qint64 samplesProcessed() const { return processed; }
+    int frameSamples() const { return frameLength; }
+    // 被预门限跳过、没有调用 libfvad 的帧数
+    qint64 gatedFrames() const { return gated; }
+    qint64 totalFrames() const { return processed / frameLength; }
+    // 当前噪底（每样本均方能量）
+    double noiseFloor() const { return floorEnergy; }
+
+    // libfvad 的得分（似然比检验余量）映射为概率，0.5 对应 libfvad 自身的判决
+    static float scoreToProbability(int score);
+
+private:
+    enum class State { Silence, Onset, Speech, Hangover };
+
+    void processFrame(const int16_t* frame, std::vector<float>* probabilities,
+                      std::vector<Event>* events);
+    bool gateFrame(const int16_t* frame);
+
+    Config cfg;
+    Fvad* handle;
+    int frameLength;
+    int onsetFrames;
+    int hangoverFrames;
+
+    std::vector<int16_t> pending;  // 不足一帧的剩余样本
+    qint64 processed;              // 已完成判决的样本数
+
+    State state;
+    qint64 runStart;   // 候选语音段 / 候选静音段的起点
+    int runFrames;     // 候选段内累计的语音帧 / 静音帧
+
+    // 预门限：噪底能量和噪声过零率
+    double floorEnergy;
+    double floorZcr;
+    int gateWarmup;    // 已观察的帧数，噪底稳定前不跳过
+    int gatedRun;      // 当前连续跳过的帧数
+    qint64 gated;
+};
+
+#endif // VAD_ENGINE_H
@@ -1,35 +1,43 @@
 #include "vad_processor.h"
 #include <QDebug>
-#include <QEventLoop>
 
 VadProcessor::VadProcessor(QObject *parent)
     : QObject(nullptr)
-    , vad(new WebRTCVad(nullptr))
+    , engine(new VadEngine(VadEngine::Config()))  // 16kHz，中等激进程度
+    , resetRequested(false)
+    , utterance(0)
     , isRunning(false)
-    , silenceFrameCount(0)
-    , silenceFramesThreshold(50)  // 默认值
     , isProcessing(false)
-    , frameBuffer()
 {
-    // 初始化 VAD
-    vad->init(16000);  // 16kHz 采样率
-    vad->setMode(2);   // 设置中等激进程度
-
-    // 将vad对象也移动到工作线程
-    vad->moveToThread(&workerThread);
-
-    // 将对象移动到工作线程
+    // 将对象移动到工作线程。线程运行默认的事件循环（QThread::exec()），
+    // 没有音频时阻塞等待，handleNewData 以排队调用的方式在其中执行
     moveToThread(&workerThread);
 
-    // 连接线程启动信号到处理槽
-    connect(&workerThread, &QThread::started, this, &VadProcessor::run);
+    connect(&workerThread, &QThread::started, this, []() {
+        qDebug() << "VAD处理线程启动";
+    });
+    connect(&workerThread, &QThread::finished, this, []() {
+        qDebug() << "VAD处理线程结束";
+    });
 }
 
 VadProcessor::~VadProcessor()
 {
     stop();
     workerThread.wait();
-    delete vad;
+    delete engine;
+}
+
+void VadProcessor::setConfig(const VadEngine::Config& config)
+{
+    if (isRunning) {
+        qDebug() << "VAD处理器运行中，忽略配置修改";
+        return;
+    }
+    delete engine;
+    engine = new VadEngine(config);
+    qDebug() << "VAD配置: 模式" << config.mode << "起始/结束阈值" << config.onsetThreshold << config.offsetThreshold
+             << "起始" << config.onsetMs << "ms 拖尾" << config.hangoverMs << "ms";
 }
 
 void VadProcessor::start()
@@ -49,12 +57,13 @@ void VadProcessor::stop()
     }
 }
 
-void VadProcessor::reset()
+int VadProcessor::reset()
 {
+    // 清空队列和递增编号在同一把锁内完成，之后取出的音频都属于新的编号
     QMutexLocker locker(&mutex);
-    silenceFrameCount = 0;
     dataQueue.clear();
-    frameBuffer.clear();  // 清除帧缓冲
+    resetRequested = true;
+    return ++utterance;
 }
 
 void VadProcessor::processAudioData(const QByteArray& pcmData)
@@ -74,22 +83,6 @@ void VadProcessor::processAudioData(const QByteArray& pcmData)
     // qDebug() << "VAD处理器触发handleNewData:" << (success ? "成功" : "失败");
 }
 
-void VadProcessor::run()
-{
-    qDebug() << "VAD处理线程启动";
-    
-    // 创建事件循环
-    QEventLoop eventLoop;
-    
-    while (isRunning) {
-        // 处理所有待处理的事件
-        eventLoop.processEvents();
-        // QThread::msleep(1); // 短暂休眠，避免CPU占用过高
-    }
-    
-    qDebug() << "VAD处理线程结束";
-}
-
 void VadProcessor::handleNewData()
 {
     if (isProcessing) {
@@ -99,37 +92,43 @@ void VadProcessor::handleNewData()
 
     isProcessing = true;
     QByteArray pcmData;
+    bool doReset = false;
+    int dataUtterance = 0;
     
     {
         QMutexLocker locker(&mutex);
         if (!dataQueue.isEmpty()) {
             pcmData = dataQueue.dequeue();
         }
+        doReset = resetRequested;
+        resetRequested = false;
+        dataUtterance = utterance;
+    }
+
+    if (doReset) {
+        engine->reset();
     }
 
     if (!pcmData.isEmpty()) {
-        frameBuffer.append(pcmData);
-        
-        // 处理完整的帧
-        while (frameBuffer.size() >= FRAME_SIZE * sizeof(int16_t)) {
-            QByteArray frame = frameBuffer.left(FRAME_SIZE * sizeof(int16_t));
-            frameBuffer.remove(0, FRAME_SIZE * sizeof(int16_t));
-            
-            const int16_t* samples = reinterpret_cast<const int16_t*>(frame.constData());
-            bool hasVoice = vad->process(samples, FRAME_SIZE);
-            
-            if (hasVoice) {
-                // qDebug() << "检测到语音帧，重置静音计数器";
-                silenceFrameCount = 0;
+        // 任意长度的块交给引擎，内部按 10ms 分帧并保留不足一帧的尾部
+        probabilities.clear();
+        events.clear();
+        engine->process(reinterpret_cast<const int16_t*>(pcmData.constData()),
+                        pcmData.size() / sizeof(int16_t), &probabilities, &events);
+
+        for (float probability : probabilities) {
+            if (probability >= engine->config().onsetThreshold) {
                 emit voiceDetected();
+            }
+        }
+        for (const VadEngine::Event& event : events) {
+            const qint64 delayMs = (event.detectedAt - event.sample) * 1000 / engine->config().sampleRate;
+            if (event.type == VadEngine::Event::SpeechStart) {
+                qDebug() << "VAD检测到语音开始，位置:" << event.sample << "判决延迟:" << delayMs << "ms";
+                emit speechStarted(event.sample, dataUtterance);
             } else {
-                // qDebug() << "检测到静音帧，当前静音帧计数:" << silenceFrameCount;
-                silenceFrameCount++;
-                if (silenceFrameCount >= silenceFramesThreshold) {
-                    qDebug() << "WebRTC VAD检测到持续静音";
-                    emit silenceDetected();
-                    reset();
-                }
+                qDebug() << "VAD检测到语音结束，位置:" << event.sample << "判决延迟:" << delayMs << "ms";
+                emit silenceDetected(event.sample, delayMs, dataUtterance);
             }
         }
     }
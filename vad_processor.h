@@ -6,7 +6,7 @@
 #include <QMutex>
 #include <QQueue>
 #include <QByteArray>
-#include "webrtcvad.h"
+#include "vad_engine.h"
 
 class VadProcessor : public QObject
 {
@@ -17,30 +17,36 @@ public:
 
     void start();
     void stop();
-    void reset();
+    // 丢弃排队的音频，工作线程处理下一块前重置引擎。
+    // 返回的编号随之后的 silenceDetected/speechStarted 一起发出，接收方据此丢弃重置前的事件
+    int reset();
     void processAudioData(const QByteArray& pcmData);
-    void setVadFrames(int frames) { silenceFramesThreshold = frames; }
+    // 在 start() 之前调用
+    void setConfig(const VadEngine::Config& config);
 
 signals:
-    void silenceDetected();
+    // 语音结束（静音持续达到拖尾时长后发出一次），endSample 为语音结束的位置，
+    // delayMs 为语音结束到做出判断经过的音频时长，utterance 为产生事件的音频所属的 reset() 编号
+    void silenceDetected(qint64 endSample, qint64 delayMs, int utterance);
     void voiceDetected();
+    // 语音帧累计达到起始时长时发出一次，startSample 为语音开始的位置
+    void speechStarted(qint64 startSample, int utterance);
     void processingFinished();
 
 private slots:
-    void run();
     void handleNewData();
 
 private:
-    static const int FRAME_SIZE = 160;  // 10ms at 16kHz
     QThread workerThread;
-    WebRTCVad* vad;
+    VadEngine* engine;
     QMutex mutex;
     QQueue<QByteArray> dataQueue;
-    QByteArray frameBuffer;  // 用于缓存未处理完的音频数据
+    bool resetRequested;  // reset() 可能来自其它线程，由工作线程在处理前执行
+    int utterance;        // reset() 的编号，与队列一起由 mutex 保护
     bool isRunning;
-    int silenceFrameCount;
-    int silenceFramesThreshold;
     bool isProcessing;
+    std::vector<float> probabilities;
+    std::vector<VadEngine::Event> events;
 };
 
 #endif // VAD_PROCESSOR_H 
\ No newline at end of file
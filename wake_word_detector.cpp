@@ -7,6 +7,9 @@
 #include <QWaitCondition>
 #include <QEventLoop>
 #include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
 #include <QCoreApplication>
 #include <QThread>
 #include <sstream>
@@ -18,12 +21,20 @@ WakeWordDetector::WakeWordDetector(QObject *parent)
     , recognizer(nullptr, [](VoskRecognizer* r) { if(r) vosk_recognizer_free(r); })
     , isInitialized(false)
     , isRunning(false)
+    , backlog(qEnvironmentVariableIsSet("XIAOZHI_WAKE_MAX_LAG_MS")
+              ? qEnvironmentVariableIntValue("XIAOZHI_WAKE_MAX_LAG_MS") : DEFAULT_MAX_LAG_MS)
     , mutex()
     , condition()
     , workerThread(nullptr)
-    , lastResetTime(std::chrono::steady_clock::now())
-    , accumulatedText("")
-    , lastRecognitionTime(std::chrono::steady_clock::now())
+    , requestedUtterance(0)
+    , currentUtterance(0)
+    , lag(0)
+    , dropped(0)
+    , matcher(WakeWordMatcher::Config())
+    , textMatcher(WakeWordMatcher::Config())
+    , startTime(std::chrono::steady_clock::now())
+    , wakeWordsWatcher(nullptr)
+    , wakeWordsReloadTimer(nullptr)
 {
 }
 
@@ -61,8 +72,10 @@ bool WakeWordDetector::initialize(const QString& modelPath)
     }
     recognizer.reset(rawRecognizer);
 
-    // 设置为单词模式，这样可以实时获取识别结果
-    vosk_recognizer_set_words(recognizer.get(), 1);
+    configureRecognizer(recognizer.get());
+
+    // 唤醒词配置，文件修改后自动重新加载
+    loadWakeWords(WakeWordMatcher::Config::defaultPath());
 
     isInitialized = true;
     qDebug() << "Vosk唤醒词检测器初始化成功";
@@ -78,11 +91,38 @@ void WakeWordDetector::processAudioData(const QByteArray& pcmData)
         return;
     }
 
+    int shed = 0;
+    {
+        QMutexLocker locker(&mutex);
+        // qDebug() << "processAudioData: 收到音频数据，大小:" << pcmData.size() << "字节";
+        shed = backlog.push(pcmData, std::chrono::steady_clock::now());
+        // qDebug() << "processAudioData: 当前队列中数据包数量:" << backlog.size();
+        condition.wakeOne();
+    }
+    if (shed > 0) {
+        reportDropped(shed);
+    }
+}
+
+void WakeWordDetector::setMaxLagMs(int ms)
+{
+    QMutexLocker locker(&mutex);
+    backlog.setMaxLagMs(ms);
+}
+
+int WakeWordDetector::maxLagMs() const
+{
     QMutexLocker locker(&mutex);
-    // qDebug() << "processAudioData: 收到音频数据，大小:" << pcmData.size() << "字节";
-    audioQueue.enqueue(pcmData);
-    // qDebug() << "processAudioData: 当前队列中数据包数量:" << audioQueue.size();
-    condition.wakeOne();
+    return backlog.maxLagMs();
+}
+
+void WakeWordDetector::reportDropped(int chunks)
+{
+    const int total = dropped.fetch_add(chunks, std::memory_order_relaxed) + chunks;
+    qDebug() << "唤醒词检测跟不上实时，丢弃积压音频" << chunks << "块，累计" << total << "块";
+    QMetaObject::invokeMethod(this, [this, chunks]() {
+        emit backlogDropped(chunks);
+    }, Qt::QueuedConnection);
 }
 
 void WakeWordDetector::start()
@@ -120,30 +160,111 @@ void WakeWordDetector::stop()
     workerThread.reset();
 }
 
-void WakeWordDetector::checkWakeWord(const QString& text) {
-    static const QStringList wakePatterns = {
-        "你好小智", "你好 小智",
-        "小智小智", "小智 小智",
-        "小子小子", "小子 小子",
-        "你好小子", "你好 小子"
-    };
+int WakeWordDetector::resetUtterance()
+{
+    // 工作线程处理下一块音频前检查编号并重置识别器
+    return ++requestedUtterance;
+}
 
-    QString cleanText = text;
-    cleanText.remove(' ');
-    
-    bool isWakeWordFound = false;
-    for (const QString& pattern : wakePatterns) {
-        QString cleanPattern = pattern;
-        cleanPattern.remove(' ');
-        
-        if (cleanText.contains(cleanPattern)) {
-            isWakeWordFound = true;
-            break;
+void WakeWordDetector::configureRecognizer(VoskRecognizer* recognizer)
+{
+    // 设置为单词模式，这样可以实时获取识别结果
+    vosk_recognizer_set_words(recognizer, 1);
+
+    // 端点检测用于本地断句（listen 模式 auto）
+    vosk_recognizer_set_endpointer_mode(recognizer, VOSK_EP_ANSWER_DEFAULT);
+    vosk_recognizer_set_endpointer_delays(recognizer, ENDPOINT_START_MAX_S,
+                                          ENDPOINT_END_S, ENDPOINT_MAX_S);
+}
+
+bool WakeWordDetector::loadWakeWords(const QString& path)
+{
+    wakeWordsPath = path;
+    watchWakeWords();
+
+    const QFileInfo info(path);
+    wakeWordsModified = info.exists() ? info.lastModified() : QDateTime();
+    WakeWordMatcher::Config config;
+    QString error;
+    if (!WakeWordMatcher::Config::loadIfExists(path, &config, &error)) {
+        qDebug() << "唤醒词配置无效，保持当前唤醒词:" << path << error;
+        return false;
+    }
+
+    auto next = std::make_unique<WakeWordMatcher>(config);
+    qDebug() << "唤醒词:" << next->config().patterns << "编辑距离:" << config.maxDistance
+             << "配置:" << (info.exists() ? path : QString("默认"));
+    if (!next->warnings().isEmpty()) {
+        qDebug() << "以下字没有拼音，只能精确匹配，可在配置的 pinyin 中补充:" << next->warnings();
+    }
+
+    textMatcher = *next;
+    QMutexLocker locker(&mutex);
+    pendingMatcher = std::move(next);
+    return true;
+}
+
+bool WakeWordDetector::matchesWakeWord(const QString& text) const
+{
+    return textMatcher.matches(text.toLower());
+}
+
+void WakeWordDetector::watchWakeWords()
+{
+    if (!wakeWordsWatcher) {
+        wakeWordsWatcher = new QFileSystemWatcher(this);
+        wakeWordsReloadTimer = new QTimer(this);
+        wakeWordsReloadTimer->setSingleShot(true);
+        wakeWordsReloadTimer->setInterval(WAKE_WORDS_RELOAD_DELAY_MS);
+        connect(wakeWordsWatcher, &QFileSystemWatcher::fileChanged,
+                wakeWordsReloadTimer, qOverload<>(&QTimer::start));
+        connect(wakeWordsWatcher, &QFileSystemWatcher::directoryChanged,
+                wakeWordsReloadTimer, qOverload<>(&QTimer::start));
+        connect(wakeWordsReloadTimer, &QTimer::timeout, this, [this]() {
+            // 目录中其他文件的变化也会触发，只在配置文件本身变化时重新加载
+            const QFileInfo info(wakeWordsPath);
+            if ((info.exists() ? info.lastModified() : QDateTime()) != wakeWordsModified) {
+                loadWakeWords(wakeWordsPath);
+            } else {
+                watchWakeWords();
+            }
+        });
+    }
+
+    // 很多编辑器保存时先删除再重建文件，文件的监视随之失效，所以同时监视所在目录，
+    // 文件新建或重建后重新加入
+    const QFileInfo info(wakeWordsPath);
+    QStringList wanted;
+    if (info.exists()) {
+        wanted.append(info.absoluteFilePath());
+    }
+    if (QFileInfo::exists(info.absolutePath())) {
+        wanted.append(info.absolutePath());
+    }
+    const QStringList watched = wakeWordsWatcher->files() + wakeWordsWatcher->directories();
+    for (const QString& path : watched) {
+        if (!wanted.contains(path)) {
+            wakeWordsWatcher->removePath(path);
+        }
+    }
+    for (const QString& path : wanted) {
+        if (!watched.contains(path)) {
+            wakeWordsWatcher->addPath(path);
         }
     }
+}
+
+qint64 WakeWordDetector::elapsedMs() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
 
-    if (isWakeWordFound) {
-        qDebug() << "processingLoop: 检测到唤醒词！完整文本:" << text;
+void WakeWordDetector::checkWakeWord(const QString& partial, qint64 timestampMs) {
+    if (matcher.feed(partial, timestampMs)) {
+        const QString text = matcher.accumulatedText();
+        qDebug() << "processingLoop: 检测到唤醒词！完整文本:" << text
+                 << "匹配:" << matcher.matchedPattern() << "编辑距离:" << matcher.matchedDistance();
         
         QMetaObject::invokeMethod(this, [this, text]() {
             emit wakeWordDetected(text);
@@ -152,14 +273,12 @@ void WakeWordDetector::checkWakeWord(const QString& text) {
         // 重置识别器状态
         vosk_recognizer_reset(recognizer.get());
         
-        // 清空累积的文本和重置时间
-        accumulatedText.clear();
-        lastRecognitionTime = std::chrono::steady_clock::now();
-        lastResetTime = std::chrono::steady_clock::now();
+        // 清空匹配状态
+        matcher.reset(timestampMs);
         
         // 获取一次部分识别结果以清空缓存
-        const char* partial = vosk_recognizer_partial_result(recognizer.get());
-        if (partial) {
+        const char* flushed = vosk_recognizer_partial_result(recognizer.get());
+        if (flushed) {
             qDebug() << "processingLoop: 识别器状态已重置";
         }
     }
@@ -172,11 +291,13 @@ void WakeWordDetector::processingLoop()
     qDebug() << "processingLoop: 处理循环开始运行，线程ID:" << QString::fromStdString(ss.str());
     
     while (isRunning) {
-        QByteArray audioData;
+        AudioBacklog::Chunk chunk;
+        std::unique_ptr<WakeWordMatcher> reloaded;
+        int shed = 0;
         
         {
             QMutexLocker locker(&mutex);
-            while (audioQueue.isEmpty() && isRunning) {
+            while (backlog.isEmpty() && isRunning) {
                 condition.wait(&mutex);
             }
             
@@ -184,15 +305,45 @@ void WakeWordDetector::processingLoop()
                 break;
             }
             
-            if (!audioQueue.isEmpty()) {
-                audioData = audioQueue.dequeue();
+            // 采集停止后不再有新的音频入队，取出前也检查一次积压
+            shed = backlog.shed(std::chrono::steady_clock::now());
+            if (!backlog.isEmpty()) {
+                chunk = backlog.takeFirst();
             }
+            reloaded = std::move(pendingMatcher);
+        }
+        if (shed > 0) {
+            reportDropped(shed);
+        }
+        const QByteArray& audioData = chunk.data;
+
+        // 唤醒词配置重新加载后从下一块音频开始使用
+        if (reloaded) {
+            matcher = *reloaded;
+            matcher.reset(elapsedMs());
         }
         
+        // 新的一句：端点检测的开头静音计时从这里开始
+        const int utterance = requestedUtterance.load();
+        if (utterance != currentUtterance) {
+            currentUtterance = utterance;
+            vosk_recognizer_reset(recognizer.get());
+            matcher.reset(elapsedMs());
+        }
+
+        // 前面的积压被丢弃，音频不连续，从这一块重新开始识别
+        if (chunk.discontinuity) {
+            vosk_recognizer_reset(recognizer.get());
+            matcher.reset(elapsedMs());
+        }
+
         if (!audioData.isEmpty()) {
             int result = vosk_recognizer_accept_waveform(recognizer.get(), 
                                                    audioData.constData(),
                                                    audioData.size());
+            // 这块音频在入队时已采集完，识别完成时落后墙上时钟的时间
+            lag.store(static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - chunk.enqueued).count()), std::memory_order_relaxed);
             
             if (result < 0) {
                 qDebug() << "processingLoop: 音频数据处理失败";
@@ -209,28 +360,25 @@ void WakeWordDetector::processingLoop()
                     if (!text.isEmpty()) {
                         // qDebug() << "processingLoop: 识别到的文本:" << text;
 
-                        auto currentTime = std::chrono::steady_clock::now();
-                        auto timeSinceLastRecognition = std::chrono::duration_cast<std::chrono::milliseconds>(
-                            currentTime - lastRecognitionTime).count();
-
-                        // 如果超过时间窗口或累积文本过长，重置累积
-                        if (timeSinceLastRecognition > ACCUMULATION_WINDOW_MS || 
-                            accumulatedText.length() > MAX_ACCUMULATED_LENGTH) {
-                            accumulatedText.clear();
-                        }
-
-                        // 更新累积文本和时间
-                        if (!accumulatedText.isEmpty()) {
-                            accumulatedText += " ";
-                        }
-                        accumulatedText += text;
-                        lastRecognitionTime = currentTime;
-
-                        // 检查累积的文本是否包含唤醒词
-                        checkWakeWord(accumulatedText);
+                        // 按拼音模糊匹配唤醒词
+                        checkWakeWord(text, elapsedMs());
                     }
                 }
             }
+
+            // 端点：先按上面的流程检查完唤醒词，再取出整句结果（识别器随后开始新的一句）
+            if (result == 1) {
+                // 下一句在时间窗口内接着这一句匹配，唤醒词可以被端点分开
+                matcher.endUtterance();
+                const char* final = vosk_recognizer_result(recognizer.get());
+                QString text;
+                if (final) {
+                    text = QJsonDocument::fromJson(final).object()["text"].toString();
+                }
+                QMetaObject::invokeMethod(this, [this, text, utterance]() {
+                    emit endpointDetected(text, utterance);
+                }, Qt::QueuedConnection);
+            }
         }
     }
     
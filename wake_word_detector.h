@@ -3,17 +3,21 @@
 
 #include <QObject>
 #include <QString>
-#include <QQueue>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QDateTime>
 #include <memory>
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include "audio_backlog.h"
+#include "wake_word_matcher.h"
 
 // 前向声明 VoskRecognizer 和 VoskModel
 struct VoskRecognizer;
 struct VoskModel;
+class QFileSystemWatcher;
+class QTimer;
 
 class WakeWordDetector : public QObject
 {
@@ -26,23 +30,60 @@ public:
     // 初始化检测器
     bool initialize(const QString& modelPath);
     
-    // 处理音频数据
+    // 处理音频数据（音频线程）。识别落后实时超过 maxLagMs 时跳过积压的音频
     void processAudioData(const QByteArray& pcmData);
+
+    // 积压上限，默认取 XIAOZHI_WAKE_MAX_LAG_MS（未设置时 DEFAULT_MAX_LAG_MS），0 不限制
+    void setMaxLagMs(int ms);
+    int maxLagMs() const;
+
+    // 统计：检测延迟（刚识别完的一块音频落后墙上时钟的时间）、因积压丢弃的音频块数
+    int lagMs() const { return lag.load(std::memory_order_relaxed); }
+    int droppedChunks() const { return dropped.load(std::memory_order_relaxed); }
     
     // 启动和停止处理线程
     void start();
     void stop();
 
+    // 开始新的一句（进入监听时调用）：识别器在处理下一块音频前重置，
+    // 端点计时从此开始。返回的编号随之后的 endpointDetected 一起发出
+    int resetUtterance();
+
+    // 读取唤醒词配置（见 WakeWordMatcher::Config::load），文件不存在时使用默认唤醒词。
+    // 在界面线程调用，工作线程处理下一块音频前换用新的匹配器。
+    // initialize() 之后配置文件（WakeWordMatcher::Config::defaultPath()）被修改时自动调用
+    bool loadWakeWords(const QString& path);
+
+    // 文本（如服务端识别结果）中是否包含当前配置的唤醒词，与音频检测使用同一配置。
+    // 在界面线程调用
+    bool matchesWakeWord(const QString& text) const;
+
+    // 识别器设置（单词模式、端点参数），离线评估工具用同样的设置回放
+    static void configureRecognizer(VoskRecognizer* recognizer);
+
+    // 共享给本地识别器（LocalAsr），初始化成功后有效
+    VoskModel* voskModel() const { return model.get(); }
+
 signals:
     // 当检测到唤醒词时发出信号
     void wakeWordDetected(const QString& text);
+
+    // Vosk 端点检测：说完一句后静音超过 ENDPOINT_END_S，或开头静音超过
+    // ENDPOINT_START_MAX_S。text 为这一句的最终识别结果，utterance 为 resetUtterance() 的编号
+    void endpointDetected(const QString& text, int utterance);
     
     // 当初始化完成时发出信号
     void initializationFinished(bool success);
 
+    // 识别跟不上实时，丢弃了 chunks 块积压音频，识别器从最新的音频重新开始
+    void backlogDropped(int chunks);
+
 private:
     void processingLoop();  // 处理循环函数
-    void checkWakeWord(const QString& text); // 检查唤醒词的辅助函数
+    void checkWakeWord(const QString& partial, qint64 timestampMs); // 检查唤醒词的辅助函数
+    qint64 elapsedMs() const;  // 唤醒词匹配使用的时间（自创建起的单调时钟）
+    void watchWakeWords();     // 监视配置文件，修改后重新加载
+    void reportDropped(int chunks);  // 累计丢弃数并通知界面线程（任意线程）
 
 private:
     std::unique_ptr<VoskModel, void(*)(VoskModel*)> model;
@@ -51,16 +92,35 @@ private:
     std::atomic<bool> isRunning;
     
     std::unique_ptr<std::thread> workerThread;
-    QQueue<QByteArray> audioQueue;
-    QMutex mutex;
+    AudioBacklog backlog;       // 由 mutex 保护
+    mutable QMutex mutex;
     QWaitCondition condition;
-    std::chrono::steady_clock::time_point lastResetTime;
+    std::atomic<int> requestedUtterance;  // resetUtterance() 请求的编号
+    int currentUtterance;                 // 工作线程已应用的编号
+    std::atomic<int> lag;
+    std::atomic<int> dropped;
+
+    // 部分识别结果按拼音模糊匹配唤醒词
+    WakeWordMatcher matcher;
+    WakeWordMatcher textMatcher;  // 界面线程的副本，供 matchesWakeWord() 使用
+    std::unique_ptr<WakeWordMatcher> pendingMatcher;  // 重新加载的配置，由 mutex 保护
+    std::chrono::steady_clock::time_point startTime;
+
+    // 唤醒词配置的热加载（界面线程）
+    QString wakeWordsPath;
+    QFileSystemWatcher* wakeWordsWatcher;
+    QTimer* wakeWordsReloadTimer;
+    QDateTime wakeWordsModified;  // 上次加载时文件的修改时间，文件不存在时无效
+
+    // Vosk 端点参数（秒）
+    static constexpr float ENDPOINT_START_MAX_S = 5.0f;        // 开头持续静音
+    static constexpr float ENDPOINT_END_S = 0.5f;              // 说完后的静音
+    static constexpr float ENDPOINT_MAX_S = 20.0f;             // 一句的最长时长
+
+    static constexpr int DEFAULT_MAX_LAG_MS = 1000;
 
-    // 新增：用于累积识别结果
-    QString accumulatedText;                                    // 累积的识别文本
-    std::chrono::steady_clock::time_point lastRecognitionTime; // 上次识别时间
-    static constexpr int ACCUMULATION_WINDOW_MS = 1500;        // 累积窗口时间（毫秒）
-    static constexpr int MAX_ACCUMULATED_LENGTH = 50;          // 最大累积长度
+    // 配置文件变化后等待的时间，编辑器保存时的多次通知合并为一次加载
+    static constexpr int WAKE_WORDS_RELOAD_DELAY_MS = 300;
 };
 
 #endif // WAKE_WORD_DETECTOR_H 
\ No newline at end of file
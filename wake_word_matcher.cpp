@@ -0,0 +1,274 @@
+#include "wake_word_matcher.h"
+#include "pinyin.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <algorithm>
+
+namespace {
+constexpr int SIMILAR_COST = 1;   // 易混音节
+constexpr int EDIT_COST = 3;      // 其他替换、多出或缺少一个音节
+}
+
+QStringList WakeWordMatcher::Config::defaultPatterns()
+{
+    // "小子小子"、"你好小子" 等近音误识别由模糊匹配覆盖
+    return {"你好小智", "小智小智"};
+}
+
+bool WakeWordMatcher::Config::load(const QString& path, Config* config, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!doc.isObject()) {
+        *error = parseError.error != QJsonParseError::NoError ? parseError.errorString() : "不是 JSON 对象";
+        return false;
+    }
+
+    const QJsonObject root = doc.object();
+    Config loaded;
+    for (const QJsonValue& value : root.value("wake_words").toArray()) {
+        const QString pattern = value.toString().trimmed();
+        if (!pattern.isEmpty()) {
+            loaded.patterns.append(pattern);
+        }
+    }
+    loaded.maxDistance = qMax(0, root.value("max_distance").toInt(loaded.maxDistance));
+    loaded.windowMs = qMax(0, root.value("window_ms").toInt(loaded.windowMs));
+    const QJsonObject pinyin = root.value("pinyin").toObject();
+    for (auto it = pinyin.constBegin(); it != pinyin.constEnd(); ++it) {
+        const QString syllable = it.value().toString().trimmed().toLower();
+        if (it.key().size() == 1 && !syllable.isEmpty()) {
+            loaded.pinyin.insert(it.key().at(0), syllable);
+        }
+    }
+    *config = loaded;
+    return true;
+}
+
+bool WakeWordMatcher::Config::loadIfExists(const QString& path, Config* config, QString* error)
+{
+    if (!QFileInfo::exists(path)) {
+        *config = Config();
+        return true;
+    }
+    return load(path, config, error);
+}
+
+QString WakeWordMatcher::Config::defaultPath()
+{
+    const QString path = qEnvironmentVariable("XIAOZHI_WAKE_CONFIG");
+    if (!path.isEmpty()) {
+        return path;
+    }
+    // 不用 AppConfigLocation：离线工具的程序名不同，也要读到主程序（xiaozhi_qt）的配置
+    return QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+           + "/xiaozhi_qt/wake_words.json";
+}
+
+WakeWordMatcher::WakeWordMatcher(const Config& config)
+    : cfg(config)
+    , lastFeedMs(0)
+    , matchedCost(0)
+{
+    if (cfg.patterns.isEmpty()) {
+        cfg.patterns = Config::defaultPatterns();
+    }
+    nodes.push_back({-1, -1, -1});
+    for (const QString& pattern : cfg.patterns) {
+        addPattern(pattern);
+    }
+    states.assign(1, initialState());
+}
+
+QString WakeWordMatcher::syllableOf(QChar c) const
+{
+    const auto it = cfg.pinyin.constFind(c);
+    return it != cfg.pinyin.constEnd() ? it.value() : Pinyin::of(c);
+}
+
+int WakeWordMatcher::symbolOf(const QString& syllable)
+{
+    int index = symbols.indexOf(syllable);
+    if (index < 0) {
+        index = symbols.size();
+        symbols.append(syllable);
+    }
+    return index;
+}
+
+void WakeWordMatcher::addPattern(const QString& pattern)
+{
+    // 含字母时按空格分隔的拼音处理，否则逐字查拼音
+    QStringList syllables;
+    if (pattern.contains(QRegularExpression("[A-Za-z]"))) {
+        syllables = pattern.toLower().split(' ', Qt::SkipEmptyParts);
+    } else {
+        for (QChar c : pattern) {
+            if (c.isSpace()) {
+                continue;
+            }
+            QString syllable = syllableOf(c);
+            if (syllable.isEmpty()) {
+                if (!unknownChars.contains(c)) {
+                    unknownChars.append(c);
+                }
+                syllable = c;
+            }
+            syllables.append(syllable);
+        }
+    }
+    if (syllables.isEmpty()) {
+        return;
+    }
+
+    int node = 0;
+    for (const QString& syllable : syllables) {
+        const int symbol = symbolOf(syllable);
+        int child = -1;
+        for (size_t n = node + 1; n < nodes.size(); ++n) {
+            if (nodes[n].parent == node && nodes[n].symbol == symbol) {
+                child = static_cast<int>(n);
+                break;
+            }
+        }
+        if (child < 0) {
+            child = static_cast<int>(nodes.size());
+            nodes.push_back({node, symbol, -1});
+        }
+        node = child;
+    }
+    if (nodes[node].pattern >= 0) {
+        return;  // 重复的唤醒词
+    }
+    nodes[node].pattern = patternNames.size();
+    patternNames.append(pattern);
+    // 两三个音节的短唤醒词容错减半，避免普通词语误唤醒
+    thresholds.push_back(syllables.size() >= 4 ? cfg.maxDistance : cfg.maxDistance / 2);
+}
+
+std::vector<int> WakeWordMatcher::initialState() const
+{
+    // 还没有文本时，到每个节点的代价是缺少路径上全部音节
+    std::vector<int> state(nodes.size(), 0);
+    for (size_t n = 1; n < nodes.size(); ++n) {
+        state[n] = state[nodes[n].parent] + EDIT_COST;
+    }
+    return state;
+}
+
+int WakeWordMatcher::step(const std::vector<int>& from, QChar c, std::vector<int>* to, int* cost) const
+{
+    QString syllable = syllableOf(c);
+    if (syllable.isEmpty()) {
+        syllable = c;
+    }
+    std::vector<int> substitution(symbols.size());
+    for (int k = 0; k < symbols.size(); ++k) {
+        if (symbols[k] == syllable) {
+            substitution[k] = 0;
+        } else {
+            substitution[k] = Pinyin::similar(symbols[k], syllable) ? SIMILAR_COST : EDIT_COST;
+        }
+    }
+
+    // to[n]：根到 n 的音节与以这个字结尾的某段文本之间的最小编辑距离。
+    // 根的代价恒为 0，唤醒词可以从文本任意位置开始
+    to->assign(nodes.size(), 0);
+    int found = -1;
+    for (size_t n = 1; n < nodes.size(); ++n) {
+        const Node& node = nodes[n];
+        const int value = std::min({from[node.parent] + substitution[node.symbol],
+                                    from[n] + EDIT_COST,
+                                    (*to)[node.parent] + EDIT_COST});
+        (*to)[n] = value;
+        if (node.pattern >= 0 && value <= thresholds[node.pattern] && (found < 0 || value < *cost)) {
+            found = node.pattern;
+            *cost = value;
+        }
+    }
+    return found;
+}
+
+bool WakeWordMatcher::feed(const QString& partial, qint64 timestampMs)
+{
+    // 距离上一次部分结果超过时间窗口，之前的内容不再拼接
+    if (timestampMs - lastFeedMs > cfg.windowMs) {
+        current.clear();
+        states.assign(1, initialState());
+    }
+    lastFeedMs = timestampMs;
+
+    QString text = partial;
+    text.remove(' ');
+
+    // 与上一次部分结果相同的前缀已经匹配过，从分叉处的状态继续
+    int common = 0;
+    const int limit = qMin(current.size(), text.size());
+    while (common < limit && current[common] == text[common]) {
+        ++common;
+    }
+    current = text;
+    states.resize(common + 1);
+
+    // 超出预算时只处理最后 budgetSyllables 个字，更早的内容在之前的部分结果中已经检查过
+    int start = common;
+    if (text.size() - start > cfg.budgetSyllables) {
+        start = text.size() - cfg.budgetSyllables;
+        states.resize(start + 1, initialState());
+    }
+
+    int found = -1;
+    for (int i = start; i < text.size(); ++i) {
+        std::vector<int> next;
+        int cost = 0;
+        const int pattern = step(states.back(), text[i], &next, &cost);
+        states.push_back(std::move(next));
+        if (pattern >= 0 && found < 0) {
+            found = pattern;
+            matched = patternNames[pattern];
+            matchedCost = cost;
+        }
+    }
+    return found >= 0;
+}
+
+void WakeWordMatcher::endUtterance()
+{
+    std::vector<int> last = states.back();
+    states.assign(1, std::move(last));
+    current.clear();
+}
+
+void WakeWordMatcher::reset(qint64 timestampMs)
+{
+    current.clear();
+    states.assign(1, initialState());
+    lastFeedMs = timestampMs;
+}
+
+bool WakeWordMatcher::matches(const QString& text) const
+{
+    std::vector<int> state = initialState();
+    std::vector<int> next;
+    for (QChar c : text) {
+        if (c.isSpace()) {
+            continue;
+        }
+        int cost = 0;
+        if (step(state, c, &next, &cost) >= 0) {
+            return true;
+        }
+        state.swap(next);
+    }
+    return false;
+}
@@ -0,0 +1,98 @@
+#ifndef WAKE_WORD_MATCHER_H
+#define WAKE_WORD_MATCHER_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+// 唤醒词匹配：唤醒词按拼音音节编译成一棵前缀树，Vosk 的部分识别结果也转成音节，
+// 在音节序列上做有界编辑距离的近似匹配（所有唤醒词一次扫描完成）。
+// 相同音节代价 0，易混音节（见 Pinyin::similar）代价 1，其他替换、多出或缺少
+// 一个音节代价 3，因此 "小子小子" 之类的近音误识别不用再逐条列出。
+//
+// 部分结果通常只在末尾增长，匹配状态按位置保存，每次只处理与上一次不同的部分，
+// 并且一次最多处理 budgetSyllables 个音节，每块音频的匹配开销有固定上限。
+// 时间由调用方传入（实时运行用单调时钟，离线评估用音频时间），
+// 同一段音频在两种情况下的判决完全相同
+class WakeWordMatcher
+{
+public:
+    struct Config {
+        int windowMs = 1500;        // 上一句结束后超过此值才来的部分结果不再与之拼接
+        int maxDistance = 2;        // 允许的编辑距离（两三个音节的短唤醒词减半）
+        int budgetSyllables = 32;   // 每次送入最多处理的音节数
+        QStringList patterns;       // 汉字或空格分隔的拼音，为空时使用 defaultPatterns()
+        QHash<QChar, QString> pinyin;  // 补充或覆盖内置拼音表
+
+        static QStringList defaultPatterns();
+
+        // 唤醒词配置文件（JSON），例如
+        // {"wake_words": ["你好小智", "小智小智"], "max_distance": 2,
+        //  "window_ms": 1500, "pinyin": {"喆": "zhe"}}
+        // 没有给出的字段保持默认值
+        static bool load(const QString& path, Config* config, QString* error);
+
+        // 与检测器相同的规则：文件存在时按 load() 读取，不存在时使用默认配置
+        static bool loadIfExists(const QString& path, Config* config, QString* error);
+
+        // XIAOZHI_WAKE_CONFIG，未设置时为主程序配置目录下的 wake_words.json（离线工具也读同一个文件）
+        static QString defaultPath();
+    };
+
+    explicit WakeWordMatcher(const Config& config);
+
+    const Config& config() const { return cfg; }
+
+    // 唤醒词中没有读音、只能按原字精确匹配的字
+    const QStringList& warnings() const { return unknownChars; }
+
+    // 送入一次非空的部分结果（已转小写），返回是否出现唤醒词
+    bool feed(const QString& partial, qint64 timestampMs);
+
+    // Vosk 端点：之后的部分结果属于新的一句，在时间窗口内接在这一句后面匹配
+    void endUtterance();
+
+    // 检测到唤醒词或开始新的一句后清空匹配状态
+    void reset(qint64 timestampMs);
+
+    // 当前这一句（去掉空格）
+    const QString& accumulatedText() const { return current; }
+
+    // 最近一次检出的唤醒词和编辑距离
+    const QString& matchedPattern() const { return matched; }
+    int matchedDistance() const { return matchedCost; }
+
+    // 文本（忽略空格）中是否包含任一唤醒词
+    bool matches(const QString& text) const;
+
+private:
+    struct Node {
+        int parent;
+        int symbol;     // 在 symbols 中的下标
+        int pattern;    // 在此结束的唤醒词，没有时为 -1
+    };
+
+    void addPattern(const QString& pattern);
+    int symbolOf(const QString& syllable);
+    QString syllableOf(QChar c) const;
+    // 代价向量送入一个字后的结果；检出时返回唤醒词下标，否则返回 -1
+    int step(const std::vector<int>& from, QChar c, std::vector<int>* to, int* cost) const;
+    std::vector<int> initialState() const;
+
+    Config cfg;
+    QStringList symbols;           // 唤醒词中出现的音节（没有读音的字按原字）
+    std::vector<Node> nodes;       // 前缀树，父节点排在子节点前面，0 为根
+    QStringList patternNames;
+    std::vector<int> thresholds;   // 每个唤醒词允许的编辑距离
+    QStringList unknownChars;
+
+    // states[i] 为当前这一句前 i 个字之后各节点的最小代价，states[0] 为上一句接过来的状态
+    QString current;
+    std::vector<std::vector<int>> states;
+    qint64 lastFeedMs;
+    QString matched;
+    int matchedCost;
+};
+
+#endif // WAKE_WORD_MATCHER_H
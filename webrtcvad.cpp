@@ -125,4 +125,101 @@ bool WebRTCVad::process(const int16_t* audio_frame, size_t frame_length)
     }
 
     return (ret == 1);  // 1表示检测到语音
-} 
\ No newline at end of file
+} 
+
+WebRTCVadBatch::WebRTCVadBatch(QObject *parent)
+    : QObject(parent)
+    , handle(nullptr)
+    , stream_count(0)
+    , sample_rate(16000)
+{
+}
+
+WebRTCVadBatch::~WebRTCVadBatch()
+{
+    if (handle) {
+        fvad_batch_free(handle);
+        handle = nullptr;
+    }
+}
+
+bool WebRTCVadBatch::init(int streams, int sampleRate)
+{
+    if (handle) {
+        fvad_batch_free(handle);
+        handle = nullptr;
+        stream_count = 0;
+    }
+
+    if (streams <= 0) {
+        qDebug() << "批量VAD路数不合法:" << streams;
+        return false;
+    }
+
+    handle = fvad_batch_new(static_cast<size_t>(streams));
+    if (!handle) {
+        qDebug() << "创建批量VAD实例失败";
+        return false;
+    }
+
+    if (fvad_batch_set_sample_rate(handle, sampleRate) < 0) {
+        qDebug() << "不支持的采样率:" << sampleRate;
+        fvad_batch_free(handle);
+        handle = nullptr;
+        return false;
+    }
+
+    stream_count = streams;
+    sample_rate = sampleRate;
+    results.resize(streams);
+
+    // 与 WebRTCVad 相同，默认使用中等激进程度
+    setMode(2);
+
+    qDebug() << "批量VAD初始化成功，路数:" << streams << "采样率:" << sampleRate;
+    return true;
+}
+
+bool WebRTCVadBatch::setMode(int mode)
+{
+    if (!handle) {
+        qDebug() << "批量VAD未初始化";
+        return false;
+    }
+
+    if (fvad_batch_set_mode(handle, mode) < 0) {
+        qDebug() << "不合法的VAD模式:" << mode;
+        return false;
+    }
+
+    qDebug() << "设置批量VAD模式成功:" << mode;
+    return true;
+}
+
+bool WebRTCVadBatch::resetStream(int stream)
+{
+    if (!handle || stream < 0) {
+        return false;
+    }
+    // 某一路断开后复用给新连接时，清掉这一路的噪声模型
+    return fvad_batch_reset_stream(handle, static_cast<size_t>(stream)) == 0;
+}
+
+bool WebRTCVadBatch::process(const int16_t* const* frames, size_t frame_length, QVector<bool>& decisions)
+{
+    if (!handle) {
+        qDebug() << "批量VAD未初始化";
+        return false;
+    }
+
+    if (fvad_batch_process(handle, frames, frame_length, results.data()) < 0) {
+        qDebug() << "不支持的帧时长:" << (frame_length * 1000) / sample_rate << "ms";
+        return false;
+    }
+
+    decisions.resize(stream_count);
+    for (int i = 0; i < stream_count; ++i) {
+        decisions[i] = results[i] == 1;
+    }
+    return true;
+}
@@ -2,6 +2,7 @@
 #define WEBRTCVAD_H
 
 #include <QObject>
+#include <QVector>
 #include <fvad.h>
 
 // 前向声明
@@ -24,4 +25,29 @@ private:
     bool initialized;
 };
 
+// 多路批量 VAD：网关同时处理大量麦克风流时使用，
+// 每次调用处理所有流的一帧，判决与每路单独使用 WebRTCVad 完全一致
+class WebRTCVadBatch : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WebRTCVadBatch(QObject *parent = nullptr);
+    ~WebRTCVadBatch();
+
+    bool init(int streams, int sampleRate = 16000);
+    bool setMode(int mode); // 0-3，所有流共用
+    bool resetStream(int stream);
+    int streamCount() const { return stream_count; }
+
+    // frames 为每路一个指针，每路 frame_length 个样本（10/20/30ms）；
+    // decisions 按流的顺序写入是否检测到语音
+    bool process(const int16_t* const* frames, size_t frame_length, QVector<bool>& decisions);
+
+private:
+    FvadBatch* handle;
+    int stream_count;
+    int sample_rate;
+    QVector<int> results;
+};
+
 #endif // WEBRTCVAD_H 
\ No newline at end of file
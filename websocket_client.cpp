@@ -3,17 +3,30 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDebug>
-#include <QNetworkInterface>
-#include <QCryptographicHash>
-#include <QUdpSocket>
-#include <QHostAddress>
-#include <QNetworkAddressEntry>
+#include "binary_protocol.h"
+#include "device_identity.h"
+#ifndef QT_NO_SSL
+#include <QSslConfiguration>
+#endif
 
 // 配置参数
 #define CONFIG_WEBSOCKET_ACCESS_TOKEN "test-token"  // 替换为实际的访问令牌
 
+// WebSocket 帧头长度（RFC 6455），客户端发出的帧带 4 字节掩码
+static int frameOverhead(int payloadSize, bool masked)
+{
+    int overhead = 2;
+    if (payloadSize > 65535) {
+        overhead += 8;
+    } else if (payloadSize > 125) {
+        overhead += 2;
+    }
+    return masked ? overhead + 4 : overhead;
+}
+
 WebSocketClient::WebSocketClient(QObject *parent)
-    : QObject(parent)
+    : Transport(parent)
+    , accessToken(CONFIG_WEBSOCKET_ACCESS_TOKEN)
 {
     connect(&webSocket, &QWebSocket::connected, this, &WebSocketClient::onConnected);
     connect(&webSocket, &QWebSocket::disconnected, this, &WebSocketClient::onDisconnected);
@@ -23,6 +36,11 @@ WebSocketClient::WebSocketClient(QObject *parent)
             this, &WebSocketClient::onError);
             
     connect(&timeoutTimer, &QTimer::timeout, this, &WebSocketClient::checkTimeout);
+    
+    // 握手后周期性 ping，检测半开连接并测量 RTT
+    connect(&webSocket, &QWebSocket::pong, this, &WebSocketClient::onPong);
+    connect(&keepAliveTimer, &QTimer::timeout, this, &WebSocketClient::sendKeepAlive);
+    keepAliveTimer.setInterval(DEFAULT_KEEPALIVE_MS);
 }
 
 WebSocketClient::~WebSocketClient()
@@ -41,20 +59,18 @@ bool WebSocketClient::connectToServer(const QString& url)
     
     // 设置请求头
     QNetworkRequest request(url);
-    request.setRawHeader("Protocol-Version", "1");
-    request.setRawHeader("Authorization", "Bearer " + QString(CONFIG_WEBSOCKET_ACCESS_TOKEN).toUtf8());
+    request.setRawHeader("Protocol-Version", QByteArray::number(preferredVersion));
+    negotiatedVersion = 1;
+    compressionActive = false;
+    deflate.reset();
+    request.setRawHeader("Authorization", "Bearer " + accessToken.toUtf8());
     
-    // 获取设备信息作为ID
-    // 44:AF:28:64:ED:3F
-    // QString deviceId = "44:a4:4c:59:44:60";  // TODO: 从实际设备获取 MAC 地址
-    // QString deviceId = "44:af:28:64:ed:3f";
-    // QString clientId = "23e62604-e78c-4efd-88df-6652c22b63e9";  // TODO: 生成唯一的客户端 ID
-    QString deviceId = getMacAddress();
-    QString clientId = generateClientId(deviceId);
-    qDebug() << "Device MAC:" << deviceId;
-    qDebug() << "Client ID:" << clientId;
-    request.setRawHeader("Device-Id", deviceId.toUtf8());
-    request.setRawHeader("Client-Id", clientId.toUtf8());
+    // 设备标识只在首次使用时解析，之后直接取缓存结果，不阻塞连接
+    const DeviceIdentity& identity = DeviceIdentity::current();
+    qDebug() << "Device MAC:" << identity.deviceId;
+    qDebug() << "Client ID:" << identity.clientId;
+    request.setRawHeader("Device-Id", identity.deviceId.toUtf8());
+    request.setRawHeader("Client-Id", identity.clientId.toUtf8());
     
     qDebug() << "Connecting to WebSocket server:" << url;
     webSocket.open(request);
@@ -65,16 +81,24 @@ bool WebSocketClient::connectToServer(const QString& url)
     return true;
 }
 
-void WebSocketClient::sendAudio(const std::vector<uint8_t>& data)
+void WebSocketClient::sendAudio(const QByteArray& opusData)
 {
-    // qDebug() << "发送音频数据大小 B:" << data.size() << "字节";
     if (!isConnected()) {
         return;
     }
-    // qDebug() << "发送音频数据大小 A:" << data.size() << "字节";
     
-    QByteArray byteArray(reinterpret_cast<const char*>(data.data()), data.size());
-    webSocket.sendBinaryMessage(byteArray);
+    if (negotiatedVersion == 1) {
+        webSocket.sendBinaryMessage(opusData);
+        wireStats.audioBytesSent += opusData.size() + frameOverhead(opusData.size(), true);
+        return;
+    }
+    
+    // 帧头和负载写入复用的发送缓冲区
+    BinaryProtocol::build(negotiatedVersion, BinaryProtocol::Audio,
+                          static_cast<quint32>(sessionClock.elapsed()),
+                          opusData.constData(), opusData.size(), txFrame);
+    webSocket.sendBinaryMessage(txFrame);
+    wireStats.audioBytesSent += txFrame.size() + frameOverhead(txFrame.size(), true);
 }
 
 void WebSocketClient::sendText(const QString& text)
@@ -83,12 +107,30 @@ void WebSocketClient::sendText(const QString& text)
         return;
     }
     qDebug() << "发送文本消息:" << text;
+    
+    const QByteArray utf8 = text.toUtf8();
+    wireStats.jsonBytesSent += utf8.size();
+    if (compressionActive && utf8.size() >= compressionThreshold) {
+        // 压缩状态在两端连续累积，压缩过的消息必须发出，不能再退回原文
+        if (deflate.compress(utf8.constData(), utf8.size(), deflateBuffer)) {
+            BinaryProtocol::build(negotiatedVersion, BinaryProtocol::DeflateJson,
+                                  static_cast<quint32>(sessionClock.elapsed()),
+                                  deflateBuffer.constData(), deflateBuffer.size(), txFrame);
+            webSocket.sendBinaryMessage(txFrame);
+            wireStats.textBytesSent += txFrame.size() + frameOverhead(txFrame.size(), true);
+            ++wireStats.compressedSent;
+            return;
+        }
+        qDebug() << "压缩失败，发送原文";
+    }
     webSocket.sendTextMessage(text);
+    wireStats.textBytesSent += utf8.size() + frameOverhead(utf8.size(), true);
 }
 
 void WebSocketClient::closeConnection()
 {
     timeoutTimer.stop();
+    keepAliveTimer.stop();
     webSocket.close();
 }
 
@@ -107,6 +149,7 @@ void WebSocketClient::onDisconnected()
 {
     qDebug() << "WebSocket disconnected";
     serverHelloReceived = false;
+    keepAliveTimer.stop();
     if (onDisconnectedCallback) {
         onDisconnectedCallback();
     }
@@ -114,62 +157,176 @@ void WebSocketClient::onDisconnected()
 
 void WebSocketClient::onBinaryMessageReceived(const QByteArray &message)
 {
-    if (onAudioCallback) {
-        std::vector<uint8_t> data(message.begin(), message.end());
-        onAudioCallback(data);
+    BinaryProtocol::PacketView packet;
+    if (!BinaryProtocol::parse(negotiatedVersion, message, packet)) {
+        qDebug() << "二进制帧格式错误，版本:" << negotiatedVersion << "长度:" << message.size();
+        return;
+    }
+    
+    if (packet.type == BinaryProtocol::Json) {
+        wireStats.textBytesReceived += message.size() + frameOverhead(message.size(), false);
+        wireStats.jsonBytesReceived += packet.payloadSize;
+        const QByteArray utf8(packet.payload, packet.payloadSize);
+        handleMessage(QString::fromUtf8(utf8), utf8);
+        return;
+    }
+    
+    if (packet.type == BinaryProtocol::DeflateJson) {
+        wireStats.textBytesReceived += message.size() + frameOverhead(message.size(), false);
+        if (!compressionActive || !deflate.decompress(packet.payload, packet.payloadSize, deflateBuffer)) {
+            // 解压状态已无法与服务器同步，只能重新连接
+            qDebug() << "压缩消息解压失败，关闭连接";
+            if (onErrorCallback) {
+                onErrorCallback("压缩消息解压失败");
+            }
+            closeConnection();
+            return;
+        }
+        wireStats.jsonBytesReceived += deflateBuffer.size();
+        ++wireStats.compressedReceived;
+        handleMessage(QString::fromUtf8(deflateBuffer), deflateBuffer);
+        return;
     }
+    
+    wireStats.audioBytesReceived += message.size() + frameOverhead(message.size(), false);
+    if (packet.hasTimestamp) {
+        downlinkStats.onPacket(packet.timestamp, sessionClock.elapsed());
+    }
+    
+    deliverAudio(packet.payload, packet.payloadSize,
+                 packet.hasTimestamp ? static_cast<qint64>(packet.timestamp) : -1);
 }
 
 void WebSocketClient::onTextMessageReceived(const QString &message)
 {
-    QJsonDocument doc = QJsonDocument::fromJson(message.toUtf8());
-    if (doc.isNull()) {
+    const QByteArray utf8 = message.toUtf8();
+    wireStats.textBytesReceived += utf8.size() + frameOverhead(utf8.size(), false);
+    wireStats.jsonBytesReceived += utf8.size();
+    handleMessage(message, utf8);
+}
+
+void WebSocketClient::handleMessage(const QString& message, const QByteArray& utf8)
+{
+    // 每条消息只在这里解析一次，之后以类型化结构体分发
+    Protocol::Message parsed = Protocol::parse(utf8);
+    if (std::holds_alternative<std::monostate>(parsed)) {
         qDebug() << "Invalid JSON received:" << message;
         return;
     }
     qDebug() << "Received message:" << message;
-
-    QJsonObject root = doc.object();
-    QString type = root["type"].toString();
     
-    qDebug() << "Received message type:" << type;
-    
-    if (type == "hello") {
-        if (!serverHelloReceived && root["transport"].toString() == "websocket") {
+    if (const auto* hello = std::get_if<Protocol::HelloMessage>(&parsed)) {
+        if (!serverHelloReceived && hello->transport == "websocket") {
             qDebug() << "Server hello received successfully";
             serverHelloReceived = true;
             timeoutTimer.stop();
             
+            // 服务器在 hello 中确认二进制协议版本；没有给出时沿用请求的版本（默认 1）
+            negotiatedVersion = Protocol::negotiateVersion(*hello, preferredVersion);
+            qDebug() << "二进制协议版本:" << negotiatedVersion
+                     << (hello->hasVersion ? "（服务器确认）" : "（服务器未给出，沿用请求的版本）");
+            // 压缩消息用二进制帧的类型字段区分，版本 1 没有类型字段
+            compressionActive = compressionThreshold > 0 && negotiatedVersion >= 2
+                                && hello->compression == "deflate";
+            qDebug() << "JSON 压缩:" << (compressionActive ? "deflate" : "关闭");
+            sessionClock.start();
+            downlinkStats.reset();
+            if (hello->hasAudioParams) {
+                downlinkStats.setFrameDuration(hello->audioParams.frameDuration);
+            }
+            
+            // 新连接重新开始保活和 RTT 估计
+            outstandingPings = 0;
+            resetRtt();
+            if (keepAliveTimer.interval() > 0) {
+                keepAliveTimer.start();
+            }
+            
             // 只在首次收到hello时调用回调
             if (onConnectedCallback) {
                 onConnectedCallback();
             }
-            if (onJsonCallback) {
-                onJsonCallback(message);
-            }
+            deliverMessage(message, parsed);
             
             // 如果服务器发送了音频参数，通知客户端
-            if (root.contains("audio_params") && onAudioParamsCallback) {
-                QJsonObject params = root["audio_params"].toObject();
-                AudioParams audioParams;
-                audioParams.format = params["format"].toString();
-                audioParams.sampleRate = params["sample_rate"].toInt();
-                audioParams.channels = params["channels"].toInt();
-                audioParams.frameDuration = params["frame_duration"].toInt();
-                onAudioParamsCallback(audioParams);
+            if (hello->hasAudioParams && onAudioParamsCallback) {
+                onAudioParamsCallback(hello->audioParams);
             }
         }
-    } else if (type == "error") {
-        qDebug() << "Received error from server:" << root["message"].toString();
+    } else if (const auto* error = std::get_if<Protocol::ErrorMessage>(&parsed)) {
+        qDebug() << "Received error from server:" << error->message;
+        deliverMessage(message, parsed);
         closeConnection();
-    } else if (!type.isEmpty() && onJsonCallback) {
-        onJsonCallback(message);
+    } else {
+        deliverMessage(message, parsed);
     }
 }
 
 void WebSocketClient::onError(QAbstractSocket::SocketError error)
 {
     qDebug() << "WebSocket error:" << error << webSocket.errorString();
+    if (onErrorCallback) {
+        onErrorCallback(webSocket.errorString());
+    }
+}
+
+void WebSocketClient::setKeepAlive(int intervalMs, int maxMissed)
+{
+    maxMissedPongs = qMax(1, maxMissed);
+    keepAliveTimer.setInterval(intervalMs);
+    if (intervalMs <= 0) {
+        keepAliveTimer.stop();
+    } else if (serverHelloReceived) {
+        keepAliveTimer.start();
+    }
+}
+
+void WebSocketClient::sendKeepAlive()
+{
+    if (outstandingPings >= maxMissedPongs) {
+        // 对端已无响应（半开连接），立即断开，由 ConnectionManager 重连
+        qDebug() << "连续" << outstandingPings << "次未收到 pong，断开连接";
+        keepAliveTimer.stop();
+        webSocket.abort();
+        if (onErrorCallback) {
+            onErrorCallback("keep-alive timeout");
+        }
+        return;
+    }
+    
+    ++outstandingPings;
+    webSocket.ping();
+}
+
+void WebSocketClient::onPong(quint64 elapsedTime, const QByteArray &payload)
+{
+    Q_UNUSED(payload);
+    outstandingPings = 0;
+    updateRtt(static_cast<qint64>(elapsedTime));
+}
+
+void WebSocketClient::setSslSessionTicket(const QByteArray& ticket)
+{
+#ifndef QT_NO_SSL
+    QSslConfiguration config = webSocket.sslConfiguration();
+    // 允许会话持久化，握手后才能取到会话票据
+    config.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    if (!ticket.isEmpty()) {
+        config.setSessionTicket(ticket);
+    }
+    webSocket.setSslConfiguration(config);
+#else
+    Q_UNUSED(ticket);
+#endif
+}
+
+QByteArray WebSocketClient::sslSessionTicket() const
+{
+#ifndef QT_NO_SSL
+    return webSocket.sslConfiguration().sessionTicket();
+#else
+    return QByteArray();
+#endif
 }
 
 void WebSocketClient::sendHello()
@@ -178,7 +335,7 @@ void WebSocketClient::sendHello()
     
     QJsonObject hello;
     hello["type"] = "hello";
-    hello["version"] = 1;
+    hello["version"] = preferredVersion;
     hello["transport"] = "websocket";
     
     QJsonObject audioParams;
@@ -189,11 +346,22 @@ void WebSocketClient::sendHello()
     
     hello["audio_params"] = audioParams;
     
+    // 请求版本 1 时也提出压缩：服务器确认版本 2/3 后才启用
+    if (compressionThreshold > 0) {
+        QJsonObject compression;
+        compression["algorithm"] = "deflate";
+        compression["threshold"] = compressionThreshold;
+        hello["compression"] = compression;
+    }
+    
     QJsonDocument doc(hello);
     QString message = doc.toJson(QJsonDocument::Compact);
     qDebug() << "Hello message:" << message;
     
     webSocket.sendTextMessage(message);
+    const int size = message.toUtf8().size();
+    wireStats.textBytesSent += size + frameOverhead(size, true);
+    wireStats.jsonBytesSent += size;
 }
 
 void WebSocketClient::checkTimeout()
@@ -203,65 +371,3 @@ void WebSocketClient::checkTimeout()
         closeConnection();
     }
 }
-
-QString WebSocketClient::getMacAddress() {
-    QString macAddress;
-    
-    // 创建UDP socket
-    QUdpSocket socket;
-    // 尝试连接Google DNS服务器（不会真正发送数据）
-    socket.connectToHost("223.6.6.6", 53);
-    if (socket.waitForConnected(1000)) {  // 等待最多1秒
-        // 获取本地地址
-        QHostAddress localAddress = socket.localAddress();
-        socket.disconnectFromHost();
-        
-        // 获取所有网络接口
-        QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
-        
-        // 查找匹配的网络接口
-        for (const QNetworkInterface &interface : interfaces) {
-            // 跳过回环接口和非活动接口
-            if (interface.flags().testFlag(QNetworkInterface::IsLoopBack) ||
-                !interface.flags().testFlag(QNetworkInterface::IsUp) ||
-                !interface.flags().testFlag(QNetworkInterface::IsRunning)) {
-                continue;
-            }
-            
-            // 检查接口的地址列表
-            QList<QNetworkAddressEntry> entries = interface.addressEntries();
-            for (const QNetworkAddressEntry &entry : entries) {
-                if (entry.ip() == localAddress) {
-                    macAddress = interface.hardwareAddress().toLower();
-                    qDebug() << "找到出口网卡:" << interface.name() 
-                            << "IP:" << localAddress.toString()
-                            << "MAC:" << macAddress;
-                    return macAddress;
-                }
-            }
-        }
-    }
-    
-    // 如果没有找到出口网卡，使用默认值
-    if (macAddress.isEmpty()) {
-        macAddress = "60:a4:4c:59:44:60";  // 使用默认的MAC地址
-        qDebug() << "未找到出口网卡的MAC地址，使用默认地址:" << macAddress;
-    }
-    
-    return macAddress;
-}
-
-QString WebSocketClient::generateClientId(const QString &macAddress) {
-    // 使用MAC地址作为种子生成UUID
-    QByteArray data = macAddress.toUtf8();
-    QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Md5);
-    
-    // 构造UUID格式 (8-4-4-4-12)
-    QString uuid = hash.toHex();
-    uuid.insert(8, '-');
-    uuid.insert(13, '-');
-    uuid.insert(18, '-');
-    uuid.insert(23, '-');
-    
-    return uuid.left(36);
-} 
@@ -1,59 +1,53 @@
 #pragma once
 
-#include <QObject>
 #include <QWebSocket>
 #include <QTimer>
-#include <functional>
-#include <vector>
+#include "transport.h"
+#include "message_deflate.h"
 
-struct AudioParams {
-    QString format;
-    int sampleRate;
-    int channels;
-    int frameDuration;
-};
-
-class WebSocketClient : public QObject {
+class WebSocketClient : public Transport {
     Q_OBJECT
 public:
     explicit WebSocketClient(QObject *parent = nullptr);
     ~WebSocketClient();
 
+    QString transportName() const override { return QStringLiteral("websocket"); }
+
     // 连接到服务器
-    bool connectToServer(const QString& url);
+    bool connectToServer(const QString& url) override;
     
-    // 发送音频数据
-    void sendAudio(const std::vector<uint8_t>& data);
+    // 发送音频数据（按协商的协议版本加帧头）
+    using Transport::sendAudio;
+    void sendAudio(const QByteArray& opusData) override;
     
     // 发送文本消息
-    void sendText(const QString& text);
+    void sendText(const QString& text) override;
     
     // 关闭连接
-    void closeConnection();
+    void closeConnection() override;
     
     // 是否已连接
-    bool isConnected() const;
-
-    // 设置回调函数
-    void setOnAudioCallback(std::function<void(const std::vector<uint8_t>&)> callback) {
-        onAudioCallback = callback;
-    }
+    bool isConnected() const override;
     
-    void setOnJsonCallback(std::function<void(const QString&)> callback) {
-        onJsonCallback = callback;
-    }
+    // 二进制协议版本：连接前设置希望使用的版本（1-3），收到服务器 hello 后确定实际版本
+    void setPreferredProtocolVersion(int version) { preferredVersion = qBound(1, version, 3); }
+    int protocolVersion() const override { return negotiatedVersion; }
     
-    void setOnConnectedCallback(std::function<void()> callback) {
-        onConnectedCallback = callback;
-    }
+    // 访问令牌（OTA 下发的 websocket.token），连接前设置
+    void setAccessToken(const QString& token) { accessToken = token; }
     
-    void setOnDisconnectedCallback(std::function<void()> callback) {
-        onDisconnectedCallback = callback;
-    }
+    // JSON 压缩：连接前设置，不小于 bytes 字节的控制消息压缩后发送，0 表示不压缩。
+    // 在 hello 中提出，服务器确认且二进制协议版本 >= 2 时才启用；音频帧从不压缩
+    void setCompressionThreshold(int bytes) { compressionThreshold = qMax(0, bytes); }
+    bool compressionEnabled() const { return compressionActive; }
     
-    void setOnAudioParamsCallback(std::function<void(const AudioParams&)> callback) {
-        onAudioParamsCallback = callback;
-    }
+    // 保活：每 intervalMs 发送一次 ping，连续 maxMissed 个 ping 没有 pong 时断开连接
+    void setKeepAlive(int intervalMs, int maxMissed) override;
+    int missedPongCount() const { return outstandingPings; }
+    
+    // TLS 会话复用：连接前设置上一次的会话票据，连接成功后取出本次的票据
+    void setSslSessionTicket(const QByteArray& ticket) override;
+    QByteArray sslSessionTicket() const override;
 
 private slots:
     void onConnected();
@@ -61,24 +55,33 @@ private slots:
     void onBinaryMessageReceived(const QByteArray &message);
     void onTextMessageReceived(const QString &message);
     void onError(QAbstractSocket::SocketError error);
+    void onPong(quint64 elapsedTime, const QByteArray &payload);
+    void sendKeepAlive();
 
 private:
     void sendHello();
+    void handleMessage(const QString& message, const QByteArray& utf8);
     void checkTimeout();
-    QString getMacAddress();
-    QString generateClientId(const QString &macAddress);
 
 private:
     QWebSocket webSocket;
     QTimer timeoutTimer;
+    QTimer keepAliveTimer;
+    int maxMissedPongs = 3;
+    int outstandingPings = 0;
     bool serverHelloReceived = false;
     
-    std::function<void(const std::vector<uint8_t>&)> onAudioCallback;
-    std::function<void(const QString&)> onJsonCallback;
-    std::function<void()> onConnectedCallback;
-    std::function<void()> onDisconnectedCallback;
-    std::function<void(const AudioParams&)> onAudioParamsCallback;
+    QString accessToken;
+    int preferredVersion = 1;
+    int negotiatedVersion = 1;
+    QByteArray txFrame;           // 发送帧缓冲区，复用容量
+    
+    int compressionThreshold = 256;
+    bool compressionActive = false;
+    MessageDeflate deflate;
+    QByteArray deflateBuffer;     // 压缩/解压缓冲区，复用容量
     
     const int TIMEOUT_MS = 10000;  // 10秒超时
+    const int DEFAULT_KEEPALIVE_MS = 5000;
     const int OPUS_FRAME_DURATION_MS = 60;
 }; 
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QTextStream>
+#include <QThread>
+#include <vosk_api.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "audio_file.h"
+#include "wake_word_matcher.h"
+
+// 离线批量转写：目录下的录音（.pcm 16kHz 单声道 s16le，或 Ogg Opus）分给多个线程，
+// 共用一个 Vosk 模型，每个文件一个识别器。每个文件一行 JSON（文本、带时间的词、
+// 是否含唤醒词、实时率），最后输出总实时率和唤醒词命中率。
+// 标注文件每行 "相对路径<TAB>1|0"（1 表示录音中说了唤醒词），给出后分别统计漏检和误唤醒。
+// 唤醒词按检测器使用的配置文件（--wake-config，默认与检测器相同）匹配。
+//
+// xiaozhi_transcribe [-m 模型目录] [-j 线程数] [-o 结果.jsonl] [-l 标注.tsv]
+//                    [--wake-config wake_words.json] 录音目录
+
+namespace {
+
+constexpr int CHUNK_BYTES = AudioFile::SAMPLE_RATE * 2 / 2;  // 每次送 0.5 秒
+
+struct FileResult {
+    QString file;          // 相对录音目录的路径
+    bool ok = false;
+    QString error;
+    qint64 audioMs = 0;
+    qint64 decodeMs = 0;
+    QString text;
+    QJsonArray words;
+    bool wake = false;
+};
+
+// Vosk 的一段结果：文本接到整句后面，词和时间追加到 words
+void appendSegment(const char* json, FileResult* result)
+{
+    const QJsonObject segment = QJsonDocument::fromJson(json).object();
+    const QString text = segment["text"].toString();
+    if (!text.isEmpty()) {
+        if (!result->text.isEmpty()) {
+            result->text += " ";
+        }
+        result->text += text;
+    }
+    for (const QJsonValue& word : segment["result"].toArray()) {
+        result->words.append(word);
+    }
+}
+
+FileResult transcribe(VoskModel* model, const WakeWordMatcher& matcher, const QString& root, const QString& path)
+{
+    FileResult result;
+    result.file = QDir(root).relativeFilePath(path);
+
+    QByteArray pcm;
+    if (!AudioFile::read(path, &pcm, &result.error)) {
+        return result;
+    }
+    result.audioMs = pcm.size() * 1000 / (AudioFile::SAMPLE_RATE * 2);
+
+    QElapsedTimer timer;
+    timer.start();
+    VoskRecognizer* recognizer = vosk_recognizer_new(model, AudioFile::SAMPLE_RATE);
+    if (!recognizer) {
+        result.error = "无法创建Vosk识别器";
+        return result;
+    }
+    vosk_recognizer_set_words(recognizer, 1);
+    for (int pos = 0; pos < pcm.size(); pos += CHUNK_BYTES) {
+        const int length = qMin(CHUNK_BYTES, pcm.size() - pos);
+        const int accepted = vosk_recognizer_accept_waveform(recognizer, pcm.constData() + pos, length);
+        if (accepted < 0) {
+            result.error = "音频数据处理失败";
+            vosk_recognizer_free(recognizer);
+            return result;
+        }
+        // 录音中的每个端点都给出一段结果，时间从文件开头计
+        if (accepted == 1) {
+            appendSegment(vosk_recognizer_result(recognizer), &result);
+        }
+    }
+    appendSegment(vosk_recognizer_final_result(recognizer), &result);
+    vosk_recognizer_free(recognizer);
+    result.decodeMs = timer.elapsed();
+
+    result.wake = matcher.matches(result.text);
+    result.ok = true;
+    return result;
+}
+
+QJsonObject toJson(const FileResult& result)
+{
+    QJsonObject object;
+    object["file"] = result.file;
+    if (!result.ok) {
+        object["error"] = result.error;
+        return object;
+    }
+    object["duration"] = result.audioMs / 1000.0;
+    object["rtf"] = result.audioMs > 0 ? static_cast<double>(result.decodeMs) / result.audioMs : 0.0;
+    object["text"] = result.text;
+    object["words"] = result.words;
+    object["wake"] = result.wake;
+    return object;
+}
+
+// 标注：相对路径 -> 是否说了唤醒词
+bool loadLabels(const QString& path, QHash<QString, bool>* labels)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QStringList fields = in.readLine().split('\t');
+        if (fields.size() >= 2 && !fields[0].startsWith('#')) {
+            labels->insert(QDir::cleanPath(fields[0]), fields[1].trimmed() == "1");
+        }
+    }
+    return true;
+}
+
+QString percent(qint64 part, qint64 total)
+{
+    return total > 0 ? QString::number(100.0 * part / total, 'f', 2) + "%" : QString("-");
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("批量离线转写录音，输出 JSONL 并统计实时率和唤醒词命中率");
+    parser.addHelpOption();
+    parser.addOption({{"m", "model"}, "Vosk 模型目录", "dir",
+                      QDir(QCoreApplication::applicationDirPath() + "/../models/vosk-model-cn").absolutePath()});
+    parser.addOption({{"j", "jobs"}, "并行线程数（默认为 CPU 核数）", "n",
+                      QString::number(QThread::idealThreadCount())});
+    parser.addOption({{"o", "output"}, "结果文件（默认输出到标准输出）", "file"});
+    parser.addOption({{"l", "labels"}, "唤醒词标注文件（相对路径<TAB>1|0）", "file"});
+    parser.addOption({"wake-config", "唤醒词配置（不存在时使用默认唤醒词）", "file",
+                      WakeWordMatcher::Config::defaultPath()});
+    parser.addPositionalArgument("dir", "录音目录（递归查找 .pcm/.raw/.ogg/.opus）");
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+    const QString root = parser.positionalArguments().first();
+    const int jobs = qMax(1, parser.value("jobs").toInt());
+
+    QStringList files;
+    QDirIterator it(root, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (AudioFile::isSupported(path)) {
+            files.append(path);
+        }
+    }
+    files.sort();
+    if (files.isEmpty()) {
+        qDebug() << "目录中没有录音:" << root;
+        return 1;
+    }
+
+    QHash<QString, bool> labels;
+    if (parser.isSet("labels") && !loadLabels(parser.value("labels"), &labels)) {
+        qDebug() << "无法读取标注文件:" << parser.value("labels");
+        return 1;
+    }
+
+    // 与检测器相同的唤醒词和读音；matches() 不修改状态，多个线程共用一个
+    WakeWordMatcher::Config wakeConfig;
+    QString error;
+    if (!WakeWordMatcher::Config::loadIfExists(parser.value("wake-config"), &wakeConfig, &error)) {
+        qDebug() << "唤醒词配置无效:" << parser.value("wake-config") << error;
+        return 1;
+    }
+    const WakeWordMatcher matcher(wakeConfig);
+    qDebug() << "唤醒词:" << matcher.config().patterns << "编辑距离:" << wakeConfig.maxDistance;
+
+    QFile output;
+    bool opened = false;
+    if (parser.isSet("output")) {
+        output.setFileName(parser.value("output"));
+        opened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    } else {
+        opened = output.open(stdout, QIODevice::WriteOnly);
+    }
+    if (!opened) {
+        qDebug() << "无法写入结果文件:" << parser.value("output");
+        return 1;
+    }
+
+    vosk_set_log_level(-1);
+    VoskModel* model = vosk_model_new(parser.value("model").toUtf8().constData());
+    if (!model) {
+        qDebug() << "无法加载Vosk模型:" << parser.value("model");
+        return 1;
+    }
+    qDebug().noquote() << QString("%1 个文件，%2 个线程").arg(files.size()).arg(jobs);
+
+    // 线程按顺序领取文件，结果按完成顺序逐行写出，中途中断也不丢已完成的部分
+    std::atomic<int> next(0);
+    QMutex outputMutex;
+    std::vector<FileResult> results(files.size());
+    QElapsedTimer wall;
+    wall.start();
+    auto worker = [&]() {
+        for (int index = next++; index < files.size(); index = next++) {
+            results[index] = transcribe(model, matcher, root, files[index]);
+            const QByteArray line = QJsonDocument(toJson(results[index])).toJson(QJsonDocument::Compact) + "\n";
+            QMutexLocker locker(&outputMutex);
+            output.write(line);
+            output.flush();
+            if ((index + 1) % 100 == 0) {
+                qDebug().noquote() << QString("已完成约 %1/%2").arg(index + 1).arg(files.size());
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < jobs; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const qint64 wallMs = wall.elapsed();
+    vosk_model_free(model);
+
+    // 汇总
+    qint64 failed = 0, audioMs = 0, decodeMs = 0, hits = 0;
+    qint64 positives = 0, detected = 0, negatives = 0, falseAccepts = 0, negativeMs = 0, unlabeled = 0;
+    for (const FileResult& result : results) {
+        if (!result.ok) {
+            ++failed;
+            qDebug().noquote() << QString("失败: %1（%2）").arg(result.file, result.error);
+            continue;
+        }
+        audioMs += result.audioMs;
+        decodeMs += result.decodeMs;
+        hits += result.wake;
+        const auto label = labels.constFind(QDir::cleanPath(result.file));
+        if (label == labels.constEnd()) {
+            ++unlabeled;
+        } else if (label.value()) {
+            ++positives;
+            detected += result.wake;
+        } else {
+            ++negatives;
+            negativeMs += result.audioMs;
+            falseAccepts += result.wake;
+        }
+    }
+
+    qDebug().noquote() << QString("%1 个文件（失败 %2），音频 %3 小时，耗时 %4 秒")
+                              .arg(results.size()).arg(failed)
+                              .arg(audioMs / 3600000.0, 0, 'f', 2).arg(wallMs / 1000.0, 0, 'f', 1);
+    qDebug().noquote() << QString("实时率: 单线程 %1，%2 线程整体 %3（每秒处理 %4 秒音频）")
+                              .arg(audioMs > 0 ? static_cast<double>(decodeMs) / audioMs : 0.0, 0, 'f', 3)
+                              .arg(jobs)
+                              .arg(audioMs > 0 ? static_cast<double>(wallMs) / audioMs : 0.0, 0, 'f', 4)
+                              .arg(wallMs > 0 ? static_cast<double>(audioMs) / wallMs : 0.0, 0, 'f', 1);
+    qDebug().noquote() << QString("含唤醒词: %1/%2（%3）")
+                              .arg(hits).arg(results.size() - failed).arg(percent(hits, results.size() - failed));
+    if (!labels.isEmpty()) {
+        qDebug().noquote() << QString("标注为唤醒: %1 个，检出 %2（%3），漏检 %4")
+                                  .arg(positives).arg(detected).arg(percent(detected, positives))
+                                  .arg(positives - detected);
+        qDebug().noquote() << QString("标注为非唤醒: %1 个，误唤醒 %2（%3），每小时 %4 次；未标注 %5 个")
+                                  .arg(negatives).arg(falseAccepts).arg(percent(falseAccepts, negatives))
+                                  .arg(negativeMs > 0 ? falseAccepts * 3600000.0 / negativeMs : 0.0, 0, 'f', 2)
+                                  .arg(unlabeled);
+    }
+    return failed == static_cast<qint64>(results.size()) ? 1 : 0;
+}
@@ -0,0 +1,451 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+#include <vosk_api.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <time.h>
+#include <vector>
+#include "audio_file.h"
+#include "wake_word_detector.h"
+#include "wake_word_matcher.h"
+
+// 唤醒词离线评估：按标注（相对路径<TAB>1|0）读取录音，以 60ms 块（与采集相同）送入
+// 与 WakeWordDetector 设置相同的 Vosk 识别器，记下每块之后的部分结果和音频时间。
+// 解码是主要开销，每个文件只解码一次；之后对每组参数（唤醒词集合 × 拼接窗口 × 编辑距离）
+// 用 WakeWordMatcher 按音频时间回放，不依赖墙上时钟，远快于实时。
+// 解码和参数扫描都分给多个线程。输出每组参数的漏检率和每小时误唤醒次数（DET 曲线上的点），
+// 以及每小时音频的解码 CPU 时间。
+//
+// xiaozhi_wake_eval -l 标注.tsv [-m 模型目录] [-j 线程数] [-o det.csv]
+//                   [-w 窗口ms列表] [-d 编辑距离列表] [-p 唤醒词集合文件]
+//                   [--wake-config wake_words.json] 录音目录
+// 唤醒词配置（默认与检测器相同）给出默认的唤醒词集合、补充读音和标为 [当前] 的参数
+
+namespace {
+
+constexpr int CHUNK_BYTES = AudioFile::SAMPLE_RATE * 2 * 60 / 1000;
+
+// 一个文件的部分结果序列
+struct Step {
+    qint64 ms;          // 已送入的音频时长
+    QString partial;    // 非空的部分结果（小写）；为空表示 Vosk 端点，新的一句开始
+};
+
+struct Trace {
+    QString file;
+    bool wake = false;  // 标注：录音中说了唤醒词
+    bool ok = false;
+    QString error;
+    qint64 audioMs = 0;
+    qint64 cpuNs = 0;   // 解码线程 CPU 时间
+    std::vector<Step> steps;
+};
+
+struct PatternSet {
+    QString name;
+    QStringList patterns;
+};
+
+struct Point {
+    QString patterns;
+    int windowMs = 0;
+    int maxDistance = 0;
+    int hits = 0;
+    int positives = 0;
+    int falseAccepts = 0;      // 非唤醒录音上的触发次数
+    int falseAcceptFiles = 0;
+    int negatives = 0;
+    double negativeHours = 0.0;
+    qint64 detectionMs = 0;    // 唤醒录音中首次触发时间之和
+    qint64 cpuNs = 0;          // 回放 CPU 时间
+    double missRate() const { return positives > 0 ? 1.0 - static_cast<double>(hits) / positives : 0.0; }
+    double falseAcceptsPerHour() const { return negativeHours > 0 ? falseAccepts / negativeHours : 0.0; }
+};
+
+qint64 threadCpuNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// 与 WakeWordDetector::processingLoop 相同的调用顺序：送入一块，取部分结果，端点时取整句结果
+void decode(VoskModel* model, const QString& path, Trace* trace)
+{
+    QByteArray pcm;
+    if (!AudioFile::read(path, &pcm, &trace->error)) {
+        return;
+    }
+    trace->audioMs = pcm.size() * 1000 / (AudioFile::SAMPLE_RATE * 2);
+
+    const qint64 start = threadCpuNs();
+    VoskRecognizer* recognizer = vosk_recognizer_new(model, AudioFile::SAMPLE_RATE);
+    if (!recognizer) {
+        trace->error = "无法创建Vosk识别器";
+        return;
+    }
+    WakeWordDetector::configureRecognizer(recognizer);
+    for (int pos = 0; pos < pcm.size(); pos += CHUNK_BYTES) {
+        const int length = qMin(CHUNK_BYTES, pcm.size() - pos);
+        const int result = vosk_recognizer_accept_waveform(recognizer, pcm.constData() + pos, length);
+        if (result < 0) {
+            continue;
+        }
+        const qint64 ms = (pos + length) * 1000LL / (AudioFile::SAMPLE_RATE * 2);
+        const QString partial = QJsonDocument::fromJson(vosk_recognizer_partial_result(recognizer))
+                                    .object()["partial"].toString().toLower();
+        if (!partial.isEmpty()) {
+            // 相同的部分结果共用一份字符串
+            if (!trace->steps.empty() && trace->steps.back().partial == partial) {
+                trace->steps.push_back({ms, trace->steps.back().partial});
+            } else {
+                trace->steps.push_back({ms, partial});
+            }
+        }
+        if (result == 1) {
+            vosk_recognizer_result(recognizer);
+            trace->steps.push_back({ms, QString()});
+        }
+    }
+    vosk_recognizer_free(recognizer);
+    trace->cpuNs = threadCpuNs() - start;
+    trace->ok = true;
+}
+
+// 按音频时间回放一个文件，返回触发次数。检测后实际的识别器会被重置，
+// 回放时去掉触发时已有的部分结果，只把之后新识别出的内容送入匹配
+int replay(const Trace& trace, const WakeWordMatcher::Config& config, qint64* firstMs)
+{
+    WakeWordMatcher matcher(config);
+    QString consumed;
+    int detections = 0;
+    for (const Step& step : trace.steps) {
+        if (step.partial.isEmpty()) {
+            consumed.clear();
+            matcher.endUtterance();
+            continue;
+        }
+        QString partial = step.partial;
+        if (!consumed.isEmpty()) {
+            if (partial.startsWith(consumed)) {
+                partial = partial.mid(consumed.size()).trimmed();
+            } else {
+                consumed.clear();
+            }
+        }
+        if (partial.isEmpty()) {
+            continue;
+        }
+        if (matcher.feed(partial, step.ms)) {
+            if (detections++ == 0) {
+                *firstMs = step.ms;
+            }
+            matcher.reset(step.ms);
+            consumed = step.partial;
+        }
+    }
+    return detections;
+}
+
+Point evaluate(const std::vector<Trace>& traces, const WakeWordMatcher::Config& base,
+               const PatternSet& set, int windowMs, int maxDistance)
+{
+    Point point;
+    point.patterns = set.name;
+    point.windowMs = windowMs;
+    point.maxDistance = maxDistance;
+
+    WakeWordMatcher::Config config = base;
+    config.windowMs = windowMs;
+    config.maxDistance = maxDistance;
+    config.patterns = set.patterns;
+
+    const qint64 start = threadCpuNs();
+    for (const Trace& trace : traces) {
+        if (!trace.ok) {
+            continue;
+        }
+        qint64 firstMs = 0;
+        const int detections = replay(trace, config, &firstMs);
+        if (trace.wake) {
+            ++point.positives;
+            if (detections > 0) {
+                ++point.hits;
+                point.detectionMs += firstMs;
+            }
+        } else {
+            ++point.negatives;
+            point.negativeHours += trace.audioMs / 3600000.0;
+            point.falseAccepts += detections;
+            point.falseAcceptFiles += detections > 0;
+        }
+    }
+    point.cpuNs = threadCpuNs() - start;
+    return point;
+}
+
+QList<int> parseIntList(const QString& text, int minimum)
+{
+    QList<int> values;
+    for (const QString& item : text.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int value = item.trimmed().toInt(&ok);
+        if (ok && value >= minimum) {
+            values.append(value);
+        }
+    }
+    return values;
+}
+
+// 唤醒词集合文件：每行 "名称<TAB>唤醒词,唤醒词,..."，唤醒词可以是汉字或空格分隔的拼音
+bool loadPatternSets(const QString& path, QList<PatternSet>* sets)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QStringList fields = in.readLine().split('\t');
+        if (fields.size() >= 2 && !fields[0].startsWith('#')) {
+            sets->append({fields[0].trimmed(), fields[1].split(',', Qt::SkipEmptyParts)});
+        }
+    }
+    return !sets->isEmpty();
+}
+
+bool loadLabels(const QString& path, QHash<QString, bool>* labels)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QStringList fields = in.readLine().split('\t');
+        if (fields.size() >= 2 && !fields[0].startsWith('#')) {
+            labels->insert(QDir::cleanPath(fields[0]), fields[1].trimmed() == "1");
+        }
+    }
+    return true;
+}
+
+// 在 count 个任务上运行 jobs 个线程
+template <typename Task>
+void parallelFor(int count, int jobs, Task task)
+{
+    std::atomic<int> next(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < qMin(jobs, count); ++i) {
+        threads.emplace_back([&]() {
+            for (int index = next++; index < count; index = next++) {
+                task(index);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("唤醒词离线评估与参数扫描，输出 DET 曲线上的点和每小时 CPU 时间");
+    parser.addHelpOption();
+    parser.addOption({{"m", "model"}, "Vosk 模型目录", "dir",
+                      QDir(QCoreApplication::applicationDirPath() + "/../models/vosk-model-cn").absolutePath()});
+    parser.addOption({{"j", "jobs"}, "并行线程数（默认为 CPU 核数）", "n",
+                      QString::number(QThread::idealThreadCount())});
+    parser.addOption({{"l", "labels"}, "标注文件（相对路径<TAB>1|0），必需", "file"});
+    parser.addOption({{"o", "output"}, "DET 结果 CSV（默认输出到标准输出）", "file"});
+    parser.addOption({{"w", "windows"}, "端点前后两句的拼接窗口（毫秒，逗号分隔）", "list", "500,1000,1500,2000,3000"});
+    parser.addOption({{"d", "distances"}, "拼音编辑距离上限（逗号分隔）", "list", "0,1,2,3,4"});
+    parser.addOption({"wake-config", "唤醒词配置（不存在时使用默认唤醒词）", "file",
+                      WakeWordMatcher::Config::defaultPath()});
+    parser.addOption({{"p", "patterns"}, "唤醒词集合文件（名称<TAB>唤醒词,唤醒词,...）", "file"});
+    parser.addPositionalArgument("dir", "录音目录（.pcm/.raw/.ogg/.opus）");
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1 || !parser.isSet("labels")) {
+        parser.showHelp(1);
+    }
+    const QString root = parser.positionalArguments().first();
+    const int jobs = qMax(1, parser.value("jobs").toInt());
+
+    QHash<QString, bool> labels;
+    if (!loadLabels(parser.value("labels"), &labels)) {
+        qDebug() << "无法读取标注文件:" << parser.value("labels");
+        return 1;
+    }
+
+    WakeWordMatcher::Config wakeConfig;
+    QString error;
+    if (!WakeWordMatcher::Config::loadIfExists(parser.value("wake-config"), &wakeConfig, &error)) {
+        qDebug() << "唤醒词配置无效:" << parser.value("wake-config") << error;
+        return 1;
+    }
+
+    QList<PatternSet> sets;
+    if (parser.isSet("patterns")) {
+        if (!loadPatternSets(parser.value("patterns"), &sets)) {
+            qDebug() << "无法读取唤醒词集合:" << parser.value("patterns");
+            return 1;
+        }
+    } else {
+        // 近音误识别由编辑距离覆盖，默认只评估检测器当前使用的唤醒词
+        sets.append({"default", WakeWordMatcher(wakeConfig).config().patterns});
+    }
+    const QList<int> windows = parseIntList(parser.value("windows"), 1);
+    const QList<int> distances = parseIntList(parser.value("distances"), 0);
+    if (windows.isEmpty() || distances.isEmpty()) {
+        qDebug() << "窗口或编辑距离列表为空";
+        return 1;
+    }
+
+    // 只评估有标注的录音
+    std::vector<Trace> traces;
+    QStringList paths;
+    QDirIterator it(root, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        const QString file = QDir::cleanPath(QDir(root).relativeFilePath(path));
+        const auto label = labels.constFind(file);
+        if (AudioFile::isSupported(path) && label != labels.constEnd()) {
+            Trace trace;
+            trace.file = file;
+            trace.wake = label.value();
+            traces.push_back(trace);
+            paths.append(path);
+        }
+    }
+    if (traces.empty()) {
+        qDebug() << "目录中没有已标注的录音:" << root;
+        return 1;
+    }
+
+    vosk_set_log_level(-1);
+    VoskModel* model = vosk_model_new(parser.value("model").toUtf8().constData());
+    if (!model) {
+        qDebug() << "无法加载Vosk模型:" << parser.value("model");
+        return 1;
+    }
+
+    // 第一步：解码，每个文件一次
+    qDebug().noquote() << QString("解码 %1 个文件，%2 个线程").arg(traces.size()).arg(jobs);
+    parallelFor(static_cast<int>(traces.size()), jobs, [&](int index) {
+        decode(model, paths[index], &traces[index]);
+    });
+    vosk_model_free(model);
+
+    qint64 audioMs = 0, cpuNs = 0;
+    int failed = 0;
+    for (const Trace& trace : traces) {
+        if (!trace.ok) {
+            ++failed;
+            qDebug().noquote() << QString("失败: %1（%2）").arg(trace.file, trace.error);
+            continue;
+        }
+        audioMs += trace.audioMs;
+        cpuNs += trace.cpuNs;
+    }
+    const double hours = audioMs / 3600000.0;
+    if (hours <= 0) {
+        qDebug() << "没有可用的音频";
+        return 1;
+    }
+
+    // 第二步：参数扫描，每组参数回放全部文件
+    struct Combination {
+        int set;
+        int windowMs;
+        int maxDistance;
+    };
+    std::vector<Combination> combinations;
+    for (int s = 0; s < sets.size(); ++s) {
+        for (int window : windows) {
+            for (int distance : distances) {
+                combinations.push_back({s, window, distance});
+            }
+        }
+    }
+    std::vector<Point> points(combinations.size());
+    parallelFor(static_cast<int>(combinations.size()), jobs, [&](int index) {
+        const Combination& c = combinations[index];
+        points[index] = evaluate(traces, wakeConfig, sets[c.set], c.windowMs, c.maxDistance);
+    });
+
+    // 每个唤醒词集合一条 DET 曲线，按每小时误唤醒次数排序
+    std::sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+        if (a.patterns != b.patterns) {
+            return a.patterns < b.patterns;
+        }
+        return a.falseAcceptsPerHour() < b.falseAcceptsPerHour()
+               || (a.falseAcceptsPerHour() == b.falseAcceptsPerHour() && a.missRate() < b.missRate());
+    });
+
+    QFile output;
+    bool opened = false;
+    if (parser.isSet("output")) {
+        output.setFileName(parser.value("output"));
+        opened = output.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+    } else {
+        opened = output.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    }
+    if (!opened) {
+        qDebug() << "无法写入结果文件:" << parser.value("output");
+        return 1;
+    }
+    QTextStream out(&output);
+    out << "patterns,window_ms,max_distance,miss_rate,false_accepts_per_hour,false_accept_file_rate,"
+           "hits,positives,false_accepts,negatives,mean_detection_ms,matcher_cpu_ms_per_hour\n";
+    for (const Point& p : points) {
+        out << p.patterns << ',' << p.windowMs << ',' << p.maxDistance << ','
+            << QString::number(p.missRate(), 'f', 4) << ','
+            << QString::number(p.falseAcceptsPerHour(), 'f', 3) << ','
+            << QString::number(p.negatives > 0 ? static_cast<double>(p.falseAcceptFiles) / p.negatives : 0.0, 'f', 4) << ','
+            << p.hits << ',' << p.positives << ',' << p.falseAccepts << ',' << p.negatives << ','
+            << (p.hits > 0 ? p.detectionMs / p.hits : 0) << ','
+            << QString::number(p.cpuNs / 1e6 / hours, 'f', 3) << '\n';
+    }
+    out.flush();
+
+    // 汇总：解码 CPU、当前默认参数和不被其他参数同时在两项上超过的点
+    qDebug().noquote() << QString("%1 个文件（失败 %2），音频 %3 小时；Vosk 解码每小时音频 CPU %4 秒（实时率 %5）")
+                              .arg(traces.size()).arg(failed).arg(hours, 0, 'f', 2)
+                              .arg(cpuNs / 1e9 / hours, 0, 'f', 1)
+                              .arg(cpuNs / 1e6 / audioMs, 0, 'f', 3);
+    const WakeWordMatcher::Config& defaults = wakeConfig;
+    for (const Point& p : points) {
+        bool dominated = false;
+        for (const Point& q : points) {
+            dominated = dominated
+                || (q.missRate() <= p.missRate() && q.falseAcceptsPerHour() <= p.falseAcceptsPerHour()
+                    && (q.missRate() < p.missRate() || q.falseAcceptsPerHour() < p.falseAcceptsPerHour()));
+        }
+        const bool current = p.patterns == "default" && p.windowMs == defaults.windowMs
+                             && p.maxDistance == defaults.maxDistance;
+        if (!dominated || current) {
+            qDebug().noquote() << QString("%1%2 窗口 %3ms 距离 %4: 漏检 %5%，误唤醒每小时 %6 次")
+                                      .arg(current ? "[当前] " : "").arg(p.patterns)
+                                      .arg(p.windowMs).arg(p.maxDistance)
+                                      .arg(p.missRate() * 100, 0, 'f', 2)
+                                      .arg(p.falseAcceptsPerHour(), 0, 'f', 3);
+        }
+    }
+    return 0;
+}